@@ -14,6 +14,7 @@
 #include <rdge/graphics/layers/tile_layer.hpp>
 #include <rdge/graphics/layers/sprite_layer.hpp>
 #include <rdge/math/vec2.hpp>
+#include <rdge/physics/tile_colliders.hpp>
 #include <rdge/util/adt/simple_varray.hpp>
 
 //!@{ Forward declarations
@@ -118,6 +119,16 @@ public:
     Layer& operator= (Layer&&) noexcept = default;
     //!@}
 
+    //! \brief Merge the tiles of a collision layer into chains
+    //! \details Every non-empty cell of the tile layer is treated as solid, and
+    //!          adjacent cells are merged by \ref physics::merge_tile_colliders.
+    //!          Coordinates are y-is-up and match the \ref TileLayer created
+    //!          from the same definition.
+    //! \param [in] scale Ratio applied to the pixel coordinates
+    //! \returns Loops wound CCW around the solid tiles
+    //! \throws rdge::Exception Layer is not a tile layer
+    std::vector<physics::TileChain> GetCollisionChains (float scale = 1.f) const;
+
 public:
     LayerType type = LayerType::INVALID; //!< Base type
 
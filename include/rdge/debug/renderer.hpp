@@ -36,6 +36,7 @@ class Fixture;
 struct ishape;
 struct aabb;
 struct circle;
+struct edge;
 struct polygon;
 }
 
@@ -162,6 +163,7 @@ void DrawLine (const math::vec2& pa, const math::vec2& pb, const color& c = DEFA
 void DrawWireFrame (const physics::aabb&, const color& = DEFAULT_COLOR, float scale = 1.f);
 void DrawWireFrame (const physics::circle&, const color& = DEFAULT_COLOR, float scale = 1.f);
 void DrawWireFrame (const physics::polygon&, const color& = DEFAULT_COLOR, float scale = 1.f);
+void DrawWireFrame (const physics::edge&, const color& = DEFAULT_COLOR, float scale = 1.f);
 void DrawWireFrame (const physics::ishape*, const color& = DEFAULT_COLOR, float scale = 1.f);
 void DrawWireFrame (const physics::Fixture*, const color& = DEFAULT_COLOR, float scale = 1.f);
 //!@}
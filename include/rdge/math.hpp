@@ -5,6 +5,7 @@
 #include <rdge/math/mat3.hpp>
 #include <rdge/math/mat4.hpp>
 #include <rdge/math/random.hpp>
+#include <rdge/math/simd.hpp>
 #include <rdge/math/vec2.hpp>
 #include <rdge/math/vec3.hpp>
 #include <rdge/math/vec4.hpp>
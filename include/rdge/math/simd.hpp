@@ -0,0 +1,229 @@
+//! \headerfile <rdge/math/simd.hpp>
+//! \author Josh Bramlett
+//! \version 0.0.11
+//! \date 10/16/2026
+
+// Minimal four lane float wrapper used by the hot loops in physics.  Only the
+// operations required by those loops are provided, and additions should be
+// made on an as-needed basis.
+//
+// The backing implementation is chosen at compile time:
+//   - SSE2 (all x86_64 targets)
+//   - NEON (ARMv7 with NEON and all ARMv8 targets)
+//   - Scalar fallback
+//
+// Loads and stores are unaligned.  Memory provided through RDGE_TMALLOC is
+// offset by the allocation header so 16 byte alignment is not guaranteed (see
+// alloc.hpp), and on current hardware an unaligned load of aligned data has
+// no penalty.
+
+#pragma once
+
+#include <rdge/core.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define RDGE_SIMD_SSE
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define RDGE_SIMD_NEON
+    #include <arm_neon.h>
+#else
+    #define RDGE_SIMD_SCALAR
+#endif
+
+#include <algorithm>
+
+//! \namespace rdge Rainbow Drop Game Engine
+namespace rdge {
+namespace math {
+
+//! \struct float4
+//! \brief Four lane single precision register
+struct float4
+{
+#if defined(RDGE_SIMD_SSE)
+    __m128 v;
+#elif defined(RDGE_SIMD_NEON)
+    float32x4_t v;
+#else
+    float v[4];
+#endif
+};
+
+//! \struct mask4
+//! \brief Result of a four lane comparison
+struct mask4
+{
+#if defined(RDGE_SIMD_SSE)
+    __m128 v;
+#elif defined(RDGE_SIMD_NEON)
+    uint32x4_t v;
+#else
+    bool v[4];
+#endif
+};
+
+//! \brief Load four floats from unaligned memory
+inline float4
+load4 (const float* p) noexcept
+{
+    float4 result;
+#if defined(RDGE_SIMD_SSE)
+    result.v = _mm_loadu_ps(p);
+#elif defined(RDGE_SIMD_NEON)
+    result.v = vld1q_f32(p);
+#else
+    for (size_t i = 0; i < 4; i++) { result.v[i] = p[i]; }
+#endif
+    return result;
+}
+
+//! \brief Store four floats to unaligned memory
+inline void
+store4 (float* p, const float4& a) noexcept
+{
+#if defined(RDGE_SIMD_SSE)
+    _mm_storeu_ps(p, a.v);
+#elif defined(RDGE_SIMD_NEON)
+    vst1q_f32(p, a.v);
+#else
+    for (size_t i = 0; i < 4; i++) { p[i] = a.v[i]; }
+#endif
+}
+
+//! \brief Broadcast a scalar to all four lanes
+inline float4
+splat4 (float s) noexcept
+{
+    float4 result;
+#if defined(RDGE_SIMD_SSE)
+    result.v = _mm_set1_ps(s);
+#elif defined(RDGE_SIMD_NEON)
+    result.v = vdupq_n_f32(s);
+#else
+    for (size_t i = 0; i < 4; i++) { result.v[i] = s; }
+#endif
+    return result;
+}
+
+//!@{ Lane-wise arithmetic
+inline float4
+operator+ (const float4& a, const float4& b) noexcept
+{
+    float4 result;
+#if defined(RDGE_SIMD_SSE)
+    result.v = _mm_add_ps(a.v, b.v);
+#elif defined(RDGE_SIMD_NEON)
+    result.v = vaddq_f32(a.v, b.v);
+#else
+    for (size_t i = 0; i < 4; i++) { result.v[i] = a.v[i] + b.v[i]; }
+#endif
+    return result;
+}
+
+inline float4
+operator- (const float4& a, const float4& b) noexcept
+{
+    float4 result;
+#if defined(RDGE_SIMD_SSE)
+    result.v = _mm_sub_ps(a.v, b.v);
+#elif defined(RDGE_SIMD_NEON)
+    result.v = vsubq_f32(a.v, b.v);
+#else
+    for (size_t i = 0; i < 4; i++) { result.v[i] = a.v[i] - b.v[i]; }
+#endif
+    return result;
+}
+
+inline float4
+operator* (const float4& a, const float4& b) noexcept
+{
+    float4 result;
+#if defined(RDGE_SIMD_SSE)
+    result.v = _mm_mul_ps(a.v, b.v);
+#elif defined(RDGE_SIMD_NEON)
+    result.v = vmulq_f32(a.v, b.v);
+#else
+    for (size_t i = 0; i < 4; i++) { result.v[i] = a.v[i] * b.v[i]; }
+#endif
+    return result;
+}
+
+inline float4
+min4 (const float4& a, const float4& b) noexcept
+{
+    float4 result;
+#if defined(RDGE_SIMD_SSE)
+    result.v = _mm_min_ps(a.v, b.v);
+#elif defined(RDGE_SIMD_NEON)
+    result.v = vminq_f32(a.v, b.v);
+#else
+    for (size_t i = 0; i < 4; i++) { result.v[i] = std::min(a.v[i], b.v[i]); }
+#endif
+    return result;
+}
+
+inline float4
+max4 (const float4& a, const float4& b) noexcept
+{
+    float4 result;
+#if defined(RDGE_SIMD_SSE)
+    result.v = _mm_max_ps(a.v, b.v);
+#elif defined(RDGE_SIMD_NEON)
+    result.v = vmaxq_f32(a.v, b.v);
+#else
+    for (size_t i = 0; i < 4; i++) { result.v[i] = std::max(a.v[i], b.v[i]); }
+#endif
+    return result;
+}
+//!@}
+
+//!@{ Lane-wise comparison
+inline mask4
+cmp_lt (const float4& a, const float4& b) noexcept
+{
+    mask4 result;
+#if defined(RDGE_SIMD_SSE)
+    result.v = _mm_cmplt_ps(a.v, b.v);
+#elif defined(RDGE_SIMD_NEON)
+    result.v = vcltq_f32(a.v, b.v);
+#else
+    for (size_t i = 0; i < 4; i++) { result.v[i] = (a.v[i] < b.v[i]); }
+#endif
+    return result;
+}
+
+inline mask4
+operator& (const mask4& a, const mask4& b) noexcept
+{
+    mask4 result;
+#if defined(RDGE_SIMD_SSE)
+    result.v = _mm_and_ps(a.v, b.v);
+#elif defined(RDGE_SIMD_NEON)
+    result.v = vandq_u32(a.v, b.v);
+#else
+    for (size_t i = 0; i < 4; i++) { result.v[i] = (a.v[i] && b.v[i]); }
+#endif
+    return result;
+}
+
+//! \brief Collapse a comparison result to a bit mask
+//! \returns Integer where bit n is set iff lane n passed
+inline int32
+movemask (const mask4& m) noexcept
+{
+#if defined(RDGE_SIMD_SSE)
+    return _mm_movemask_ps(m.v);
+#elif defined(RDGE_SIMD_NEON)
+    static const uint32 bits[4] = { 1, 2, 4, 8 };
+    uint32x4_t masked = vandq_u32(m.v, vld1q_u32(bits));
+    uint32x2_t sum = vadd_u32(vget_low_u32(masked), vget_high_u32(masked));
+    return static_cast<int32>(vget_lane_u32(vpadd_u32(sum, sum), 0));
+#else
+    return (m.v[0] ? 1 : 0) | (m.v[1] ? 2 : 0) | (m.v[2] ? 4 : 0) | (m.v[3] ? 8 : 0);
+#endif
+}
+//!@}
+
+} // namespace math
+} // namespace rdge
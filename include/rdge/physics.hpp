@@ -10,4 +10,5 @@
 #include <rdge/physics/joints/base_joint.hpp>
 #include <rdge/physics/joints/revolute_joint.hpp>
 #include <rdge/physics/shapes/circle.hpp>
+#include <rdge/physics/shapes/edge.hpp>
 #include <rdge/physics/shapes/polygon.hpp>
@@ -0,0 +1,208 @@
+//! \headerfile <rdge/physics/broad_phase.hpp>
+//! \author Josh Bramlett
+//! \version 0.0.11
+//! \date 10/16/2026
+
+#pragma once
+
+#include <rdge/core.hpp>
+#include <rdge/physics/aabb.hpp>
+#include <rdge/physics/collision.hpp>
+#include <rdge/math/vec2.hpp>
+
+#include <ostream>
+#include <type_traits>
+
+//! \namespace rdge Rainbow Drop Game Engine
+namespace rdge {
+namespace physics {
+
+//!@{ Forward declarations
+struct snapshot_writer;
+struct snapshot_reader;
+//!@}
+
+//! \enum BroadPhaseType
+//! \brief Spatial partitioning structure of an \ref IBroadPhase
+enum class BroadPhaseType : uint8
+{
+    BVH = 0,     //!< \ref BVHTree
+    SPATIAL_HASH //!< \ref SpatialHashGrid
+};
+
+//! \struct proxy_filter
+//! \brief Collision filter stored alongside each proxy
+//! \details Copy of the fixture filter and body type, so pairs which can never
+//!          collide are rejected while traversing the broad phase instead of
+//!          after the pair has been found.  The default filter accepts all pairs.
+//! \see ContactFilter::ShouldCollide
+struct proxy_filter
+{
+    uint16 category = 0xFFFF; //!< Category the proxy belongs to
+    uint16 mask     = 0xFFFF; //!< Mask of other categories the proxy can collide with
+    uint16 group    = 0;      //!< Logical grouping
+    uint16 flags    = 0;      //!< \ref Flags
+
+    enum Flags : uint16
+    {
+        NON_DYNAMIC   = 0x0001, //!< Proxy belongs to a static or kinematic body
+        TEST_CATEGORY = 0x0002  //!< Query applies the group and category rule
+    };
+
+    //! \brief Check if the query proxy (this) can collide with the other proxy
+    //! \details Two non-dynamic proxies never collide.  The group and category
+    //!          rule is the same as the default \ref ContactFilter, and is only
+    //!          applied if the query requests it.
+    //! \param [in] other Filter of the visited proxy
+    //! \returns False iff the pair can never collide
+    constexpr bool should_collide (const proxy_filter& other) const noexcept
+    {
+        if (flags & other.flags & NON_DYNAMIC)
+        {
+            return false;
+        }
+
+        if ((flags & TEST_CATEGORY) == 0)
+        {
+            return true;
+        }
+
+        if ((group != 0) && (group == other.group))
+        {
+            return (group > 0);
+        }
+
+        return (mask & other.category) && (other.mask & category);
+    }
+};
+
+//! \class IBroadPhase
+//! \brief Interface for the proxy storage of the \ref CollisionGraph
+//! \details Proxies are the fattened aabbs of fixtures, which are referenced by
+//!          an integer handle.  Implementations differ in how the proxies are
+//!          partitioned, but share the same query and cast semantics.
+//!
+//!          Queries are non-virtual templates which forward to a virtual visitor
+//!          through a function pointer and context.  Performance sensitive
+//!          callers should test the \ref Type and use the concrete class, whose
+//!          queries are inlined.
+class IBroadPhase
+{
+public:
+    virtual ~IBroadPhase (void) noexcept = default;
+
+    //! \returns Type tag of the implementation
+    virtual BroadPhaseType Type (void) const noexcept = 0;
+
+    virtual void ClearProxies (void) noexcept = 0;
+    virtual int32 CreateProxy (const aabb& box, void* user_data) = 0;
+    virtual void DestroyProxy (int32 handle) = 0;
+
+    //! \brief Update the proxy aabb
+    //! \param [in] handle Proxy handle
+    //! \param [in] box New (unfattened) aabb
+    //! \param [in] displacement Predicted movement used to enlarge the fat aabb
+    //! \returns True iff the fat aabb was changed
+    virtual bool MoveProxy (int32 handle, const aabb& box, const math::vec2& displacement) = 0;
+
+    //! \brief Create a proxy which is not visible until the next \ref Build
+    //! \details Implementations without a bulk load create the proxy immediately.
+    virtual int32 CreateDeferredProxy (const aabb& box, void* user_data)
+    {
+        return CreateProxy(box, user_data);
+    }
+
+    //! \brief Insert all deferred proxies
+    virtual void Build (void) { }
+
+    //! \returns True iff there are proxies waiting on a \ref Build
+    virtual bool HasDeferredProxies (void) const noexcept { return false; }
+
+    //! \brief Refresh any query acceleration data after proxies were modified
+    //! \details Called by the graph prior to querying the dirty proxies.
+    virtual void PrepareQueries (void) { }
+
+    //! \brief Set the filter tested when the proxy is visited by a pair query
+    //! \details Proxies are created with the default (accept all) filter.
+    virtual void SetFilter (int32 handle, const proxy_filter& filter) noexcept = 0;
+
+    //! \returns User data of the proxy
+    virtual void* GetUserData (int32 handle) const noexcept = 0;
+
+    //! \returns Enlarged aabb of the proxy
+    virtual const aabb& GetFatAABB (int32 handle) const noexcept = 0;
+
+    //! \returns Number of proxies
+    virtual size_t ProxyCount (void) const noexcept = 0;
+
+    //!@{ \see CollisionGraph::Snapshot
+    virtual void Save (snapshot_writer& writer) const = 0;
+    virtual void Restore (snapshot_reader& reader) = 0;
+    //!@}
+
+    virtual void DebugDraw (float pixel_ratio) = 0;
+
+    //! \brief Visit all proxies whose fat aabb intersects the provided box
+    //! \param [in] box aabb to query
+    //! \param [in] fn Callback of type bool(int32 handle), returning false to
+    //!                terminate the query
+    template <typename Fn>
+    void Query (const aabb& box, Fn&& fn) const
+    {
+        using F = typename std::remove_reference<Fn>::type;
+        F* f = &fn;
+        QueryProxies(box, [](void* context, int32 handle) {
+            return (**static_cast<F**>(context))(handle);
+        }, &f);
+    }
+
+    //! \brief Cast a ray against the proxies
+    //! \param [in] input Ray segment
+    //! \param [in] fn Callback of type float(const ray_cast_input&, int32 handle)
+    //! \see BVHTree::RayCast
+    template <typename Fn>
+    void RayCast (const ray_cast_input& input, Fn&& fn) const
+    {
+        using F = typename std::remove_reference<Fn>::type;
+        F* f = &fn;
+        SweepProxies(input, math::vec2(0.f, 0.f), [](void* context, const ray_cast_input& sub_input, int32 handle) {
+            return (**static_cast<F**>(context))(sub_input, handle);
+        }, &f);
+    }
+
+    //! \brief Cast an aabb along a translation against the proxies
+    //! \param [in] box aabb to cast
+    //! \param [in] translation Translation of the box
+    //! \param [in] max_fraction Fraction of the translation to test
+    //! \param [in] fn Callback of type float(const ray_cast_input&, int32 handle)
+    //! \see BVHTree::BoxCast
+    template <typename Fn>
+    void BoxCast (const aabb& box, const math::vec2& translation, float max_fraction, Fn&& fn) const
+    {
+        math::vec2 center = box.centroid();
+        ray_cast_input input = { center, center + translation, max_fraction };
+        using F = typename std::remove_reference<Fn>::type;
+        F* f = &fn;
+        SweepProxies(input, box.half_extent(), [](void* context, const ray_cast_input& sub_input, int32 handle) {
+            return (**static_cast<F**>(context))(sub_input, handle);
+        }, &f);
+    }
+
+protected:
+    using query_fn = bool (*)(void* context, int32 handle);
+    using sweep_fn = float (*)(void* context, const ray_cast_input& input, int32 handle);
+
+    //!@{ Type erased query and cast visitors
+    virtual void QueryProxies (const aabb& box, query_fn fn, void* context) const = 0;
+    virtual void SweepProxies (const ray_cast_input& input,
+                               const math::vec2& extension,
+                               sweep_fn fn,
+                               void* context) const = 0;
+    //!@}
+};
+
+//! \brief BroadPhaseType stream output operator
+std::ostream& operator<< (std::ostream& os, BroadPhaseType value);
+
+} // namespace physics
+} // namespace rdge
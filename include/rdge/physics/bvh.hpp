@@ -7,6 +7,12 @@
 
 #include <rdge/core.hpp>
 #include <rdge/physics/aabb.hpp>
+#include <rdge/physics/broad_phase.hpp>
+#include <rdge/physics/collision.hpp>
+#include <rdge/physics/pair_buffer.hpp>
+#include <rdge/physics/query_batch.hpp>
+#include <rdge/math/simd.hpp>
+#include <rdge/util/adt/stack_array.hpp>
 #include <rdge/util/containers/freelist.hpp>
 
 #include <vector>
@@ -15,8 +21,18 @@
 
 //! \namespace rdge Rainbow Drop Game Engine
 namespace rdge {
+
+//!@{ Forward declarations
+class WorkerPool;
+//!@}
+
 namespace physics {
 
+//!@{ Forward declarations
+struct snapshot_writer;
+struct snapshot_reader;
+//!@}
+
 //! \struct bvh_node
 //! \brief Node in the \ref BVHTree
 struct bvh_node
@@ -32,6 +48,7 @@ struct bvh_node
     int32 right;
 
     void* user_data;
+    proxy_filter filter; //!< Pair filter (leaves only)
 
     bool is_leaf (void) const noexcept
     {
@@ -39,6 +56,93 @@ struct bvh_node
     }
 };
 
+//! \struct bvh_wide_node
+//! \brief Four-wide node of the \ref BVHTree query layout
+//! \details The binary tree is collapsed so every node holds up to four
+//!          children.  Child bounds are stored as a structure of arrays so all
+//!          four can be tested against a query box with one set of SIMD
+//!          comparisons.  Unused lanes contain an inverted box which will never
+//!          report an intersection.  Nodes are stored in physics memory which is
+//!          not 16 byte aligned, so the lanes are always loaded unaligned.
+struct bvh_wide_node
+{
+    static constexpr size_t WIDTH = 4;
+
+    float lo_x[WIDTH];
+    float lo_y[WIDTH];
+    float hi_x[WIDTH];
+    float hi_y[WIDTH];
+
+    //! \brief Index of the child wide node, or the encoded leaf handle
+    //! \details Leaf handles are stored as their bitwise complement so all
+    //!          leaves are negative.
+    int32 children[WIDTH];
+
+    //! \brief Test all children against the provided box (edge exclusive)
+    //! \param [in] box aabb to test
+    //! \returns Bit mask where bit n is set iff child n intersects
+    int32 overlaps (const aabb& box) const noexcept
+    {
+        using namespace rdge::math;
+        mask4 m = cmp_lt(splat4(box.lo.x), load4(hi_x)) &
+                  cmp_lt(load4(lo_x), splat4(box.hi.x)) &
+                  cmp_lt(splat4(box.lo.y), load4(hi_y)) &
+                  cmp_lt(load4(lo_y), splat4(box.hi.y));
+
+        return movemask(m);
+    }
+
+    static constexpr bool is_leaf (int32 child) noexcept { return (child < 0); }
+    static constexpr int32 encode_leaf (int32 handle) noexcept { return ~handle; }
+    static constexpr int32 decode_leaf (int32 child) noexcept { return ~child; }
+};
+
+//! \struct bvh_stack
+//! \brief Traversal stack for the \ref BVHTree
+//! \details Uses inline storage, which is large enough for any reasonably
+//!          balanced tree, and only spills to the heap when exceeded.
+struct bvh_stack
+{
+    static constexpr size_t INLINE_CAPACITY = 256;
+
+    void push (int32 value)
+    {
+        if (m_count < INLINE_CAPACITY)
+        {
+            m_inline[m_count++] = value;
+        }
+        else
+        {
+            m_spill.push_back(value);
+        }
+    }
+
+    int32 pop (void) noexcept
+    {
+        SDL_assert(!empty());
+
+        // spill is only used when inline is full, so it's always the top
+        if (!m_spill.empty())
+        {
+            int32 value = m_spill.back();
+            m_spill.pop_back();
+            return value;
+        }
+
+        return m_inline[--m_count];
+    }
+
+    bool empty (void) const noexcept
+    {
+        return (m_count == 0);
+    }
+
+private:
+    int32 m_inline[INLINE_CAPACITY];
+    size_t m_count = 0;
+    std::vector<int32> m_spill;
+};
+
 //! \class BVHTree
 //! \brief Bounding Volume Hierarchy
 //! \details Used for spacial partitioning, the BVH is a binary tree where the leaf
@@ -47,7 +151,7 @@ struct bvh_node
 //!          (e.g. ray cast and intersection) to be done in O(log n) time.
 //! \see http://www.randygaul.net/2013/08/06/dynamic-aabb-tree/
 //! \see https://www.codeproject.com/Articles/832957/Dynamic-Bounding-Volume-Hiearchy-in-Csharp
-class BVHTree
+class BVHTree : public IBroadPhase
 {
 public:
     //! \brief Amount of padding added to AABBs
@@ -57,7 +161,7 @@ public:
     static constexpr float DISP_MULTIPLIER = 2.f;
 
     BVHTree (void) = default;
-    ~BVHTree (void) noexcept = default;
+    ~BVHTree (void) noexcept override = default;
 
     //!@{
     //! \brief Non-copyable, move enabled
@@ -67,10 +171,33 @@ public:
     BVHTree& operator= (BVHTree&&) = default;
     //!@}
 
-    void ClearProxies (void) noexcept;
-    int32 CreateProxy (const aabb& box, void* user_data);
-    void DestroyProxy (int32 handle);
-    bool MoveProxy (int32 handle, const aabb& box, const math::vec2& displacement);
+    BroadPhaseType Type (void) const noexcept override { return BroadPhaseType::BVH; }
+
+    void ClearProxies (void) noexcept override;
+    int32 CreateProxy (const aabb& box, void* user_data) override;
+    void DestroyProxy (int32 handle) override;
+    bool MoveProxy (int32 handle, const aabb& box, const math::vec2& displacement) override;
+
+    //! \brief Create a proxy which is not inserted until the next \ref Build
+    //! \details Use when loading many proxies at once (e.g. a tile map) to avoid
+    //!          the incremental insertion and rebalancing cost of each proxy.
+    //!          Deferred proxies are not visible to queries until built.
+    //! \param [in] box Proxy aabb
+    //! \param [in] user_data Proxy user data
+    //! \returns Proxy handle, which remains valid after the build
+    int32 CreateDeferredProxy (const aabb& box, void* user_data) override;
+
+    //! \brief Rebuild the tree including all deferred proxies
+    //! \details Top-down construction using a binned surface area heuristic,
+    //!          which produces a higher quality tree than incremental insertion.
+    //!          All proxy handles remain valid, but internal nodes are recreated.
+    void Build (void) override;
+
+    //! \returns True iff there are proxies waiting on a \ref Build
+    bool HasDeferredProxies (void) const noexcept override
+    {
+        return !m_deferred.empty();
+    }
 
     //! \brief Query for all intersecting pairs for the provided handles
     //! \details Resultant list of intersecting pairs is guaranteed to be
@@ -81,6 +208,13 @@ public:
     template <typename T>
     std::vector<std::pair<T*, T*>> Query (const std::vector<int32>& handles) const;
 
+    //! \brief Query for all intersecting pairs for the provided handles
+    //! \details Pairs are deduplicated by the buffer and are appended in
+    //!          traversal order.  The buffer is not cleared.
+    //! \param [in] handles List of handles to query for intersections
+    //! \param [out] pairs Buffer the intersecting pairs are added to
+    void Query (const std::vector<int32>& handles, PairBuffer& pairs) const;
+
     //! \brief Query for all proxies intersecting with the provided aabb
     //! \details Resultant list will not be sorted.  List may be empty if
     //!          there are no intersecting proxies.
@@ -89,6 +223,80 @@ public:
     template <typename T>
     std::vector<T*> Query (const aabb& box) const;
 
+    //! \brief Visit all proxies whose fat aabb intersects the provided box
+    //! \details Inlined traversal (unlike the type erased \ref IBroadPhase::Query)
+    //!          using the inline storage of \ref bvh_stack, so the query does
+    //!          not allocate.  Proxies are visited in no particular order.
+    //! \param [in] box aabb to query
+    //! \param [in] fn Callback of type bool(int32 handle), returning false to
+    //!                terminate the query
+    template <typename Fn>
+    void Query (const aabb& box, Fn&& fn) const
+    {
+        QueryLeaves(box, std::forward<Fn>(fn));
+    }
+
+    //! \brief Resolve all queries of the batch
+    //! \details Groups of queries (see \ref QueryBatch::CHUNK_SIZE) share a
+    //!          single traversal, where each node is tested against the queries
+    //!          still active at its parent.  This touches every node once per
+    //!          group rather than once per query.  Each query reports the same
+    //!          proxies as querying the box individually, and the order of the
+    //!          results does not depend on the workers.
+    //! \param [in,out] batch Queries to resolve, which receives the results
+    //! \param [in] workers Optional pool the groups are split across
+    void Query (QueryBatch& batch, WorkerPool* workers = nullptr) const;
+
+    //! \brief Cast a ray against the proxies in the tree
+    //! \details The callback is invoked for every proxy whose fat aabb is hit by
+    //!          the ray, and it controls the traversal with the return value:
+    //!            - Zero terminates the ray cast
+    //!            - Negative ignores the proxy and continues
+    //!            - Positive clips the ray to the returned fraction
+    //!          Returning the hit fraction prunes everything behind the hit,
+    //!          which results in finding the closest hit.
+    //! \param [in] input Ray segment
+    //! \param [in] fn Callback of type float(const ray_cast_input&, int32 handle)
+    template <typename Fn>
+    void RayCast (const ray_cast_input& input, Fn&& fn) const
+    {
+        SweepLeaves(input, math::vec2(0.f, 0.f), std::forward<Fn>(fn));
+    }
+
+    //! \brief Cast an aabb along a translation against the proxies in the tree
+    //! \details Used as the broad phase of a shape cast.  Callback behavior is
+    //!          the same as \ref RayCast, where the ray is the translation of the
+    //!          box center.
+    //! \param [in] box aabb to cast
+    //! \param [in] translation Translation of the box
+    //! \param [in] max_fraction Fraction of the translation to test
+    //! \param [in] fn Callback of type float(const ray_cast_input&, int32 handle)
+    template <typename Fn>
+    void BoxCast (const aabb& box, const math::vec2& translation, float max_fraction, Fn&& fn) const
+    {
+        math::vec2 center = box.centroid();
+        ray_cast_input input = { center, center + translation, max_fraction };
+        SweepLeaves(input, box.half_extent(), std::forward<Fn>(fn));
+    }
+
+    void SetFilter (int32 handle, const proxy_filter& filter) noexcept override
+    {
+        SDL_assert(m_nodes[handle].is_leaf());
+        m_nodes[handle].filter = filter;
+    }
+
+    //! \returns User data of the proxy
+    void* GetUserData (int32 handle) const noexcept override
+    {
+        return m_nodes[handle].user_data;
+    }
+
+    //! \returns Enlarged aabb of the proxy
+    const aabb& GetFatAABB (int32 handle) const noexcept override
+    {
+        return m_nodes[handle].fat_box;
+    }
+
     bool Intersects (int32 handle_a, int32 handle_b)
     {
         SDL_assert(handle_a != bvh_node::NULL_NODE);
@@ -100,139 +308,322 @@ public:
         return node_a.fat_box.intersects_with(node_b.fat_box);
     }
 
+    //! \brief Enable the four-wide query layout
+    //! \details When enabled, queries traverse a collapsed copy of the tree
+    //!          (see \ref bvh_wide_node) which reduces the traversal depth and
+    //!          tests four children per node using SIMD.  The layout is a
+    //!          snapshot and must be refreshed by calling \ref UpdateWideLayout
+    //!          after the tree is modified.  Until then queries fall back to
+    //!          the binary tree.  The rebuild is O(n), so the layout suits
+    //!          trees that are rarely modified, such as static geometry.
+    //! \param [in] enable True to enable, false to disable
+    void EnableWideLayout (bool enable) noexcept
+    {
+        SET_FLAG(enable, m_flags, WIDE_LAYOUT);
+        m_flags |= WIDE_LAYOUT_DIRTY;
+    }
+
+    //! \returns True iff queries will use the wide layout
+    bool UsesWideLayout (void) const noexcept
+    {
+        return (m_flags & (WIDE_LAYOUT | WIDE_LAYOUT_DIRTY)) == WIDE_LAYOUT;
+    }
+
+    //! \brief Rebuild the wide layout if the tree has changed since the last build
+    //! \details Does nothing if the wide layout is not enabled.
+    void UpdateWideLayout (void);
+
+    //! \brief Refreshes the wide layout
+    void PrepareQueries (void) override
+    {
+        UpdateWideLayout();
+    }
+
     int32 Height (void) const noexcept
     {
         return (m_root == bvh_node::NULL_NODE) ? 0 : m_nodes[m_root].height;
     }
 
+    //! \returns Number of nodes, including internal nodes
     size_t Size (void) const noexcept
     {
         return m_nodes.size();
     }
 
+    size_t ProxyCount (void) const noexcept override;
+
+    //!@{
+    //! \brief Copy of the node pool for \ref CollisionGraph::Snapshot
+    //! \details Handles and user data are preserved, so a restored tree does
+    //!          not need to be rebuilt.  The wide layout is not included, and
+    //!          will be refreshed by the next \ref UpdateWideLayout.
+    void Save (snapshot_writer& writer) const override;
+    void Restore (snapshot_reader& reader) override;
+    //!@}
+
+    //! \brief Ratio of the summed internal node perimeters to the root perimeter
+    //! \details Measures the tree quality, where lower is better.
+    float AreaRatio (void) const noexcept;
+
     // TODO Normalize debug printing.
     std::string Dump (void);
 
-    void DebugDraw (float pixel_ratio);
+    void DebugDraw (float pixel_ratio) override;
+
+protected:
+    void QueryProxies (const aabb& box, query_fn fn, void* context) const override;
+    void SweepProxies (const ray_cast_input& input,
+                       const math::vec2& extension,
+                       sweep_fn fn,
+                       void* context) const override;
 
 private:
     friend class CollisionGraph;
 
     void ValidateStructure (int32 index);
 
+    //! \brief Visit all leaves whose fat aabb intersects the provided box
+    //! \details The callback is invoked with the leaf handle, and returns
+    //!          false to terminate the traversal.  If a filter is provided,
+    //!          leaves it cannot collide with are skipped.
+    template <typename Fn>
+    void QueryLeaves (const aabb& box, Fn&& fn, const proxy_filter* filter = nullptr) const;
+
+    //! \brief Shared traversal for a range of the sorted batch queries
+    void QueryChunk (const QueryBatch& batch,
+                     uint32 begin,
+                     uint32 end,
+                     QueryBatch::worker_scratch& scratch) const;
+
+    //! \brief Visit all leaves hit by a segment swept by the extension
+    //! \see RayCast
+    template <typename Fn>
+    void SweepLeaves (const ray_cast_input& input, const math::vec2& extension, Fn&& fn) const;
+
     int32 CreateNode (void);
     void InsertLeaf (int32 leaf_handle);
     void RemoveLeaf (int32 leaf_handle);
     int32 Balance (int32 handle);
 
+    //! \brief Recursively build a subtree from the range of leaves
+    //! \returns Handle of the subtree root
+    int32 BuildRange (int32* leaves, size_t count, int32 depth);
+
     freelist<bvh_node> m_nodes;
     int32 m_root = bvh_node::NULL_NODE;
+
+    std::vector<int32> m_deferred;
+
+    stack_array<bvh_wide_node, memory_bucket_physics> m_wideNodes;
+    std::vector<std::pair<int32, int32>> m_wideBuildStack;
+
+    enum StateFlags
+    {
+        WIDE_LAYOUT       = 0x0001,
+        WIDE_LAYOUT_DIRTY = 0x0002
+    };
+
+    uint16 m_flags = 0;
 };
 
-template <typename T>
-inline std::vector<std::pair<T*, T*>>
-BVHTree::Query (const std::vector<int32>& handles) const
+template <typename Fn>
+inline void
+BVHTree::QueryLeaves (const aabb& box, Fn&& fn, const proxy_filter* filter) const
 {
-    // TODO Perf refactor.  Remove vectors.
-    std::vector<std::pair<int32, int32>> pairs;
-    std::vector<int32> stack;
-    for (int32 handle_a : handles)
+    bvh_stack stack;
+
+    if (UsesWideLayout())
     {
-        const auto& node_a = m_nodes[handle_a];
-        SDL_assert(node_a.is_leaf());
+        if (m_wideNodes.empty())
+        {
+            return;
+        }
 
-        stack.push_back(m_root);
+        stack.push(0);
         while (!stack.empty())
         {
-            int32 handle_b = stack.back();
-            stack.pop_back();
+            const auto& node = m_wideNodes[static_cast<size_t>(stack.pop())];
 
-            if (handle_b == bvh_node::NULL_NODE || handle_a == handle_b)
+            int32 hits = node.overlaps(box);
+            for (size_t i = 0; hits != 0; i++, hits >>= 1)
             {
-                continue;
-            }
+                if ((hits & 1) == 0)
+                {
+                    continue;
+                }
 
-            const auto& node_b = m_nodes[handle_b];
-            if (node_a.fat_box.intersects_with(node_b.fat_box))
-            {
-                if (node_b.is_leaf())
+                int32 child = node.children[i];
+                if (bvh_wide_node::is_leaf(child))
                 {
-                    if (handle_a < handle_b)
+                    int32 handle = bvh_wide_node::decode_leaf(child);
+                    if (filter && !filter->should_collide(m_nodes[handle].filter))
                     {
-                        pairs.emplace_back(handle_a, handle_b);
+                        continue;
                     }
-                    else
+
+                    if (!fn(handle))
                     {
-                        pairs.emplace_back(handle_b, handle_a);
+                        return;
                     }
                 }
                 else
                 {
-                    stack.push_back(node_b.left);
-                    stack.push_back(node_b.right);
+                    stack.push(child);
                 }
             }
         }
+
+        return;
     }
 
-    // sort pairs to make duplicates adjacent
-    std::sort(pairs.begin(), pairs.end(), [](auto& a, auto& b) {
-        if (a.first == b.first)
+    stack.push(m_root);
+    while (!stack.empty())
+    {
+        int32 handle = stack.pop();
+
+        if (handle == bvh_node::NULL_NODE)
         {
-            return (a.second < b.second);
+            continue;
         }
 
-        return (a.first < b.first);
-    });
+        const auto& node = m_nodes[handle];
+        if (box.intersects_with(node.fat_box))
+        {
+            if (node.is_leaf())
+            {
+                if (filter && !filter->should_collide(node.filter))
+                {
+                    continue;
+                }
 
-    // remove adjacent duplicates
-    auto last = std::unique(pairs.begin(), pairs.end());
-    pairs.erase(last, pairs.end());
+                if (!fn(handle))
+                {
+                    return;
+                }
+            }
+            else
+            {
+                stack.push(node.left);
+                stack.push(node.right);
+            }
+        }
+    }
+}
 
-    std::vector<std::pair<T*, T*>> result;
-    result.reserve(pairs.size());
-    for (auto& p : pairs)
+template <typename Fn>
+inline void
+BVHTree::SweepLeaves (const ray_cast_input& input, const math::vec2& extension, Fn&& fn) const
+{
+    // Based on Box2D b2DynamicTree::RayCast(), where nodes are culled using
+    // the segment aabb and the separating axis perpendicular to the segment.
+
+    math::vec2 p1 = input.p1;
+    math::vec2 d = input.p2 - input.p1;
+    float length = d.length();
+    if (length == 0.f)
     {
-        result.emplace_back(reinterpret_cast<T*>(m_nodes[p.first].user_data),
-                            reinterpret_cast<T*>(m_nodes[p.second].user_data));
+        return;
     }
 
-    return result;
-}
+    math::vec2 v = (d * (1.f / length)).perp();
+    math::vec2 abs_v = math::abs(v);
 
-template <typename T>
-inline std::vector<T*>
-BVHTree::Query (const aabb& box) const
-{
-    // TODO Perf refactor.  Remove vectors.
-    std::vector<T*> result;
-    std::vector<int32> stack;
+    float max_fraction = input.max_fraction;
+    auto segment_box = [&](void) {
+        math::vec2 p2 = p1 + (d * max_fraction);
+        return aabb(math::vec2(std::min(p1.x, p2.x), std::min(p1.y, p2.y)) - extension,
+                    math::vec2(std::max(p1.x, p2.x), std::max(p1.y, p2.y)) + extension);
+    };
+
+    aabb sweep_box = segment_box();
 
-    stack.push_back(m_root);
+    bvh_stack stack;
+    stack.push(m_root);
     while (!stack.empty())
     {
-        int32 handle = stack.back();
-        stack.pop_back();
+        int32 handle = stack.pop();
 
         if (handle == bvh_node::NULL_NODE)
         {
             continue;
         }
 
+        // edge inclusive so axis aligned segments are not culled
         const auto& node = m_nodes[handle];
-        if (box.intersects_with(node.fat_box))
+        if (node.fat_box.lo.x > sweep_box.hi.x || sweep_box.lo.x > node.fat_box.hi.x ||
+            node.fat_box.lo.y > sweep_box.hi.y || sweep_box.lo.y > node.fat_box.hi.y)
         {
-            if (node.is_leaf())
+            continue;
+        }
+
+        // |dot(v, p1 - c)| > dot(|v|, h)
+        math::vec2 c = node.fat_box.centroid();
+        math::vec2 h = node.fat_box.half_extent() + extension;
+        if (math::abs(math::dot(v, p1 - c)) - math::dot(abs_v, h) > 0.f)
+        {
+            continue;
+        }
+
+        if (node.is_leaf())
+        {
+            ray_cast_input sub_input = { input.p1, input.p2, max_fraction };
+            float value = fn(sub_input, handle);
+            if (value == 0.f)
             {
-                result.push_back(reinterpret_cast<T*>(node.user_data));
+                return;
             }
-            else
+
+            if (value > 0.f)
             {
-                stack.push_back(node.left);
-                stack.push_back(node.right);
+                max_fraction = value;
+                sweep_box = segment_box();
             }
         }
+        else
+        {
+            stack.push(node.left);
+            stack.push(node.right);
+        }
     }
+}
+
+template <typename T>
+inline std::vector<std::pair<T*, T*>>
+BVHTree::Query (const std::vector<int32>& handles) const
+{
+    PairBuffer pairs;
+    Query(handles, pairs);
+
+    std::vector<proxy_pair> sorted(pairs.begin(), pairs.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        if (a.handle_a == b.handle_a)
+        {
+            return (a.handle_b < b.handle_b);
+        }
+
+        return (a.handle_a < b.handle_a);
+    });
+
+    std::vector<std::pair<T*, T*>> result;
+    result.reserve(sorted.size());
+    for (const auto& p : sorted)
+    {
+        result.emplace_back(reinterpret_cast<T*>(m_nodes[p.handle_a].user_data),
+                            reinterpret_cast<T*>(m_nodes[p.handle_b].user_data));
+    }
+
+    return result;
+}
+
+template <typename T>
+inline std::vector<T*>
+BVHTree::Query (const aabb& box) const
+{
+    std::vector<T*> result;
+    QueryLeaves(box, [&](int32 handle) {
+        result.push_back(reinterpret_cast<T*>(m_nodes[handle].user_data));
+        return true;
+    });
 
     return result;
 }
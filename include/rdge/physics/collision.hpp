@@ -23,7 +23,9 @@ namespace rdge {
 namespace physics {
 
 struct circle;
+struct edge;
 struct polygon;
+struct sweep_step;
 
 //! \var Linear constraint and collision tolerance
 static constexpr float LINEAR_SLOP = 0.005f;
@@ -31,6 +33,50 @@ static constexpr float LINEAR_SLOP = 0.005f;
 //! \var Angular constraint and collision tolerance
 static constexpr float ANGULAR_SLOP = (2.f / 180.f * math::PI);
 
+//! \struct contact_feature
+//! \brief Identifies the shape features which generated a contact point
+//! \details Features are relative to the shapes passed to the intersection
+//!          test (a and b), regardless of which is used as the reference.
+//!          Used to match contact points between steps for warm starting.
+struct contact_feature
+{
+    enum Type : uint8
+    {
+        VERTEX = 0,
+        FACE   = 1
+    };
+
+    uint8 index_a = 0; //!< Vertex or face index on shape a
+    uint8 index_b = 0; //!< Vertex or face index on shape b
+    uint8 type_a = VERTEX;
+    uint8 type_b = VERTEX;
+
+    //! \returns Packed value used for comparison
+    constexpr uint32 key (void) const noexcept
+    {
+        return static_cast<uint32>(index_a) |
+               (static_cast<uint32>(index_b) << 8) |
+               (static_cast<uint32>(type_a) << 16) |
+               (static_cast<uint32>(type_b) << 24);
+    }
+};
+
+//! \brief Create a feature from the reference and incident shapes
+//! \param [in] ref_index Vertex or face index on the reference shape
+//! \param [in] ref_type Feature type on the reference shape
+//! \param [in] inc_index Vertex or face index on the incident shape
+//! \param [in] inc_type Feature type on the incident shape
+inline contact_feature
+make_feature (size_t ref_index, uint8 ref_type, size_t inc_index, uint8 inc_type)
+{
+    contact_feature result;
+    result.index_a = static_cast<uint8>(ref_index);
+    result.type_a = ref_type;
+    result.index_b = static_cast<uint8>(inc_index);
+    result.type_b = inc_type;
+    return result;
+}
+
 //! \struct collision_manifold
 //! \brief Container for collision resolution details
 //! \details Manifold data is represented in world space.  Reference/incident naming
@@ -41,18 +87,91 @@ struct collision_manifold
     math::vec2 plane;               //!< (ref) Collision plane
     math::vec2 normal;              //!< (ref) Vector of resolution, or collision normal
     math::vec2 contacts[2];         //!< (inc) Clipping points
+    contact_feature features[2];    //!< Features which generated the clipping points
     size_t count = 0;               //!< Number of collision points
 
     bool flip = false;              //!< Flip reference/incident shapes
+
+    //! \returns Collision normal pointing from shape a to shape b
+    math::vec2 oriented_normal (void) const noexcept
+    {
+        return (flip) ? -normal : normal;
+    }
 };
 
 //! \struct contact_impulse
 //! \brief Container for impulses generated by the solver
 struct contact_impulse
 {
-    float normals[2];
-    float tangents[2];
-    size_t count;
+    float normals[2] = { 0.f, 0.f };
+    float tangents[2] = { 0.f, 0.f };
+    size_t count = 0;
+};
+
+//! \struct ray_cast_input
+//! \brief Ray cast input data
+//! \details The ray extends from p1 to (p1 + max_fraction * (p2 - p1)).
+struct ray_cast_input
+{
+    math::vec2 p1;            //!< Ray origin
+    math::vec2 p2;            //!< Ray end point
+    float max_fraction = 1.f; //!< Fraction of the segment to test
+};
+
+//! \struct ray_cast_output
+//! \brief Ray cast result data
+//! \details The hit point is (p1 + fraction * (p2 - p1)).
+struct ray_cast_output
+{
+    math::vec2 normal;    //!< Surface normal at the hit point
+    float fraction = 0.f; //!< Fraction of the input segment where the hit occurred
+};
+
+//! \struct toi_output
+//! \brief Time of impact result data
+struct toi_output
+{
+    enum State
+    {
+        FAILED = 0, //!< Iteration limit reached prior to touching
+        OVERLAPPED, //!< Shapes overlap at the start of the sweep
+        TOUCHING,   //!< Shapes touch at the time of impact
+        SEPARATED   //!< Shapes do not touch during the sweep
+    };
+
+    State state = FAILED;
+    float t = 0.f; //!< Sweep fraction of the result
+};
+
+//! \struct simplex_cache
+//! \brief Simplex of a previous distance query
+//! \details Stores the vertex indices of the final simplex, which are used to
+//!          warm start the next query of the same pair of shapes.  Shapes which
+//!          have moved a small amount typically share the same closest
+//!          features, so the cached simplex is usually the final simplex.
+//! \note Must only be reused for the same pair of shapes.  Default state is
+//!       an empty cache.
+struct simplex_cache
+{
+    float metric = 0.f;  //!< Length or area of the simplex, to detect large changes
+    uint8 count = 0;     //!< Number of vertices
+    uint8 index_a[3];    //!< Vertices of shape a
+    uint8 index_b[3];    //!< Vertices of shape b
+};
+
+//! \struct distance_output
+//! \brief Closest points between two shapes
+//! \details For overlapping shapes the points are the deepest points of each
+//!          shape within the other, and the distance is the negative
+//!          penetration depth.  In either case moving shape b along the normal
+//!          by the negated distance leaves the shapes touching.
+struct distance_output
+{
+    math::vec2 point_a;    //!< Closest point on shape a (world space)
+    math::vec2 point_b;    //!< Closest point on shape b (world space)
+    math::vec2 normal;     //!< Unit direction from shape a towards shape b
+    float distance = 0.f;  //!< Distance between the shapes (negative if overlapping)
+    size_t iterations = 0; //!< GJK iterations performed
 };
 
 //! \struct half_plane
@@ -84,6 +203,47 @@ project (const half_plane& hp, const math::vec2& point)
     return point - (hp.normal * distance(hp, point));
 }
 
+//! \struct clip_vertex
+//! \brief Candidate manifold point and the features which generated it
+struct clip_vertex
+{
+    math::vec2 point;
+    contact_feature feature;
+};
+
+//! \brief Clip a segment to the half-plane, keeping the points behind the plane
+//! \details A point generated by the clip is assigned the provided feature.
+//!          Based on Box2D b2ClipSegmentToLine()
+//! \param [out] out Clipped segment
+//! \param [in] in Segment to clip
+//! \param [in] plane Clipping plane
+//! \param [in] clip_feature Feature of a point generated by the clip
+//! \returns Number of points in the output
+inline size_t
+clip_segment (clip_vertex (&out)[2],
+              const clip_vertex (&in)[2],
+              const half_plane& plane,
+              const contact_feature& clip_feature)
+{
+    size_t num_out = 0;
+    float d0 = distance(plane, in[0].point);
+    float d1 = distance(plane, in[1].point);
+
+    // points are behind the plane
+    if (d0 <= 0.f) { out[num_out++] = in[0]; }
+    if (d1 <= 0.f) { out[num_out++] = in[1]; }
+
+    // points are on different sides of the plane
+    if ((d0 * d1) < 0.f)
+    {
+        out[num_out].point = in[0].point + (d0 / (d0 - d1)) * (in[1].point - in[0].point);
+        out[num_out].feature = clip_feature;
+        num_out++;
+    }
+
+    return num_out;
+}
+
 //! \struct gjk
 //! \brief Implementation of the GJK algorithm for collision detection
 //! \details The algorithm operates on two convex shapes, and performs it's
@@ -220,6 +380,95 @@ struct gjk
 //! \returns True iff intersecting
 bool intersects (const polygon& p, const circle& c, collision_manifold& mf);
 
+//! \brief Check edge/circle intersection and build manifold
+//! \details One sided edges ignore circles behind the segment, or those
+//!          which are closest to a neighboring segment of the chain.
+//! \param [in] e Edge shape
+//! \param [in] c Circle shape
+//! \param [out] mf Manifold containing resolution
+//! \returns True iff intersecting
+bool intersects (const edge& e, const circle& c, collision_manifold& mf);
+
+//! \brief Check edge/polygon intersection and build manifold
+//! \details One sided edges ignore polygons behind the segment, and use the
+//!          ghost vertices to reject (or snap to the edge normal) separating
+//!          axes which would catch on an internal vertex of the chain.
+//! \param [in] e Edge shape
+//! \param [in] p Polygon shape
+//! \param [out] mf Manifold containing resolution
+//! \returns True iff intersecting
+//! \see https://box2d.org/posts/2020/06/ghost-collisions/
+bool intersects (const edge& e, const polygon& p, collision_manifold& mf);
+
+//! \brief Cast a shape along a translation against a stationary shape
+//! \details Computes the first time of impact of the moving shape.  The output
+//!          normal is the surface normal of the target shape at the point of
+//!          contact.  If the shapes are overlapping at the start of the cast
+//!          a hit is reported at fraction zero with a zero normal.
+//! \param [in] moving Shape being cast (world space)
+//! \param [in] translation Translation of the moving shape
+//! \param [in] target Stationary shape (world space)
+//! \param [in] max_fraction Fraction of the translation to test
+//! \param [out] output Fraction and normal of the hit
+//! \returns True iff the moving shape hits the target
+bool shape_cast (const ishape* moving,
+                 const math::vec2& translation,
+                 const ishape* target,
+                 float max_fraction,
+                 ray_cast_output& output);
+
+//! \brief Compute the time of impact of two shapes moving along their sweeps
+//! \details Conservative advancement, where the sweeps are advanced by the
+//!          separation divided by an upper bound of the relative motion until
+//!          the shapes are touching.  Touching is defined as overlapping by
+//!          half the \ref LINEAR_SLOP, which ensures a manifold can be built at
+//!          the time of impact.  The separation of polygon pairs is measured on
+//!          the separating axis, which is a lower bound of the distance and may
+//!          require more iterations near vertex/vertex configurations.
+//! \param [in] a First shape (local space)
+//! \param [in] sweep_a Motion of the first shape
+//! \param [in] b Second shape (local space)
+//! \param [in] sweep_b Motion of the second shape
+//! \param [in] t_max Sweep fraction to stop searching
+//! \param [out] output State and sweep fraction of the result
+void time_of_impact (const ishape* a,
+                     const sweep_step& sweep_a,
+                     const ishape* b,
+                     const sweep_step& sweep_b,
+                     float t_max,
+                     toi_output& output);
+
+//!@{
+//! \brief Compute the closest points of two shapes
+//! \details GJK finds the closest points of the shape cores (circles are
+//!          treated as a point and then inflated by the radius).  If the cores
+//!          overlap, EPA expands the final GJK simplex to find the penetration
+//!          depth and the minimum translation to separate the shapes.  Edges
+//!          are treated as two sided.
+//!
+//!          The optional cache is read to warm start GJK, and updated with the
+//!          final simplex.  Repeated queries of a pair whose relative position
+//!          changes slowly typically finish in a single iteration.
+//! \param [in] a First shape (local space)
+//! \param [in] xf_a Transform of the first shape
+//! \param [in] b Second shape (local space)
+//! \param [in] xf_b Transform of the second shape
+//! \param [in,out] cache Simplex of the previous query of the pair
+//! \param [out] output Closest points and distance
+void distance (const ishape* a,
+               const iso_transform& xf_a,
+               const ishape* b,
+               const iso_transform& xf_b,
+               simplex_cache& cache,
+               distance_output& output);
+
+void distance (const ishape* a,
+               const iso_transform& xf_a,
+               const ishape* b,
+               const iso_transform& xf_b,
+               distance_output& output);
+//!@}
+
 //! \brief collision_manifold stream output operator
 std::ostream& operator<< (std::ostream& os, const collision_manifold& mf);
 
@@ -6,16 +6,25 @@
 #pragma once
 
 #include <rdge/core.hpp>
+#include <rdge/physics/broad_phase.hpp>
 #include <rdge/physics/bvh.hpp>
 #include <rdge/physics/contact.hpp>
 #include <rdge/physics/fixture.hpp>
+#include <rdge/physics/graph_stats.hpp>
+#include <rdge/physics/pair_buffer.hpp>
 #include <rdge/physics/rigid_body.hpp>
+#include <rdge/physics/snapshot.hpp>
+#include <rdge/physics/spatial_hash.hpp>
 #include <rdge/physics/joints/base_joint.hpp>
 #include <rdge/physics/solver.hpp>
 #include <rdge/math/vec2.hpp>
 #include <rdge/util/containers/intrusive_list.hpp>
 #include <rdge/util/memory/small_block_allocator.hpp>
 
+#include <SDL_assert.h>
+
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 //! \namespace rdge Rainbow Drop Game Engine
@@ -25,6 +34,8 @@ namespace rdge {
 namespace debug {
 class PhysicsWidget;
 }
+
+class WorkerPool;
 //!@}
 
 namespace physics {
@@ -58,6 +69,14 @@ public:
 
         return (fa.mask & fb.category) && (fb.mask & fa.category);
     }
+
+    //! \brief Apply the default rule during broad phase pair generation
+    //! \details Pairs rejected by the default rule are skipped while traversing
+    //!          the broad phase, and never reach \ref ShouldCollide.  The graph
+    //!          always applies the rule for its built-in filter.  Filters which
+    //!          never accept a pair the default rule rejects may return true to
+    //!          opt in.
+    virtual bool UsesDefaultRule (void) const noexcept { return false; }
 };
 
 class GraphListener
@@ -70,6 +89,13 @@ public:
     virtual void OnPreSolve (Contact*, const collision_manifold&) { }
     virtual void OnPostSolve (Contact*) { }
 
+    //!@{ Sensor overlaps which began or ended since the previous step
+    //! \details Called at most once per step with all events of the step.
+    //!          Events are valid only for the duration of the call.
+    virtual void OnSensorBegin (const sensor_event*, size_t) { }
+    virtual void OnSensorEnd (const sensor_event*, size_t) { }
+    //!@}
+
     //! \brief Triggered during destruction of the parent \ref RigidBody
     virtual void OnDestroyed (Fixture*) { }
 };
@@ -88,6 +114,16 @@ struct time_step
     float ratio = 0.f; //!< Ratio from the last step to the current
 };
 
+//! \struct cast_hit
+//! \brief Result of a ray or shape cast against the graph
+struct cast_hit
+{
+    Fixture* fixture = nullptr; //!< Fixture hit by the cast
+    math::vec2 point;           //!< World hit point (shape casts use the cast shape centroid)
+    math::vec2 normal;          //!< Surface normal of the fixture hit
+    float fraction = 0.f;       //!< Fraction of the cast where the hit occurred
+};
+
 class CollisionGraph
 {
 public:
@@ -104,8 +140,165 @@ public:
     void DisableForceClearing (void) noexcept { m_flags &= ~CLEAR_FORCES; }
     void ClearForces (void) noexcept;
 
+    //! \brief Select the broad phase structures
+    //! \details The default \ref BVHTree adapts to proxies of any size.  The
+    //!          \ref SpatialHashGrid is suited to worlds where most fixtures are
+    //!          about the size of a cell (e.g. tile maps, using the tile size),
+    //!          and provides constant time moves and queries.
+    //! \param [in] static_type Broad phase for static bodies
+    //! \param [in] dynamic_type Broad phase for dynamic and kinematic bodies
+    //! \param [in] cell_size Cell size of a spatial hash grid (in world units)
+    //! \throws rdge::Exception Graph contains bodies
+    void SetBroadPhase (BroadPhaseType static_type,
+                        BroadPhaseType dynamic_type,
+                        const math::vec2& cell_size = math::vec2(1.f, 1.f));
+
+    //!@{ Static broad phase queries use the four-wide SIMD node layout
+    //! \details Only applies to a static \ref BVHTree broad phase.  The
+    //!          dynamic tree stays binary, as proxy moves restructure it every
+    //!          step and the layout would have to be rebuilt each time.
+    //! \see BVHTree::EnableWideLayout
+    void EnableWideBroadPhase (void) noexcept { SetWideBroadPhase(true); }
+    void DisableWideBroadPhase (void) noexcept { SetWideBroadPhase(false); }
+    //!@}
+
+    //!@{ Contact velocity constraints are solved four at a time
+    //! \see Solver::wide_contacts
+    void EnableWideSolver (void) noexcept { m_solver.wide_contacts = true; }
+    void DisableWideSolver (void) noexcept { m_solver.wide_contacts = false; }
+    //!@}
+
+    //!@{ Normal constraints of two point contacts are solved as a block
+    //! \see Solver::block_contacts
+    void EnableBlockSolver (void) noexcept { m_solver.block_contacts = true; }
+    void DisableBlockSolver (void) noexcept { m_solver.block_contacts = false; }
+    //!@}
+
+    //!@{ Constraints are solved with substeps rather than iterations
+    //! \see Solver::soft_step
+    void EnableSoftStep (void) noexcept { m_solver.soft_step = true; }
+    void DisableSoftStep (void) noexcept { m_solver.soft_step = false; }
+    //!@}
+
+    //! \brief Set the number of soft step substeps
+    //! \param [in] count Number of substeps (must be non-zero)
+    void SetSubsteps (size_t count) noexcept;
+
     void Step (float dt);
 
+    //! \brief Advance the simulation by the real elapsed time
+    //! \details Elapsed time is accumulated and consumed by steps of the fixed
+    //!          size (see \ref SetFixedStep), so the simulation rate is independent
+    //!          of the frame rate.  At most \ref max_fixed_steps are performed,
+    //!          and any whole steps beyond the limit are discarded so a slow
+    //!          frame does not cause more work for the following frames.
+    //! \param [in] elapsed Real time elapsed (seconds)
+    //! \returns Number of steps performed
+    size_t Update (float elapsed);
+
+    //!@{ Time step used by \ref Update
+    float GetFixedStep (void) const noexcept { return m_fixedStep; }
+    void SetFixedStep (float dt) noexcept
+    {
+        SDL_assert(dt > 0.f);
+        m_fixedStep = dt;
+        m_accumulator = 0.f;
+    }
+    //!@}
+
+    //! \brief Fraction of a fixed step accumulated but not yet simulated
+    //! \details Used to render bodies in between steps.
+    //! \see RigidBody::GetInterpolatedTransform
+    float GetInterpolationAlpha (void) const noexcept
+    {
+        return (m_fixedStep > 0.f) ? (m_accumulator / m_fixedStep) : 1.f;
+    }
+
+    //! \brief Cast a ray against all fixtures in the graph
+    //! \details The callback controls the ray cast with the return value:
+    //!            - Zero terminates the ray cast
+    //!            - Negative ignores the fixture and continues
+    //!            - Fraction clips the ray to the hit point
+    //!            - One continues without clipping
+    //!          Fixtures are reported in no particular order.
+    //! \note Fixtures created before the first \ref Step are bulk loaded into
+    //!       the broad phase during that step, and will not be reported until then.
+    //! \param [in] p1 Ray origin
+    //! \param [in] p2 Ray end point
+    //! \param [in] fn Callback of type
+    //!             float(Fixture*, const vec2& point, const vec2& normal, float fraction)
+    template <typename Fn>
+    void RayCast (const math::vec2& p1, const math::vec2& p2, Fn&& fn) const;
+
+    //! \brief Find the closest fixture hit by a ray
+    //! \details Sensors are ignored.
+    //! \param [in] p1 Ray origin
+    //! \param [in] p2 Ray end point
+    //! \param [out] hit Closest hit
+    //! \returns True iff a fixture was hit
+    bool RayCastClosest (const math::vec2& p1, const math::vec2& p2, cast_hit& hit) const;
+
+    //! \brief Visit all fixtures whose aabb intersects the provided box
+    //! \details Fixtures are reported in no particular order, and are only
+    //!          culled by their fat aabb in the broad phase.  Sensors are
+    //!          included.  The query does not allocate, so it's suitable for
+    //!          frequent queries (e.g. triggers and AI sensing).
+    //! \note Fixtures created before the first \ref Step are bulk loaded into
+    //!       the broad phase during that step, and will not be reported until then.
+    //! \param [in] box aabb to query in world coordinates
+    //! \param [in] fn Callback of type bool(Fixture*), returning false to
+    //!                terminate the query
+    template <typename Fn>
+    void QueryAABB (const aabb& box, Fn&& fn) const;
+
+    //! \brief Sweep a shape against all fixtures in the graph
+    //! \details The shape is provided in world coordinates and swept along the
+    //!          translation.  Callback behavior is the same as \ref RayCast,
+    //!          where the reported point is the centroid of the cast shape at
+    //!          the time of impact.  Fixtures overlapping the shape at the start
+    //!          are reported with a zero fraction.
+    //! \param [in] shape Shape in world coordinates
+    //! \param [in] translation Translation of the shape
+    //! \param [in] fn Callback of type
+    //!             float(Fixture*, const vec2& point, const vec2& normal, float fraction)
+    template <typename Fn>
+    void ShapeCast (const ishape* shape, const math::vec2& translation, Fn&& fn) const;
+
+    //! \brief Find the closest fixture hit by a swept shape
+    //! \details Sensors are ignored.
+    //! \param [in] shape Shape in world coordinates
+    //! \param [in] translation Translation of the shape
+    //! \param [out] hit Closest hit
+    //! \returns True iff a fixture was hit
+    bool ShapeCastClosest (const ishape* shape, const math::vec2& translation, cast_hit& hit) const;
+
+    //! \brief Capture the simulation state for rollback
+    //! \details Includes body motion and sleep state, the broad phase node pools,
+    //!          contacts with their cached impulses, sensor overlaps, and joint
+    //!          impulses.  The
+    //!          contents of the snapshot are replaced, reusing its buffer.
+    //! \param [out] snapshot Snapshot to write
+    void Snapshot (graph_snapshot& snapshot) const;
+
+    //! \brief Return the simulation to a captured state
+    //! \details State is restored in place, so the broad phase is not rebuilt
+    //!          and no allocations are made for the bodies.  Contacts are
+    //!          recreated without sending listener events.  The graph must
+    //!          contain the same bodies, fixtures, and joints as when the
+    //!          snapshot was taken.
+    //! \param [in] snapshot Snapshot produced by this graph
+    //! \throws rdge::Exception Snapshot does not match the graph
+    void Restore (const graph_snapshot& snapshot);
+
+    //!@{ Number of objects in the graph
+    size_t BodyCount (void) const noexcept { return m_bodies.size(); }
+    size_t ContactCount (void) const noexcept { return m_contacts.size(); }
+    size_t JointCount (void) const noexcept { return m_joints.size(); }
+    size_t AwakeBodyCount (void) const noexcept { return m_awakeBodies.size(); }
+    size_t AwakeContactCount (void) const noexcept { return m_awakeContacts.size(); }
+    size_t SensorOverlapCount (void) const noexcept { return m_sensorOverlaps.size(); }
+    //!@}
+
     bool IsLocked (void) const noexcept { return m_flags & LOCKED; }
 
     bool IsSleepPrevented (void) const noexcept { return m_flags & PREVENT_SLEEP; }
@@ -114,17 +307,90 @@ public:
 
 private:
 
+    friend class Fixture;
     friend class RigidBody;
 
     void CreateContact (fixture_proxy* a, fixture_proxy* b);
     void DestroyContact (Contact* contact);
     void PurgeContacts (void);
 
+    //!@{ Reserve a handle in the dense state storage
+    //! \details Released handles are reused first, so the storage only grows
+    //!          with the peak number of bodies or contacts.
+    int32 ReserveBodyState (void);
+    int32 ReserveContactState (void);
+    //!@}
+
+    //!@{ Sensor overlap set
+    //! \details Pairs with a sensor never reach the solver, so they are kept
+    //!          apart from the contacts and only test if the shapes overlap.
+    //!          Overlaps are swap removed, so the set is unordered.
+    void CreateSensorOverlap (fixture_proxy* a, fixture_proxy* b);
+    void DestroySensorOverlap (size_t index, bool report);
+    void DestroySensorOverlaps (const Fixture* fixture, bool report);
+    void UpdateSensors (void);
+    //!@}
+
+    //!@{ Awake set maintenance
+    //! \details Contacts are awake while either body is awake.  Elements are
+    //!          swap removed, so the sets are unordered.
+    void AddAwakeBody (RigidBody* body);
+    void RemoveAwakeBody (RigidBody* body);
+    void AddAwakeContact (Contact* contact);
+    void RemoveAwakeContact (Contact* contact);
+    //!@}
+
+    //!@{ Island solving
+    void CollectIslands (void);
+    void SolveIslands (void);
+    void ProcessPostSolve (const solver_island& island);
+    //!@}
+
+    //!@{ Continuous collision
+    void SolveTOI (void);
+    void AdvanceBullet (RigidBody* body);
+    //!@}
+
     int32 RegisterProxy (fixture_proxy* proxy);
     void UnregisterProxy (const fixture_proxy* proxy);
     void MoveProxy (const fixture_proxy* proxy, const math::vec2& displacement);
     void TouchProxy (const fixture_proxy* proxy);
 
+    //! \brief Copy the fixture filter to the broad phase, and search for pairs
+    //!        which may have been rejected by the previous filter
+    void RefilterProxy (const fixture_proxy* proxy);
+
+    //! \brief Remove all pairs of the fixture, and search for them again
+    //! \details Used when the fixture moves between the contacts and the
+    //!          sensor overlaps.
+    void RebuildPairs (Fixture* fixture);
+
+    //!@{ Proxy keys are unique across both broad phases
+    //! \details Static proxy handles are stored as their bitwise complement.
+    //!          Keys are used for the dirty list and the pair buffer.
+    int32 GetProxyKey (const fixture_proxy* proxy) const noexcept;
+    fixture_proxy* GetProxy (int32 key) const noexcept;
+    const aabb& GetFatAABB (int32 key) const noexcept;
+    //!@}
+
+    void SetWideBroadPhase (bool enable) noexcept;
+
+    //!@{ Broad phase traversal inlined for the concrete type
+    //! \see BVHTree::QueryLeaves
+    template <typename Fn>
+    static void QueryBroadPhase (const IBroadPhase& broad_phase,
+                                 const aabb& box,
+                                 Fn&& fn,
+                                 const proxy_filter* filter = nullptr);
+
+    //! \see BVHTree::SweepLeaves
+    template <typename Fn>
+    static void SweepBroadPhase (const IBroadPhase& broad_phase,
+                                 const ray_cast_input& input,
+                                 const math::vec2& extension,
+                                 Fn&& fn);
+    //!@}
+
 public:
 
     SmallBlockAllocator block_allocator;    //!< Allocator for all simulation
@@ -132,40 +398,241 @@ public:
     ContactFilter* custom_filter = nullptr; //!< Fixture filtering
     GraphListener* listener = nullptr;      //!< Callback listener
 
+    //! \brief Optional pool used to solve islands concurrently
+    //! \details Results and callback order are identical to solving serially.
+    //!          The pool must outlive its use by the graph.
+    WorkerPool* workers = nullptr;
+
+    size_t max_fixed_steps = 8; //!< Step limit per \ref Update
+
+    //! \brief Timings and counts of the most recent steps
+    GraphStats stats;
+
 private:
 
     friend class rdge::debug::PhysicsWidget;
 
-    BVHTree m_tree;
-    Solver m_solver;
+    std::unique_ptr<IBroadPhase> m_staticBroadPhase;  //!< Broad phase for static bodies
+    std::unique_ptr<IBroadPhase> m_dynamicBroadPhase; //!< Broad phase for dynamic and kinematic bodies
+    math::vec2 m_cellSize = { 1.f, 1.f };             //!< Cell size of spatial hash grids
+    PairBuffer m_pairs;
+    Solver m_solver;                     //!< Solver for worker zero and configuration
+    std::vector<Solver> m_workerSolvers; //!< Solvers for the remaining workers
+
+    std::vector<contact_update> m_contactUpdates; //!< Narrow phase work list
+
+    //!@{ Islands collected every step
+    std::vector<solver_island> m_islands;
+    std::vector<RigidBody*> m_islandBodies;
+    std::vector<solver_contact_ref> m_islandContacts;
+    std::vector<solver_joint_data> m_islandJoints;
+    std::vector<RigidBody*> m_islandStack;
+    //!@}
 
     std::vector<int32> m_dirtyProxies;
     intrusive_list<RigidBody> m_bodies;
     intrusive_list<Contact> m_contacts;
     intrusive_list<BaseJoint> m_joints;
 
+    //!@{ Hot per-step state of bodies and contacts
+    //! \details Addressed by the handle each object holds, which is stable for
+    //!          the lifetime of the object.  Released handles are kept in the
+    //!          free lists.
+    std::vector<body_state> m_bodyStates;
+    std::vector<contact_state> m_contactStates;
+    std::vector<int32> m_freeBodyStates;
+    std::vector<int32> m_freeContactStates;
+    //!@}
+
+    //!@{ Bodies and contacts visited during a step
+    //! \details Sleeping bodies, and contacts between bodies which are not
+    //!          awake, are left out so the cost of a step scales with the number
+    //!          of awake bodies rather than the size of the graph.
+    std::vector<RigidBody*> m_awakeBodies;
+    std::vector<awake_contact> m_awakeContacts;
+    //!@}
+
+    //!@{ Sensor overlap set
+    std::vector<sensor_overlap> m_sensorOverlaps;
+    std::unordered_map<uint64, uint32> m_sensorLookup; //!< Overlap index by proxy key pair
+    std::vector<sensor_event> m_sensorBegin;           //!< Events not yet reported
+    std::vector<sensor_event> m_sensorEnd;             //!< Events not yet reported
+    std::vector<Fixture*> m_sensorRefiltered;          //!< Flagged clean after the contact purge
+    //!@}
+
     time_step m_step;
+    step_stats m_current; //!< Metrics of the step in progress
+
+    float m_fixedStep = 0.f;   //!< Time step used by \ref Update
+    float m_accumulator = 0.f; //!< Elapsed time not yet simulated
 
     enum StateFlags
     {
         LOCKED        = 0x0001,
         CLEAR_FORCES  = 0x0002,
-        PREVENT_SLEEP = 0x0004
+        PREVENT_SLEEP = 0x0004,
+        STEPPED       = 0x0008, //!< Proxies are no longer bulk loaded
+        WIDE_BROAD    = 0x0010, //!< Static BVH broad phase uses the wide layout
+        FILTER_DIRTY  = 0x0020  //!< An awake contact may have a dirty filter
     };
 
     uint16 m_flags = 0;
+};
 
-#ifdef RDGE_DEBUG_PROFILING
-public:
-    struct profiler
+template <typename Fn>
+inline void
+CollisionGraph::QueryBroadPhase (const IBroadPhase& broad_phase,
+                                 const aabb& box,
+                                 Fn&& fn,
+                                 const proxy_filter* filter)
+{
+    if (broad_phase.Type() == BroadPhaseType::BVH)
     {
-        int64_t create_contacts = 0;
-        int64_t purge_contacts = 0;
-        int64_t solve = 0;
-        int64_t synchronize = 0;
-    } debug_profile;
-#endif
-};
+        static_cast<const BVHTree&>(broad_phase).QueryLeaves(box, fn, filter);
+    }
+    else
+    {
+        static_cast<const SpatialHashGrid&>(broad_phase).QueryCells(box, fn, filter);
+    }
+}
+
+template <typename Fn>
+inline void
+CollisionGraph::SweepBroadPhase (const IBroadPhase& broad_phase,
+                                 const ray_cast_input& input,
+                                 const math::vec2& extension,
+                                 Fn&& fn)
+{
+    if (broad_phase.Type() == BroadPhaseType::BVH)
+    {
+        static_cast<const BVHTree&>(broad_phase).SweepLeaves(input, extension, fn);
+    }
+    else
+    {
+        static_cast<const SpatialHashGrid&>(broad_phase).SweepCells(input, extension, fn);
+    }
+}
+
+template <typename Fn>
+inline void
+CollisionGraph::QueryAABB (const aabb& box, Fn&& fn) const
+{
+    bool terminated = false;
+    auto visit = [&](const IBroadPhase& broad_phase, int32 handle) {
+        auto proxy = static_cast<fixture_proxy*>(broad_phase.GetUserData(handle));
+        terminated = !fn(proxy->fixture);
+        return !terminated;
+    };
+
+    QueryBroadPhase(*m_staticBroadPhase, box, [&](int32 handle) {
+        return visit(*m_staticBroadPhase, handle);
+    });
+
+    if (!terminated)
+    {
+        QueryBroadPhase(*m_dynamicBroadPhase, box, [&](int32 handle) {
+            return visit(*m_dynamicBroadPhase, handle);
+        });
+    }
+}
+
+template <typename Fn>
+inline void
+CollisionGraph::RayCast (const math::vec2& p1, const math::vec2& p2, Fn&& fn) const
+{
+    ray_cast_input input = { p1, p2, 1.f };
+    bool terminated = false;
+
+    // clipping and termination carry over from the static to the dynamic tree
+    auto visit = [&](const IBroadPhase& broad_phase, const ray_cast_input& sub_input, int32 handle) {
+        auto proxy = static_cast<fixture_proxy*>(broad_phase.GetUserData(handle));
+        Fixture* fixture = proxy->fixture;
+
+        ray_cast_output output;
+        if (!fixture->shape.world->ray_cast(sub_input, output))
+        {
+            return sub_input.max_fraction;
+        }
+
+        math::vec2 point = sub_input.p1 + ((sub_input.p2 - sub_input.p1) * output.fraction);
+        float value = fn(fixture, point, output.normal, output.fraction);
+        if (value == 0.f)
+        {
+            terminated = true;
+        }
+        else if (value > 0.f)
+        {
+            input.max_fraction = value;
+        }
+
+        return value;
+    };
+
+    math::vec2 extension(0.f, 0.f);
+    SweepBroadPhase(*m_staticBroadPhase, input, extension,
+                    [&](const ray_cast_input& sub_input, int32 handle) {
+        return visit(*m_staticBroadPhase, sub_input, handle);
+    });
+
+    if (!terminated)
+    {
+        SweepBroadPhase(*m_dynamicBroadPhase, input, extension,
+                        [&](const ray_cast_input& sub_input, int32 handle) {
+            return visit(*m_dynamicBroadPhase, sub_input, handle);
+        });
+    }
+}
+
+template <typename Fn>
+inline void
+CollisionGraph::ShapeCast (const ishape* shape, const math::vec2& translation, Fn&& fn) const
+{
+    math::vec2 centroid = shape->get_centroid();
+    aabb box = shape->compute_aabb();
+    float max_fraction = 1.f;
+    bool terminated = false;
+
+    auto visit = [&](const IBroadPhase& broad_phase, const ray_cast_input& sub_input, int32 handle) {
+        auto proxy = static_cast<fixture_proxy*>(broad_phase.GetUserData(handle));
+        Fixture* fixture = proxy->fixture;
+
+        ray_cast_output output;
+        if (!shape_cast(shape, translation, fixture->shape.world, sub_input.max_fraction, output))
+        {
+            return sub_input.max_fraction;
+        }
+
+        math::vec2 point = centroid + (translation * output.fraction);
+        float value = fn(fixture, point, output.normal, output.fraction);
+        if (value == 0.f)
+        {
+            terminated = true;
+        }
+        else if (value > 0.f)
+        {
+            max_fraction = value;
+        }
+
+        return value;
+    };
+
+    // the box center is swept, extended by the box half extent
+    math::vec2 center = box.centroid();
+    ray_cast_input input = { center, center + translation, max_fraction };
+    SweepBroadPhase(*m_staticBroadPhase, input, box.half_extent(),
+                    [&](const ray_cast_input& sub_input, int32 handle) {
+        return visit(*m_staticBroadPhase, sub_input, handle);
+    });
+
+    if (!terminated)
+    {
+        input.max_fraction = max_fraction;
+        SweepBroadPhase(*m_dynamicBroadPhase, input, box.half_extent(),
+                        [&](const ray_cast_input& sub_input, int32 handle) {
+            return visit(*m_dynamicBroadPhase, sub_input, handle);
+        });
+    }
+}
 
 } // namespace physics
 } // namespace rdge
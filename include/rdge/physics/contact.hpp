@@ -9,6 +9,10 @@
 #include <rdge/physics/collision.hpp>
 #include <rdge/util/containers/intrusive_list.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 //! \namespace rdge Rainbow Drop Game Engine
 namespace rdge {
 
@@ -27,6 +31,18 @@ class RigidBody;
 class Fixture;
 //!@}
 
+//!@{ Combined surface properties of two fixtures in contact
+inline float mix_friction (float a, float b)
+{
+    return std::sqrt(a * b);
+}
+
+constexpr float mix_restitution (float a, float b)
+{
+    return std::max(a, b);
+}
+//!@}
+
 //! \struct contact_edge
 //! \brief Represents contact between two bodies
 //! \details The bodies which have fixtures in contact represent nodes in a
@@ -38,6 +54,66 @@ struct contact_edge : public intrusive_list_element<contact_edge>
     Contact* contact = nullptr; //!< Contact connecting the bodies
 };
 
+//! \struct contact_update
+//! \brief Contact state recorded prior to narrow phase evaluation
+//! \details Gathered serially for all contacts requiring evaluation, which
+//!          allows the evaluation itself to be performed concurrently.
+struct contact_update
+{
+    Contact* contact = nullptr;      //!< Contact to evaluate
+    collision_manifold old_manifold; //!< Manifold from the previous step
+    bool was_touching = false;       //!< Touching state from the previous step
+};
+
+//! \struct contact_state
+//! \brief Contact data read and written every step
+//! \details Stored densely by the graph and addressed by a stable handle, so
+//!          the purge, narrow phase and solver don't pull the rest of the
+//!          contact into cache.
+struct contact_state
+{
+    Fixture* fixture_a = nullptr; //!< Fixture a (see \ref Contact::GetFixtureA)
+    Fixture* fixture_b = nullptr; //!< Fixture b (see \ref Contact::GetFixtureB)
+    collision_manifold manifold;  //!< Manifold from the last evaluation
+    uint16 flags = 0;             //!< Contact state flags
+};
+
+//! \struct awake_contact
+//! \brief Cache-friendly contact data visited every step
+//! \details Stored densely in the graph awake set.  Proxy keys never change
+//!          during the lifetime of a contact, so the broad phase overlap test
+//!          performed for every awake contact doesn't dereference the contact
+//!          or its fixtures.
+struct awake_contact
+{
+    Contact* contact = nullptr; //!< Remaining contact data
+    int32 state = -1;           //!< Handle of the contact state
+    int32 key_a = 0;            //!< Proxy key of fixture a
+    int32 key_b = 0;            //!< Proxy key of fixture b
+};
+
+//! \struct sensor_overlap
+//! \brief Pair of fixtures where at least one is a sensor
+//! \details Sensors don't generate a collision response, so rather than a
+//!          \ref Contact the pair only tracks whether the shapes overlap.
+//!          Stored densely in the graph sensor set.
+struct sensor_overlap
+{
+    Fixture* sensor = nullptr;  //!< Sensor fixture
+    Fixture* visitor = nullptr; //!< Fixture overlapping the sensor (may also be a sensor)
+    int32 key_sensor = 0;       //!< Proxy key of the sensor
+    int32 key_visitor = 0;      //!< Proxy key of the visitor
+    bool touching = false;      //!< Shapes overlapped during the last update
+};
+
+//! \struct sensor_event
+//! \brief Sensor overlap which began or ended during a step
+struct sensor_event
+{
+    Fixture* sensor = nullptr;  //!< Sensor fixture
+    Fixture* visitor = nullptr; //!< Fixture entering or leaving the sensor
+};
+
 class Contact : public intrusive_list_element<Contact>
 {
 public:
@@ -48,15 +124,17 @@ public:
     Contact& operator= (Contact&&) = delete;
     //!@}
 
-    bool IsTouching (void) const noexcept { return m_flags & TOUCHING; }
-    bool IsEnabled (void) const noexcept { return m_flags & ENABLED; }
-    bool HasSensor (void) const noexcept { return m_flags & HAS_SENSOR; }
+    bool IsTouching (void) const noexcept { return State().flags & TOUCHING; }
+    bool IsEnabled (void) const noexcept { return State().flags & ENABLED; }
 
     //!@{ \ref Fixture nodes linked by this contact
-    Fixture* fixture_a = nullptr;
-    Fixture* fixture_b = nullptr;
+    Fixture* GetFixtureA (void) const noexcept { return State().fixture_a; }
+    Fixture* GetFixtureB (void) const noexcept { return State().fixture_b; }
     //!@}
 
+    //! \brief Manifold generated by the last narrow phase evaluation
+    const collision_manifold& GetManifold (void) const noexcept { return State().manifold; }
+
     //!@{ Pointers to edges stored by each \ref RigidBody
     contact_edge edge_a;
     contact_edge edge_b;
@@ -66,7 +144,6 @@ public:
     float restitution = 0.f;
     float tangent_speed = 0.f;
 
-    collision_manifold manifold;
     contact_impulse impulse;
 
 private:
@@ -75,23 +152,44 @@ private:
     friend class Solver;
     friend class rdge::SmallBlockAllocator;
 
-    explicit Contact (Fixture* a, Fixture* b);
+    //! \brief Contact ctor
+    //! \param [in] a Fixture a
+    //! \param [in] b Fixture b
+    //! \param [in] states Dense state storage of the graph
+    //! \param [in] state Reserved handle of the contact state
+    explicit Contact (Fixture* a, Fixture* b, std::vector<contact_state>* states, int32 state);
     ~Contact (void) noexcept = default;
 
+    //!@{ Per-step state stored by the graph
+    contact_state& State (void) noexcept { return (*m_states)[static_cast<size_t>(m_state)]; }
+    const contact_state& State (void) const noexcept { return (*m_states)[static_cast<size_t>(m_state)]; }
+    //!@}
+
     //! \brief Narrow phase contact evaluation
     //! \details Performs narrow phase intersection tests and manifold generation.
-    //!          Responsible for sending contact listener events during state changes.
-    void Update (GraphListener* listener);
+    //!          Impulses from the previous step are carried over to the contact
+    //!          points with matching features.  Only the contact is modified, so
+    //!          separate contacts may be evaluated concurrently.
+    //! \param [in] update Contact state prior to the evaluation
+    void Evaluate (const contact_update& update);
+
+    //! \brief Apply the result of the narrow phase evaluation
+    //! \details Wakes the bodies and sends contact listener events during state
+    //!          changes.  Must be called serially after \ref Evaluate.
+    //! \param [in] update Contact state prior to the evaluation
+    //! \param [in] listener Optional contact listener
+    void Commit (const contact_update& update, GraphListener* listener);
 
     enum StateFlags
     {
-        ENABLED    = 0x0001,
-        TOUCHING   = 0x0002,
-        HAS_SENSOR = 0x0004,
-        ON_ISLAND  = 0x0008
+        ENABLED   = 0x0001,
+        TOUCHING  = 0x0002,
+        ON_ISLAND = 0x0004
     };
 
-    uint16 m_flags = 0;
+    std::vector<contact_state>* m_states = nullptr; //!< Dense state storage of the graph
+    int32 m_state = -1;                            //!< Handle of the contact state
+    int32 m_awakeIndex = -1;                       //!< Index in the graph awake set
 };
 
 } // namespace physics
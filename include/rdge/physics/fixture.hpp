@@ -17,6 +17,7 @@
 namespace rdge {
 namespace physics {
 
+class CollisionGraph;
 class RigidBody;
 class Fixture;
 
@@ -78,30 +79,23 @@ public:
         m_flags &= ~FILTER_DIRTY;
     }
 
-    void FlagFilterDirty (void) noexcept
-    {
-        m_flags |= FILTER_DIRTY;
-    }
+    //! \brief Flag contacts of the fixture to be filtered on the next step
+    void FlagFilterDirty (void) noexcept;
 
-    void SetFilter (const collision_filter& f)
-    {
-        this->filter = f;
-        m_flags |= FILTER_DIRTY;
-    }
+    //! \brief Replace the collision filter
+    //! \details Existing contacts are filtered on the next step, and the broad
+    //!          phase is searched for pairs the previous filter rejected.
+    void SetFilter (const collision_filter& f);
 
-    void Refilter (void)
-    {
-        throw "not yet implemented";
-        // Box2D:
-        // 1) for each contact list in the body
-        // 2) if the contact fixture is this, set the contact's filter flag
-        // 3) have the broad phase "touch" each proxy
-        //
-        // NOTE: 1 & 2 are not needed because of adding the DIRTY_FILTER flag.
-        //       Still need to implement a better solution for point 3.
-    }
+    //! \brief Filter the fixture again on the next step
+    //! \details Required after changing the rules of a custom \ref ContactFilter.
+    void Refilter (void);
 
-    void SetSensor (bool value) noexcept;
+    //! \brief Change if the fixture generates a collision response
+    //! \details Existing pairs are removed, ending any sensor overlaps, and
+    //!          found again by the next step.
+    //! \warning Function is locked during simulation
+    void SetSensor (bool value);
     bool IsSensor (void) const noexcept { return m_flags & SENSOR; }
 
     mass_data ComputeMass (void) const noexcept
@@ -138,6 +132,7 @@ public:
     color wireframe; //!< Debug wireframe color
 
 private:
+    friend class CollisionGraph;
     friend class RigidBody;
     friend class rdge::SmallBlockAllocator;
 
@@ -0,0 +1,102 @@
+//! \headerfile <rdge/physics/graph_stats.hpp>
+//! \author Josh Bramlett
+//! \version 0.0.11
+//! \date 10/16/2026
+
+#pragma once
+
+#include <rdge/core.hpp>
+
+#include <SDL_assert.h>
+
+//! \namespace rdge Rainbow Drop Game Engine
+namespace rdge {
+namespace physics {
+
+//! \struct step_stats
+//! \brief Metrics recorded for a single \ref CollisionGraph::Step
+//! \details Counts include changes made to the graph since the previous step
+//!          (e.g. contacts destroyed along with a body).
+struct step_stats
+{
+    //!@{ Phase timings (microseconds)
+    int64 create_contacts = 0;
+    int64 purge_contacts = 0;
+    int64 update_sensors = 0;
+    int64 solve = 0;
+    int64 synchronize = 0;
+    int64 solve_toi = 0;
+    int64 total = 0;
+    //!@}
+
+    //!@{ Counts
+    uint32 proxies_moved = 0;       //!< Proxies queried against the broad phase
+    uint32 pairs_tested = 0;        //!< Unique pairs found by the broad phase
+    uint32 contacts_created = 0;
+    uint32 contacts_destroyed = 0;
+    uint32 islands = 0;
+    uint32 bodies_awake = 0;        //!< Non-static bodies solved in an island
+    uint32 velocity_iterations = 0; //!< Velocity iterations summed over islands
+    uint32 position_iterations = 0; //!< Position iterations summed over islands
+    //!@}
+};
+
+//! \struct stat_summary
+//! \brief Distribution of a single metric over the recorded steps
+struct stat_summary
+{
+    double min = 0.0;
+    double avg = 0.0;
+    double max = 0.0;
+    double p99 = 0.0; //!< 99th percentile (nearest rank)
+};
+
+//! \class GraphStats
+//! \brief Ring buffer of metrics for the most recent steps
+//! \details Recording is a fixed size copy, so it is always enabled.  Once the
+//!          buffer is full the oldest step is overwritten.
+class GraphStats
+{
+public:
+    //! \var Number of steps retained
+    static constexpr size_t HISTORY_SIZE = 128;
+
+    //! \brief Add the metrics of a step, overwriting the oldest if full
+    void Record (const step_stats& stats) noexcept;
+
+    //! \brief Remove all recorded steps
+    void Clear (void) noexcept;
+
+    bool Empty (void) const noexcept { return (m_count == 0); }
+    size_t Size (void) const noexcept { return m_count; }
+
+    //! \returns Metrics of the most recent step
+    const step_stats& Last (void) const noexcept
+    {
+        SDL_assert(m_count > 0);
+        return (*this)[m_count - 1];
+    }
+
+    //! \brief Access recorded steps from oldest to newest
+    const step_stats& operator[] (size_t index) const noexcept
+    {
+        SDL_assert(index < m_count);
+        return m_history[(m_head + index) % HISTORY_SIZE];
+    }
+
+    //!@{
+    //! \brief Summarize a metric over all recorded steps
+    //! \param [in] field Metric to summarize (e.g. &step_stats::solve)
+    //! \returns Zeroed summary if no steps are recorded
+    stat_summary Summarize (int64 step_stats::* field) const noexcept;
+    stat_summary Summarize (uint32 step_stats::* field) const noexcept;
+    //!@}
+
+private:
+    step_stats m_history[HISTORY_SIZE];
+    size_t m_head = 0;  //!< Index of the oldest step
+    size_t m_count = 0;
+};
+
+} // namespace physics
+} // namespace rdge
@@ -24,7 +24,10 @@ class CollisionGraph;
 class Solver;
 class RigidBody;
 struct time_step;
+struct snapshot_writer;
+struct snapshot_reader;
 struct solver_body_data;
+struct soft_step_data;
 //!@}
 
 //! \enum JointType
@@ -106,6 +109,28 @@ protected:
     virtual bool SolvePositionConstraints (solver_body_data& bdata_a,
                                            solver_body_data& bdata_b) = 0;
 
+    //!@{
+    //! \brief Soft step solver (see \ref Solver::soft_step)
+    //! \details Accumulated impulses are per substep, and warm starting is
+    //!          applied every substep.  Solving without bias relaxes the
+    //!          constraint, and returns true iff the error is within tolerance.
+    virtual void InitializeSoftSolver (const time_step&  step,
+                                       solver_body_data& bdata_a,
+                                       solver_body_data& bdata_b) = 0;
+    virtual void WarmStartSoft (solver_body_data& bdata_a,
+                                solver_body_data& bdata_b) = 0;
+    virtual bool SolveSoftConstraints (const soft_step_data& soft,
+                                       bool                  use_bias,
+                                       solver_body_data&     bdata_a,
+                                       solver_body_data&     bdata_b) = 0;
+    //!@}
+
+    //!@{
+    //! \brief Solver state and properties for \ref CollisionGraph::Snapshot
+    virtual void SaveState (snapshot_writer& writer) const = 0;
+    virtual void RestoreState (snapshot_reader& reader) = 0;
+    //!@}
+
     enum BaseStateFlags
     {
         BODIES_COLLIDABLE = 0x0001,
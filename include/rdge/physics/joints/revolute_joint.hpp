@@ -25,6 +25,7 @@ class CollisionGraph;
 class Solver;
 struct time_step;
 struct solver_body_data;
+struct soft_step_data;
 //!@}
 
 //! \class RevoluteJoint
@@ -85,6 +86,19 @@ private:
     bool SolvePositionConstraints (solver_body_data& bdata_a,
                                    solver_body_data& bdata_b) override;
 
+    void InitializeSoftSolver (const time_step&  step,
+                               solver_body_data& bdata_a,
+                               solver_body_data& bdata_b) override;
+    void WarmStartSoft (solver_body_data& bdata_a,
+                        solver_body_data& bdata_b) override;
+    bool SolveSoftConstraints (const soft_step_data& soft,
+                               bool                  use_bias,
+                               solver_body_data&     bdata_a,
+                               solver_body_data&     bdata_b) override;
+
+    void SaveState (snapshot_writer& writer) const override;
+    void RestoreState (snapshot_reader& reader) override;
+
     math::vec2 m_anchor[2];          //!< Anchors local to the respective bodies
     math::mat3 m_mass;               //!< Effective mass for point-to-point constraint
 	float      m_referenceAngle = 0.f;
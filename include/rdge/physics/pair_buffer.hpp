@@ -0,0 +1,98 @@
+//! \headerfile <rdge/physics/pair_buffer.hpp>
+//! \author Josh Bramlett
+//! \version 0.0.11
+//! \date 10/16/2026
+
+#pragma once
+
+#include <rdge/core.hpp>
+
+#include <SDL_assert.h>
+
+//! \namespace rdge Rainbow Drop Game Engine
+namespace rdge {
+namespace physics {
+
+//! \struct proxy_pair
+//! \brief Pair of broad phase proxy handles
+//! \details Handles are ordered so (handle_a < handle_b).
+struct proxy_pair
+{
+    int32 handle_a;
+    int32 handle_b;
+};
+
+//! \class PairBuffer
+//! \brief Set of unique proxy pairs found by the broad phase
+//! \details Pairs are deduplicated on insertion using an open addressing hash
+//!          table, and are stored contiguously in insertion order so iteration
+//!          is deterministic.  Memory is retained between steps, so once the
+//!          buffer has grown to the working set no further allocations occur.
+class PairBuffer
+{
+public:
+    //! \brief PairBuffer ctor
+    //! \param [in] capacity Initial number of pairs to allocate
+    //! \throws rdge::Exception Memory allocation failed
+    explicit PairBuffer (size_t capacity = 128);
+
+    //! \brief PairBuffer dtor
+    ~PairBuffer (void) noexcept;
+
+    //!@{
+    //! \brief Non-copyable and non-movable
+    PairBuffer (const PairBuffer&) = delete;
+    PairBuffer& operator= (const PairBuffer&) = delete;
+    PairBuffer (PairBuffer&&) = delete;
+    PairBuffer& operator= (PairBuffer&&) = delete;
+    //!@}
+
+    //! \brief Add a pair of handles to the set
+    //! \details Order of the handles does not matter.
+    //! \param [in] a First proxy handle
+    //! \param [in] b Second proxy handle
+    //! \returns True iff the pair was added (i.e. not a duplicate)
+    bool Insert (int32 a, int32 b);
+
+    //! \returns True iff the pair exists in the set
+    bool Contains (int32 a, int32 b) const noexcept;
+
+    //! \brief Remove all pairs
+    //! \details Only the hash slots that were used are reset, so the cost is
+    //!          proportional to the number of pairs rather than the capacity.
+    void Clear (void) noexcept;
+
+    bool Empty (void) const noexcept { return (m_count == 0); }
+    size_t Size (void) const noexcept { return m_count; }
+
+    //!@{ Pair iteration (insertion order)
+    const proxy_pair* begin (void) const noexcept { return m_pairs; }
+    const proxy_pair* end (void) const noexcept { return m_pairs + m_count; }
+
+    const proxy_pair& operator[] (size_t index) const noexcept
+    {
+        SDL_assert(index < m_count);
+        return m_pairs[index];
+    }
+    //!@}
+
+private:
+    //! \brief Find the slot containing the key, or the empty slot to insert it
+    size_t FindSlot (uint64 key) const noexcept;
+
+    //! \brief Double the capacity and rehash all pairs
+    void Grow (void);
+
+    static constexpr int32 EMPTY_SLOT = -1;
+
+    proxy_pair* m_pairs = nullptr; //!< Pairs in insertion order
+    uint32* m_pairSlots = nullptr; //!< Hash slot of each pair
+    size_t m_count = 0;            //!< Number of pairs
+    size_t m_capacity = 0;         //!< Max pairs before growing
+
+    int32* m_table = nullptr;      //!< Hash slots containing the pair index
+    size_t m_tableSize = 0;        //!< Number of slots (power of two)
+};
+
+} // namespace physics
+} // namespace rdge
@@ -0,0 +1,132 @@
+//! \headerfile <rdge/physics/query_batch.hpp>
+//! \author Josh Bramlett
+//! \version 0.0.11
+//! \date 10/16/2026
+
+#pragma once
+
+#include <rdge/core.hpp>
+#include <rdge/physics/aabb.hpp>
+
+#include <SDL_assert.h>
+
+#include <vector>
+
+//! \namespace rdge Rainbow Drop Game Engine
+namespace rdge {
+namespace physics {
+
+//! \class QueryBatch
+//! \brief Set of aabb queries resolved with a single tree traversal
+//! \details Boxes are added to the batch and then resolved by
+//!          \ref BVHTree::Query, which walks the tree once for a group of
+//!          queries rather than once per query.  Queries are grouped by sorting
+//!          the box centers along a Morton curve, so each group covers a
+//!          compact region and shares most of its traversal.  Results are
+//!          stored in a flat buffer indexed by the query offsets, in the order
+//!          the queries were added.
+//!
+//!          Memory is retained between frames, so once the batch has grown to
+//!          the working set no further allocations occur.
+class QueryBatch
+{
+public:
+    //! \brief Number of queries traversed together
+    //! \details Also the unit of work handed to each worker.
+    static constexpr uint32 CHUNK_SIZE = 32;
+
+    //! \brief Remove all queries and results
+    void Clear (void) noexcept;
+
+    //! \brief Add a query box
+    //! \details Results of previous resolves are invalidated.
+    //! \param [in] box aabb to query
+    //! \returns Index of the query
+    uint32 Add (const aabb& box);
+
+    //! \returns Number of queries
+    size_t Size (void) const noexcept { return m_boxes.size(); }
+
+    //! \returns Query boxes
+    const aabb* Boxes (void) const noexcept { return m_boxes.data(); }
+
+    //!@{ Proxy handles intersecting the query, in traversal order
+    const int32* begin (uint32 query) const noexcept
+    {
+        SDL_assert(query + 1 < m_offsets.size());
+        return m_handles.data() + m_offsets[query];
+    }
+
+    const int32* end (uint32 query) const noexcept
+    {
+        SDL_assert(query + 1 < m_offsets.size());
+        return m_handles.data() + m_offsets[query + 1];
+    }
+
+    size_t Count (uint32 query) const noexcept
+    {
+        return static_cast<size_t>(end(query) - begin(query));
+    }
+    //!@}
+
+    //!@{ Flat result buffer, where the handles of query n are in the range
+    //!   [offsets[n], offsets[n + 1])
+    const std::vector<uint32>& Offsets (void) const noexcept { return m_offsets; }
+    const std::vector<int32>& Handles (void) const noexcept { return m_handles; }
+    //!@}
+
+private:
+    friend class BVHTree;
+
+    //! \brief Intersection found for a query
+    struct query_hit
+    {
+        uint32 query;
+        int32 handle;
+    };
+
+    //! \brief Query still active at a node
+    //! \details Box is copied so the active list is tested sequentially.
+    struct active_query
+    {
+        aabb box;
+        uint32 query;
+    };
+
+    //! \brief Traversal stack entry
+    //! \details Queries still active at the node are the range of the active
+    //!          list, which is shared by siblings.
+    struct batch_entry
+    {
+        int32 node;
+        uint32 active_begin;
+        uint32 active_end;
+        aabb bounds; //!< Union of the active query boxes (binary layout only)
+    };
+
+    //! \brief Per-worker traversal state
+    struct worker_scratch
+    {
+        std::vector<batch_entry> stack;
+        std::vector<active_query> active;
+        std::vector<uint8> masks;
+        std::vector<query_hit> hits;
+    };
+
+    //! \brief Sort the queries into groups and prepare the scratch
+    //! \param [in] worker_count Number of workers traversing the tree
+    void Begin (size_t worker_count);
+
+    //! \brief Gather the hits of all workers into the flat result buffer
+    void Finish (void);
+
+    std::vector<aabb> m_boxes;
+    std::vector<uint64> m_order; //!< Morton code (high) and query (low), sorted
+    std::vector<uint32> m_offsets = { 0 };
+    std::vector<int32> m_handles;
+
+    std::vector<worker_scratch> m_scratch;
+};
+
+} // namespace physics
+} // namespace rdge
@@ -14,6 +14,8 @@
 #include <rdge/physics/joints/base_joint.hpp>
 #include <rdge/util/containers/intrusive_list.hpp>
 
+#include <vector>
+
 //! \namespace rdge Rainbow Drop Game Engine
 namespace rdge {
 
@@ -42,7 +44,7 @@ struct sweep_step
     //! \brief Calculate the interpolated transform for a given time
     //! \param [in] beta Normalized time fraction, where 0 indicates alpha_0
     //! \returns Interpolated transform
-    iso_transform lerp_transform (float beta) noexcept
+    iso_transform lerp_transform (float beta) const noexcept
     {
         SDL_assert(0.f <= beta && beta <= 1.f);
 
@@ -75,6 +77,18 @@ struct sweep_step
     }
 };
 
+//! \struct body_state
+//! \brief Body state read and written every step
+//! \details Stored densely by the graph and addressed by a stable handle, so
+//!          the solver and fixture synchronization don't pull the rest of the
+//!          body into cache.
+struct body_state
+{
+    sweep_step sweep;              //!< Center of mass motion over the step
+    math::vec2 linear_velocity;    //!< Linear velocity of the center of mass
+    float angular_velocity = 0.f;  //!< Angular velocity
+};
+
 //! \enum RigidBodyType
 //! \brief Defines how a body acts during simulation
 enum class RigidBodyType : uint8
@@ -122,6 +136,7 @@ struct rigid_body_profile
     bool awake = true;             //!< Body is initially awake
     bool prevent_rotation = false; //!< Prevent rotation
     bool prevent_sleep = false;    //!< Keep body awake
+    bool bullet = false;           //!< Continuous collision (see \ref RigidBody::IsBullet)
     //!@}
 };
 
@@ -149,6 +164,23 @@ public:
     //! \warning Function is locked during simulation
     Fixture* CreateFixture (ishape* shape, float density);
 
+    //! \brief Create a chain of one sided edge fixtures
+    //! \details Each segment becomes an \ref edge fixture whose ghost vertices
+    //!          are the neighboring vertices of the chain, so shapes slide
+    //!          across the segment joints without catching.  Open chains use
+    //!          the extension of the end segments as the ghost vertices.
+    //! \param [in] vertices Chain vertices in local space (loops wound CCW to
+    //!                      collide on the outside)
+    //! \param [in] count Number of vertices
+    //! \param [in] loop Connect the last vertex to the first
+    //! \param [in] profile Profile of each fixture (the shape is ignored)
+    //! \returns Number of fixtures created
+    //! \warning Function is locked during simulation
+    size_t CreateChain (const math::vec2* vertices,
+                        size_t count,
+                        bool loop,
+                        const fixture_profile& profile = fixture_profile());
+
     //! \brief Destroy an attached fixture
     //! \details If the body is simulating contacts associated with the fixture
     //!          are destroyed.  Mass data is automatically re-calculated.
@@ -158,7 +190,8 @@ public:
 
     math::vec2 GetLinearVelocityFromWorldPoint (const math::vec2& point)
     {
-        return linear.velocity + ((point - sweep.pos_n).perp() * angular.velocity);
+        const auto& state = State();
+        return state.linear_velocity + ((point - state.sweep.pos_n).perp() * state.angular_velocity);
     }
 
     //! \brief Apply a force at a world point
@@ -181,7 +214,7 @@ public:
         if (m_flags & AWAKE)
         {
             linear.force += force;
-            angular.torque += math::perp_dot(point - sweep.pos_n, force);
+            angular.torque += math::perp_dot(point - State().sweep.pos_n, force);
         }
     }
 
@@ -246,8 +279,9 @@ public:
 
         if (m_flags & AWAKE)
         {
-            linear.velocity += impulse * linear.inv_mass;
-            angular.velocity += math::perp_dot(point - sweep.pos_n, impulse) * angular.inv_mmoi;
+            auto& state = State();
+            state.linear_velocity += impulse * linear.inv_mass;
+            state.angular_velocity += math::perp_dot(point - state.sweep.pos_n, impulse) * angular.inv_mmoi;
         }
     }
 
@@ -268,7 +302,7 @@ public:
 
         if (m_flags & AWAKE)
         {
-            linear.velocity += impulse * linear.inv_mass;
+            State().linear_velocity += impulse * linear.inv_mass;
         }
     }
 
@@ -288,13 +322,19 @@ public:
 
         if (m_flags & AWAKE)
         {
-            angular.velocity += impulse * angular.inv_mmoi;
+            State().angular_velocity += impulse * angular.inv_mmoi;
         }
     }
 
+    //!@{ Velocity of the center of mass
+    //! \details Setting the velocity does not wake the body.
+    math::vec2 GetLinearVelocity (void) const noexcept { return State().linear_velocity; }
+    void SetLinearVelocity (const math::vec2& velocity) noexcept { State().linear_velocity = velocity; }
+    float GetAngularVelocity (void) const noexcept { return State().angular_velocity; }
+    void SetAngularVelocity (float velocity) noexcept { State().angular_velocity = velocity; }
+    //!@}
+
     //void SetTransform(const b2Vec2& position, float32 angle);
-    //void SetLinearVelocity(const b2Vec2& v);
-    //void SetAngularVelocity(float32 omega);
 
     //b2Vec2 GetWorldPoint(const b2Vec2& localPoint) const;
     //b2Vec2 GetWorldVector(const b2Vec2& localVector) const;
@@ -319,12 +359,12 @@ public:
 
     // world position of the body origin
     math::vec2 GetPosition (void) const noexcept { return world_transform.pos; }
-    float GetAngle (void) const noexcept { return sweep.angle_n; }
+    float GetAngle (void) const noexcept { return State().sweep.angle_n; }
     void SetPosition (math::vec2 pos);
 
     // world position of the body center of mass
-    math::vec2 GetWorldCenter (void) const noexcept { return sweep.pos_n; }
-    math::vec2 GetLocalCenter (void) const noexcept { return sweep.local_center; }
+    math::vec2 GetWorldCenter (void) const noexcept { return State().sweep.pos_n; }
+    math::vec2 GetLocalCenter (void) const noexcept { return State().sweep.local_center; }
 
     math::vec2 GetLocalPoint (const math::vec2 world_point) const noexcept
     {
@@ -336,6 +376,15 @@ public:
         return world_transform.to_world(local_point);
     }
 
+    //! \brief Transform interpolated between the last two fixed steps
+    //! \details Used to render bodies of a graph with a fixed time step, where
+    //!          the real time falls in between steps.  Moving the body directly
+    //!          discards the previous state, so it will not be interpolated.
+    //! \param [in] alpha Fraction from the previous step to the current step
+    //! \returns Interpolated transform of the body origin
+    //! \see CollisionGraph::GetInterpolationAlpha
+    iso_transform GetInterpolatedTransform (float alpha) const noexcept;
+
     //! \brief Check if body is participating in the physics simulation
     bool IsSimulating (void) const noexcept { return m_flags & SIMULATE; }
     void Enable (void);
@@ -354,32 +403,25 @@ public:
         return (m_type == RigidBodyType::STATIC) || (m_flags & PREVENT_SLEEP);
     }
 
-    void WakeUp (void) noexcept
-    {
-        if (!IsAwake())
-        {
-            m_flags |= AWAKE;
-            m_sleepTime = 0.f;
-        }
-    }
-
-    void Sleep (void) noexcept
-    {
-        if (IsAwake())
-        {
-            m_flags &= ~AWAKE;
-            m_sleepTime = 0.f;
+    //! \brief Wake the body, adding it to the graph awake set
+    void WakeUp (void) noexcept;
 
-            linear.force = { 0.f, 0.f };
-            angular.torque = 0.f;
-            linear.velocity = { 0.f, 0.f };
-            angular.velocity = 0.f;
-        }
-    }
+    //! \brief Put the body to sleep, removing it from the graph awake set
+    //! \details Velocities and forces are cleared.  Sleeping bodies are not
+    //!          visited during a step until they're woken.
+    void Sleep (void) noexcept;
 
 
     bool IsFixedRotation (void) const noexcept { return m_flags & PREVENT_ROTATION; }
 
+    //! \brief Check if body is a bullet
+    //! \details Bullets are dynamic bodies which have their motion swept against
+    //!          other bodies at the end of each step, preventing fast moving
+    //!          bodies from passing through others.  Continuous collision has a
+    //!          cost, so only a few fast moving bodies should be bullets.
+    bool IsBullet (void) const noexcept { return m_flags & BULLET; }
+    void SetBullet (bool enable) noexcept { SET_FLAG(enable, m_flags, BULLET); }
+
     bool ShouldCollide (RigidBody* other) noexcept
     {
         if ((this == other) ||
@@ -405,6 +447,7 @@ private:
     friend class CollisionGraph;
     friend class Solver;
     friend class rdge::SmallBlockAllocator;
+    friend std::ostream& operator<< (std::ostream&, const RigidBody&);
 
     //! \brief RigidBody ctor
     //! \details Initialized from the provided profile.  Creation is done
@@ -417,6 +460,11 @@ private:
     //! \details Responsible for cleaning up child fixtures.
     ~RigidBody (void) noexcept;
 
+    //!@{ Per-step state stored by the graph
+    body_state& State (void) noexcept { return (*m_states)[static_cast<size_t>(m_state)]; }
+    const body_state& State (void) const noexcept { return (*m_states)[static_cast<size_t>(m_state)]; }
+    //!@}
+
     bool HasEdge (const Fixture* a, const Fixture* b) noexcept;
     void SyncFixtures (void);
     void ComputeMass (void);
@@ -433,7 +481,6 @@ public:
     //! \brief Collection of elements defining the linear motion
     struct linear_motion
     {
-        math::vec2 velocity;
         math::vec2 force;
         float      damping = 0.f;
         float      mass = 0.f;
@@ -443,7 +490,6 @@ public:
     //! \brief Collection of elements defining the angular motion
     struct angular_motion
     {
-        float velocity = 0.f;
         float torque = 0.f;
         float damping = 0.f;
         float mmoi = 0.f;
@@ -453,10 +499,6 @@ public:
     //! \brief Linear/angular transforms to represent the body in world space
     iso_transform world_transform;
 
-    //! \brief Contains the local center of mass, and the position/angle over the
-    //!        the timestep.
-    sweep_step sweep;
-
     float gravity_scale = 0.f; //!< Gravitational impact on the body
 
     size_t solver_index; //!< Used internally by the solver
@@ -469,11 +511,21 @@ private:
         AWAKE            = 0x0002,
         PREVENT_ROTATION = 0x0004,
         PREVENT_SLEEP    = 0x0008,
+        BULLET           = 0x0010,
 
-        ON_ISLAND        = 0x0010
+        ON_ISLAND        = 0x0020
     };
 
     float      m_sleepTime = 0.f;
+    int32      m_awakeIndex = -1; //!< Index in the graph awake set
+
+    std::vector<body_state>* m_states = nullptr; //!< Dense state storage of the graph
+    int32      m_state = -1;                     //!< Handle of the body state
+
+    //!@{ Center of mass and angle prior to the last fixed step
+    math::vec2 m_previousCenter;
+    float      m_previousAngle = 0.f;
+    //!@}
 
     uint16        m_flags = 0;
     RigidBodyType m_type;
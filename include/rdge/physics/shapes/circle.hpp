@@ -81,6 +81,12 @@ struct circle : public ishape
     //! \returns True iff intersecting
     bool intersects_with (const ishape* other, collision_manifold& mf) const override;
 
+    //! \brief Cast a ray against the circle
+    //! \param [in] input Ray segment
+    //! \param [out] output Fraction and surface normal of the hit
+    //! \returns True iff the ray hits the circle
+    bool ray_cast (const ray_cast_input& input, ray_cast_output& output) const override;
+
     //! \brief Compute an aabb surrounding the circle
     //! \warning Resultant value may still need to be converted to world space
     //! \returns Surrounding aabb
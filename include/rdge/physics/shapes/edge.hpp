@@ -0,0 +1,146 @@
+//! \headerfile <rdge/physics/shapes/edge.hpp>
+//! \author Josh Bramlett
+//! \version 0.0.11
+//! \date 10/16/2026
+
+#pragma once
+
+#include <rdge/core.hpp>
+#include <rdge/math/vec2.hpp>
+#include <rdge/physics/shapes/ishape.hpp>
+#include <rdge/physics/collision.hpp>
+
+//! \namespace rdge Rainbow Drop Game Engine
+namespace rdge {
+namespace physics {
+
+//! \struct edge
+//! \brief Line segment used for static geometry
+//! \details Edges have no area, and therefore no mass, so they should only be
+//!          attached to static bodies.  Edges never collide with other edges.
+//!
+//!          A two sided edge collides on both sides.  A one sided edge is a
+//!          single segment of a chain, and only collides on the side of the
+//!          normal (to the right of v1 -> v2, so the normal points outward for
+//!          chains wound CCW).  The ghost vertices v0 and v3 are the neighboring
+//!          vertices of the chain, which are used to smooth the transition
+//!          between segments so shapes sliding along a chain don't catch on the
+//!          internal vertices.
+//! \see https://box2d.org/posts/2020/06/ghost-collisions/
+struct edge : public ishape
+{
+    //! \var Padding between the edge vertices and its aabb edges
+    static constexpr float AABB_PADDING = LINEAR_SLOP * 2.f;
+
+    math::vec2 v0;           //!< Ghost vertex preceding v1
+    math::vec2 v1;           //!< Segment start
+    math::vec2 v2;           //!< Segment end
+    math::vec2 v3;           //!< Ghost vertex following v2
+    math::vec2 normal;       //!< Unit normal to the right of v1 -> v2
+    bool one_sided = false;  //!< Only collides on the side of the normal
+
+    //! \brief edge default ctor
+    //! \details Zero initialization.
+    edge (void) = default;
+
+    //! \brief edge two sided ctor
+    //! \param [in] p1 Segment start
+    //! \param [in] p2 Segment end
+    explicit edge (const math::vec2& p1, const math::vec2& p2);
+
+    //! \brief edge one sided ctor
+    //! \param [in] p0 Ghost vertex preceding the segment
+    //! \param [in] p1 Segment start
+    //! \param [in] p2 Segment end
+    //! \param [in] p3 Ghost vertex following the segment
+    explicit edge (const math::vec2& p0, const math::vec2& p1,
+                   const math::vec2& p2, const math::vec2& p3);
+
+    //!@{ Shape properties
+    ShapeType type (void) const override { return ShapeType::EDGE; }
+    math::vec2 get_centroid (void) const override { return (v1 + v2) * 0.5f; }
+    //!@}
+
+    //! \brief Converts the edge to world space
+    //! \param [in] xf Transform
+    void to_world (const iso_transform& xf) override
+    {
+        v0 = xf.to_world(v0);
+        v1 = xf.to_world(v1);
+        v2 = xf.to_world(v2);
+        v3 = xf.to_world(v3);
+        normal = xf.rot.rotate(normal);
+    }
+
+    //! \brief Edges have no area, so never contain a point
+    bool contains (const math::vec2&) const override { return false; }
+
+    //! \brief Check if the edge intersects with another shape
+    //! \details Uses the manifold routines so the result respects the one sided
+    //!          and ghost vertex rules.
+    //! \param [in] other Other shape to test
+    //! \warning Before calling ensure both shapes are in the same coordinate space
+    //! \returns True iff shapes intersect
+    bool intersects_with (const ishape* other) const override;
+
+    //! \brief Check if the edge intersects with another shape
+    //! \details The provided \ref collision_manifold will be populated with details
+    //!          on how the collision could be resolved.  If there was no collision
+    //!          the manifold count will be set to zero.
+    //! \param [in] other shape
+    //! \param [out] mf Manifold containing resolution
+    //! \warning Before calling ensure both shapes are in the same coordinate space
+    //! \returns True iff intersecting
+    bool intersects_with (const ishape* other, collision_manifold& mf) const override;
+
+    //! \brief Cast a ray against the edge
+    //! \details One sided edges only report hits on the side of the normal.
+    //! \param [in] input Ray segment
+    //! \param [out] output Fraction and surface normal of the hit
+    //! \returns True iff the ray hits the edge
+    bool ray_cast (const ray_cast_input& input, ray_cast_output& output) const override;
+
+    //! \brief Compute an aabb surrounding the edge
+    //! \note aabb edges will be padded by \ref AABB_PADDING
+    //! \returns Surrounding aabb
+    aabb compute_aabb (void) const override;
+    aabb compute_aabb (const iso_transform& xf) const override;
+
+    //! \brief Edges have no mass
+    //! \returns Zero mass centered on the segment
+    mass_data compute_mass (float) const override
+    {
+        mass_data result;
+        result.centroid = get_centroid();
+        return result;
+    }
+
+    //!@{ SAT support functions
+    //! \brief Provides the min and max projection on the provided axis
+    //! \param [in] axis Normalized axis
+    math::vec2 project (const math::vec2& axis) const override
+    {
+        float a = axis.dot(v1);
+        float b = axis.dot(v2);
+        return (a < b) ? math::vec2(a, b) : math::vec2(b, a);
+    }
+    //!@}
+
+    //!@{ GJK support functions
+    //! \brief Provides the segment start
+    math::vec2 first_point (void) const override { return v1; }
+
+    //! \brief Retrieves the farthest point along the provided direction
+    //! \param [in] d Direction to find the farthest point
+    math::vec2 farthest_point (const math::vec2& d) const override
+    {
+        return (math::dot(d, v1) >= math::dot(d, v2)) ? v1 : v2;
+    }
+    //!@}
+};
+
+//! \brief edge stream output operator
+std::ostream& operator<< (std::ostream&, const edge&);
+
+} // namespace physics
+} // namespace rdge
@@ -16,11 +16,17 @@
 namespace rdge {
 namespace physics {
 
+//!@{ Forward declarations
+struct ray_cast_input;
+struct ray_cast_output;
+//!@}
+
 enum class ShapeType : uint8
 {
     INVALID = 0,
     CIRCLE,
-    POLYGON
+    POLYGON,
+    EDGE
 };
 
 //! \struct mass_data
@@ -47,7 +53,6 @@ struct ishape
 {
 
     //https://github.com/erincatto/Box2D/blob/master/Box2D/Box2D/Collision/Shapes/b2Shape.h
-    // TODO raycast
 
     virtual ~ishape (void) noexcept = default;
 
@@ -72,6 +77,14 @@ struct ishape
     virtual bool intersects_with (const ishape* other, collision_manifold& mf) const = 0;
     //!@}
 
+    //! \brief Cast a ray against the shape
+    //! \details Rays starting inside the shape do not report a hit.
+    //! \param [in] input Ray segment
+    //! \param [out] output Fraction and surface normal of the hit
+    //! \warning Before calling ensure the ray and shape are in the same coordinate space
+    //! \returns True iff the ray hits the shape
+    virtual bool ray_cast (const ray_cast_input& input, ray_cast_output& output) const = 0;
+
     //!@{ SAT support functions
     virtual math::vec2 project (const math::vec2& axis) const = 0;
     //!@}
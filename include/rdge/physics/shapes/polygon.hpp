@@ -133,6 +133,12 @@ struct polygon : public ishape
     //! \returns True iff intersecting
     bool intersects_with (const ishape* other, collision_manifold& mf) const override;
 
+    //! \brief Cast a ray against the polygon
+    //! \param [in] input Ray segment
+    //! \param [out] output Fraction and surface normal of the hit
+    //! \returns True iff the ray hits the polygon
+    bool ray_cast (const ray_cast_input& input, ray_cast_output& output) const override;
+
     //! \brief Compute an aabb surrounding the polygon
     //! \note aabb edges will be padded by \ref AABB_PADDING
     //! \returns Surrounding aabb
@@ -0,0 +1,163 @@
+//! \headerfile <rdge/physics/snapshot.hpp>
+//! \author Josh Bramlett
+//! \version 0.0.11
+//! \date 10/16/2026
+
+#pragma once
+
+#include <rdge/core.hpp>
+#include <rdge/util/compiler.hpp>
+
+#include <type_traits>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+//! \namespace rdge Rainbow Drop Game Engine
+namespace rdge {
+namespace physics {
+
+//! \struct graph_snapshot
+//! \brief Binary copy of the simulation state of a \ref CollisionGraph
+//! \details The blob references the bodies, fixtures, and joints by address,
+//!          so it is only valid for the graph which produced it, and only as
+//!          long as the same set of objects exists.  The buffer is retained
+//!          between snapshots so repeated captures do not allocate.
+//! \see CollisionGraph::Snapshot
+struct graph_snapshot
+{
+    std::vector<uint8> data;
+
+    bool empty (void) const noexcept { return data.empty(); }
+    size_t size (void) const noexcept { return data.size(); }
+};
+
+//! \struct snapshot_writer
+//! \brief Appends trivially copyable values to a snapshot
+//! \details Values are padded to their natural alignment, which allows the
+//!          reader to access arrays in place.
+struct snapshot_writer
+{
+    explicit snapshot_writer (graph_snapshot& snapshot)
+        : m_data(snapshot.data)
+    { }
+
+    template <typename T>
+    void write (const T& value)
+    {
+        write(&value, 1);
+    }
+
+    template <typename T>
+    void write (const T* values, size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+        write_bytes(values, sizeof(T) * count, alignof(T));
+    }
+
+    //! \brief Reserve an array to be filled in place
+    //! \returns Pointer into the snapshot, valid until the next write
+    template <typename T>
+    T* write_array (size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "T is over-aligned");
+        return static_cast<T*>(reserve_bytes(sizeof(T) * count, alignof(T)));
+    }
+
+private:
+    void* reserve_bytes (size_t size, size_t alignment)
+    {
+        size_t offset = (m_data.size() + (alignment - 1)) & ~(alignment - 1);
+        m_data.resize(offset + size);
+        return m_data.data() + offset;
+    }
+
+    void write_bytes (const void* src, size_t size, size_t alignment)
+    {
+        // padding is still written so the layout matches the reader, but src
+        // may be null for an empty array
+        void* dst = reserve_bytes(size, alignment);
+        if (size == 0)
+        {
+            return;
+        }
+
+        std::memcpy(dst, src, size);
+    }
+
+    std::vector<uint8>& m_data;
+};
+
+//! \struct snapshot_reader
+//! \brief Reads values in the order written by the \ref snapshot_writer
+struct snapshot_reader
+{
+    explicit snapshot_reader (const graph_snapshot& snapshot)
+        : m_data(snapshot.data)
+    { }
+
+    //! \throws rdge::Exception Read past the end of the snapshot
+    template <typename T>
+    void read (T& value)
+    {
+        read(&value, 1);
+    }
+
+    //! \throws rdge::Exception Read past the end of the snapshot
+    template <typename T>
+    void read (T* values, size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+        const void* src = read_bytes(sizeof(T) * count, alignof(T));
+        if (count == 0)
+        {
+            return;
+        }
+
+        std::memcpy(values, src, sizeof(T) * count);
+    }
+
+    //! \brief Access an array in place
+    //! \returns Pointer into the snapshot, valid while the snapshot is unmodified
+    //! \throws rdge::Exception Read past the end of the snapshot
+    template <typename T>
+    const T* read_array (size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "T is over-aligned");
+        return static_cast<const T*>(read_bytes(sizeof(T) * count, alignof(T)));
+    }
+
+    //! \throws rdge::Exception Read past the end of the snapshot
+    template <typename T>
+    T read (void)
+    {
+        T value;
+        read(value);
+        return value;
+    }
+
+    bool at_end (void) const noexcept { return (m_offset == m_data.size()); }
+
+private:
+    const void* read_bytes (size_t size, size_t alignment)
+    {
+        size_t offset = (m_offset + (alignment - 1)) & ~(alignment - 1);
+        if (RDGE_UNLIKELY(offset > m_data.size() || size > (m_data.size() - offset)))
+        {
+            throw_out_of_range();
+        }
+
+        m_offset = offset + size;
+        return m_data.data() + offset;
+    }
+
+    [[noreturn]] static void throw_out_of_range (void);
+
+    const std::vector<uint8>& m_data;
+    size_t m_offset = 0;
+};
+
+} // namespace physics
+} // namespace rdge
@@ -8,6 +8,7 @@
 #include <rdge/core.hpp>
 #include <rdge/physics/collision.hpp>
 #include <rdge/math/intrinsics.hpp>
+#include <rdge/math/mat2.hpp>
 #include <rdge/math/vec2.hpp>
 #include <rdge/util/adt/stack_array.hpp>
 
@@ -60,7 +61,118 @@ struct solver_contact_data
         float normal_mass;       //!< two body effective mass relative to the normal
         float tangent_mass;      //!< two body effective mass relative to the tangent
         float velocity_bias;
+        float separation;        //!< at the start of the step (soft step only)
     } points[2];
+
+    //!@{ Normal constraints of both points solved as a block
+    math::mat2 block_k;    //!< two body effective mass matrix (K)
+    math::mat2 block_mass; //!< inverse of K
+    bool block_solve;      //!< K is well conditioned
+    //!@}
+};
+
+//! \struct softness
+//! \brief Coefficients of a soft constraint
+//! \details Soft constraints behave as a damped spring, which removes error
+//!          over time rather than in a single step.  The constraint impulse is
+//!          computed from the biased velocity constraint as
+//!              impulse = -mass_scale * m * (Cdot + bias_rate * C)
+//!                        - impulse_scale * accumulated_impulse
+//!          The default coefficients are a rigid constraint with no bias.
+struct softness
+{
+    float bias_rate = 0.f;
+    float mass_scale = 1.f;
+    float impulse_scale = 0.f;
+
+    softness (void) = default;
+
+    //! \param [in] hertz Stiffness of the constraint (cycles per second)
+    //! \param [in] damping_ratio Damping of the constraint (1 is critical)
+    //! \param [in] h Elapsed time of the step
+    softness (float hertz, float damping_ratio, float h) noexcept;
+};
+
+//! \struct soft_step_data
+//! \brief Substep data shared by the soft constraint solvers
+struct soft_step_data
+{
+    float h = 0.f;        //!< Substep elapsed time
+    float inv_h = 0.f;    //!< Substep inverse elapsed time
+    size_t count = 0;     //!< Number of substeps
+    softness contact;     //!< Contact normal constraints
+    softness joint;       //!< Joint point and limit constraints
+};
+
+//! \struct solver_contact_wide
+//! \brief Four contacts packed for lane-wise solving
+//! \details Data is stored as a structure of arrays, one array element per
+//!          lane.  Contacts in a bundle never share a body which can be moved
+//!          by the solver, so the lanes can be solved simultaneously.  Lanes
+//!          for contacts with a single point have a zeroed second point.
+struct solver_contact_wide
+{
+    size_t contact_index[4]; //!< Indices of contacts in the \ref m_contacts container
+    size_t body_index[2][4]; //!< Indices of bodies in the \ref m_bodies container
+
+    float normal_x[4];
+    float normal_y[4];
+    float friction[4];
+    float tangent_speed[4];
+
+    //!@{ Cache of the body properties
+    float inv_mass_a[4];
+    float inv_mmoi_a[4];
+    float inv_mass_b[4];
+    float inv_mmoi_b[4];
+    //!@}
+
+    struct wide_constraint_point
+    {
+        float rel_ax[4];
+        float rel_ay[4];
+        float rel_bx[4];
+        float rel_by[4];
+        float normal_impulse[4];
+        float tangent_impulse[4];
+        float normal_mass[4];
+        float tangent_mass[4];
+        float velocity_bias[4];
+    } points[2];
+};
+
+//! \struct solver_joint_data
+//! \brief Joint with the indices of the bodies it connects
+struct solver_joint_data
+{
+    BaseJoint* joint;
+    size_t body_index[2];    //!< Indices of bodies in the \ref m_bodies container
+};
+
+//! \struct solver_contact_ref
+//! \brief Contact with the indices of the bodies it connects
+struct solver_contact_ref
+{
+    Contact* contact;
+    size_t body_index[2];    //!< Indices of the bodies in the island
+};
+
+//! \struct solver_island
+//! \brief Range of items forming an independent island
+//! \details Islands share no dynamic bodies, contacts or joints, so they can
+//!          be solved concurrently.  Ranges refer to flat arrays owned by the
+//!          \ref CollisionGraph.
+struct solver_island
+{
+    size_t body_begin = 0;
+    size_t body_count = 0;
+    size_t contact_begin = 0;
+    size_t contact_count = 0;
+    size_t joint_begin = 0;
+    size_t joint_count = 0;
+    bool positions_solved = false; //!< Result of the solve, used for sleeping
+    size_t velocity_iterations = 0;
+    size_t position_iterations = 0;
 };
 
 //! \class Solver
@@ -92,6 +204,20 @@ public:
     static constexpr float MAX_ROTATION = 0.5f * math::PI;
     //!@}
 
+    //!@{ Soft step properties
+    //! \var Stiffness of contacts.  Limited to a quarter of the substep rate.
+    static constexpr float CONTACT_HERTZ = 30.f;
+
+    //! \var Damping of contacts, which is heavily over-damped to prevent bounce.
+    static constexpr float CONTACT_DAMPING_RATIO = 10.f;
+
+    //! \var Damping of joints, which are twice as stiff as contacts.
+    static constexpr float JOINT_DAMPING_RATIO = 2.f;
+
+    //! \var Maximum velocity at which contact overlap is resolved.
+    static constexpr float MAX_PUSHOUT_VELOCITY = 3.f;
+    //!@}
+
     //!@{ Sleep properties
     //! \var Body must have a linear velocity below threshold to sleep
     static constexpr float LINEAR_SLEEP_TOLERANCE = 0.01f;
@@ -116,9 +242,14 @@ public:
     void Initialize (size_t body_count, size_t contact_count, size_t joint_count);
 
     //!@{ Add items to the solver
+    //! \details Bodies are indexed in the order they are added, and contacts
+    //!          and joints must provide the indices of the bodies they connect
+    //!          (ordered by fixture_a/body_a and fixture_b/body_b respectively).
+    //!          Adding is read-only with respect to the items, so islands sharing
+    //!          static bodies can be filled concurrently by different solvers.
     void Add (RigidBody* b);
-    void Add (Contact* c);
-    void Add (BaseJoint* j);
+    void Add (Contact* c, size_t index_a, size_t index_b);
+    void Add (BaseJoint* j, size_t index_a, size_t index_b);
     //!@}
 
     //! \brief Clear all bodies and contacts from the solver
@@ -127,27 +258,85 @@ public:
     //! \brief Perform impulse resolution
     //! \details Velocity constraints are solved and positions are corrected.
     //!          Bodies positions and velocities are updated with the impulses
-    //!          generated by the solver.
+    //!          generated by the solver.  Static bodies are never written to.
     void Solve (void);
 
-    //! \brief Update island bodies and contacts
-    //! \details Responsible for firing the \ref OnPostSolve event for each
-    //!          contact, and sets bodies to sleep if applicable.
-    void ProcessPostSolve (const CollisionGraph& graph);
+    //! \returns True iff the last solve corrected all positions within tolerance
+    bool PositionsSolved (void) const noexcept { return m_positionsSolved; }
+
+    //! \returns Velocity iterations (or substeps) performed by the last solve
+    size_t VelocityIterations (void) const noexcept { return m_velocityIterations; }
+
+    //! \returns Position iterations performed by the last solve
+    size_t PositionIterations (void) const noexcept { return m_positionIterations; }
 
 private:
 
     //!@{ Steps during solve
+    void PrepareContacts (void);
+    void IntegratePositions (float h);
+    void StoreBodies (void);
+    void WarmStart (void);
     void SolveVelocityConstraints (void);
+    void SolveVelocityConstraint (solver_contact_data& data);
+    void SolveBlockConstraint (solver_contact_data& data);
     bool CorrectPositions (void);
     //!@}
 
+    //!@{ Soft step solving
+    void SolveSoft (void);
+    void IntegrateVelocities (float h);
+    float SolveSoftConstraints (bool use_bias);
+    void ApplyRestitution (void);
+    //!@}
+
+    //!@{ Wide contact solving
+    void PrepareWideContacts (void);
+    void SolveWideVelocityConstraints (void);
+    void StoreWideImpulses (void);
+    //!@}
+
 public:
 
     //!@{ Global configuration
     math::vec2 gravity = { 0.f, -9.8f }; //!< Gravitational force
-    size_t velocity_iterations = 8;      //!< Number of velocity constraint iterations
+    size_t velocity_iterations = 4;      //!< Number of velocity constraint iterations
     size_t position_iterations = 3;      //!< Number of position correction iterations
+    bool warm_starting = true;           //!< Apply impulses from the previous step
+
+    //! \brief Solve the normal constraints of two point manifolds together
+    //! \details The two points are solved as a 2x2 linear complementarity
+    //!          problem, so a resting box converges in fewer iterations than
+    //!          when the points are solved one after the other.  Manifolds
+    //!          where the points are nearly redundant (e.g. an edge resting on
+    //!          a corner) are ill-conditioned, and are solved sequentially.
+    //!          Contacts bundled by \ref wide_contacts are always solved
+    //!          sequentially.
+    bool block_contacts = true;
+
+    //! \brief Solve contact velocity constraints four at a time
+    //! \details Contacts are colored so no two contacts of the same color share
+    //!          a dynamic body, and each color is packed into bundles solved
+    //!          with SIMD.  Contacts which do not fill a bundle are solved
+    //!          individually.  The order contacts are solved in differs from
+    //!          the default, so results are not identical.
+    bool wide_contacts = false;
+
+    //! \brief Solve with substeps rather than iterations
+    //! \details Each step is divided into \ref substeps, and every substep
+    //!          integrates velocities, solves the soft constraints once with
+    //!          bias, integrates positions, and then relaxes the constraints
+    //!          once without bias to remove the velocity added by the bias.
+    //!          Overlap is resolved by the soft constraints, so there is no
+    //!          position correction, and \ref velocity_iterations and
+    //!          \ref position_iterations are unused.  Joint chains remain stiff
+    //!          at a lower cost than raising the iteration counts.
+    //!
+    //!          Contact impulses reported to the \ref GraphListener are the
+    //!          total of all substeps, the same as the iterative solver.  The
+    //!          \ref wide_contacts and \ref block_contacts solvers are not used.
+    bool soft_step = false;
+    size_t substeps = 4; //!< Number of soft step substeps
     //!@}
 
 private:
@@ -155,9 +344,17 @@ private:
     //!@{ Private members which are used and reset every time step
     stack_array<solver_body_data, memory_bucket_physics>    m_bodies;
     stack_array<solver_contact_data, memory_bucket_physics> m_contacts;
-    stack_array<BaseJoint*, memory_bucket_physics>          m_joints;
+    stack_array<solver_joint_data, memory_bucket_physics>   m_joints;
+
+    stack_array<solver_contact_wide, memory_bucket_physics> m_wideContacts;
+    stack_array<size_t, memory_bucket_physics>              m_remainingContacts; //!< Not in a bundle
+    stack_array<uint32, memory_bucket_physics>              m_contactColors;
+    stack_array<uint32, memory_bucket_physics>              m_bodyColors; //!< Color mask per body
     const time_step* m_step = nullptr;
-    bool m_positionsSolved;
+    soft_step_data m_softStep;
+    bool m_positionsSolved = false;
+    size_t m_velocityIterations = 0;
+    size_t m_positionIterations = 0;
     //!@}
 };
 
@@ -0,0 +1,449 @@
+//! \headerfile <rdge/physics/spatial_hash.hpp>
+//! \author Josh Bramlett
+//! \version 0.0.11
+//! \date 10/16/2026
+
+#pragma once
+
+#include <rdge/core.hpp>
+#include <rdge/physics/aabb.hpp>
+#include <rdge/physics/broad_phase.hpp>
+#include <rdge/physics/collision.hpp>
+#include <rdge/math/vec2.hpp>
+#include <rdge/util/containers/freelist.hpp>
+
+#include <SDL_assert.h>
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+
+//! \namespace rdge Rainbow Drop Game Engine
+namespace rdge {
+namespace physics {
+
+//! \struct grid_range
+//! \brief Inclusive range of cells covered by an aabb
+struct grid_range
+{
+    int32 lo[2]; //!< Lowest cell on the x and y axes
+    int32 hi[2]; //!< Highest cell on the x and y axes
+
+    //! \returns Number of cells in the range
+    int64 count (void) const noexcept
+    {
+        return static_cast<int64>(hi[0] - lo[0] + 1) * static_cast<int64>(hi[1] - lo[1] + 1);
+    }
+
+    bool operator== (const grid_range& other) const noexcept
+    {
+        return (lo[0] == other.lo[0] && lo[1] == other.lo[1] &&
+                hi[0] == other.hi[0] && hi[1] == other.hi[1]);
+    }
+};
+
+//! \struct grid_proxy
+//! \brief Proxy in the \ref SpatialHashGrid
+struct grid_proxy
+{
+    aabb fat_box;
+    void* user_data;
+    proxy_filter filter; //!< Pair filter
+
+    grid_range cells; //!< Cells the proxy is registered in
+    int32 oversized;  //!< Index in the oversized list, or -1 if registered in cells
+};
+
+//! \struct grid_cell_entry
+//! \brief Registration of a proxy in a single cell
+//! \details Entries of cells which hash to the same bucket form a singly linked
+//!          list, so a proxy covering several cells has one entry per cell.
+struct grid_cell_entry
+{
+    int32 x;
+    int32 y;
+    int32 proxy;
+    int32 next;
+};
+
+//! \class SpatialHashGrid
+//! \brief Uniform grid broad phase backed by a hash table
+//! \details Proxies are registered in every cell their fat aabb covers.  Only
+//!          occupied cells are stored, so the grid is unbounded.  When the cell
+//!          size is close to the proxy size (e.g. a tile map using the tile
+//!          size), proxies cover few cells, which makes moves and queries
+//!          constant time regardless of the number of proxies.
+//!
+//!          Proxies covering more than \ref MAX_PROXY_CELLS are kept in a
+//!          separate list which is tested by every query, so the grid degrades
+//!          gracefully for the occasional large fixture.
+class SpatialHashGrid : public IBroadPhase
+{
+public:
+    static constexpr int32 NULL_ENTRY = -1;
+
+    //! \brief Amount of padding added to the aabb of moving proxies
+    static constexpr float FATTEN_AMOUNT = 0.1f;
+
+    //! \brief Displacement multiplier for movement predictive AABB expansion
+    static constexpr float DISP_MULTIPLIER = 2.f;
+
+    //! \brief Proxies covering more cells are not registered in the grid
+    static constexpr int64 MAX_PROXY_CELLS = 64;
+
+    //! \brief Initial number of hash buckets (must be a power of two)
+    static constexpr size_t INITIAL_BUCKET_COUNT = 256;
+
+    //! \brief Construct an empty grid
+    //! \param [in] cell_size Cell width and height in world units
+    //! \param [in] margin Padding added to proxy aabbs (use zero for proxies
+    //!                    which rarely move, like static tiles)
+    explicit SpatialHashGrid (const math::vec2& cell_size, float margin = FATTEN_AMOUNT);
+    ~SpatialHashGrid (void) noexcept override = default;
+
+    //!@{
+    //! \brief Non-copyable, move enabled
+    SpatialHashGrid (const SpatialHashGrid&) = delete;
+    SpatialHashGrid& operator= (const SpatialHashGrid&) = delete;
+    SpatialHashGrid (SpatialHashGrid&&) = default;
+    SpatialHashGrid& operator= (SpatialHashGrid&&) = default;
+    //!@}
+
+    BroadPhaseType Type (void) const noexcept override { return BroadPhaseType::SPATIAL_HASH; }
+
+    void ClearProxies (void) noexcept override;
+    int32 CreateProxy (const aabb& box, void* user_data) override;
+    void DestroyProxy (int32 handle) override;
+
+    //! \brief Update the proxy aabb
+    //! \details The cells are only updated when the fat aabb no longer contains
+    //!          the box and the enlarged box covers a different range of cells.
+    bool MoveProxy (int32 handle, const aabb& box, const math::vec2& displacement) override;
+
+    //! \brief Cast a ray against the proxies in the grid
+    //! \details Cells are visited in order along the dominant axis of the ray,
+    //!          so clipping the ray stops the traversal early.
+    //! \see BVHTree::RayCast
+    template <typename Fn>
+    void RayCast (const ray_cast_input& input, Fn&& fn) const
+    {
+        SweepCells(input, math::vec2(0.f, 0.f), std::forward<Fn>(fn));
+    }
+
+    //! \brief Cast an aabb along a translation against the proxies in the grid
+    //! \see BVHTree::BoxCast
+    template <typename Fn>
+    void BoxCast (const aabb& box, const math::vec2& translation, float max_fraction, Fn&& fn) const
+    {
+        math::vec2 center = box.centroid();
+        ray_cast_input input = { center, center + translation, max_fraction };
+        SweepCells(input, box.half_extent(), std::forward<Fn>(fn));
+    }
+
+    void SetFilter (int32 handle, const proxy_filter& filter) noexcept override
+    {
+        m_proxies[handle].filter = filter;
+    }
+
+    //! \returns User data of the proxy
+    void* GetUserData (int32 handle) const noexcept override
+    {
+        return m_proxies[handle].user_data;
+    }
+
+    //! \returns Enlarged aabb of the proxy
+    const aabb& GetFatAABB (int32 handle) const noexcept override
+    {
+        return m_proxies[handle].fat_box;
+    }
+
+    size_t ProxyCount (void) const noexcept override
+    {
+        return m_proxies.size();
+    }
+
+    //! \returns Number of cell registrations of all proxies
+    size_t EntryCount (void) const noexcept
+    {
+        return m_entryCount;
+    }
+
+    //! \returns Number of proxies too large to be registered in cells
+    size_t OversizedCount (void) const noexcept
+    {
+        return m_oversized.size();
+    }
+
+    const math::vec2& CellSize (void) const noexcept
+    {
+        return m_cellSize;
+    }
+
+    //!@{ \see CollisionGraph::Snapshot
+    void Save (snapshot_writer& writer) const override;
+    void Restore (snapshot_reader& reader) override;
+    //!@}
+
+    void DebugDraw (float pixel_ratio) override;
+
+protected:
+    void QueryProxies (const aabb& box, query_fn fn, void* context) const override;
+    void SweepProxies (const ray_cast_input& input,
+                       const math::vec2& extension,
+                       sweep_fn fn,
+                       void* context) const override;
+
+private:
+    friend class CollisionGraph;
+
+    //! \brief Visit all proxies whose fat aabb intersects the provided box
+    //! \details Each proxy is visited once.  The callback is invoked with the
+    //!          proxy handle, and returns false to terminate the query.  If a
+    //!          filter is provided, proxies it cannot collide with are skipped.
+    template <typename Fn>
+    void QueryCells (const aabb& box, Fn&& fn, const proxy_filter* filter = nullptr) const;
+
+    //! \brief Visit all proxies hit by a segment swept by the extension
+    //! \see RayCast
+    template <typename Fn>
+    void SweepCells (const ray_cast_input& input, const math::vec2& extension, Fn&& fn) const;
+
+    //! \brief Compute the cells covered by the aabb
+    //! \param [in] box aabb
+    //! \param [in] edge_inclusive Include cells which only touch the box edge
+    grid_range ComputeRange (const aabb& box, bool edge_inclusive) const noexcept;
+
+    size_t Bucket (int32 x, int32 y) const noexcept
+    {
+        uint32 h = (static_cast<uint32>(x) * 0x8DA6B343u) ^ (static_cast<uint32>(y) * 0xD8163841u);
+        return static_cast<size_t>((h * 0x9E3779B1u) >> m_bucketShift);
+    }
+
+    void InsertCells (int32 handle);
+    void RemoveCells (int32 handle);
+    void Rehash (size_t bucket_count);
+
+    math::vec2 m_cellSize;
+    math::vec2 m_invCellSize;
+    float m_margin;
+
+    freelist<grid_proxy> m_proxies;
+
+    std::vector<int32> m_buckets; //!< Head entry of each bucket
+    std::vector<grid_cell_entry> m_entries;
+    int32 m_freeEntry = NULL_ENTRY;
+    size_t m_entryCount = 0;
+    uint32 m_bucketShift = 0; //!< Shift mapping the hash onto the bucket count
+
+    std::vector<int32> m_oversized;
+};
+
+template <typename Fn>
+inline void
+SpatialHashGrid::QueryCells (const aabb& box, Fn&& fn, const proxy_filter* filter) const
+{
+    auto accept = [&](const grid_proxy& proxy) {
+        return box.intersects_with(proxy.fat_box) &&
+               (!filter || filter->should_collide(proxy.filter));
+    };
+
+    for (int32 handle : m_oversized)
+    {
+        if (accept(m_proxies[handle]) && !fn(handle))
+        {
+            return;
+        }
+    }
+
+    grid_range range = ComputeRange(box, false);
+    if (range.count() > static_cast<int64>(m_entryCount))
+    {
+        // the box covers more cells than are occupied
+        for (size_t i = 0; i < m_proxies.size(); i++)
+        {
+            auto handle = static_cast<int32>(m_proxies.handles()[i]);
+            const auto& proxy = m_proxies.data()[handle];
+            if (proxy.oversized < 0 && accept(proxy) && !fn(handle))
+            {
+                return;
+            }
+        }
+
+        return;
+    }
+
+    for (int32 y = range.lo[1]; y <= range.hi[1]; y++)
+    {
+        for (int32 x = range.lo[0]; x <= range.hi[0]; x++)
+        {
+            for (int32 e = m_buckets[Bucket(x, y)]; e != NULL_ENTRY;)
+            {
+                const auto& entry = m_entries[static_cast<size_t>(e)];
+                e = entry.next;
+                if (entry.x != x || entry.y != y)
+                {
+                    continue;
+                }
+
+                // proxies are only reported from the first cell they share with
+                // the query, which prevents duplicates without tracking state
+                const auto& proxy = m_proxies[entry.proxy];
+                if (x != std::max(proxy.cells.lo[0], range.lo[0]) ||
+                    y != std::max(proxy.cells.lo[1], range.lo[1]))
+                {
+                    continue;
+                }
+
+                if (accept(proxy) && !fn(entry.proxy))
+                {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+template <typename Fn>
+inline void
+SpatialHashGrid::SweepCells (const ray_cast_input& input, const math::vec2& extension, Fn&& fn) const
+{
+    // Proxies are culled the same as BVHTree::SweepLeaves(), using the segment
+    // aabb and the separating axis perpendicular to the segment.
+
+    math::vec2 p1 = input.p1;
+    math::vec2 d = input.p2 - input.p1;
+    float length = d.length();
+    if (length == 0.f)
+    {
+        return;
+    }
+
+    math::vec2 v = (d * (1.f / length)).perp();
+    math::vec2 abs_v = math::abs(v);
+
+    float max_fraction = input.max_fraction;
+    auto segment_box = [&](void) {
+        math::vec2 p2 = p1 + (d * max_fraction);
+        return aabb(math::vec2(std::min(p1.x, p2.x), std::min(p1.y, p2.y)) - extension,
+                    math::vec2(std::max(p1.x, p2.x), std::max(p1.y, p2.y)) + extension);
+    };
+
+    aabb sweep_box = segment_box();
+
+    // returns false when the cast is terminated
+    auto visit = [&](int32 handle) {
+        // edge inclusive so axis aligned segments are not culled
+        const auto& fat_box = m_proxies[handle].fat_box;
+        if (fat_box.lo.x > sweep_box.hi.x || sweep_box.lo.x > fat_box.hi.x ||
+            fat_box.lo.y > sweep_box.hi.y || sweep_box.lo.y > fat_box.hi.y)
+        {
+            return true;
+        }
+
+        // |dot(v, p1 - c)| > dot(|v|, h)
+        math::vec2 c = fat_box.centroid();
+        math::vec2 h = fat_box.half_extent() + extension;
+        if (math::abs(math::dot(v, p1 - c)) - math::dot(abs_v, h) > 0.f)
+        {
+            return true;
+        }
+
+        ray_cast_input sub_input = { input.p1, input.p2, max_fraction };
+        float value = fn(sub_input, handle);
+        if (value == 0.f)
+        {
+            return false;
+        }
+
+        if (value > 0.f)
+        {
+            max_fraction = value;
+            sweep_box = segment_box();
+        }
+
+        return true;
+    };
+
+    for (int32 handle : m_oversized)
+    {
+        if (!visit(handle))
+        {
+            return;
+        }
+    }
+
+    grid_range range = ComputeRange(sweep_box, true);
+    if (range.count() > static_cast<int64>(m_entryCount))
+    {
+        // the sweep covers more cells than are occupied
+        for (size_t i = 0; i < m_proxies.size(); i++)
+        {
+            auto handle = static_cast<int32>(m_proxies.handles()[i]);
+            if (m_proxies.data()[handle].oversized < 0 && !visit(handle))
+            {
+                return;
+            }
+        }
+
+        return;
+    }
+
+    // Cells are visited in slices along the dominant axis starting from p1, so
+    // once the sweep is clipped the remaining slices can be skipped.  Proxies
+    // are reported from the first cell visited, which makes the early out safe.
+    uint8 axis = (std::abs(d.x) >= std::abs(d.y)) ? 0 : 1;
+    uint8 other = 1 - axis;
+    int32 step = (d[axis] > 0.f) ? 1 : -1;
+    int32 first = (step > 0) ? range.lo[axis] : range.hi[axis];
+    int32 last = (step > 0) ? range.hi[axis] : range.lo[axis];
+
+    for (int32 i = first; ; i += step)
+    {
+        // fraction where the leading edge of the swept box enters the slice
+        float edge = (step > 0) ? (static_cast<float>(i) * m_cellSize[axis]) - extension[axis]
+                                : (static_cast<float>(i + 1) * m_cellSize[axis]) + extension[axis];
+        if ((edge - p1[axis]) / d[axis] > max_fraction)
+        {
+            return;
+        }
+
+        for (int32 j = range.lo[other]; j <= range.hi[other]; j++)
+        {
+            int32 cell[2];
+            cell[axis] = i;
+            cell[other] = j;
+
+            for (int32 e = m_buckets[Bucket(cell[0], cell[1])]; e != NULL_ENTRY;)
+            {
+                const auto& entry = m_entries[static_cast<size_t>(e)];
+                e = entry.next;
+                if (entry.x != cell[0] || entry.y != cell[1])
+                {
+                    continue;
+                }
+
+                const auto& cells = m_proxies[entry.proxy].cells;
+                int32 first_i = (step > 0) ? std::max(cells.lo[axis], range.lo[axis])
+                                           : std::min(cells.hi[axis], range.hi[axis]);
+                if (i != first_i || j != std::max(cells.lo[other], range.lo[other]))
+                {
+                    continue;
+                }
+
+                if (!visit(entry.proxy))
+                {
+                    return;
+                }
+            }
+        }
+
+        if (i == last)
+        {
+            return;
+        }
+    }
+}
+
+} // namespace physics
+} // namespace rdge
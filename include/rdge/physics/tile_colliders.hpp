@@ -0,0 +1,47 @@
+//! \headerfile <rdge/physics/tile_colliders.hpp>
+//! \author Josh Bramlett
+//! \version 0.0.11
+//! \date 10/16/2026
+
+#pragma once
+
+#include <rdge/core.hpp>
+#include <rdge/math/vec2.hpp>
+
+#include <vector>
+
+//! \namespace rdge Rainbow Drop Game Engine
+namespace rdge {
+namespace physics {
+
+//! \struct tile_collider_grid
+//! \brief Grid of solid tiles to outline
+struct tile_collider_grid
+{
+    const uint8* solid = nullptr;    //!< Row major tile flags (non-zero is solid)
+    uint32 cols = 0;                 //!< Number of columns
+    uint32 rows = 0;                 //!< Number of rows (row zero is the bottom)
+    math::vec2 cell_size = { 1.f, 1.f }; //!< Tile size
+    math::vec2 origin;               //!< Bottom left corner of the first tile
+};
+
+//! \typedef Closed loop of chain vertices
+using TileChain = std::vector<math::vec2>;
+
+//! \brief Merge adjacent solid tiles into closed chains
+//! \details Traces the boundary between solid and empty tiles, so each
+//!          connected region of tiles becomes a single loop around its
+//!          perimeter (plus one loop per hole).  Collinear vertices are removed,
+//!          so a straight wall is a single segment regardless of the number of
+//!          tiles.  Tiles touching only at a corner are outlined separately.
+//!
+//!          Loops are wound so the solid tiles are on the left, which makes the
+//!          outer boundaries CCW and holes CW.  Loops are meant to be passed to
+//!          \ref RigidBody::CreateChain, whose one sided edges then face away
+//!          from the solid tiles.
+//! \param [in] grid Tiles to outline
+//! \returns Loops of vertices, where the last vertex connects to the first
+std::vector<TileChain> merge_tile_colliders (const tile_collider_grid& grid);
+
+} // namespace physics
+} // namespace rdge
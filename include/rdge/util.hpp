@@ -5,6 +5,7 @@
 #include <rdge/util/profiling.hpp>
 #include <rdge/util/strings.hpp>
 #include <rdge/util/timer.hpp>
+#include <rdge/util/worker_pool.hpp>
 #include <rdge/util/adt/simple_varray.hpp>
 #include <rdge/util/adt/stack_array.hpp>
 #include <rdge/util/containers/freelist.hpp>
@@ -111,7 +111,8 @@ struct stack_array
         RDGE_ASSERT(m_capacity > 0);
         RDGE_ASSERT(m_count < m_capacity);
 
-        memset(m_data + m_count, 0, sizeof(T));
+        // value initialized rather than cleared, as T may not be trivial
+        m_data[m_count] = T();
         return m_data[m_count++];
     }
 
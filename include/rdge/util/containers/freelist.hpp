@@ -13,6 +13,8 @@
 
 #include <utility>
 #include <stdexcept>
+#include <type_traits>
+#include <cstring>
 
 //! \namespace rdge Rainbow Drop Game Engine
 namespace rdge {
@@ -149,7 +151,8 @@ public:
         SDL_assert(handle < m_capacity);
         SDL_assert(is_reserved(handle));
 
-        memset(&m_data[handle], 0, sizeof(T));
+        // value initialized rather than cleared, as T may not be trivial
+        m_data[handle] = T();
         for (size_t i = 0; i < m_count; i++)
         {
             if (m_handles[i] == handle)
@@ -180,6 +183,47 @@ public:
     size_t capacity (void) const noexcept { return m_capacity; }
     //!@}
 
+    //!@{ Raw storage, where the first \ref size handles are reserved
+    const T* data (void) const noexcept { return m_data; }
+    const handle_type* handles (void) const noexcept { return m_handles; }
+    //!@}
+
+    //! \brief Replace the contents with a copy of raw storage
+    //! \details Handles reserved in the source remain valid.  Memory is only
+    //!          reallocated if the capacity differs.
+    //! \param [in] data Data array of the provided capacity
+    //! \param [in] handles Handle array of the provided capacity
+    //! \param [in] count Number of reserved handles
+    //! \param [in] capacity Capacity of the source arrays
+    //! \throws std::runtime_error Memory allocation failed
+    void assign (const T* data, const handle_type* handles, size_t count, size_t capacity)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+        SDL_assert(count <= capacity);
+
+        if (m_capacity != capacity)
+        {
+            m_capacity = capacity;
+            if (RDGE_UNLIKELY(!RDGE_TREALLOC(m_data, m_capacity, memory_bucket_containers)))
+            {
+                throw std::runtime_error("Memory allocation failed");
+            }
+
+            if (RDGE_UNLIKELY(!RDGE_TREALLOC(m_handles, m_capacity, memory_bucket_containers)))
+            {
+                throw std::runtime_error("Memory allocation failed");
+            }
+        }
+
+        if (capacity > 0)
+        {
+            memcpy(m_data, data, sizeof(T) * capacity);
+            memcpy(m_handles, handles, sizeof(handle_type) * capacity);
+        }
+
+        m_count = count;
+    }
+
 private:
 
     //! \brief Create handles for newly allocated blocks
@@ -0,0 +1,147 @@
+//! \headerfile <rdge/util/worker_pool.hpp>
+//! \author Josh Bramlett
+//! \version 0.0.11
+//! \date 10/16/2026
+
+#pragma once
+
+#include <rdge/core.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+//! \namespace rdge Rainbow Drop Game Engine
+namespace rdge {
+
+//! \class WorkerPool
+//! \brief Fixed set of threads used to split work over a range of items
+//! \details Work is submitted with \ref ParallelFor, which blocks until all
+//!          items have been processed.  The calling thread participates as
+//!          worker zero, so a pool with zero threads runs everything inline.
+//!          Items are handed out in batches from a shared counter, so the
+//!          assignment of items to workers is not deterministic.
+//! \warning Not reentrant.  Only one thread may submit work at a time, and
+//!          the work may not submit to the same pool.
+class WorkerPool
+{
+public:
+    //! \brief WorkerPool ctor
+    //! \details Spawns the worker threads, which remain idle until work is
+    //!          submitted.
+    //! \param [in] thread_count Number of threads to spawn (in addition to
+    //!                          the calling thread)
+    explicit WorkerPool (size_t thread_count = DefaultThreadCount());
+
+    //! \brief WorkerPool dtor
+    //! \details Joins all worker threads.
+    ~WorkerPool (void) noexcept;
+
+    //!@{ Non-copyable and non-movable
+    WorkerPool (const WorkerPool&) = delete;
+    WorkerPool& operator= (const WorkerPool&) = delete;
+    WorkerPool (WorkerPool&&) = delete;
+    WorkerPool& operator= (WorkerPool&&) = delete;
+    //!@}
+
+    //! \returns Number of workers, including the calling thread
+    size_t WorkerCount (void) const noexcept
+    {
+        return m_threads.size() + 1;
+    }
+
+    //! \brief Process a range of items across all workers
+    //! \details The callback is invoked with a sub-range of items and the index
+    //!          of the worker processing them, which is in [0, WorkerCount).
+    //!          The worker index can be used to access per-worker scratch data.
+    //!
+    //!          An exception thrown on the calling thread is rethrown once the
+    //!          worker threads have finished the remaining items.  Callbacks
+    //!          must not throw on the worker threads, which terminates.
+    //! \param [in] count Number of items
+    //! \param [in] batch_size Number of items processed per callback
+    //! \param [in] fn Callback of type void(size_t begin, size_t end, size_t worker)
+    template <typename Fn>
+    void ParallelFor (size_t count, size_t batch_size, Fn&& fn);
+
+    //! \returns Hardware thread count minus the calling thread
+    static size_t DefaultThreadCount (void) noexcept;
+
+private:
+    using job_fn = void (*)(void* context, size_t worker);
+
+    //! \brief Run the job on all workers and wait for completion
+    void Execute (job_fn fn, void* context);
+
+    //! \brief Wait for the worker threads to finish the current job
+    void Wait (void);
+
+    //! \brief Stop and join all worker threads
+    void Shutdown (void) noexcept;
+
+    //! \brief Worker thread entry point
+    void WorkerMain (size_t worker);
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_finish;
+
+    job_fn m_job = nullptr;
+    void* m_context = nullptr;
+    uint64 m_generation = 0; //!< Incremented for every job submitted
+    size_t m_active = 0;     //!< Worker threads still running the current job
+    bool m_shutdown = false;
+};
+
+template <typename Fn>
+inline void
+WorkerPool::ParallelFor (size_t count, size_t batch_size, Fn&& fn)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    batch_size = (batch_size == 0) ? 1 : batch_size;
+    if (m_threads.empty() || count <= batch_size)
+    {
+        fn(size_t(0), count, size_t(0));
+        return;
+    }
+
+    struct job
+    {
+        typename std::remove_reference<Fn>::type* fn;
+        size_t count;
+        size_t batch_size;
+        std::atomic<size_t> next;
+    } j;
+
+    j.fn = &fn;
+    j.count = count;
+    j.batch_size = batch_size;
+    j.next.store(0, std::memory_order_relaxed);
+
+    Execute([](void* context, size_t worker) {
+        auto& j = *static_cast<job*>(context);
+        while (true)
+        {
+            size_t begin = j.next.fetch_add(j.batch_size, std::memory_order_relaxed);
+            if (begin >= j.count)
+            {
+                return;
+            }
+
+            size_t end = std::min(begin + j.batch_size, j.count);
+            (*j.fn)(begin, end, worker);
+        }
+    }, &j);
+}
+
+} // namespace rdge
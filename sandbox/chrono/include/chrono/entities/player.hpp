@@ -16,7 +16,7 @@
 class PendingActionCache
 {
 public:
-    void Add (rdge::physics::Contact* contact,
+    void Add (const rdge::physics::sensor_event& overlap,
               fixture_user_data* child,
               fixture_user_data* sibling)
     {
@@ -24,18 +24,19 @@ public:
         auto& node = m_nodes[handle];
         node.next = nullptr;
         node.handle = handle;
-        node.contact = contact;
+        node.overlap = overlap;
         node.child = child;
         node.sibling = sibling;
 
         m_actions.push_back(node);
     }
 
-    void Remove (rdge::physics::Contact* contact)
+    void Remove (const rdge::physics::sensor_event& overlap)
     {
         for (auto& action : m_actions)
         {
-            if (action.contact == contact)
+            if (action.overlap.sensor == overlap.sensor &&
+                action.overlap.visitor == overlap.visitor)
             {
                 auto handle = action.handle;
                 m_actions.remove(action);
@@ -65,17 +66,17 @@ public:
     bool Empty (void) const noexcept { return m_nodes.empty(); }
 
 private:
-    // Pending actions represent sensor contacts that are currently
+    // Pending actions represent sensor overlaps that are currently
     // touching, but are not actionable unless invoked by the player.
     // The collision graph callbacks will send the notifications to
     // add/remove values from the list.
     struct pending_action
     {
         pending_action* next;
-        rdge::uint32 handle;                // handle to storage
-        rdge::physics::Contact* contact;    // contact that's touching
-        fixture_user_data* child;           // player fixture data
-        fixture_user_data* sibling;         // colliding fixture data
+        rdge::uint32 handle;                 // handle to storage
+        rdge::physics::sensor_event overlap; // sensor overlap that's touching
+        fixture_user_data* child;            // player fixture data
+        fixture_user_data* sibling;          // colliding fixture data
     };
 
     rdge::intrusive_forward_list<pending_action> m_actions;
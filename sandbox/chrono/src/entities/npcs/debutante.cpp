@@ -112,7 +112,7 @@ Debutante::OnUpdate (const delta_time& dt)
         }
     }
 
-    body->linear.velocity = (this->normal * velocity);
+    body->SetLinearVelocity(this->normal * velocity);
 
     auto& frame = this->m_currentAnimation->GetFrame(dt.ticks);
     math::vec2 screen_pos(this->body->GetWorldCenter() * g_game.ratios.world_to_screen);
@@ -264,13 +264,13 @@ Player::OnUpdate (const delta_time& dt)
 
 #if 0
     // high damping if directional normal is different than the linear velocity
-    body->linear.damping = (math::dot(this->normal, body->linear.velocity) > 0.f) ? 0.f : 9.f;
+    body->linear.damping = (math::dot(this->normal, body->GetLinearVelocity()) > 0.f) ? 0.f : 9.f;
 
-    math::vec2 delta = (this->normal * velocity_scale) - body->linear.velocity;
+    math::vec2 delta = (this->normal * velocity_scale) - body->GetLinearVelocity();
     math::vec2 impulse = delta * body->linear.mass;
     body->ApplyForce(impulse);
 #else
-    body->linear.velocity = (this->normal * velocity_scale);
+    body->SetLinearVelocity(this->normal * velocity_scale);
 #endif
 
     auto& frame = this->m_currentAnimation->GetFrame(dt.ticks);
@@ -3,16 +3,16 @@
 //!@{ Forward declarations
 namespace rdge {
 namespace physics {
-class Contact;
+struct sensor_event;
 } // namespace physics
 } // namespace rdge
 //!@}
 
 namespace perch {
 
-//!@{ Collision contact processing
-void ProcessContactStart (rdge::physics::Contact* contact);
-void ProcessContactEnd (rdge::physics::Contact* contact);
+//!@{ Sensor overlap processing
+void ProcessSensorBegin (const rdge::physics::sensor_event& event);
+void ProcessSensorEnd (const rdge::physics::sensor_event& event);
 //!@}
 
 } // namespace perch
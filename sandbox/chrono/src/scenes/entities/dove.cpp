@@ -86,7 +86,7 @@ Dove::OnUpdate (const delta_time& dt)
     if (is_flying)
     {
         math::vec2 desired_velocity(-5.f, 0.f);
-        this->body->ApplyLinearImpulse(desired_velocity - this->body->linear.velocity);
+        this->body->ApplyLinearImpulse(desired_velocity - this->body->GetLinearVelocity());
 
         const auto& frame = m_currentAnimation->GetFrame(dt.ticks);
         math::vec2 pos((this->body->GetWorldCenter() * g_game.ppm) - frame.origin);
@@ -102,7 +102,7 @@ Duck::OnUpdate (const delta_time& dt)
         math::vec2 d_normal = d.normalize();
         math::vec2 desired_velocity = d_normal * 10.f;
 
-        math::vec2 delta = desired_velocity - body->linear.velocity;
+        math::vec2 delta = desired_velocity - body->GetLinearVelocity();
         math::vec2 impulse = delta * body->linear.mass;
         body->ApplyForce(impulse);
     }
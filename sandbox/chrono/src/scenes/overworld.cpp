@@ -250,18 +250,6 @@ OverworldScene::OnRender (void)
     debug::SetProjection(camera.combined);
 }
 
-void
-OverworldScene::OnContactStart (Contact* c)
-{
-    perch::ProcessContactStart(c);
-}
-
-void
-OverworldScene::OnContactEnd (Contact* c)
-{
-    perch::ProcessContactEnd(c);
-}
-
 void
 OverworldScene::OnPreSolve (Contact* c, const collision_manifold& mf)
 {
@@ -279,6 +267,24 @@ OverworldScene::OnPostSolve (Contact* c)
               //<< c->impulse << std::endl;
 }
 
+void
+OverworldScene::OnSensorBegin (const sensor_event* events, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        perch::ProcessSensorBegin(events[i]);
+    }
+}
+
+void
+OverworldScene::OnSensorEnd (const sensor_event* events, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        perch::ProcessSensorEnd(events[i]);
+    }
+}
+
 void
 OverworldScene::OnDestroyed (Fixture*)
 { }
@@ -310,7 +316,7 @@ OverworldScene::UpdateWidget (void)
     ImGui::Spacing();
     ImGui::Indent(15.f);
     ImGui::Text("pos: %s", rdge::to_string(player.GetWorldCenter()).c_str());
-    ImGui::Text("vel: %s", rdge::to_string(player.body->linear.velocity).c_str());
+    ImGui::Text("vel: %s", rdge::to_string(player.body->GetLinearVelocity()).c_str());
     ImGui::Unindent(15.f);
     ImGui::Separator();
 
@@ -318,16 +324,16 @@ OverworldScene::UpdateWidget (void)
     ImGui::Spacing();
     ImGui::Indent(15.f);
     ImGui::Text("pos: %s", rdge::to_string(duck.GetWorldCenter()).c_str());
-    ImGui::Text("vel: %s", rdge::to_string(duck.body->linear.velocity).c_str());
+    ImGui::Text("vel: %s", rdge::to_string(duck.body->GetLinearVelocity()).c_str());
     ImGui::SliderFloat("#one", &duck.kb_impulse, 5.f, 100.f, "impulse = %.3f");
     ImGui::SliderFloat("#two", &duck.kb_damping, 5.f, 100.f, "damping = %.3f");
     ImGui::Unindent(15.f);
     ImGui::Separator();
 
     auto ab = player.GetWorldCenter() - duck.GetWorldCenter();
-    float dot = math::dot(ab, duck.body->linear.velocity);
+    float dot = math::dot(ab, duck.body->GetLinearVelocity());
 
-    float dot_normal_vel = math::dot(player.normal, player.body->linear.velocity);
+    float dot_normal_vel = math::dot(player.normal, player.body->GetLinearVelocity());
 
     ImGui::Text("Misc");
     ImGui::Spacing();
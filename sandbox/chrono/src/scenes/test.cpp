@@ -216,7 +216,7 @@ TestScene::UpdateWidget (void)
     ImGui::Spacing();
     ImGui::Indent(15.f);
     ImGui::Text("pos: %s", rdge::to_string(player.GetWorldCenter()).c_str());
-    ImGui::Text("vel: %s", rdge::to_string(player.body->linear.velocity).c_str());
+    ImGui::Text("vel: %s", rdge::to_string(player.body->GetLinearVelocity()).c_str());
     ImGui::Unindent(15.f);
     ImGui::Separator();
 
@@ -224,16 +224,16 @@ TestScene::UpdateWidget (void)
     ImGui::Spacing();
     ImGui::Indent(15.f);
     ImGui::Text("pos: %s", rdge::to_string(duck.GetWorldCenter()).c_str());
-    ImGui::Text("vel: %s", rdge::to_string(duck.body->linear.velocity).c_str());
+    ImGui::Text("vel: %s", rdge::to_string(duck.body->GetLinearVelocity()).c_str());
     ImGui::SliderFloat("#one", &duck.kb_impulse, 5.f, 100.f, "impulse = %.3f");
     ImGui::SliderFloat("#two", &duck.kb_damping, 5.f, 100.f, "damping = %.3f");
     ImGui::Unindent(15.f);
     ImGui::Separator();
 
     auto ab = player.GetWorldCenter() - duck.GetWorldCenter();
-    float dot = math::dot(ab, duck.body->linear.velocity);
+    float dot = math::dot(ab, duck.body->GetLinearVelocity());
 
-    float dot_normal_vel = math::dot(player.normal, player.body->linear.velocity);
+    float dot_normal_vel = math::dot(player.normal, player.body->GetLinearVelocity());
 
     ImGui::Text("Misc");
     ImGui::Spacing();
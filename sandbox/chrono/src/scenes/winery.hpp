@@ -37,10 +37,10 @@ public:
     //!@}
 
     //!@{ GraphListener - Physics Events
-    void OnContactStart (rdge::physics::Contact*) override;
-    void OnContactEnd (rdge::physics::Contact*) override;
     void OnPreSolve (rdge::physics::Contact*, const rdge::physics::collision_manifold&) override;
     void OnPostSolve (rdge::physics::Contact*) override;
+    void OnSensorBegin (const rdge::physics::sensor_event*, size_t) override;
+    void OnSensorEnd (const rdge::physics::sensor_event*, size_t) override;
     void OnDestroyed (rdge::physics::Fixture*) override;
     //!@}
 
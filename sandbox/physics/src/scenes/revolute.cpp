@@ -35,6 +35,7 @@ namespace {
 RevoluteScene::RevoluteScene (void)
     : collision_graph({ 0.f, -9.8f })
 {
+    collision_graph.SetFixedStep(1.f / 60.f);
     collision_graph.listener = &l;
 }
 
@@ -63,8 +64,8 @@ RevoluteScene::Initialize (void)
         ball->CreateFixture(&c, 5.f);
 
         float w = 100.f;
-        ball->linear.velocity = math::vec2(-8.f * w, 0.f);
-        ball->angular.velocity = w;
+        ball->SetLinearVelocity(math::vec2(-8.f * w, 0.f));
+        ball->SetAngularVelocity(w);
 
         joint = collision_graph.CreateRevoluteJoint(ground, ball, vec2(-10.f, 12.f));
         joint->SetMotorSpeed(1 * math::PI);
@@ -141,9 +142,7 @@ RevoluteScene::OnEvent (const Event& event)
 void
 RevoluteScene::OnUpdate (const delta_time& dt)
 {
-    Unused(dt);
-
-    collision_graph.Step(1.f / 60.f);
+    collision_graph.Update(dt.seconds);
     ILOG() << *ball;
 }
 
@@ -42,6 +42,7 @@ namespace {
 TestScene::TestScene (void)
     : collision_graph({ 0.f, -9.8f })
 {
+    collision_graph.SetFixedStep(1.f / 60.f);
     collision_graph.listener = &l;
     debug::settings::physics::draw_fixtures = true;
 }
@@ -117,9 +118,7 @@ TestScene::OnEvent (const Event& event)
 void
 TestScene::OnUpdate (const delta_time& dt)
 {
-    Unused(dt);
-
-    collision_graph.Step(1.f / 60.f);
+    collision_graph.Update(dt.seconds);
 }
 
 void
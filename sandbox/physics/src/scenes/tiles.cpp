@@ -15,6 +15,7 @@ using namespace rdge::physics;
 TilesScene::TilesScene (void)
     : collision_graph({ 0.f, -9.8f })
 {
+    collision_graph.SetFixedStep(1.f / 60.f);
     debug::settings::physics::draw_fixtures = true;
 }
 
@@ -115,9 +116,7 @@ TilesScene::OnEvent (const Event& event)
 void
 TilesScene::OnUpdate (const delta_time& dt)
 {
-    Unused(dt);
-
-    collision_graph.Step(1.f / 60.f);
+    collision_graph.Update(dt.seconds);
 }
 
 void
@@ -15,6 +15,7 @@ using namespace rdge::physics;
 TumblerScene::TumblerScene (void)
     : collision_graph({ 0.f, -9.8f })
 {
+    collision_graph.SetFixedStep(1.f / 60.f);
     debug::settings::physics::draw_fixtures = true;
 }
 
@@ -75,8 +76,8 @@ TumblerScene::OnEvent (const Event& event)
 void
 TumblerScene::OnUpdate (const delta_time& dt)
 {
-    tumbler->angular.velocity = 0.05f * math::PI;
-    tumbler->linear.velocity = { 0.f, 0.f };
+    tumbler->SetAngularVelocity(0.05f * math::PI);
+    tumbler->SetLinearVelocity({ 0.f, 0.f });
 
     rigid_body_profile bprof;
     bprof.type = RigidBodyType::DYNAMIC;
@@ -96,7 +97,7 @@ TumblerScene::OnUpdate (const delta_time& dt)
         }
     }
 
-    collision_graph.Step(1.f / 60.f);
+    collision_graph.Update(dt.seconds);
 }
 
 void
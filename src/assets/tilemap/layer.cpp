@@ -5,6 +5,8 @@
 #include <rdge/util/json.hpp>
 #include <rdge/util/strings.hpp>
 
+#include <algorithm>
+#include <limits>
 #include <sstream>
 #include <cstring> // strrchr
 
@@ -148,6 +150,62 @@ Layer::Layer (const nlohmann::json& j, Tilemap* tilemap)
     }
 }
 
+std::vector<physics::TileChain>
+Layer::GetCollisionChains (float scale) const
+{
+    if (this->type != LayerType::TILELAYER)
+    {
+        RDGE_THROW("Tilemap::Layer[" + this->name + "]: Collision chains require a tile layer");
+    }
+
+    // Chunk cells are in row major order with a y-is-down coordinate, so the
+    // rows are flipped when filling in the solid flags.  Layers without a parent
+    // have no chunk size, and store the data as a single chunk.
+    const auto& grid = this->tilelayer.grid;
+    int32 pitch = static_cast<int32>((grid.chunk_size.w > 0) ? grid.chunk_size.w : grid.size.w);
+    if (pitch <= 0 || this->tilelayer.chunks.size() == 0)
+    {
+        return { };
+    }
+
+    math::ivec2 lo(std::numeric_limits<int32>::max(), std::numeric_limits<int32>::max());
+    math::ivec2 hi(std::numeric_limits<int32>::lowest(), std::numeric_limits<int32>::lowest());
+    for (const auto& chunk : this->tilelayer.chunks)
+    {
+        int32 height = static_cast<int32>(chunk.data.size()) / pitch;
+        lo.x = std::min(lo.x, chunk.coord.x);
+        lo.y = std::min(lo.y, chunk.coord.y);
+        hi.x = std::max(hi.x, chunk.coord.x + pitch);
+        hi.y = std::max(hi.y, chunk.coord.y + height);
+    }
+
+    physics::tile_collider_grid colliders;
+    colliders.cols = static_cast<uint32>(hi.x - lo.x);
+    colliders.rows = static_cast<uint32>(hi.y - lo.y);
+
+    std::vector<uint8> solid(colliders.cols * colliders.rows, 0);
+    for (const auto& chunk : this->tilelayer.chunks)
+    {
+        for (size_t i = 0; i < chunk.data.size(); i++)
+        {
+            if (chunk.data[i])
+            {
+                int32 x = chunk.coord.x + static_cast<int32>(i % pitch) - lo.x;
+                int32 y = hi.y - 1 - (chunk.coord.y + static_cast<int32>(i / pitch));
+                solid[static_cast<size_t>((y * static_cast<int32>(colliders.cols)) + x)] = 1;
+            }
+        }
+    }
+
+    colliders.solid = solid.data();
+    colliders.cell_size.x = static_cast<float>(grid.cell_size.w) * scale;
+    colliders.cell_size.y = static_cast<float>(grid.cell_size.h) * scale;
+    colliders.origin.x = (this->offset.x * scale) + (colliders.cell_size.x * lo.x);
+    colliders.origin.y = -(this->offset.y * scale) - (colliders.cell_size.y * hi.y);
+
+    return physics::merge_tile_colliders(colliders);
+}
+
 std::ostream&
 operator<< (std::ostream& os, LayerType value)
 {
@@ -17,6 +17,7 @@
 #include <rdge/physics/shapes/ishape.hpp>
 #include <rdge/physics/shapes/circle.hpp>
 #include <rdge/physics/shapes/polygon.hpp>
+#include <rdge/physics/shapes/edge.hpp>
 #include <rdge/physics/fixture.hpp>
 #include <rdge/system/window.hpp>
 #include <rdge/util/compiler.hpp>
@@ -786,6 +787,12 @@ DrawWireFrame (const polygon& poly, const color& c, float scale)
     }
 }
 
+void
+DrawWireFrame (const edge& e, const color& c, float scale)
+{
+    DrawLine(e.v1 * scale, e.v2 * scale, c);
+}
+
 void
 DrawWireFrame (const ishape* shape, const color& c, float scale)
 {
@@ -797,6 +804,9 @@ DrawWireFrame (const ishape* shape, const color& c, float scale)
     case ShapeType::POLYGON:
         DrawWireFrame(*static_cast<const polygon*>(shape), c, scale);
         break;
+    case ShapeType::EDGE:
+        DrawWireFrame(*static_cast<const edge*>(shape), c, scale);
+        break;
     case ShapeType::INVALID:
     default:
         break;
@@ -9,6 +9,35 @@ namespace debug {
 
 using namespace rdge::physics;
 
+namespace {
+
+void
+BroadPhaseStats (const char* label, const IBroadPhase& broad_phase)
+{
+    ImGui::Text("%s", label);
+    ImGui::Spacing();
+    ImGui::Indent(15.f);
+    ImGui::Text("proxies:         %zu", broad_phase.ProxyCount());
+    if (broad_phase.Type() == BroadPhaseType::BVH)
+    {
+        const auto& tree = static_cast<const BVHTree&>(broad_phase);
+        ImGui::Text("height:          %d", tree.Height());
+        ImGui::Text("nodes:           %zu", tree.Size());
+        ImGui::Text("area ratio:      %.2f", tree.AreaRatio());
+    }
+    else
+    {
+        const auto& grid = static_cast<const SpatialHashGrid&>(broad_phase);
+        ImGui::Text("cell size:       %.2f x %.2f", grid.CellSize().x, grid.CellSize().y);
+        ImGui::Text("cell entries:    %zu", grid.EntryCount());
+        ImGui::Text("oversized:       %zu", grid.OversizedCount());
+    }
+
+    ImGui::Unindent(15.f);
+}
+
+} // anonymous namespace
+
 void
 PhysicsWidget::UpdateWidget (void)
 {
@@ -19,7 +48,7 @@ PhysicsWidget::UpdateWidget (void)
         return;
     }
 
-    ImGui::SetNextWindowSize(ImVec2(210.f, 410.f), ImGuiSetCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(210.f, 560.f), ImGuiSetCond_FirstUseEver);
     if (!ImGui::Begin("Physics", &show_widget))
     {
         ImGui::End();
@@ -39,8 +68,9 @@ PhysicsWidget::UpdateWidget (void)
     ImGui::Text("Graph");
     ImGui::Spacing();
     ImGui::Indent(15.f);
-    ImGui::Text("bodies:   %zu", active_graph->m_bodies.size());
-    ImGui::Text("contacts: %zu", active_graph->m_contacts.size());
+    ImGui::Text("bodies:   %zu (%zu awake)", active_graph->m_bodies.size(), active_graph->m_awakeBodies.size());
+    ImGui::Text("contacts: %zu (%zu awake)", active_graph->m_contacts.size(), active_graph->m_awakeContacts.size());
+    ImGui::Text("sensors:  %zu", active_graph->m_sensorOverlaps.size());
     ImGui::Text("joints:   %zu", active_graph->m_joints.size());
     ImGui::Unindent(15.f);
 
@@ -60,42 +90,62 @@ PhysicsWidget::UpdateWidget (void)
     ImGui::Separator();
     ImGui::Spacing();
 
-    ImGui::Text("BVH Tree");
+    BroadPhaseStats("Broad phase (static)", *active_graph->m_staticBroadPhase);
+
     ImGui::Spacing();
-    ImGui::Indent(15.f);
-    ImGui::Text("height:          %d", active_graph->m_tree.Height());
-    ImGui::Text("nodes:           %zu", active_graph->m_tree.Size());
-    ImGui::Unindent(15.f);
+    BroadPhaseStats("Broad phase (dynamic)", *active_graph->m_dynamicBroadPhase);
 
     ImGui::Spacing();
     ImGui::Separator();
     ImGui::Spacing();
 
-#ifdef RDGE_DEBUG_PROFILING
-    ImGui::Text("Profiling (us)");
-    ImGui::Spacing();
-    ImGui::Indent(15.f);
-    ImGui::Text("create contacts: %lld", active_graph->debug_profile.create_contacts);
-    ImGui::Text("purge contacts:  %lld", active_graph->debug_profile.purge_contacts);
-    ImGui::Text("solve:           %lld", active_graph->debug_profile.solve);
-    ImGui::Text("synchronize:     %lld", active_graph->debug_profile.synchronize);
-    ImGui::Text("---------------------");
-    ImGui::Text("total:           %lld", active_graph->debug_profile.create_contacts +
-                                         active_graph->debug_profile.purge_contacts +
-                                         active_graph->debug_profile.solve +
-                                         active_graph->debug_profile.synchronize);
-    ImGui::Unindent(15.f);
+    const auto& stats = active_graph->stats;
+    if (!stats.Empty())
+    {
+        const auto& last = stats.Last();
+        ImGui::Text("Profiling (us)");
+        ImGui::Spacing();
+        ImGui::Indent(15.f);
+        ImGui::Text("create contacts: %lld", static_cast<long long>(last.create_contacts));
+        ImGui::Text("purge contacts:  %lld", static_cast<long long>(last.purge_contacts));
+        ImGui::Text("update sensors:  %lld", static_cast<long long>(last.update_sensors));
+        ImGui::Text("solve:           %lld", static_cast<long long>(last.solve));
+        ImGui::Text("synchronize:     %lld", static_cast<long long>(last.synchronize));
+        ImGui::Text("solve toi:       %lld", static_cast<long long>(last.solve_toi));
+        ImGui::Text("---------------------");
+        ImGui::Text("total:           %lld", static_cast<long long>(last.total));
+
+        auto total = stats.Summarize(&step_stats::total);
+        ImGui::Text("avg:             %.0f", total.avg);
+        ImGui::Text("p99:             %.0f", total.p99);
+        ImGui::Text("max:             %.0f", total.max);
+        ImGui::Unindent(15.f);
 
-    ImGui::Spacing();
-    ImGui::Separator();
-    ImGui::Spacing();
-#endif
+        ImGui::Spacing();
+        ImGui::Text("Step");
+        ImGui::Spacing();
+        ImGui::Indent(15.f);
+        ImGui::Text("proxies moved:   %u", last.proxies_moved);
+        ImGui::Text("pairs tested:    %u", last.pairs_tested);
+        ImGui::Text("contacts +/-:    %u/%u", last.contacts_created, last.contacts_destroyed);
+        ImGui::Text("islands:         %u", last.islands);
+        ImGui::Text("bodies awake:    %u", last.bodies_awake);
+        ImGui::Text("iterations:      %u/%u", last.velocity_iterations, last.position_iterations);
+        ImGui::Unindent(15.f);
+
+        ImGui::Spacing();
+        ImGui::Separator();
+        ImGui::Spacing();
+    }
 
     bool prevent_sleep = active_graph->IsSleepPrevented();
     ImGui::Text("Properties");
     ImGui::Spacing();
     ImGui::Indent(15.f);
     ImGui::Checkbox("Prevent Sleep", &prevent_sleep);
+    ImGui::Checkbox("Wide Contact Solver", &active_graph->m_solver.wide_contacts);
+    ImGui::Checkbox("Block Contact Solver", &active_graph->m_solver.block_contacts);
+    ImGui::Checkbox("Soft Step Solver", &active_graph->m_solver.soft_step);
     ImGui::Unindent(15.f);
 
     if (prevent_sleep)
@@ -136,7 +186,8 @@ PhysicsWidget::OnWidgetCustomRender (void)
 
     if (draw_bvh_nodes)
     {
-        active_graph->m_tree.DebugDraw(scale);
+        active_graph->m_staticBroadPhase->DebugDraw(scale);
+        active_graph->m_dynamicBroadPhase->DebugDraw(scale);
     }
 
     if (draw_joints)
@@ -1,4 +1,6 @@
 #include <rdge/physics/bvh.hpp>
+#include <rdge/physics/snapshot.hpp>
+#include <rdge/util/worker_pool.hpp>
 
 #ifdef RDGE_DEBUG
 #include <rdge/debug/renderer.hpp>
@@ -6,15 +8,34 @@
 #endif
 
 #include <sstream>
+#include <limits>
 
 namespace rdge {
 namespace physics {
 
+namespace {
+
+// Number of bins the centroid bounds are split into when evaluating the SAH
+constexpr size_t SAH_BIN_COUNT = 16;
+
+// Subtrees deeper than this are split at the median to bound the tree height
+constexpr int32 SAH_MAX_DEPTH = 32;
+
+struct sah_bin
+{
+    aabb box;
+    size_t count = 0;
+};
+
+} // anonymous namespace
+
 void
 BVHTree::ClearProxies (void) noexcept
 {
     m_nodes.clear();
+    m_deferred.clear();
     m_root = bvh_node::NULL_NODE;
+    m_flags |= WIDE_LAYOUT_DIRTY;
 }
 
 int32
@@ -31,13 +52,38 @@ BVHTree::CreateProxy (const aabb& box, void* user_data)
     return handle;
 }
 
+int32
+BVHTree::CreateDeferredProxy (const aabb& box, void* user_data)
+{
+    int32 handle = CreateNode();
+
+    // detached leaves are flagged with a negative height
+    auto& node = m_nodes[handle];
+    node.height = -1;
+    node.user_data = user_data;
+    node.fat_box = box;
+    node.fat_box.fatten(FATTEN_AMOUNT);
+
+    m_deferred.push_back(handle);
+    return handle;
+}
+
 void
 BVHTree::DestroyProxy (int32 handle)
 {
     SDL_assert(handle != bvh_node::NULL_NODE);
     SDL_assert(m_nodes[handle].is_leaf());
 
-    RemoveLeaf(handle);
+    if (m_nodes[handle].height < 0)
+    {
+        m_deferred.erase(std::remove(m_deferred.begin(), m_deferred.end(), handle),
+                         m_deferred.end());
+    }
+    else
+    {
+        RemoveLeaf(handle);
+    }
+
     m_nodes.release(handle);
 }
 
@@ -52,6 +98,14 @@ BVHTree::MoveProxy (int32 handle, const aabb& box, const math::vec2& displacemen
         return false;
     }
 
+    if (node.height < 0)
+    {
+        // not in the tree, so the new box will be picked up by the build
+        node.fat_box = box;
+        node.fat_box.fatten(FATTEN_AMOUNT);
+        return true;
+    }
+
     RemoveLeaf(handle);
 
     node.fat_box = box;
@@ -80,6 +134,211 @@ BVHTree::MoveProxy (int32 handle, const aabb& box, const math::vec2& displacemen
     return true;
 }
 
+void
+BVHTree::Query (const std::vector<int32>& handles, PairBuffer& pairs) const
+{
+    for (int32 handle_a : handles)
+    {
+        const auto& node_a = m_nodes[handle_a];
+        SDL_assert(node_a.is_leaf());
+
+        QueryLeaves(node_a.fat_box, [&](int32 handle_b) {
+            if (handle_a != handle_b)
+            {
+                pairs.Insert(handle_a, handle_b);
+            }
+
+            return true;
+        });
+    }
+}
+
+void
+BVHTree::Query (QueryBatch& batch, WorkerPool* workers) const
+{
+    auto count = static_cast<uint32>(batch.Size());
+    size_t chunks = (count + QueryBatch::CHUNK_SIZE - 1) / QueryBatch::CHUNK_SIZE;
+    batch.Begin((workers) ? workers->WorkerCount() : 1);
+
+    auto resolve = [&](size_t begin, size_t end, size_t worker) {
+        for (size_t i = begin; i < end; i++)
+        {
+            uint32 lo = static_cast<uint32>(i) * QueryBatch::CHUNK_SIZE;
+            uint32 hi = std::min(lo + QueryBatch::CHUNK_SIZE, count);
+            QueryChunk(batch, lo, hi, batch.m_scratch[worker]);
+        }
+    };
+
+    if (workers && chunks > 1)
+    {
+        workers->ParallelFor(chunks, 1, resolve);
+    }
+    else
+    {
+        resolve(0, chunks, 0);
+    }
+
+    batch.Finish();
+}
+
+void
+BVHTree::QueryChunk (const QueryBatch& batch,
+                     uint32 begin,
+                     uint32 end,
+                     QueryBatch::worker_scratch& scratch) const
+{
+    using batch_entry = QueryBatch::batch_entry;
+
+    const aabb* boxes = batch.m_boxes.data();
+    auto& stack = scratch.stack;
+    auto& active = scratch.active;
+    auto& hits = scratch.hits;
+
+    // Each stack entry refers to the queries overlapping the node, stored as a
+    // range of the active list.  Ranges are appended when a node is pushed, and
+    // as the stack is LIFO everything past the range of the popped entry
+    // belongs to subtrees which have been completed.
+    stack.clear();
+    active.clear();
+    for (uint32 i = begin; i < end; i++)
+    {
+        auto q = static_cast<uint32>(batch.m_order[i]);
+        active.push_back({ boxes[q], q });
+    }
+
+    if (UsesWideLayout())
+    {
+        if (m_wideNodes.empty())
+        {
+            return;
+        }
+
+        auto& masks = scratch.masks;
+        stack.push_back({ 0, 0, static_cast<uint32>(active.size()), aabb() });
+        while (!stack.empty())
+        {
+            auto entry = stack.back();
+            stack.pop_back();
+            active.resize(entry.active_end);
+
+            // test every active query against all children at once
+            const auto& node = m_wideNodes[static_cast<size_t>(entry.node)];
+            masks.resize(entry.active_end - entry.active_begin);
+
+            int32 any = 0;
+            for (uint32 i = entry.active_begin; i < entry.active_end; i++)
+            {
+                int32 hit = node.overlaps(active[i].box);
+                masks[i - entry.active_begin] = static_cast<uint8>(hit);
+                any |= hit;
+            }
+
+            for (size_t c = 0; any != 0; c++, any >>= 1)
+            {
+                if ((any & 1) == 0)
+                {
+                    continue;
+                }
+
+                int32 child = node.children[c];
+                uint8 bit = static_cast<uint8>(1 << c);
+                if (bvh_wide_node::is_leaf(child))
+                {
+                    int32 handle = bvh_wide_node::decode_leaf(child);
+                    for (uint32 i = entry.active_begin; i < entry.active_end; i++)
+                    {
+                        if (masks[i - entry.active_begin] & bit)
+                        {
+                            hits.push_back({ active[i].query, handle });
+                        }
+                    }
+                }
+                else
+                {
+                    auto child_begin = static_cast<uint32>(active.size());
+                    for (uint32 i = entry.active_begin; i < entry.active_end; i++)
+                    {
+                        if (masks[i - entry.active_begin] & bit)
+                        {
+                            auto q = active[i];
+                            active.push_back(q);
+                        }
+                    }
+
+                    stack.push_back({ child, child_begin, static_cast<uint32>(active.size()), aabb() });
+                }
+            }
+        }
+
+        return;
+    }
+
+    if (m_root == bvh_node::NULL_NODE)
+    {
+        return;
+    }
+
+    // reports the parent queries overlapping a leaf, or pushes an internal
+    // node with the overlapping subset.  Nodes outside the bounds of all the
+    // parent queries are rejected without testing each query.
+    auto visit = [&](int32 handle, const batch_entry& parent) {
+        const auto& node = m_nodes[handle];
+        if (!parent.bounds.intersects_with(node.fat_box))
+        {
+            return;
+        }
+
+        if (node.is_leaf())
+        {
+            for (uint32 i = parent.active_begin; i < parent.active_end; i++)
+            {
+                if (active[i].box.intersects_with(node.fat_box))
+                {
+                    hits.push_back({ active[i].query, handle });
+                }
+            }
+
+            return;
+        }
+
+        auto node_begin = static_cast<uint32>(active.size());
+        aabb bounds;
+        for (uint32 i = parent.active_begin; i < parent.active_end; i++)
+        {
+            auto q = active[i];
+            if (q.box.intersects_with(node.fat_box))
+            {
+                bounds = (active.size() == node_begin) ? q.box : aabb::merge(bounds, q.box);
+                active.push_back(q);
+            }
+        }
+
+        auto node_end = static_cast<uint32>(active.size());
+        if (node_begin != node_end)
+        {
+            stack.push_back({ handle, node_begin, node_end, bounds });
+        }
+    };
+
+    batch_entry root = { m_root, 0, static_cast<uint32>(active.size()), active[0].box };
+    for (const auto& q : active)
+    {
+        root.bounds.merge(q.box);
+    }
+
+    visit(m_root, root);
+    while (!stack.empty())
+    {
+        auto entry = stack.back();
+        stack.pop_back();
+        active.resize(entry.active_end);
+
+        const auto& node = m_nodes[entry.node];
+        visit(node.left, entry);
+        visit(node.right, entry);
+    }
+}
+
 int32
 BVHTree::CreateNode (void)
 {
@@ -91,6 +350,7 @@ BVHTree::CreateNode (void)
     node.left = bvh_node::NULL_NODE;
     node.right = bvh_node::NULL_NODE;
     node.user_data = nullptr;
+    node.filter = proxy_filter();
 
     return handle;
 }
@@ -98,6 +358,8 @@ BVHTree::CreateNode (void)
 void
 BVHTree::InsertLeaf (int32 leaf_handle)
 {
+    m_flags |= WIDE_LAYOUT_DIRTY;
+
     if (m_root == bvh_node::NULL_NODE)
     {
         m_root = leaf_handle;
@@ -222,6 +484,8 @@ BVHTree::InsertLeaf (int32 leaf_handle)
 void
 BVHTree::RemoveLeaf (int32 leaf_handle)
 {
+    m_flags |= WIDE_LAYOUT_DIRTY;
+
     if (leaf_handle == m_root)
     {
         m_root = bvh_node::NULL_NODE;
@@ -421,6 +685,393 @@ BVHTree::Balance (int32 handle_a)
     return handle_a;
 }
 
+void
+BVHTree::Build (void)
+{
+    // Gather all leaves and release the internal nodes
+    std::vector<int32> leaves;
+    leaves.reserve(m_nodes.size() + m_deferred.size());
+
+    std::vector<int32> stack;
+    stack.push_back(m_root);
+    while (!stack.empty())
+    {
+        int32 handle = stack.back();
+        stack.pop_back();
+
+        if (handle == bvh_node::NULL_NODE)
+        {
+            continue;
+        }
+
+        const auto& node = m_nodes[handle];
+        if (node.is_leaf())
+        {
+            leaves.push_back(handle);
+        }
+        else
+        {
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+            m_nodes.release(handle);
+        }
+    }
+
+    leaves.insert(leaves.end(), m_deferred.begin(), m_deferred.end());
+    m_deferred.clear();
+
+    m_flags |= WIDE_LAYOUT_DIRTY;
+    m_root = bvh_node::NULL_NODE;
+    if (leaves.empty())
+    {
+        return;
+    }
+
+    for (int32 handle : leaves)
+    {
+        auto& node = m_nodes[handle];
+        node.height = 0;
+        node.parent = bvh_node::NULL_NODE;
+    }
+
+    m_root = BuildRange(leaves.data(), leaves.size(), 0);
+
+#ifdef RDGE_DEBUG
+    ValidateStructure(m_root);
+#endif
+}
+
+int32
+BVHTree::BuildRange (int32* leaves, size_t count, int32 depth)
+{
+    // Based on "On fast Construction of SAH-based Bounding Volume Hierarchies"
+    // (Wald, 2007).  Leaf centroids are binned along the longest axis of the
+    // centroid bounds, and the split minimizing the surface area heuristic is
+    // chosen.  In 2D the perimeter is used in place of the surface area.
+
+    if (count == 1)
+    {
+        return leaves[0];
+    }
+
+    auto centroid = [&](int32 handle, size_t axis) {
+        const auto& box = m_nodes[handle].fat_box;
+        return (axis == 0) ? (box.lo.x + box.hi.x) : (box.lo.y + box.hi.y);
+    };
+
+    math::vec2 c_lo(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+    math::vec2 c_hi(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+    for (size_t i = 0; i < count; i++)
+    {
+        math::vec2 c(centroid(leaves[i], 0), centroid(leaves[i], 1));
+        c_lo = math::vec2(std::min(c_lo.x, c.x), std::min(c_lo.y, c.y));
+        c_hi = math::vec2(std::max(c_hi.x, c.x), std::max(c_hi.y, c.y));
+    }
+
+    size_t axis = ((c_hi.x - c_lo.x) >= (c_hi.y - c_lo.y)) ? 0 : 1;
+    float axis_lo = (axis == 0) ? c_lo.x : c_lo.y;
+    float axis_extent = (axis == 0) ? (c_hi.x - c_lo.x) : (c_hi.y - c_lo.y);
+
+    size_t split = 0;
+    if (depth < SAH_MAX_DEPTH && axis_extent > 0.f)
+    {
+        float scale = static_cast<float>(SAH_BIN_COUNT) / axis_extent;
+        auto bin_index = [&](int32 handle) {
+            size_t b = static_cast<size_t>((centroid(handle, axis) - axis_lo) * scale);
+            return std::min(b, SAH_BIN_COUNT - 1);
+        };
+
+        sah_bin bins[SAH_BIN_COUNT];
+        for (size_t i = 0; i < count; i++)
+        {
+            auto& bin = bins[bin_index(leaves[i])];
+            const auto& box = m_nodes[leaves[i]].fat_box;
+            bin.box = (bin.count == 0) ? box : aabb::merge(bin.box, box);
+            bin.count++;
+        }
+
+        // Sweep from the right to get the cost of everything right of each split
+        float right_cost[SAH_BIN_COUNT];
+        aabb accumulated;
+        size_t accumulated_count = 0;
+        for (size_t i = SAH_BIN_COUNT - 1; i > 0; i--)
+        {
+            if (bins[i].count > 0)
+            {
+                accumulated = (accumulated_count == 0) ? bins[i].box
+                                                       : aabb::merge(accumulated, bins[i].box);
+                accumulated_count += bins[i].count;
+            }
+
+            right_cost[i] = (accumulated_count == 0)
+                ? 0.f
+                : accumulated.perimeter() * static_cast<float>(accumulated_count);
+        }
+
+        // Sweep from the left evaluating each split (bins [0, i) on the left)
+        float best_cost = std::numeric_limits<float>::max();
+        size_t best_bin = 0;
+        accumulated_count = 0;
+        for (size_t i = 1; i < SAH_BIN_COUNT; i++)
+        {
+            const auto& bin = bins[i - 1];
+            if (bin.count > 0)
+            {
+                accumulated = (accumulated_count == 0) ? bin.box
+                                                       : aabb::merge(accumulated, bin.box);
+                accumulated_count += bin.count;
+            }
+
+            if (accumulated_count == 0 || accumulated_count == count)
+            {
+                continue;
+            }
+
+            float cost = (accumulated.perimeter() * static_cast<float>(accumulated_count)) +
+                         right_cost[i];
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_bin = i;
+            }
+        }
+
+        if (best_bin > 0)
+        {
+            int32* mid = std::partition(leaves, leaves + count, [&](int32 handle) {
+                return bin_index(handle) < best_bin;
+            });
+
+            split = static_cast<size_t>(mid - leaves);
+        }
+    }
+
+    if (split == 0 || split == count)
+    {
+        // Degenerate centroids or depth limit reached, so split at the median
+        split = count / 2;
+        std::nth_element(leaves, leaves + split, leaves + count, [&](int32 a, int32 b) {
+            return centroid(a, axis) < centroid(b, axis);
+        });
+    }
+
+    int32 left = BuildRange(leaves, split, depth + 1);
+    int32 right = BuildRange(leaves + split, count - split, depth + 1);
+
+    // CreateNode may reallocate, so node references are taken afterwards
+    int32 handle = CreateNode();
+    auto& node = m_nodes[handle];
+    auto& left_node = m_nodes[left];
+    auto& right_node = m_nodes[right];
+
+    node.left = left;
+    node.right = right;
+    node.height = 1 + std::max(left_node.height, right_node.height);
+    node.fat_box = aabb::merge(left_node.fat_box, right_node.fat_box);
+    left_node.parent = handle;
+    right_node.parent = handle;
+
+    return handle;
+}
+
+float
+BVHTree::AreaRatio (void) const noexcept
+{
+    if (m_root == bvh_node::NULL_NODE)
+    {
+        return 0.f;
+    }
+
+    float root_area = m_nodes[m_root].fat_box.perimeter();
+    float total_area = 0.f;
+
+    std::vector<int32> stack;
+    stack.push_back(m_root);
+    while (!stack.empty())
+    {
+        int32 handle = stack.back();
+        stack.pop_back();
+
+        const auto& node = m_nodes[handle];
+        if (!node.is_leaf())
+        {
+            total_area += node.fat_box.perimeter();
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+
+    return (root_area > 0.f) ? (total_area / root_area) : 0.f;
+}
+
+void
+BVHTree::Save (snapshot_writer& writer) const
+{
+    writer.write(static_cast<uint64>(m_nodes.size()));
+    writer.write(static_cast<uint64>(m_nodes.capacity()));
+    writer.write(m_nodes.data(), m_nodes.capacity());
+    writer.write(m_nodes.handles(), m_nodes.capacity());
+
+    writer.write(m_root);
+    writer.write(static_cast<uint64>(m_deferred.size()));
+    writer.write(m_deferred.data(), m_deferred.size());
+}
+
+void
+BVHTree::Restore (snapshot_reader& reader)
+{
+    auto count = static_cast<size_t>(reader.read<uint64>());
+    auto capacity = static_cast<size_t>(reader.read<uint64>());
+    const auto* nodes = reader.read_array<bvh_node>(capacity);
+    const auto* handles = reader.read_array<freelist<bvh_node>::handle_type>(capacity);
+    m_nodes.assign(nodes, handles, count, capacity);
+
+    reader.read(m_root);
+    m_deferred.resize(static_cast<size_t>(reader.read<uint64>()));
+    reader.read(m_deferred.data(), m_deferred.size());
+
+    m_flags |= WIDE_LAYOUT_DIRTY;
+}
+
+size_t
+BVHTree::ProxyCount (void) const noexcept
+{
+    size_t count = 0;
+    for (size_t i = 0; i < m_nodes.size(); i++)
+    {
+        if (m_nodes.data()[m_nodes.handles()[i]].is_leaf())
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+void
+BVHTree::QueryProxies (const aabb& box, query_fn fn, void* context) const
+{
+    QueryLeaves(box, [=](int32 handle) {
+        return fn(context, handle);
+    });
+}
+
+void
+BVHTree::SweepProxies (const ray_cast_input& input,
+                       const math::vec2& extension,
+                       sweep_fn fn,
+                       void* context) const
+{
+    SweepLeaves(input, extension, [=](const ray_cast_input& sub_input, int32 handle) {
+        return fn(context, sub_input, handle);
+    });
+}
+
+void
+BVHTree::UpdateWideLayout (void)
+{
+    if ((m_flags & WIDE_LAYOUT) == 0 || (m_flags & WIDE_LAYOUT_DIRTY) == 0)
+    {
+        return;
+    }
+
+    m_flags &= ~WIDE_LAYOUT_DIRTY;
+    m_wideNodes.clear();
+    if (m_root == bvh_node::NULL_NODE)
+    {
+        return;
+    }
+
+    // Every wide node consumes at least one internal node of the binary tree,
+    // so the node count is a safe upper bound and next() will never realloc.
+    m_wideNodes.reserve(m_nodes.size());
+    m_wideNodes.next();
+
+    // stack pairs are the binary node handle and the wide node index it maps to
+    m_wideBuildStack.clear();
+    m_wideBuildStack.emplace_back(m_root, 0);
+    while (!m_wideBuildStack.empty())
+    {
+        int32 handle = m_wideBuildStack.back().first;
+        size_t index = static_cast<size_t>(m_wideBuildStack.back().second);
+        m_wideBuildStack.pop_back();
+
+        int32 lanes[bvh_wide_node::WIDTH];
+        size_t count = 0;
+
+        const auto& node = m_nodes[handle];
+        if (node.is_leaf())
+        {
+            // only possible when the root is a leaf
+            lanes[count++] = handle;
+        }
+        else
+        {
+            lanes[count++] = node.left;
+            lanes[count++] = node.right;
+        }
+
+        // Collapse by repeatedly opening the largest internal child
+        while (count < bvh_wide_node::WIDTH)
+        {
+            size_t best = count;
+            float best_perimeter = -1.f;
+            for (size_t i = 0; i < count; i++)
+            {
+                const auto& child = m_nodes[lanes[i]];
+                if (!child.is_leaf() && child.fat_box.perimeter() > best_perimeter)
+                {
+                    best = i;
+                    best_perimeter = child.fat_box.perimeter();
+                }
+            }
+
+            if (best == count)
+            {
+                break;
+            }
+
+            const auto& opened = m_nodes[lanes[best]];
+            lanes[best] = opened.left;
+            lanes[count++] = opened.right;
+        }
+
+        for (size_t i = 0; i < bvh_wide_node::WIDTH; i++)
+        {
+            auto& wide = m_wideNodes[index];
+            if (i >= count)
+            {
+                wide.lo_x[i] = std::numeric_limits<float>::max();
+                wide.lo_y[i] = std::numeric_limits<float>::max();
+                wide.hi_x[i] = std::numeric_limits<float>::lowest();
+                wide.hi_y[i] = std::numeric_limits<float>::lowest();
+                wide.children[i] = bvh_node::NULL_NODE;
+                continue;
+            }
+
+            const auto& child = m_nodes[lanes[i]];
+            wide.lo_x[i] = child.fat_box.lo.x;
+            wide.lo_y[i] = child.fat_box.lo.y;
+            wide.hi_x[i] = child.fat_box.hi.x;
+            wide.hi_y[i] = child.fat_box.hi.y;
+
+            if (child.is_leaf())
+            {
+                wide.children[i] = bvh_wide_node::encode_leaf(lanes[i]);
+            }
+            else
+            {
+                int32 child_index = static_cast<int32>(m_wideNodes.size());
+                m_wideNodes.next();
+
+                // reference is refreshed each iteration since next() was called
+                m_wideNodes[index].children[i] = child_index;
+                m_wideBuildStack.emplace_back(lanes[i], child_index);
+            }
+        }
+    }
+}
+
 void
 BVHTree::ValidateStructure (int32 index)
 {
@@ -1,15 +1,770 @@
 #include <rdge/physics/collision.hpp>
 #include <rdge/physics/shapes/polygon.hpp>
 #include <rdge/physics/shapes/circle.hpp>
+#include <rdge/physics/shapes/edge.hpp>
+#include <rdge/physics/rigid_body.hpp>
 #include <rdge/util/logger.hpp>
 
 #include <SDL_assert.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace rdge {
 namespace physics {
 
 using namespace rdge::math;
 
+namespace {
+
+// Polygon feature for a polygon/circle contact (the circle has no features)
+contact_feature
+circle_feature (size_t index, uint8 type)
+{
+    contact_feature result;
+    result.index_a = static_cast<uint8>(index);
+    result.type_a = type;
+    return result;
+}
+
+// Segment as a degenerate two vertex polygon.  Routines which only depend on
+// the vertices and edge normals (casts, separation) handle it unchanged, with
+// the segment treated as two sided.
+polygon
+segment_polygon (const edge& e)
+{
+    polygon result;
+    result.count = 2;
+    result.vertices[0] = e.v1;
+    result.vertices[1] = e.v2;
+    result.normals[0] = e.normal;
+    result.normals[1] = -e.normal;
+    result.centroid = e.get_centroid();
+    return result;
+}
+
+// Smallest non-negative t where |origin + t * d - center| = radius
+bool
+ray_cast_circle (const vec2& origin,
+                 const vec2& d,
+                 const vec2& center,
+                 float radius,
+                 float max_fraction,
+                 ray_cast_output& output)
+{
+    circle c(center, radius);
+    ray_cast_input input = { origin, origin + d, max_fraction };
+    return c.ray_cast(input, output);
+}
+
+// Squared distance from a point to the polygon (zero if contained)
+float
+distance_squared (const polygon& p, const vec2& point)
+{
+    float result = std::numeric_limits<float>::max();
+    bool inside = true;
+    for (size_t i = 0; i < p.count; i++)
+    {
+        const auto& v0 = p.vertices[i];
+        const auto& v1 = p.vertices[((i + 1) < p.count) ? (i + 1) : 0];
+        if (dot(p.normals[i], point - v0) > 0.f)
+        {
+            inside = false;
+        }
+
+        vec2 e = v1 - v0;
+        float t = clamp(dot(point - v0, e) / e.self_dot(), 0.f, 1.f);
+        result = std::min(result, (point - (v0 + e * t)).self_dot());
+    }
+
+    return (inside) ? 0.f : result;
+}
+
+// Ray cast against the polygon inflated by the radius (i.e. the Minkowski sum
+// of the polygon and a circle).  The rounded polygon is the union of the
+// polygon and a capsule around each edge, so the closest hit on any of the
+// capsule boundaries is the hit on the rounded polygon.
+bool
+ray_cast_rounded (const polygon& p,
+                  float radius,
+                  const vec2& origin,
+                  const vec2& d,
+                  float max_fraction,
+                  ray_cast_output& output)
+{
+    if (distance_squared(p, origin) < square(radius))
+    {
+        output.fraction = 0.f;
+        output.normal = { 0.f, 0.f };
+        return true;
+    }
+
+    bool hit = false;
+    float best = max_fraction;
+    for (size_t i = 0; i < p.count; i++)
+    {
+        const auto& n = p.normals[i];
+        const auto& v0 = p.vertices[i];
+        const auto& v1 = p.vertices[((i + 1) < p.count) ? (i + 1) : 0];
+
+        // edge offset by the radius, only approachable from the outside
+        float denominator = dot(n, d);
+        if (denominator < 0.f)
+        {
+            float t = (dot(n, v0) + radius - dot(n, origin)) / denominator;
+            if (0.f <= t && t <= best)
+            {
+                vec2 e = v1 - v0;
+                float s = dot((origin + d * t) - v0, e);
+                if (0.f <= s && s <= e.self_dot())
+                {
+                    best = t;
+                    output.fraction = t;
+                    output.normal = n;
+                    hit = true;
+                }
+            }
+        }
+
+        // rounded corner
+        ray_cast_output corner;
+        if (ray_cast_circle(origin, d, v0, radius, best, corner))
+        {
+            best = corner.fraction;
+            output = corner;
+            hit = true;
+        }
+    }
+
+    return hit;
+}
+
+// Casts polygon a against polygon b.  The configuration space obstacle (b - a)
+// is convex and bounded by the edge normals of b and the negated edge normals
+// of a, so the cast becomes a ray from the origin clipped against each of
+// those half-planes.
+bool
+shape_cast_polygons (const polygon& a,
+                     const vec2& d,
+                     const polygon& b,
+                     float max_fraction,
+                     ray_cast_output& output)
+{
+    float lower = 0.f;
+    float upper = max_fraction;
+    vec2 best_normal;
+    bool entered = false;
+
+    auto clip = [&](const vec2& n) {
+        // support of the configuration space obstacle along n
+        float h = b.project(n).y - a.project(n).x;
+        float denominator = dot(n, d);
+        if (denominator == 0.f)
+        {
+            return (h >= 0.f);
+        }
+
+        float t = h / denominator;
+        if (denominator < 0.f)
+        {
+            if (t > lower)
+            {
+                lower = t;
+                best_normal = n;
+                entered = true;
+            }
+        }
+        else if (t < upper)
+        {
+            upper = t;
+        }
+
+        return (lower <= upper);
+    };
+
+    for (size_t i = 0; i < b.count; i++)
+    {
+        if (!clip(b.normals[i]))
+        {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < a.count; i++)
+    {
+        if (!clip(-a.normals[i]))
+        {
+            return false;
+        }
+    }
+
+    output.fraction = lower;
+    output.normal = (entered) ? best_normal : vec2(0.f, 0.f);
+    return true;
+}
+
+// conservative advancement tolerances
+constexpr float TOI_TARGET = -0.5f * LINEAR_SLOP;
+constexpr float TOI_TOLERANCE = 0.25f * LINEAR_SLOP;
+constexpr size_t MAX_TOI_ITERATIONS = 20;
+
+// Copy of a local shape transformed to world space
+struct world_shape
+{
+    circle c;
+    polygon p;
+    const ishape* shape = nullptr;
+
+    world_shape (const ishape* local, const iso_transform& xf)
+    {
+        if (local->type() == ShapeType::CIRCLE)
+        {
+            c = *static_cast<const circle*>(local);
+            c.to_world(xf);
+            shape = &c;
+        }
+        else if (local->type() == ShapeType::EDGE)
+        {
+            edge e = *static_cast<const edge*>(local);
+            e.to_world(xf);
+            p = segment_polygon(e);
+            shape = &p;
+        }
+        else
+        {
+            p = *static_cast<const polygon*>(local);
+            p.to_world(xf);
+            shape = &p;
+        }
+    }
+};
+
+// Distance from the polygon to the circle, or the negative penetration depth
+float
+separation (const polygon& p, const circle& c)
+{
+    float d2 = distance_squared(p, c.pos);
+    if (d2 > 0.f)
+    {
+        return std::sqrt(d2) - c.radius;
+    }
+
+    float sep_max = std::numeric_limits<float>::lowest();
+    for (size_t i = 0; i < p.count; i++)
+    {
+        sep_max = std::max(sep_max, dot(p.normals[i], c.pos - p.vertices[i]));
+    }
+
+    return sep_max - c.radius;
+}
+
+// Lower bound of the distance between two world space shapes, which is the
+// negative penetration depth when overlapping
+float
+separation (const ishape* a, const ishape* b)
+{
+    if (a->type() == ShapeType::CIRCLE)
+    {
+        const auto& c = *static_cast<const circle*>(a);
+        if (b->type() == ShapeType::CIRCLE)
+        {
+            const auto& other = *static_cast<const circle*>(b);
+            return (other.pos - c.pos).length() - c.radius - other.radius;
+        }
+
+        return separation(*static_cast<const polygon*>(b), c);
+    }
+
+    const auto& p = *static_cast<const polygon*>(a);
+    if (b->type() == ShapeType::CIRCLE)
+    {
+        return separation(p, *static_cast<const circle*>(b));
+    }
+
+    const auto& other = *static_cast<const polygon*>(b);
+    return std::max(p.max_separation(other).first, other.max_separation(p).first);
+}
+
+// Upper bound of the distance any point on the shape travels over the sweep
+float
+motion_bound (const ishape* shape, const sweep_step& sweep)
+{
+    float radius = 0.f;
+    if (shape->type() == ShapeType::CIRCLE)
+    {
+        const auto& c = *static_cast<const circle*>(shape);
+        radius = (c.pos - sweep.local_center).length() + c.radius;
+    }
+    else if (shape->type() == ShapeType::EDGE)
+    {
+        const auto& e = *static_cast<const edge*>(shape);
+        radius = std::max((e.v1 - sweep.local_center).length(),
+                          (e.v2 - sweep.local_center).length());
+    }
+    else
+    {
+        const auto& p = *static_cast<const polygon*>(shape);
+        for (size_t i = 0; i < p.count; i++)
+        {
+            radius = std::max(radius, (p.vertices[i] - sweep.local_center).length());
+        }
+    }
+
+    return (sweep.pos_n - sweep.pos_0).length() +
+           (math::abs(sweep.angle_n - sweep.angle_0) * radius);
+}
+
+// GJK/EPA limits
+constexpr size_t MAX_GJK_ITERATIONS = 20;
+constexpr size_t MAX_EPA_VERTICES = 32;
+constexpr float EPA_TOLERANCE = 0.01f * LINEAR_SLOP;
+
+// Vertices of the shape core, where circles are a point inflated by a radius
+struct distance_proxy
+{
+    const vec2* vertices = nullptr;
+    size_t count = 0;
+    float radius = 0.f;
+    vec2 buffer[2];
+
+    explicit distance_proxy (const ishape* shape)
+    {
+        if (shape->type() == ShapeType::CIRCLE)
+        {
+            const auto& c = *static_cast<const circle*>(shape);
+            buffer[0] = c.pos;
+            vertices = buffer;
+            count = 1;
+            radius = c.radius;
+        }
+        else if (shape->type() == ShapeType::EDGE)
+        {
+            const auto& e = *static_cast<const edge*>(shape);
+            buffer[0] = e.v1;
+            buffer[1] = e.v2;
+            vertices = buffer;
+            count = 2;
+        }
+        else
+        {
+            const auto& p = *static_cast<const polygon*>(shape);
+            vertices = p.vertices.data();
+            count = p.count;
+        }
+    }
+
+    distance_proxy (const distance_proxy&) = delete;
+    distance_proxy& operator= (const distance_proxy&) = delete;
+
+    // Index of the farthest vertex along the (local space) direction
+    uint8 support (const vec2& d) const
+    {
+        size_t result = 0;
+        float best = dot(vertices[0], d);
+        for (size_t i = 1; i < count; i++)
+        {
+            float value = dot(vertices[i], d);
+            if (value > best)
+            {
+                result = i;
+                best = value;
+            }
+        }
+
+        return static_cast<uint8>(result);
+    }
+};
+
+// Vertex of the Minkowski difference (b - a)
+struct simplex_vertex
+{
+    vec2 w_a;         // world vertex of a
+    vec2 w_b;         // world vertex of b
+    vec2 w;           // w_b - w_a
+    float a = 0.f;    // barycentric coordinate of the closest point
+    uint8 index_a = 0;
+    uint8 index_b = 0;
+};
+
+// Shapes and transforms of a distance query
+struct distance_pair
+{
+    const distance_proxy& proxy_a;
+    const iso_transform& xf_a;
+    const distance_proxy& proxy_b;
+    const iso_transform& xf_b;
+
+    simplex_vertex vertex (uint8 index_a, uint8 index_b) const
+    {
+        simplex_vertex result;
+        result.index_a = index_a;
+        result.index_b = index_b;
+        result.w_a = xf_a.to_world(proxy_a.vertices[index_a]);
+        result.w_b = xf_b.to_world(proxy_b.vertices[index_b]);
+        result.w = result.w_b - result.w_a;
+        return result;
+    }
+
+    // Farthest vertex of the Minkowski difference along the direction
+    simplex_vertex support (const vec2& d) const
+    {
+        return vertex(proxy_a.support(xf_a.rot.inv_rotate(-d)),
+                      proxy_b.support(xf_b.rot.inv_rotate(d)));
+    }
+};
+
+// Simplex of the GJK distance algorithm.  Solving reduces the simplex to the
+// sub-simplex containing the point closest to the origin.
+// Based on Box2D b2Simplex
+struct gjk_simplex
+{
+    simplex_vertex v[3];
+    size_t count = 0;
+
+    void read_cache (const simplex_cache& cache, const distance_pair& pair)
+    {
+        count = 0;
+        for (size_t i = 0; i < cache.count; i++)
+        {
+            if (cache.index_a[i] >= pair.proxy_a.count || cache.index_b[i] >= pair.proxy_b.count)
+            {
+                // cache belongs to another pair of shapes
+                count = 0;
+                break;
+            }
+
+            v[count++] = pair.vertex(cache.index_a[i], cache.index_b[i]);
+        }
+
+        // flush the cache if the simplex has changed drastically
+        if (count > 1)
+        {
+            float metric_0 = cache.metric;
+            float metric_n = metric();
+            if (metric_n < 0.5f * metric_0 ||
+                2.f * metric_0 < metric_n ||
+                metric_n < std::numeric_limits<float>::epsilon())
+            {
+                count = 0;
+            }
+        }
+
+        if (count == 0)
+        {
+            v[0] = pair.vertex(0, 0);
+            v[0].a = 1.f;
+            count = 1;
+        }
+    }
+
+    void write_cache (simplex_cache& cache) const
+    {
+        cache.metric = metric();
+        cache.count = static_cast<uint8>(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            cache.index_a[i] = v[i].index_a;
+            cache.index_b[i] = v[i].index_b;
+        }
+    }
+
+    float metric (void) const
+    {
+        switch (count)
+        {
+        case 2:
+            return (v[1].w - v[0].w).length();
+        case 3:
+            return perp_dot(v[1].w - v[0].w, v[2].w - v[0].w);
+        default:
+            return 0.f;
+        }
+    }
+
+    vec2 search_direction (void) const
+    {
+        if (count == 1)
+        {
+            return -v[0].w;
+        }
+
+        // towards the origin from the segment
+        vec2 e = v[1].w - v[0].w;
+        return (perp_dot(e, -v[0].w) > 0.f) ? e.perp() : e.perp_ccw();
+    }
+
+    void witness_points (vec2& a, vec2& b) const
+    {
+        switch (count)
+        {
+        case 1:
+            a = v[0].w_a;
+            b = v[0].w_b;
+            break;
+        case 2:
+            a = (v[0].w_a * v[0].a) + (v[1].w_a * v[1].a);
+            b = (v[0].w_b * v[0].a) + (v[1].w_b * v[1].a);
+            break;
+        default:
+            a = (v[0].w_a * v[0].a) + (v[1].w_a * v[1].a) + (v[2].w_a * v[2].a);
+            b = a;
+            break;
+        }
+    }
+
+    // Closest point on the segment using barycentric coordinates
+    void solve2 (void)
+    {
+        vec2 e12 = v[1].w - v[0].w;
+
+        // w1 region
+        float d12_2 = -dot(v[0].w, e12);
+        if (d12_2 <= 0.f)
+        {
+            v[0].a = 1.f;
+            count = 1;
+            return;
+        }
+
+        // w2 region
+        float d12_1 = dot(v[1].w, e12);
+        if (d12_1 <= 0.f)
+        {
+            v[1].a = 1.f;
+            v[0] = v[1];
+            count = 1;
+            return;
+        }
+
+        float inv = 1.f / (d12_1 + d12_2);
+        v[0].a = d12_1 * inv;
+        v[1].a = d12_2 * inv;
+        count = 2;
+    }
+
+    // Closest point on the triangle, tested against the vertex, edge, and
+    // interior regions
+    void solve3 (void)
+    {
+        const vec2& w1 = v[0].w;
+        const vec2& w2 = v[1].w;
+        const vec2& w3 = v[2].w;
+
+        vec2 e12 = w2 - w1;
+        float d12_1 = dot(w2, e12);
+        float d12_2 = -dot(w1, e12);
+
+        vec2 e13 = w3 - w1;
+        float d13_1 = dot(w3, e13);
+        float d13_2 = -dot(w1, e13);
+
+        vec2 e23 = w3 - w2;
+        float d23_1 = dot(w3, e23);
+        float d23_2 = -dot(w2, e23);
+
+        float n123 = perp_dot(e12, e13);
+        float d123_1 = n123 * perp_dot(w2, w3);
+        float d123_2 = n123 * perp_dot(w3, w1);
+        float d123_3 = n123 * perp_dot(w1, w2);
+
+        // w1 region
+        if (d12_2 <= 0.f && d13_2 <= 0.f)
+        {
+            v[0].a = 1.f;
+            count = 1;
+            return;
+        }
+
+        // e12 region
+        if (d12_1 > 0.f && d12_2 > 0.f && d123_3 <= 0.f)
+        {
+            float inv = 1.f / (d12_1 + d12_2);
+            v[0].a = d12_1 * inv;
+            v[1].a = d12_2 * inv;
+            count = 2;
+            return;
+        }
+
+        // e13 region
+        if (d13_1 > 0.f && d13_2 > 0.f && d123_2 <= 0.f)
+        {
+            float inv = 1.f / (d13_1 + d13_2);
+            v[0].a = d13_1 * inv;
+            v[2].a = d13_2 * inv;
+            v[1] = v[2];
+            count = 2;
+            return;
+        }
+
+        // w2 region
+        if (d12_1 <= 0.f && d23_2 <= 0.f)
+        {
+            v[1].a = 1.f;
+            v[0] = v[1];
+            count = 1;
+            return;
+        }
+
+        // w3 region
+        if (d13_1 <= 0.f && d23_1 <= 0.f)
+        {
+            v[2].a = 1.f;
+            v[0] = v[2];
+            count = 1;
+            return;
+        }
+
+        // e23 region
+        if (d23_1 > 0.f && d23_2 > 0.f && d123_1 <= 0.f)
+        {
+            float inv = 1.f / (d23_1 + d23_2);
+            v[1].a = d23_1 * inv;
+            v[2].a = d23_2 * inv;
+            v[0] = v[2];
+            count = 2;
+            return;
+        }
+
+        // origin is within the triangle
+        float inv = 1.f / (d123_1 + d123_2 + d123_3);
+        v[0].a = d123_1 * inv;
+        v[1].a = d123_2 * inv;
+        v[2].a = d123_3 * inv;
+        count = 3;
+    }
+};
+
+// Expanding polytope algorithm.  Grows the final GJK simplex of overlapping
+// cores towards the boundary of the Minkowski difference, where the boundary
+// edge closest to the origin is the minimum translation to separate the cores.
+// Results are the core witness points, and the edge normal facing away from
+// the origin.  Returns false for a degenerate (zero area) difference.
+bool
+expand_polytope (const gjk_simplex& simplex,
+                 const distance_pair& pair,
+                 vec2& point_a,
+                 vec2& point_b,
+                 vec2& normal)
+{
+    simplex_vertex poly[MAX_EPA_VERTICES];
+    size_t count = simplex.count;
+    std::copy(simplex.v, simplex.v + count, poly);
+
+    // Touching cores leave a point or segment simplex, which is expanded
+    // to a triangle containing the origin on its boundary
+    static const vec2 AXES[4] = { { 1.f, 0.f }, { -1.f, 0.f }, { 0.f, 1.f }, { 0.f, -1.f } };
+    for (size_t i = 0; i < 4 && count == 1; i++)
+    {
+        simplex_vertex s = pair.support(AXES[i]);
+        if ((s.w - poly[0].w).self_dot() > square(EPA_TOLERANCE))
+        {
+            poly[count++] = s;
+        }
+    }
+
+    if (count == 2)
+    {
+        vec2 n = (poly[1].w - poly[0].w).perp();
+        for (float side : { 1.f, -1.f })
+        {
+            simplex_vertex s = pair.support(n * side);
+            if (dot(s.w - poly[0].w, n * side) > EPA_TOLERANCE)
+            {
+                poly[count++] = s;
+                break;
+            }
+        }
+    }
+
+    if (count < 3)
+    {
+        normal = (count == 2) ? (poly[1].w - poly[0].w).perp().normalize() : vec2(0.f, 1.f);
+        point_a = poly[0].w_a;
+        point_b = poly[0].w_b;
+        return false;
+    }
+
+    // wind CCW so edge normals point away from the origin
+    if (perp_dot(poly[1].w - poly[0].w, poly[2].w - poly[0].w) < 0.f)
+    {
+        std::swap(poly[1], poly[2]);
+    }
+
+    size_t edge = 0;
+    float edge_distance = 0.f;
+    while (true)
+    {
+        edge_distance = std::numeric_limits<float>::max();
+        for (size_t i = 0; i < count; i++)
+        {
+            vec2 n = (poly[(i + 1) % count].w - poly[i].w).perp_ccw().normalize();
+            float d = dot(n, poly[i].w);
+            if (d < edge_distance)
+            {
+                edge = i;
+                edge_distance = d;
+                normal = n;
+            }
+        }
+
+        if (count == MAX_EPA_VERTICES)
+        {
+            break;
+        }
+
+        simplex_vertex s = pair.support(normal);
+        if (dot(s.w, normal) - edge_distance < EPA_TOLERANCE)
+        {
+            break;
+        }
+
+        bool duplicate = false;
+        for (size_t i = 0; i < count; i++)
+        {
+            duplicate |= (poly[i].index_a == s.index_a && poly[i].index_b == s.index_b);
+        }
+
+        if (duplicate)
+        {
+            break;
+        }
+
+        std::copy_backward(poly + edge + 1, poly + count, poly + count + 1);
+        poly[edge + 1] = s;
+        count++;
+
+        // the new vertex may leave neighbors inside the polytope, which are
+        // removed to keep it convex
+        for (size_t i = 0; i < count && count > 3;)
+        {
+            const vec2& prev = poly[(i + count - 1) % count].w;
+            const vec2& next = poly[(i + 1) % count].w;
+            if (perp_dot(poly[i].w - prev, next - poly[i].w) <= 0.f)
+            {
+                std::copy(poly + i + 1, poly + count, poly + i);
+                count--;
+                i = 0;
+            }
+            else
+            {
+                i++;
+            }
+        }
+    }
+
+    // project the origin onto the closest edge
+    const auto& v0 = poly[edge];
+    const auto& v1 = poly[(edge + 1) % count];
+    vec2 e = v1.w - v0.w;
+    float t = clamp(-dot(v0.w, e) / e.self_dot(), 0.f, 1.f);
+    point_a = v0.w_a + ((v1.w_a - v0.w_a) * t);
+    point_b = v0.w_b + ((v1.w_b - v0.w_b) * t);
+    return true;
+}
+
+} // anonymous namespace
+
 bool
 intersects (const polygon& p, const circle& c, collision_manifold& mf)
 {
@@ -44,6 +799,7 @@ intersects (const polygon& p, const circle& c, collision_manifold& mf)
         mf.depths[0] = sep_max;
         mf.normal = p.normals[index_a];
         mf.plane = (vertex_a + vertex_b) * 0.5f;
+        mf.features[0] = circle_feature(index_a, contact_feature::FACE);
     }
     else if (math::dot(c.pos - vertex_a, vertex_b - vertex_a) <= 0.f)
     {
@@ -64,6 +820,7 @@ intersects (const polygon& p, const circle& c, collision_manifold& mf)
         mf.depths[0] = c.radius - a_zero.length();
         mf.normal = a_zero.normalize();
         mf.plane = vertex_a;
+        mf.features[0] = circle_feature(index_a, contact_feature::VERTEX);
     }
     else if (math::dot(c.pos - vertex_b, vertex_a - vertex_b) <= 0.f)
     {
@@ -81,6 +838,7 @@ intersects (const polygon& p, const circle& c, collision_manifold& mf)
         mf.depths[0] = c.radius - b_zero.length();
         mf.normal = b_zero.normalize();
         mf.plane = vertex_b;
+        mf.features[0] = circle_feature(index_b, contact_feature::VERTEX);
     }
     else
     {
@@ -99,11 +857,540 @@ intersects (const polygon& p, const circle& c, collision_manifold& mf)
         mf.depths[0] = s;
         mf.normal = p.normals[index_a];
         mf.plane = face_center;
+        mf.features[0] = circle_feature(index_a, contact_feature::FACE);
+    }
+
+    return true;
+}
+
+bool
+intersects (const edge& e, const circle& c, collision_manifold& mf)
+{
+    // Finds the closest feature of the segment to the circle center.  Based on
+    // Box2D b2CollideEdgeAndCircle()
+
+    mf.count = 0;
+
+    const auto& q = c.pos;
+    float offset = math::dot(e.normal, q - e.v1);
+    if (e.one_sided && offset < 0.f)
+    {
+        return false;
+    }
+
+    // barycentric coordinates of the center projected on the segment
+    vec2 ev = e.v2 - e.v1;
+    float u = math::dot(ev, e.v2 - q);
+    float v = math::dot(ev, q - e.v1);
+
+    size_t index = 0;
+    uint8 type = contact_feature::VERTEX;
+    vec2 closest;
+    if (v <= 0.f)
+    {
+        // Region v1) The previous segment of the chain owns the circle if the
+        // center projects onto it
+        if (e.one_sided && math::dot(e.v1 - e.v0, e.v1 - q) > 0.f)
+        {
+            return false;
+        }
+
+        closest = e.v1;
+    }
+    else if (u <= 0.f)
+    {
+        // Region v2) Same as above for the next segment
+        if (e.one_sided && math::dot(e.v3 - e.v2, q - e.v2) > 0.f)
+        {
+            return false;
+        }
+
+        index = 1;
+        closest = e.v2;
+    }
+    else
+    {
+        // Region v1v2) Faces are indexed by the side of the segment
+        index = (offset < 0.f) ? 1 : 0;
+        type = contact_feature::FACE;
+        closest = ((e.v1 * u) + (e.v2 * v)) * (1.f / ev.self_dot());
+    }
+
+    vec2 d = q - closest;
+    float dd = d.self_dot();
+    if (dd > math::square(c.radius))
+    {
+        return false;
+    }
+
+    float l = std::sqrt(dd);
+    mf.count = 1;
+    mf.contacts[0] = q;
+    mf.depths[0] = c.radius - l;
+    mf.plane = closest;
+    mf.flip = false;
+    mf.features[0] = circle_feature(index, type);
+
+    if (type == contact_feature::FACE || l == 0.f)
+    {
+        mf.normal = (offset < 0.f) ? -e.normal : e.normal;
+    }
+    else
+    {
+        mf.normal = d * (1.f / l);
+    }
+
+    return true;
+}
+
+bool
+intersects (const edge& e, const polygon& p, collision_manifold& mf)
+{
+    // SAT using the two sides of the segment and the polygon edge normals.
+    // One sided edges apply the ghost vertex rules to the chosen axis.  Based on
+    // Box2D b2CollideEdgeAndPolygon()
+
+    mf.count = 0;
+
+    if (e.one_sided && math::dot(e.normal, p.centroid - e.v1) < 0.f)
+    {
+        return false;
+    }
+
+    // a) separation on the sides of the segment
+    float edge_sep = std::numeric_limits<float>::lowest();
+    size_t edge_side = 0;
+    for (size_t side = 0; side < 2; side++)
+    {
+        vec2 n = (side == 0) ? e.normal : -e.normal;
+        float sep = math::dot(n, p.vertices[0] - e.v1);
+        for (size_t i = 1; i < p.count; i++)
+        {
+            sep = std::min(sep, math::dot(n, p.vertices[i] - e.v1));
+        }
+
+        if (sep > edge_sep)
+        {
+            edge_sep = sep;
+            edge_side = side;
+        }
+    }
+
+    if (edge_sep > 0.f)
+    {
+        return false;
+    }
+
+    // b) separation on the polygon edge normals
+    float poly_sep = std::numeric_limits<float>::lowest();
+    size_t poly_edge = 0;
+    for (size_t i = 0; i < p.count; i++)
+    {
+        float sep = std::min(math::dot(p.normals[i], e.v1 - p.vertices[i]),
+                             math::dot(p.normals[i], e.v2 - p.vertices[i]));
+        if (sep > poly_sep)
+        {
+            poly_sep = sep;
+            poly_edge = i;
+        }
+    }
+
+    if (poly_sep > 0.f)
+    {
+        return false;
+    }
+
+    // normal of the reference face pointing from the edge to the polygon
+    bool edge_reference = (poly_sep <= edge_sep + polygon::RELATIVE_TOLERANCE);
+    vec2 axis = (edge_reference) ? ((edge_side == 0) ? e.normal : -e.normal)
+                                 : -p.normals[poly_edge];
+
+    if (e.one_sided)
+    {
+        // Axes pointing past a convex vertex belong to the neighboring segment,
+        // and axes into a concave vertex are snapped to the segment normal.
+        constexpr float SIN_TOLERANCE = 0.1f;
+
+        vec2 tangent = (e.v2 - e.v1).normalize();
+        if (math::dot(axis, tangent) <= 0.f)
+        {
+            vec2 tangent0 = (e.v1 - e.v0).normalize();
+            if (math::perp_dot(tangent0, tangent) >= 0.f)
+            {
+                if (math::perp_dot(axis, tangent0.perp_ccw()) > SIN_TOLERANCE)
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                edge_reference = true;
+            }
+        }
+        else
+        {
+            vec2 tangent2 = (e.v3 - e.v2).normalize();
+            if (math::perp_dot(tangent, tangent2) >= 0.f)
+            {
+                if (math::perp_dot(tangent2.perp_ccw(), axis) > SIN_TOLERANCE)
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                edge_reference = true;
+            }
+        }
+
+        // the back side never acts as the reference
+        if (edge_reference)
+        {
+            edge_side = 0;
+            axis = e.normal;
+        }
     }
 
+    // build the reference face and incident vertices.  Features are stored
+    // relative to the edge (a) and polygon (b), where the edge faces are indexed
+    // by side and the vertices are v1 and v2.
+    vec2 ref_vertices[2];
+    size_t ref_index[2];
+    size_t inc_face = 0;
+    clip_vertex inc_vertices[2];
+    if (edge_reference)
+    {
+        // incident edge is most anti-parallel to the reference normal
+        size_t inc_edge = 0;
+        float d_min = math::dot(axis, p.normals[0]);
+        for (size_t i = 1; i < p.count; i++)
+        {
+            float d = math::dot(axis, p.normals[i]);
+            if (d < d_min)
+            {
+                d_min = d;
+                inc_edge = i;
+            }
+        }
+
+        // reference vertices are ordered so the face winds CCW about the normal
+        ref_vertices[0] = (edge_side == 0) ? e.v1 : e.v2;
+        ref_vertices[1] = (edge_side == 0) ? e.v2 : e.v1;
+        ref_index[0] = (edge_side == 0) ? 0 : 1;
+        ref_index[1] = (edge_side == 0) ? 1 : 0;
+
+        size_t next_v = ((inc_edge + 1) < p.count) ? (inc_edge + 1) : 0;
+        inc_vertices[0].point = p.vertices[inc_edge];
+        inc_vertices[0].feature = make_feature(edge_side, contact_feature::FACE,
+                                               inc_edge, contact_feature::VERTEX);
+        inc_vertices[1].point = p.vertices[next_v];
+        inc_vertices[1].feature = make_feature(edge_side, contact_feature::FACE,
+                                               next_v, contact_feature::VERTEX);
+        inc_face = inc_edge;
+        mf.flip = false;
+    }
+    else
+    {
+        ref_index[0] = poly_edge;
+        ref_index[1] = ((poly_edge + 1) < p.count) ? (poly_edge + 1) : 0;
+        ref_vertices[0] = p.vertices[ref_index[0]];
+        ref_vertices[1] = p.vertices[ref_index[1]];
+
+        inc_vertices[0].point = e.v2;
+        inc_vertices[0].feature = make_feature(poly_edge, contact_feature::FACE,
+                                               1, contact_feature::VERTEX);
+        inc_vertices[1].point = e.v1;
+        inc_vertices[1].feature = make_feature(poly_edge, contact_feature::FACE,
+                                               0, contact_feature::VERTEX);
+        inc_face = (math::dot(e.normal, axis) >= 0.f) ? 0 : 1;
+        mf.flip = true;
+    }
+
+    // clip incident vertices to the side planes of the reference face
+    vec2 tangent = (ref_vertices[1] - ref_vertices[0]).normalize();
+    half_plane left = { -tangent, math::dot(-tangent, ref_vertices[0]) };
+    half_plane right = { tangent, math::dot(tangent, ref_vertices[1]) };
+
+    clip_vertex left_clipped[2];
+    if (clip_segment(left_clipped, inc_vertices, left,
+                     make_feature(ref_index[0], contact_feature::VERTEX,
+                                  inc_face, contact_feature::FACE)) < 2)
+    {
+        return false;
+    }
+
+    clip_vertex clipped[2];
+    if (clip_segment(clipped, left_clipped, right,
+                     make_feature(ref_index[1], contact_feature::VERTEX,
+                                  inc_face, contact_feature::FACE)) < 2)
+    {
+        return false;
+    }
+
+    vec2 ref_normal = tangent.perp_ccw();
+    half_plane penetration_plane = { ref_normal, math::dot(ref_normal, ref_vertices[0]) };
+
+    size_t num_points = 0;
+    for (size_t i = 0; i < 2; i++)
+    {
+        const auto& point = clipped[i].point;
+        float d = distance(penetration_plane, point);
+        if (d < 0.f)
+        {
+            auto feature = clipped[i].feature;
+            if (mf.flip)
+            {
+                std::swap(feature.index_a, feature.index_b);
+                std::swap(feature.type_a, feature.type_b);
+            }
+
+            mf.contacts[num_points] = point;
+            mf.depths[num_points] = -d;
+            mf.features[num_points] = feature;
+            num_points++;
+        }
+    }
+
+    mf.count = num_points;
+    mf.normal = ref_normal;
+    mf.plane = (ref_vertices[0] + ref_vertices[1]) * 0.5f;
     return true;
 }
 
+bool
+shape_cast (const ishape* moving,
+            const math::vec2& translation,
+            const ishape* target,
+            float max_fraction,
+            ray_cast_output& output)
+{
+    SDL_assert(moving && target);
+
+    // edges are cast as two sided segments
+    polygon segments[2];
+    if (moving->type() == ShapeType::EDGE)
+    {
+        segments[0] = segment_polygon(*static_cast<const edge*>(moving));
+        moving = &segments[0];
+    }
+
+    if (target->type() == ShapeType::EDGE)
+    {
+        segments[1] = segment_polygon(*static_cast<const edge*>(target));
+        target = &segments[1];
+    }
+
+    ShapeType type_a = moving->type();
+    ShapeType type_b = target->type();
+    if (type_a == ShapeType::CIRCLE)
+    {
+        const auto& c = *static_cast<const circle*>(moving);
+        if (type_b == ShapeType::CIRCLE)
+        {
+            const auto& other = *static_cast<const circle*>(target);
+            float r = c.radius + other.radius;
+            if ((c.pos - other.pos).self_dot() < square(r))
+            {
+                output.fraction = 0.f;
+                output.normal = { 0.f, 0.f };
+                return true;
+            }
+
+            return ray_cast_circle(c.pos, translation, other.pos, r, max_fraction, output);
+        }
+        else if (type_b == ShapeType::POLYGON)
+        {
+            const auto& p = *static_cast<const polygon*>(target);
+            return ray_cast_rounded(p, c.radius, c.pos, translation, max_fraction, output);
+        }
+    }
+    else if (type_a == ShapeType::POLYGON)
+    {
+        const auto& p = *static_cast<const polygon*>(moving);
+        if (type_b == ShapeType::CIRCLE)
+        {
+            // Cast the circle backwards against the moving polygon.  The result
+            // normal is on the polygon surface, so flip it onto the target.
+            const auto& c = *static_cast<const circle*>(target);
+            if (ray_cast_rounded(p, c.radius, c.pos, -translation, max_fraction, output))
+            {
+                output.normal = -output.normal;
+                return true;
+            }
+
+            return false;
+        }
+        else if (type_b == ShapeType::POLYGON)
+        {
+            const auto& other = *static_cast<const polygon*>(target);
+            return shape_cast_polygons(p, translation, other, max_fraction, output);
+        }
+    }
+
+    return false;
+}
+
+void
+time_of_impact (const ishape* a,
+                 const sweep_step& sweep_a,
+                 const ishape* b,
+                 const sweep_step& sweep_b,
+                 float t_max,
+                 toi_output& output)
+{
+    SDL_assert(a && b);
+    SDL_assert(0.f <= t_max && t_max <= 1.f);
+
+    // No point on either shape can move further than the bound per unit of
+    // sweep, so advancing by (separation / bound) never passes the surface.
+    float bound = motion_bound(a, sweep_a) + motion_bound(b, sweep_b);
+
+    float t = 0.f;
+    for (size_t i = 0; i < MAX_TOI_ITERATIONS; i++)
+    {
+        world_shape shape_a(a, sweep_a.lerp_transform(t));
+        world_shape shape_b(b, sweep_b.lerp_transform(t));
+
+        float d = separation(shape_a.shape, shape_b.shape);
+        if (d < (TOI_TARGET + TOI_TOLERANCE))
+        {
+            bool overlapped = (i == 0) && (d < (TOI_TARGET - TOI_TOLERANCE));
+            output.state = (overlapped) ? toi_output::OVERLAPPED : toi_output::TOUCHING;
+            output.t = t;
+            return;
+        }
+
+        if (bound <= std::numeric_limits<float>::epsilon())
+        {
+            break;
+        }
+
+        t += (d - TOI_TARGET) / bound;
+        if (t >= t_max)
+        {
+            break;
+        }
+
+        if (i == (MAX_TOI_ITERATIONS - 1))
+        {
+            output.state = toi_output::FAILED;
+            output.t = t;
+            return;
+        }
+    }
+
+    output.state = toi_output::SEPARATED;
+    output.t = t_max;
+}
+
+void
+distance (const ishape* a,
+          const iso_transform& xf_a,
+          const ishape* b,
+          const iso_transform& xf_b,
+          simplex_cache& cache,
+          distance_output& output)
+{
+    // Based on Box2D b2Distance()
+    distance_proxy proxy_a(a);
+    distance_proxy proxy_b(b);
+    distance_pair pair = { proxy_a, xf_a, proxy_b, xf_b };
+
+    gjk_simplex simplex;
+    simplex.read_cache(cache, pair);
+
+    // last simplex vertices, to detect cycling
+    uint8 save_a[3];
+    uint8 save_b[3];
+
+    size_t iterations = 0;
+    while (iterations < MAX_GJK_ITERATIONS)
+    {
+        size_t save_count = simplex.count;
+        for (size_t i = 0; i < save_count; i++)
+        {
+            save_a[i] = simplex.v[i].index_a;
+            save_b[i] = simplex.v[i].index_b;
+        }
+
+        if (simplex.count == 2)
+        {
+            simplex.solve2();
+        }
+        else if (simplex.count == 3)
+        {
+            simplex.solve3();
+        }
+
+        // origin is contained by the simplex
+        if (simplex.count == 3)
+        {
+            break;
+        }
+
+        // origin is on the simplex (touching or overlapping)
+        vec2 d = simplex.search_direction();
+        if (d.self_dot() < square(std::numeric_limits<float>::epsilon()))
+        {
+            break;
+        }
+
+        simplex_vertex s = pair.support(d);
+        iterations++;
+
+        // no progress can be made if the vertex is already in the simplex
+        bool duplicate = false;
+        for (size_t i = 0; i < save_count; i++)
+        {
+            duplicate |= (s.index_a == save_a[i] && s.index_b == save_b[i]);
+        }
+
+        if (duplicate)
+        {
+            break;
+        }
+
+        simplex.v[simplex.count++] = s;
+    }
+
+    simplex.write_cache(cache);
+    output.iterations = iterations;
+
+    vec2 core_a;
+    vec2 core_b;
+    simplex.witness_points(core_a, core_b);
+
+    float core_distance = (core_b - core_a).length();
+    if (simplex.count < 3 && core_distance > std::numeric_limits<float>::epsilon())
+    {
+        output.normal = (core_b - core_a) * (1.f / core_distance);
+    }
+    else
+    {
+        // cores overlap, so the normal is the separating direction of b
+        vec2 n;
+        expand_polytope(simplex, pair, core_a, core_b, n);
+        output.normal = -n;
+        core_distance = -(core_b - core_a).length();
+    }
+
+    // inflate the cores by their radii
+    output.point_a = core_a + (output.normal * proxy_a.radius);
+    output.point_b = core_b - (output.normal * proxy_b.radius);
+    output.distance = core_distance - proxy_a.radius - proxy_b.radius;
+}
+
+void
+distance (const ishape* a,
+          const iso_transform& xf_a,
+          const ishape* b,
+          const iso_transform& xf_b,
+          distance_output& output)
+{
+    simplex_cache cache;
+    distance(a, xf_a, b, xf_b, cache, output);
+}
+
 std::ostream& operator<< (std::ostream& os, const collision_manifold& mf)
 {
     if (mf.count == 0)
@@ -1,14 +1,263 @@
 #include <rdge/physics/collision_graph.hpp>
 #include <rdge/physics/joints/revolute_joint.hpp>
+#include <rdge/physics/shapes/circle.hpp>
+#include <rdge/physics/shapes/edge.hpp>
+#include <rdge/physics/shapes/polygon.hpp>
+#include <rdge/util/exception.hpp>
 #include <rdge/util/profiling.hpp>
+#include <rdge/util/worker_pool.hpp>
 
-#include <algorithm> // remove_if
+#include <algorithm> // remove_if, find, none_of, max
+#include <chrono>
+#include <cmath>
+#include <cstring> // memcpy
+#include <limits>
+#include <utility> // swap
 
 namespace rdge {
 namespace physics {
 
 namespace {
 
+// squared to avoid sqrt
+constexpr float LINEAR_SLEEP_TOLERANCE_SQUARED = math::square(Solver::LINEAR_SLEEP_TOLERANCE);
+constexpr float ANGULAR_SLEEP_TOLERANCE_SQUARED = math::square(Solver::ANGULAR_SLEEP_TOLERANCE);
+
+// contacts evaluated per worker batch during the narrow phase
+constexpr size_t NARROW_PHASE_BATCH_SIZE = 32;
+
+// impacts resolved per bullet per step
+constexpr size_t MAX_TOI_SUBSTEPS = 8;
+
+// snapshot header, where the version is incremented when the layout changes
+constexpr uint32 SNAPSHOT_MAGIC = 0x53474452; // "RDGS"
+constexpr uint32 SNAPSHOT_VERSION = 6;
+
+// contact state is written as a single record to keep snapshots cheap
+struct snapshot_contact
+{
+    int32 key_a;
+    int32 key_b;
+    uint16 flags;
+    int32 awake_index;
+    float friction;
+    float restitution;
+    float tangent_speed;
+    collision_manifold manifold;
+    contact_impulse impulse;
+};
+
+// sensor overlaps reference fixtures by proxy key, like contacts
+struct snapshot_sensor
+{
+    int32 key_sensor;
+    int32 key_visitor;
+    bool touching;
+};
+
+// Unique key of an unordered pair of proxy keys
+uint64
+sensor_pair_key (int32 a, int32 b) noexcept
+{
+    auto lo = static_cast<uint32>(std::min(a, b));
+    auto hi = static_cast<uint32>(std::max(a, b));
+    return (static_cast<uint64>(lo) << 32) | hi;
+}
+
+// Copy of the fixture filter tested by the broad phase
+proxy_filter
+make_proxy_filter (const Fixture* fixture) noexcept
+{
+    proxy_filter result;
+    result.category = fixture->filter.category;
+    result.mask = fixture->filter.mask;
+    result.group = fixture->filter.group;
+    if (!fixture->body->IsDynamic())
+    {
+        result.flags |= proxy_filter::NON_DYNAMIC;
+    }
+
+    return result;
+}
+
+// Static proxies rarely move, so grids don't pad them
+std::unique_ptr<IBroadPhase>
+CreateBroadPhase (BroadPhaseType type, const math::vec2& cell_size, bool is_static)
+{
+    if (type == BroadPhaseType::SPATIAL_HASH)
+    {
+        float margin = is_static ? 0.f : SpatialHashGrid::FATTEN_AMOUNT;
+        return std::unique_ptr<IBroadPhase>(new SpatialHashGrid(cell_size, margin));
+    }
+
+    return std::unique_ptr<IBroadPhase>(new BVHTree);
+}
+
+// Build the contact manifold of two local shapes at the provided transforms
+void
+toi_manifold (const ishape* a, const iso_transform& xf_a,
+              const ishape* b, const iso_transform& xf_b,
+              collision_manifold& mf)
+{
+    circle circles[2];
+    polygon polygons[2];
+    edge edges[2];
+    ishape* world[2];
+
+    const ishape* local[2] = { a, b };
+    const iso_transform* xf[2] = { &xf_a, &xf_b };
+    for (size_t i = 0; i < 2; i++)
+    {
+        if (local[i]->type() == ShapeType::CIRCLE)
+        {
+            circles[i] = *static_cast<const circle*>(local[i]);
+            world[i] = &circles[i];
+        }
+        else if (local[i]->type() == ShapeType::EDGE)
+        {
+            edges[i] = *static_cast<const edge*>(local[i]);
+            world[i] = &edges[i];
+        }
+        else
+        {
+            polygons[i] = *static_cast<const polygon*>(local[i]);
+            world[i] = &polygons[i];
+        }
+
+        world[i]->to_world(*xf[i]);
+    }
+
+    mf.count = 0;
+    ShapeType type_a = world[0]->type();
+    ShapeType type_b = world[1]->type();
+    if ((type_a == ShapeType::CIRCLE && type_b == ShapeType::POLYGON) ||
+        (type_a != ShapeType::EDGE && type_b == ShapeType::EDGE))
+    {
+        // b must be primary, so flip the normal back to point from a to b
+        world[1]->intersects_with(world[0], mf);
+        mf.flip = !mf.flip;
+    }
+    else
+    {
+        world[0]->intersects_with(world[1], mf);
+    }
+}
+
+// impulse iterations when resolving a time of impact
+constexpr size_t TOI_VELOCITY_ITERATIONS = 20;
+
+// Sequential impulses removing the approaching velocity of an impact.  Body a
+// is located at center_a, and body b at the end of the step.
+void
+resolve_impact (RigidBody* a, const math::vec2& center_a, RigidBody* b,
+                const collision_manifold& mf, float friction, float restitution)
+{
+    struct impact_point
+    {
+        math::vec2 rel_point[2];
+        float normal_impulse = 0.f;
+        float tangent_impulse = 0.f;
+        float normal_mass = 0.f;
+        float tangent_mass = 0.f;
+        float velocity_bias = 0.f;
+    } points[2];
+
+    const auto& la = a->linear;
+    const auto& aa = a->angular;
+    const auto& lb = b->linear;
+    const auto& ab = b->angular;
+    math::vec2 va = a->GetLinearVelocity();
+    float wa = a->GetAngularVelocity();
+    math::vec2 vb = b->GetLinearVelocity();
+    float wb = b->GetAngularVelocity();
+    math::vec2 normal = mf.oriented_normal();
+    math::vec2 tangent = normal.perp_ccw();
+
+    auto relative_velocity = [&](const impact_point& ip) {
+        return (vb + (ip.rel_point[1].perp() * wb)) -
+               (va + (ip.rel_point[0].perp() * wa));
+    };
+
+    auto apply = [&](const impact_point& ip, const math::vec2& impulse) {
+        va -= la.inv_mass * impulse;
+        wa -= aa.inv_mmoi * math::perp_dot(ip.rel_point[0], impulse);
+        vb += lb.inv_mass * impulse;
+        wb += ab.inv_mmoi * math::perp_dot(ip.rel_point[1], impulse);
+    };
+
+    float inv_mass = la.inv_mass + lb.inv_mass;
+    for (size_t i = 0; i < mf.count; i++)
+    {
+        auto& ip = points[i];
+        ip.rel_point[0] = mf.contacts[i] - center_a;
+        ip.rel_point[1] = mf.contacts[i] - b->GetWorldCenter();
+
+        float enm = inv_mass +
+                    (aa.inv_mmoi * math::square(math::perp_dot(ip.rel_point[0], normal))) +
+                    (ab.inv_mmoi * math::square(math::perp_dot(ip.rel_point[1], normal)));
+        float etm = inv_mass +
+                    (aa.inv_mmoi * math::square(math::perp_dot(ip.rel_point[0], tangent))) +
+                    (ab.inv_mmoi * math::square(math::perp_dot(ip.rel_point[1], tangent)));
+        ip.normal_mass = (enm > 0.f) ? (1.f / enm) : 0.f;
+        ip.tangent_mass = (etm > 0.f) ? (1.f / etm) : 0.f;
+
+        float rnv = math::dot(normal, relative_velocity(ip));
+        if (rnv < -Solver::VELOCITY_THRESHOLD)
+        {
+            ip.velocity_bias = rnv * -restitution;
+        }
+    }
+
+    for (size_t iteration = 0; iteration < TOI_VELOCITY_ITERATIONS; iteration++)
+    {
+        for (size_t i = 0; i < mf.count; i++)
+        {
+            auto& ip = points[i];
+
+            float lambda = -ip.tangent_mass * math::dot(tangent, relative_velocity(ip));
+            float max_friction = friction * ip.normal_impulse;
+            float new_impulse = math::clamp(ip.tangent_impulse + lambda,
+                                            -max_friction, max_friction);
+            apply(ip, tangent * (new_impulse - ip.tangent_impulse));
+            ip.tangent_impulse = new_impulse;
+        }
+
+        for (size_t i = 0; i < mf.count; i++)
+        {
+            auto& ip = points[i];
+
+            float rnv = math::dot(normal, relative_velocity(ip));
+            float lambda = -ip.normal_mass * (rnv - ip.velocity_bias);
+            float new_impulse = std::max(ip.normal_impulse + lambda, 0.f);
+            apply(ip, normal * (new_impulse - ip.normal_impulse));
+            ip.normal_impulse = new_impulse;
+        }
+    }
+
+    a->SetLinearVelocity(va);
+    a->SetAngularVelocity(wa);
+    b->SetLinearVelocity(vb);
+    b->SetAngularVelocity(wb);
+}
+
+// Reserve a handle in dense state storage, reusing released handles first
+template <typename T>
+int32
+reserve_state (std::vector<T>& states, std::vector<int32>& free_handles)
+{
+    if (free_handles.empty())
+    {
+        states.emplace_back();
+        return static_cast<int32>(states.size() - 1);
+    }
+
+    int32 handle = free_handles.back();
+    free_handles.pop_back();
+    states[static_cast<size_t>(handle)] = T();
+
+    return handle;
+}
+
 ContactFilter s_defaultContactFilter;
 GraphListener s_defaultGraphListener;
 
@@ -17,6 +266,8 @@ GraphListener s_defaultGraphListener;
 CollisionGraph::CollisionGraph (const math::vec2& g)
     : custom_filter(&s_defaultContactFilter)
     , listener(&s_defaultGraphListener)
+    , m_staticBroadPhase(new BVHTree)
+    , m_dynamicBroadPhase(new BVHTree)
     , m_solver(&m_step)
     , m_flags(CLEAR_FORCES)
 {
@@ -29,6 +280,51 @@ CollisionGraph::~CollisionGraph (void) noexcept
     ClearGraph();
 }
 
+void
+CollisionGraph::SetBroadPhase (BroadPhaseType static_type,
+                               BroadPhaseType dynamic_type,
+                               const math::vec2& cell_size)
+{
+    if (IsLocked())
+    {
+        SDL_assert(false);
+        return;
+    }
+
+    if (!m_bodies.empty())
+    {
+        RDGE_THROW("Broad phase can only be changed while the graph is empty");
+    }
+
+    auto static_broad_phase = CreateBroadPhase(static_type, cell_size, true);
+    auto dynamic_broad_phase = CreateBroadPhase(dynamic_type, cell_size, false);
+    m_staticBroadPhase = std::move(static_broad_phase);
+    m_dynamicBroadPhase = std::move(dynamic_broad_phase);
+    m_cellSize = cell_size;
+
+    SetWideBroadPhase((m_flags & WIDE_BROAD) != 0);
+}
+
+void
+CollisionGraph::SetWideBroadPhase (bool enable) noexcept
+{
+    SET_FLAG(enable, m_flags, WIDE_BROAD);
+
+    // the dynamic tree is restructured by every proxy move, which would force a
+    // full collapse each step, so only the static tree uses the wide layout
+    if (m_staticBroadPhase->Type() == BroadPhaseType::BVH)
+    {
+        static_cast<BVHTree*>(m_staticBroadPhase.get())->EnableWideLayout(enable);
+    }
+}
+
+void
+CollisionGraph::SetSubsteps (size_t count) noexcept
+{
+    SDL_assert(count > 0);
+    m_solver.substeps = std::max(count, static_cast<size_t>(1));
+}
+
 void
 CollisionGraph::ClearGraph (void) noexcept
 {
@@ -37,12 +333,27 @@ CollisionGraph::ClearGraph (void) noexcept
     });
 
     m_dirtyProxies.clear();
-    m_tree.ClearProxies();
+    m_sensorBegin.clear();
+    m_sensorEnd.clear();
+    m_bodyStates.clear();
+    m_contactStates.clear();
+    m_freeBodyStates.clear();
+    m_freeContactStates.clear();
+    m_staticBroadPhase->ClearProxies();
+    m_dynamicBroadPhase->ClearProxies();
     block_allocator.Clear();
 
+    m_flags &= ~STEPPED;
+    m_accumulator = 0.f;
+    m_current = step_stats();
+    stats.Clear();
+
     SDL_assert(m_bodies.size() == 0);
     SDL_assert(m_contacts.size() == 0);
     SDL_assert(m_joints.size() == 0);
+    SDL_assert(m_awakeBodies.empty());
+    SDL_assert(m_awakeContacts.empty());
+    SDL_assert(m_sensorOverlaps.empty());
 }
 
 RigidBody*
@@ -56,6 +367,10 @@ CollisionGraph::CreateBody (const rigid_body_profile& profile)
 
     RigidBody* result = block_allocator.New<RigidBody>(profile, this);
     m_bodies.push_back(*result);
+    if (result->IsAwake())
+    {
+        AddAwakeBody(result);
+    }
 
     return result;
 }
@@ -78,7 +393,13 @@ CollisionGraph::DestroyBody (RigidBody* body)
         body->DestroyFixture(f);
     });
 
+    if (body->m_awakeIndex >= 0)
+    {
+        RemoveAwakeBody(body);
+    }
+
     m_bodies.remove(*body);
+    m_freeBodyStates.push_back(body->m_state);
     block_allocator.Delete<RigidBody>(body);
 }
 
@@ -119,8 +440,8 @@ CollisionGraph::DestroyJoint (BaseJoint* joint)
         body_a->contact_edges.for_each([=](auto* edge) {
             if (edge->other == body_b)
             {
-                edge->contact->fixture_a->FlagFilterDirty();
-                edge->contact->fixture_b->FlagFilterDirty();
+                edge->contact->GetFixtureA()->FlagFilterDirty();
+                edge->contact->GetFixtureB()->FlagFilterDirty();
             }
         });
     }
@@ -136,6 +457,7 @@ CollisionGraph::DestroyJoint (BaseJoint* joint)
 void
 CollisionGraph::Step (float dt)
 {
+    auto step_start = ScopeProfiler<>::Clock::now();
     m_flags |= LOCKED;
 
     SDL_assert(dt > 0.f);
@@ -143,294 +465,1352 @@ CollisionGraph::Step (float dt)
     m_step.inv = 1.f / dt;
     m_step.ratio = m_step.inv_0 * dt;
 
+    // static proxies are always bulk loaded, and dynamic proxies are bulk
+    // loaded when registered prior to the first step
+    if (m_staticBroadPhase->HasDeferredProxies())
+    {
+        m_staticBroadPhase->Build();
+    }
+
+    if (m_dynamicBroadPhase->HasDeferredProxies())
+    {
+        m_dynamicBroadPhase->Build();
+    }
+
+    m_flags |= STEPPED;
+
     // 1) update contact list
     {
         // find new contacts for any added proxies
         if (!m_dirtyProxies.empty())
         {
-#ifdef RDGE_DEBUG_PROFILING
-            ScopeProfiler<> p(&debug_profile.create_contacts);
-#endif
-            auto pairs = m_tree.Query<fixture_proxy>(m_dirtyProxies);
-            for (auto& p : pairs)
+            ScopeProfiler<> p(&m_current.create_contacts);
+            m_staticBroadPhase->PrepareQueries();
+            m_dynamicBroadPhase->PrepareQueries();
+            m_pairs.Clear();
+            m_current.proxies_moved = static_cast<uint32>(m_dirtyProxies.size());
+
+            // dynamic proxies are tested against both trees, and static proxies
+            // only against the dynamic tree (static pairs never collide).  The
+            // proxy filters reject pairs which can never collide, so they never
+            // enter the pair buffer.  The default rule is only applied when the
+            // filter cannot accept more pairs than the rule does.
+            bool default_rule = (custom_filter == &s_defaultContactFilter) ||
+                                (custom_filter && custom_filter->UsesDefaultRule());
+            uint16 query_flags = (default_rule) ? proxy_filter::TEST_CATEGORY : 0;
+
+            for (int32 key : m_dirtyProxies)
+            {
+                const aabb& box = GetFatAABB(key);
+                proxy_filter filter = make_proxy_filter(GetProxy(key)->fixture);
+                filter.flags |= query_flags;
+
+                if (key >= 0)
+                {
+                    QueryBroadPhase(*m_staticBroadPhase, box, [&](int32 handle) {
+                        m_pairs.Insert(key, ~handle);
+                        return true;
+                    }, &filter);
+                }
+
+                QueryBroadPhase(*m_dynamicBroadPhase, box, [&](int32 handle) {
+                    if (handle != key)
+                    {
+                        m_pairs.Insert(key, handle);
+                    }
+
+                    return true;
+                }, &filter);
+            }
+
+            m_current.pairs_tested = static_cast<uint32>(m_pairs.Size());
+            for (const auto& p : m_pairs)
             {
-                CreateContact(p.first, p.second);
+                CreateContact(GetProxy(p.handle_a), GetProxy(p.handle_b));
             }
 
             m_dirtyProxies.clear();
         }
 
+        // sensors are updated first, as filter changes are cleared by the purge
+        {
+            ScopeProfiler<> p(&m_current.update_sensors);
+            UpdateSensors();
+        }
+
         // remove all contacts that are not colliding
-#ifdef RDGE_DEBUG_PROFILING
-        ScopeProfiler<> p(&debug_profile.purge_contacts);
-#endif
+        ScopeProfiler<> p(&m_current.purge_contacts);
         PurgeContacts();
     }
 
-    {
-        // NOTE: Island flags must be reset prior to solving.  To avoid another
-        //       iteration to reset the flags, they are performed at:
-        //   - bodies reset at the end of the step
-        //   - contacts reset during contact purging
-        //   - joints done here
+    // NOTE: Island flags must be reset prior to solving.  Only the objects
+    //       collected into islands are flagged, so the flags are reset from
+    //       the island lists at the end of the step rather than by visiting
+    //       every object in the graph.
 
-        // TODO Remove this when physics engine gets more mileage.
+    // TODO Remove this when physics engine gets more mileage.
 
 #ifdef RDGE_DEBUG
-        m_bodies.for_each([](auto* body) {
-            SDL_assert((body->m_flags & RigidBody::ON_ISLAND) == 0);
-        });
+    m_bodies.for_each([](auto* body) {
+        SDL_assert((body->m_flags & RigidBody::ON_ISLAND) == 0);
+    });
 
-        m_contacts.for_each([](auto* contact) {
-            SDL_assert((contact->m_flags & Contact::ON_ISLAND) == 0);
-        });
-#endif
+    m_contacts.for_each([](auto* contact) {
+        SDL_assert((contact->State().flags & Contact::ON_ISLAND) == 0);
+    });
 
-        m_joints.for_each([](auto* joint) {
-            joint->m_flags &= ~BaseJoint::ON_ISLAND;
-        });
-    }
+    m_joints.for_each([](auto* joint) {
+        SDL_assert((joint->m_flags & BaseJoint::ON_ISLAND) == 0);
+    });
+#endif
 
     // 2) integration and contact solving
     {
-#ifdef RDGE_DEBUG_PROFILING
-        ScopeProfiler<> p(&debug_profile.solve);
-#endif
-        static std::vector<RigidBody*> body_stack;
-        body_stack.reserve(m_bodies.size());
-
-        m_solver.Initialize(m_bodies.size(), m_contacts.size(), m_joints.size());
-        m_bodies.for_each([&](auto* body) {
-            if ((body->m_flags & RigidBody::ON_ISLAND) ||
-                !body->IsSimulating() ||
-                !body->IsAwake())
-            {
-                return;
-            }
-
-            body_stack.clear();
-            m_solver.Clear();
-
-            body->m_flags |= RigidBody::ON_ISLAND;
-            body_stack.push_back(body);
-            while (!body_stack.empty())
-            {
-                RigidBody* b = body_stack.back();
-                body_stack.pop_back();
-
-                m_solver.Add(b);
-
-                // to keep islands small do not propogate past static bodies
-                if (b->m_type == RigidBodyType::STATIC)
-                {
-                    continue;
-                }
+        ScopeProfiler<> p(&m_current.solve);
+        CollectIslands();
+        SolveIslands();
 
-                b->contact_edges.for_each([&](auto* edge) {
-                    Contact* c = edge->contact;
-
-                    // TODO could be simplified to m_flags != 0 (except sensor test),
-                    //      but for future proofing should remain as is.  Look into
-                    //      IsTouching to see where it's used.
-                    if ((c->m_flags & Contact::ON_ISLAND) ||
-                        !c->IsTouching() ||
-                        !c->IsEnabled() ||
-                        (c->fixture_a->IsSensor() || c->fixture_b->IsSensor()))
-                    {
-                        return;
-                    }
-
-                    c->m_flags |= Contact::ON_ISLAND;
-                    m_solver.Add(c);
-
-                    if ((edge->other->m_flags & RigidBody::ON_ISLAND) == 0)
-                    {
-                        edge->other->m_flags |= RigidBody::ON_ISLAND;
-                        body_stack.push_back(edge->other);
-                    }
-                });
-
-                b->joint_edges.for_each([&](auto* edge) {
-                    BaseJoint* j = edge->joint;
-
-                    // TODO could be simplified to m_flags != 0 (except sensor test),
-                    //      but for future proofing should remain as is.  Look into
-                    //      IsTouching to see where it's used.
-                    if (j->m_flags & BaseJoint::ON_ISLAND)
-                    {
-                        return;
-                    }
-
-                    if (!j->body_a->IsSimulating() || !j->body_b->IsSimulating())
-                    {
-                        return;
-                    }
+        // callbacks and sleeping are processed in island order regardless of
+        // which worker solved the island
+        for (const auto& island : m_islands)
+        {
+            ProcessPostSolve(island);
+            m_current.velocity_iterations += static_cast<uint32>(island.velocity_iterations);
+            m_current.position_iterations += static_cast<uint32>(island.position_iterations);
+        }
 
-                    j->m_flags |= BaseJoint::ON_ISLAND;
-                    m_solver.Add(j);
+        m_current.islands = static_cast<uint32>(m_islands.size());
 
-                    if ((edge->other->m_flags & RigidBody::ON_ISLAND) == 0)
-                    {
-                        edge->other->m_flags |= RigidBody::ON_ISLAND;
-                        body_stack.push_back(edge->other);
-                    }
-                });
-            }
+        for (auto& data : m_islandContacts)
+        {
+            data.contact->State().flags &= ~Contact::ON_ISLAND;
+        }
 
-            m_solver.Solve();
-            m_solver.ProcessPostSolve(*this);
-        });
+        for (auto& data : m_islandJoints)
+        {
+            data.joint->m_flags &= ~BaseJoint::ON_ISLAND;
+        }
     }
 
     {
-#ifdef RDGE_DEBUG_PROFILING
-        ScopeProfiler<> p(&debug_profile.synchronize);
-#endif
-        m_bodies.for_each([=](auto* body) {
-            // If a body was not in an island then it did not move.
+        // If a body was not in an island then it did not move.  Bodies which
+        // fell asleep during the step still need their fixtures synchronized.
+        ScopeProfiler<> p(&m_current.synchronize);
+        for (RigidBody* body : m_islandBodies)
+        {
+            // static bodies had their flag removed during collection
             if (body->m_flags & RigidBody::ON_ISLAND)
             {
-                if (body->m_type != RigidBodyType::STATIC)
-                {
-                    body->SyncFixtures();
+                body->SyncFixtures();
+                m_current.bodies_awake++;
 
-                    if (m_flags & CLEAR_FORCES)
-                    {
-                        body->linear.force = { 0.f, 0.f };
-                        body->angular.torque = 0.f;
-                    }
+                if (m_flags & CLEAR_FORCES)
+                {
+                    body->linear.force = { 0.f, 0.f };
+                    body->angular.torque = 0.f;
                 }
 
                 // Remove flag for the next iteration
                 body->m_flags &= ~RigidBody::ON_ISLAND;
             }
-        });
+        }
+    }
+
+    // 3) continuous collision for bullets
+    {
+        ScopeProfiler<> p(&m_current.solve_toi);
+        SolveTOI();
     }
 
     m_step.dt_0 = m_step.dt;
     m_step.inv_0 = m_step.inv;
 
     m_flags &= ~LOCKED;
+
+    auto step_time = ScopeProfiler<>::Clock::now() - step_start;
+    m_current.total = std::chrono::duration_cast<std::chrono::microseconds>(step_time).count();
+    stats.Record(m_current);
+    m_current = step_stats();
 }
 
-void
-CollisionGraph::CreateContact (fixture_proxy* a, fixture_proxy* b)
+size_t
+CollisionGraph::Update (float elapsed)
 {
-    RigidBody* body_a = a->fixture->body;
-    RigidBody* body_b = b->fixture->body;
+    SDL_assert(m_fixedStep > 0.f);
+    SDL_assert(elapsed >= 0.f);
 
-    if (!body_a->ShouldCollide(body_b))
-    {
-        return;
-    }
+    m_accumulator += elapsed;
 
-    if (custom_filter && !custom_filter->ShouldCollide(a->fixture, b->fixture))
+    size_t steps = 0;
+    while (m_accumulator >= m_fixedStep && steps < max_fixed_steps)
     {
-        return;
-    }
+        // state prior to the step is the interpolation origin (sleeping
+        // bodies already have it set from when they fell asleep)
+        for (RigidBody* body : m_awakeBodies)
+        {
+            const auto& sweep = body->State().sweep;
+            body->m_previousCenter = sweep.pos_n;
+            body->m_previousAngle = sweep.angle_n;
+        }
 
-    if (body_a->HasEdge(a->fixture, b->fixture))
-    {
-        return;
+        Step(m_fixedStep);
+        m_accumulator -= m_fixedStep;
+        steps++;
     }
 
-    Contact* contact = block_allocator.New<Contact>(a->fixture, b->fixture);
-    m_contacts.push_back(*contact);
-
-    // fixtures may have swapped order during contact construction, so cached
-    // body variables cannot be trusted.
-    contact->fixture_a->body->contact_edges.push_back(contact->edge_a);
-    contact->fixture_b->body->contact_edges.push_back(contact->edge_b);
-
-    if (!contact->fixture_a->IsSensor() && !contact->fixture_b->IsSensor())
+    if (m_accumulator >= m_fixedStep)
     {
-        contact->fixture_a->body->WakeUp();
-        contact->fixture_b->body->WakeUp();
+        // fell behind, so drop the whole steps that could not be simulated
+        m_accumulator = std::fmod(m_accumulator, m_fixedStep);
     }
+
+    return steps;
 }
 
 void
-CollisionGraph::DestroyContact (Contact* contact)
+CollisionGraph::CollectIslands (void)
 {
-    RigidBody* body_a = contact->fixture_a->body;
-    RigidBody* body_b = contact->fixture_b->body;
-
-    if (contact->IsTouching())
+    m_islands.clear();
+    m_islandBodies.clear();
+    m_islandContacts.clear();
+    m_islandJoints.clear();
+
+    // bodies woken while collecting are appended to the awake set, but will
+    // already be on an island
+    for (size_t seed = 0; seed < m_awakeBodies.size(); seed++)
     {
-        if (listener)
+        RigidBody* body = m_awakeBodies[seed];
+        if ((body->m_flags & RigidBody::ON_ISLAND) ||
+            !body->IsSimulating() ||
+            !body->IsAwake())
         {
-            listener->OnContactEnd(contact);
+            continue;
         }
 
-        if (!contact->fixture_a->IsSensor() &&
-            !contact->fixture_b->IsSensor())
+        solver_island island;
+        island.body_begin = m_islandBodies.size();
+        island.contact_begin = m_islandContacts.size();
+        island.joint_begin = m_islandJoints.size();
+
+        m_islandStack.clear();
+        body->m_flags |= RigidBody::ON_ISLAND;
+        m_islandStack.push_back(body);
+        while (!m_islandStack.empty())
         {
-            body_a->WakeUp();
-            body_b->WakeUp();
-        }
-    }
+            RigidBody* b = m_islandStack.back();
+            m_islandStack.pop_back();
+
+            // Store positions for continuous collision.  Body is woken b/c for
+            // it to be added to the island it was already awake or now in
+            // contact with an awake body
+            auto& sweep = b->State().sweep;
+            sweep.angle_0 = sweep.angle_n;
+            sweep.pos_0 = sweep.pos_n;
+            b->WakeUp();
+            b->solver_index = m_islandBodies.size() - island.body_begin;
+            m_islandBodies.push_back(b);
+
+            // to keep islands small do not propogate past static bodies
+            if (b->m_type == RigidBodyType::STATIC)
+            {
+                continue;
+            }
 
-    m_contacts.remove(*contact);
-    body_a->contact_edges.remove(contact->edge_a);
-    body_b->contact_edges.remove(contact->edge_b);
+            b->contact_edges.for_each([&](auto* edge) {
+                Contact* c = edge->contact;
 
-    block_allocator.Delete<Contact>(contact);
-}
+                // TODO could be simplified to m_flags != 0, but for future
+                //      proofing should remain as is.  Look into IsTouching to
+                //      see where it's used.
+                auto& flags = c->State().flags;
+                if ((flags & Contact::ON_ISLAND) ||
+                    (flags & Contact::TOUCHING) == 0 ||
+                    (flags & Contact::ENABLED) == 0)
+                {
+                    return;
+                }
 
-void
-CollisionGraph::PurgeContacts (void)
-{
-    m_contacts.for_each([this](auto* contact) {
-        contact->m_flags &= ~Contact::ON_ISLAND;
+                flags |= Contact::ON_ISLAND;
+                m_islandContacts.push_back({ c, { 0, 0 } });
 
-        Fixture* a = contact->fixture_a;
-        Fixture* b = contact->fixture_b;
-        if (a->IsFilterDirty() || b->IsFilterDirty())
-        {
-            if (a->body->ShouldCollide(b->body) == false)
-            {
-                DestroyContact(contact);
-                return;
-            }
+                if ((edge->other->m_flags & RigidBody::ON_ISLAND) == 0)
+                {
+                    edge->other->m_flags |= RigidBody::ON_ISLAND;
+                    m_islandStack.push_back(edge->other);
+                }
+            });
 
-            if (custom_filter && custom_filter->ShouldCollide(a, b) == false)
-            {
-                DestroyContact(contact);
-                return;
-            }
+            b->joint_edges.for_each([&](auto* edge) {
+                BaseJoint* j = edge->joint;
+                if (j->m_flags & BaseJoint::ON_ISLAND)
+                {
+                    return;
+                }
+
+                if (!j->body_a->IsSimulating() || !j->body_b->IsSimulating())
+                {
+                    return;
+                }
+
+                j->m_flags |= BaseJoint::ON_ISLAND;
+                m_islandJoints.push_back({ j, { 0, 0 } });
 
-            a->FlagFilterClean();
-            b->FlagFilterClean();
+                if ((edge->other->m_flags & RigidBody::ON_ISLAND) == 0)
+                {
+                    edge->other->m_flags |= RigidBody::ON_ISLAND;
+                    m_islandStack.push_back(edge->other);
+                }
+            });
         }
 
-        // skip intersecion tests for sleeping bodies
-        if (!a->body->IsAwake() && !b->body->IsAwake())
+        island.body_count = m_islandBodies.size() - island.body_begin;
+        island.contact_count = m_islandContacts.size() - island.contact_begin;
+        island.joint_count = m_islandJoints.size() - island.joint_begin;
+
+        // All island bodies have been indexed, so the indices can be resolved.
+        // Static bodies are shared between islands, so indices are not valid
+        // once the next island is collected.
+        for (size_t i = island.contact_begin; i < m_islandContacts.size(); i++)
         {
-            return;
+            auto& data = m_islandContacts[i];
+            const auto& state = data.contact->State();
+            data.body_index[0] = state.fixture_a->body->solver_index;
+            data.body_index[1] = state.fixture_b->body->solver_index;
         }
 
-        // purge non-intersecting contacts.  check is on the enlarged AABBs
-        if (!m_tree.Intersects(a->proxy->handle, b->proxy->handle))
+        for (size_t i = island.joint_begin; i < m_islandJoints.size(); i++)
         {
-            DestroyContact(contact);
-            return;
+            auto& data = m_islandJoints[i];
+            data.body_index[0] = data.joint->body_a->solver_index;
+            data.body_index[1] = data.joint->body_b->solver_index;
         }
 
-        contact->Update(listener);
-    });
-}
-
-int32
-CollisionGraph::RegisterProxy (fixture_proxy* proxy)
-{
-    int32 handle = m_tree.CreateProxy(proxy->box, proxy);
-    m_dirtyProxies.push_back(handle);
+        // allow static bodies to be added to other islands
+        for (size_t i = island.body_begin; i < m_islandBodies.size(); i++)
+        {
+            RigidBody* b = m_islandBodies[i];
+            if (b->m_type == RigidBodyType::STATIC)
+            {
+                b->m_flags &= ~RigidBody::ON_ISLAND;
+            }
+        }
 
-    return handle;
+        m_islands.push_back(island);
+    }
 }
 
 void
-CollisionGraph::UnregisterProxy (const fixture_proxy* proxy)
+CollisionGraph::SolveIslands (void)
+{
+    size_t max_bodies = 0;
+    size_t max_contacts = 0;
+    size_t max_joints = 0;
+    for (const auto& island : m_islands)
+    {
+        max_bodies = std::max(max_bodies, island.body_count);
+        max_contacts = std::max(max_contacts, island.contact_count);
+        max_joints = std::max(max_joints, island.joint_count);
+    }
+
+    // Each worker has its own solver, all sharing the graph solver configuration.
+    // Solvers must be initialized prior to solving so no allocations are made
+    // from the worker threads.
+    size_t worker_count = (workers) ? workers->WorkerCount() : 1;
+    while (m_workerSolvers.size() < (worker_count - 1))
+    {
+        m_workerSolvers.emplace_back(&m_step);
+    }
+
+    m_solver.Initialize(max_bodies, max_contacts, max_joints);
+    for (size_t i = 0; i < (worker_count - 1); i++)
+    {
+        auto& solver = m_workerSolvers[i];
+        solver.gravity = m_solver.gravity;
+        solver.velocity_iterations = m_solver.velocity_iterations;
+        solver.position_iterations = m_solver.position_iterations;
+        solver.warm_starting = m_solver.warm_starting;
+        solver.wide_contacts = m_solver.wide_contacts;
+        solver.block_contacts = m_solver.block_contacts;
+        solver.soft_step = m_solver.soft_step;
+        solver.substeps = m_solver.substeps;
+        solver.Initialize(max_bodies, max_contacts, max_joints);
+    }
+
+    auto solve = [this](size_t begin, size_t end, size_t worker) {
+        Solver& solver = (worker == 0) ? m_solver : m_workerSolvers[worker - 1];
+        for (size_t i = begin; i < end; i++)
+        {
+            auto& island = m_islands[i];
+
+            solver.Clear();
+            for (size_t b = 0; b < island.body_count; b++)
+            {
+                solver.Add(m_islandBodies[island.body_begin + b]);
+            }
+
+            for (size_t c = 0; c < island.contact_count; c++)
+            {
+                const auto& data = m_islandContacts[island.contact_begin + c];
+                solver.Add(data.contact, data.body_index[0], data.body_index[1]);
+            }
+
+            for (size_t j = 0; j < island.joint_count; j++)
+            {
+                const auto& data = m_islandJoints[island.joint_begin + j];
+                solver.Add(data.joint, data.body_index[0], data.body_index[1]);
+            }
+
+            solver.Solve();
+            island.positions_solved = solver.PositionsSolved();
+            island.velocity_iterations = solver.VelocityIterations();
+            island.position_iterations = solver.PositionIterations();
+        }
+    };
+
+    if (workers && m_islands.size() > 1)
+    {
+        workers->ParallelFor(m_islands.size(), 1, solve);
+    }
+    else
+    {
+        solve(0, m_islands.size(), 0);
+    }
+}
+
+void
+CollisionGraph::ProcessPostSolve (const solver_island& island)
+{
+    if (listener)
+    {
+        for (size_t i = 0; i < island.contact_count; i++)
+        {
+            listener->OnPostSolve(m_islandContacts[island.contact_begin + i].contact);
+        }
+    }
+
+    if (IsSleepPrevented() || !island.positions_solved)
+    {
+        return;
+    }
+
+    float min_sleep_time = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < island.body_count; i++)
+    {
+        auto body = m_islandBodies[island.body_begin + i];
+        if (body->m_type == RigidBodyType::STATIC)
+        {
+            continue;
+        }
+
+        const auto& state = body->State();
+        if (body->IsSleepPrevented() ||
+            state.linear_velocity.self_dot() > LINEAR_SLEEP_TOLERANCE_SQUARED ||
+            math::square(state.angular_velocity) > ANGULAR_SLEEP_TOLERANCE_SQUARED)
+        {
+            body->m_sleepTime = 0.f;
+            min_sleep_time = 0.f;
+        }
+        else
+        {
+            body->m_sleepTime += m_step.dt;
+            min_sleep_time = std::min(min_sleep_time, body->m_sleepTime);
+        }
+    }
+
+    if (min_sleep_time >= Solver::SLEEP_THRESHOLD)
+    {
+        for (size_t i = 0; i < island.body_count; i++)
+        {
+            m_islandBodies[island.body_begin + i]->Sleep();
+        }
+    }
+}
+
+void
+CollisionGraph::SolveTOI (void)
+{
+    // Bullets are swept after the fixtures have been synchronized, so the
+    // broad phase contains the final pose of every other body.  Impacts may
+    // wake bodies, which are appended to the awake set.
+    for (size_t i = 0; i < m_awakeBodies.size(); i++)
+    {
+        RigidBody* body = m_awakeBodies[i];
+        if (body->IsBullet() && body->IsAwake() && body->m_type == RigidBodyType::DYNAMIC)
+        {
+            AdvanceBullet(body);
+        }
+    }
+}
+
+void
+CollisionGraph::AdvanceBullet (RigidBody* body)
+{
+    // Simplified time of impact sub-stepping.  The bullet is moved to the
+    // first impact of its sweep, the impact is resolved with a few sequential
+    // impulses, and the bullet continues for the remainder of the step.  Other
+    // bodies are treated as stationary at the end of the step.
+
+    struct toi_hit
+    {
+        Fixture* fixture = nullptr;
+        Fixture* other = nullptr;
+        collision_manifold mf;
+        float t = 1.f;
+    };
+
+    sweep_step motion = body->State().sweep;
+    float alpha = 0.f; // consumed fraction of the step
+    bool moved = false;
+
+    for (size_t substep = 0; substep < MAX_TOI_SUBSTEPS; substep++)
+    {
+        toi_hit hit;
+        float remaining = (1.f - alpha) * m_step.dt;
+
+        body->fixtures.for_each([&](auto* fixture) {
+            if (fixture->IsSensor())
+            {
+                return;
+            }
+
+            const ishape* shape = fixture->shape.local;
+            aabb box = aabb::merge(shape->compute_aabb(motion.lerp_transform(0.f)),
+                                   shape->compute_aabb(motion.lerp_transform(1.f)));
+
+            auto visit = [&](const IBroadPhase& broad_phase, int32 handle) {
+                auto proxy = static_cast<fixture_proxy*>(broad_phase.GetUserData(handle));
+                Fixture* other = proxy->fixture;
+                RigidBody* other_body = other->body;
+                if (other->IsSensor() || !body->ShouldCollide(other_body) ||
+                    (custom_filter && !custom_filter->ShouldCollide(fixture, other)))
+                {
+                    return true;
+                }
+
+                sweep_step target = other_body->State().sweep;
+                target.pos_0 = target.pos_n;
+                target.angle_0 = target.angle_n;
+
+                toi_output output;
+                time_of_impact(shape, motion, other->shape.local, target, hit.t, output);
+                if (output.state == toi_output::FAILED)
+                {
+                    // stop short of the impact, and try again next sub-step
+                    hit.fixture = fixture;
+                    hit.other = other;
+                    hit.mf.count = 0;
+                    hit.t = output.t;
+                }
+                else if (output.state == toi_output::TOUCHING)
+                {
+                    collision_manifold mf;
+                    toi_manifold(shape, motion.lerp_transform(output.t),
+                                 other->shape.local, other_body->world_transform, mf);
+
+                    // ignore contacts the bullet is not moving into, which
+                    // includes resting on the surface
+                    math::vec2 normal = mf.oriented_normal();
+                    math::vec2 center = motion.pos_0 + ((motion.pos_n - motion.pos_0) * output.t);
+                    bool approaching = false;
+                    for (size_t i = 0; i < mf.count; i++)
+                    {
+                        math::vec2 vel_a = body->GetLinearVelocity() +
+                                           ((mf.contacts[i] - center).perp() * body->GetAngularVelocity());
+                        math::vec2 vel_b = other_body->GetLinearVelocityFromWorldPoint(mf.contacts[i]);
+                        if ((math::dot(normal, vel_b - vel_a) * remaining) < -LINEAR_SLOP)
+                        {
+                            approaching = true;
+                        }
+                    }
+
+                    if (approaching)
+                    {
+                        hit.fixture = fixture;
+                        hit.other = other;
+                        hit.mf = mf;
+                        hit.t = output.t;
+                    }
+                }
+
+                return true;
+            };
+
+            QueryBroadPhase(*m_staticBroadPhase, box, [&](int32 handle) {
+                return visit(*m_staticBroadPhase, handle);
+            });
+
+            QueryBroadPhase(*m_dynamicBroadPhase, box, [&](int32 handle) {
+                return visit(*m_dynamicBroadPhase, handle);
+            });
+        });
+
+        if (!hit.fixture)
+        {
+            break;
+        }
+
+        // move the bullet to the time of impact
+        motion.advance(hit.t);
+        motion.alpha_0 = 0.f;
+        motion.pos_n = motion.pos_0;
+        motion.angle_n = motion.angle_0;
+        alpha += (1.f - alpha) * hit.t;
+        moved = true;
+
+        // resolve the impact, where the other body receives the opposite impulse
+        RigidBody* other_body = hit.other->body;
+        resolve_impact(body, motion.pos_0, other_body, hit.mf,
+                       mix_friction(hit.fixture->friction, hit.other->friction),
+                       mix_restitution(hit.fixture->restitution, hit.other->restitution));
+
+        if (other_body->m_type == RigidBodyType::DYNAMIC)
+        {
+            other_body->WakeUp();
+        }
+
+        // continue for the remainder of the step with the new velocity
+        float rest = (1.f - alpha) * m_step.dt;
+        motion.pos_n = motion.pos_0 + (body->GetLinearVelocity() * rest);
+        motion.angle_n = motion.angle_0 + (body->GetAngularVelocity() * rest);
+    }
+
+    if (moved)
+    {
+        auto& sweep = body->State().sweep;
+        sweep.pos_n = motion.pos_n;
+        sweep.angle_n = motion.angle_n;
+
+        auto& xf = body->world_transform;
+        xf.set_angle(sweep.angle_n);
+        xf.pos = sweep.pos_n - xf.rot.rotate(sweep.local_center);
+
+        body->SyncFixtures();
+    }
+}
+
+bool
+CollisionGraph::RayCastClosest (const math::vec2& p1, const math::vec2& p2, cast_hit& hit) const
+{
+    hit.fixture = nullptr;
+    RayCast(p1, p2, [&](Fixture* fixture, const math::vec2& point, const math::vec2& normal, float fraction) {
+        if (fixture->IsSensor())
+        {
+            return -1.f;
+        }
+
+        hit.fixture = fixture;
+        hit.point = point;
+        hit.normal = normal;
+        hit.fraction = fraction;
+        return fraction;
+    });
+
+    return (hit.fixture != nullptr);
+}
+
+bool
+CollisionGraph::ShapeCastClosest (const ishape* shape, const math::vec2& translation, cast_hit& hit) const
+{
+    hit.fixture = nullptr;
+    ShapeCast(shape, translation, [&](Fixture* fixture, const math::vec2& point, const math::vec2& normal, float fraction) {
+        if (fixture->IsSensor())
+        {
+            return -1.f;
+        }
+
+        hit.fixture = fixture;
+        hit.point = point;
+        hit.normal = normal;
+        hit.fraction = fraction;
+        return fraction;
+    });
+
+    return (hit.fixture != nullptr);
+}
+
+void
+CollisionGraph::Snapshot (graph_snapshot& snapshot) const
+{
+    SDL_assert(!IsLocked());
+
+    snapshot.data.clear();
+    snapshot_writer writer(snapshot);
+    writer.write(SNAPSHOT_MAGIC);
+    writer.write(SNAPSHOT_VERSION);
+    writer.write(static_cast<uint64>(0)); // total size, written once known
+
+    // 1) Identity of the objects, verified before anything is restored
+    writer.write(static_cast<uint32>(m_bodies.size()));
+    for (const auto& body : m_bodies)
+    {
+        writer.write(&body);
+        writer.write(body.m_type);
+        writer.write(static_cast<uint32>(body.fixtures.size()));
+        for (const auto& fixture : body.fixtures)
+        {
+            writer.write(&fixture);
+        }
+    }
+
+    writer.write(static_cast<uint32>(m_joints.size()));
+    for (const auto& joint : m_joints)
+    {
+        writer.write(&joint);
+    }
+
+    writer.write(m_staticBroadPhase->Type());
+    writer.write(m_dynamicBroadPhase->Type());
+    writer.write(m_cellSize);
+
+    // 2) Simulation state
+    writer.write(m_step);
+    writer.write(m_accumulator);
+    writer.write(static_cast<uint16>(m_flags & STEPPED));
+
+    // awake sets are unordered, so each element records its index
+    writer.write(static_cast<uint32>(m_awakeBodies.size()));
+    for (const auto& body : m_bodies)
+    {
+        writer.write(body.m_awakeIndex);
+        writer.write(body.State());
+        writer.write(body.world_transform);
+        writer.write(body.linear);
+        writer.write(body.angular);
+        writer.write(body.m_sleepTime);
+        writer.write(body.m_previousCenter);
+        writer.write(body.m_previousAngle);
+        writer.write(static_cast<uint16>(body.m_flags & ~RigidBody::ON_ISLAND));
+
+        for (const auto& fixture : body.fixtures)
+        {
+            writer.write(fixture.proxy->box);
+            writer.write(fixture.proxy->handle);
+        }
+    }
+
+    for (const auto& joint : m_joints)
+    {
+        joint.SaveState(writer);
+    }
+
+    m_staticBroadPhase->Save(writer);
+    m_dynamicBroadPhase->Save(writer);
+
+    writer.write(static_cast<uint32>(m_dirtyProxies.size()));
+    writer.write(m_dirtyProxies.data(), m_dirtyProxies.size());
+
+    // 3) Contacts reference fixtures by proxy key, which remain valid once
+    //    the broad phase is restored
+    writer.write(static_cast<uint32>(m_awakeContacts.size()));
+    writer.write(static_cast<uint32>(m_contacts.size()));
+    auto* record = writer.write_array<snapshot_contact>(m_contacts.size());
+    for (const auto& contact : m_contacts)
+    {
+        const auto& state = contact.State();
+        record->key_a = GetProxyKey(state.fixture_a->proxy);
+        record->key_b = GetProxyKey(state.fixture_b->proxy);
+        record->flags = static_cast<uint16>(state.flags & ~Contact::ON_ISLAND);
+        record->awake_index = contact.m_awakeIndex;
+        record->friction = contact.friction;
+        record->restitution = contact.restitution;
+        record->tangent_speed = contact.tangent_speed;
+        record->manifold = state.manifold;
+        record->impulse = contact.impulse;
+        record++;
+    }
+
+    // 4) Sensor overlaps, where the set order is preserved
+    writer.write(static_cast<uint32>(m_sensorOverlaps.size()));
+    auto* sensor_record = writer.write_array<snapshot_sensor>(m_sensorOverlaps.size());
+    for (const auto& overlap : m_sensorOverlaps)
+    {
+        sensor_record->key_sensor = overlap.key_sensor;
+        sensor_record->key_visitor = overlap.key_visitor;
+        sensor_record->touching = overlap.touching;
+        sensor_record++;
+    }
+
+    auto size = static_cast<uint64>(snapshot.data.size());
+    std::memcpy(snapshot.data.data() + (sizeof(uint32) * 2), &size, sizeof(size));
+}
+
+void
+CollisionGraph::Restore (const graph_snapshot& snapshot)
+{
+    if (IsLocked())
+    {
+        SDL_assert(false);
+        return;
+    }
+
+    snapshot_reader reader(snapshot);
+    if (snapshot.size() < (sizeof(uint32) * 2) + sizeof(uint64) ||
+        reader.read<uint32>() != SNAPSHOT_MAGIC ||
+        reader.read<uint32>() != SNAPSHOT_VERSION ||
+        reader.read<uint64>() != snapshot.size())
+    {
+        RDGE_THROW("Invalid graph snapshot");
+    }
+
+    // 1) Verify the graph contains the same objects
+    bool matches = (reader.read<uint32>() == m_bodies.size());
+    for (auto it = m_bodies.begin(); matches && it != m_bodies.end(); ++it)
+    {
+        const auto& body = *it;
+        matches = (reader.read<const RigidBody*>() == &body) &&
+                  (reader.read<RigidBodyType>() == body.m_type) &&
+                  (reader.read<uint32>() == body.fixtures.size());
+
+        for (auto f = body.fixtures.begin(); matches && f != body.fixtures.end(); ++f)
+        {
+            matches = (reader.read<const Fixture*>() == &(*f));
+        }
+    }
+
+    matches = matches && (reader.read<uint32>() == m_joints.size());
+    for (auto it = m_joints.begin(); matches && it != m_joints.end(); ++it)
+    {
+        matches = (reader.read<const BaseJoint*>() == &(*it));
+    }
+
+    matches = matches &&
+              (reader.read<BroadPhaseType>() == m_staticBroadPhase->Type()) &&
+              (reader.read<BroadPhaseType>() == m_dynamicBroadPhase->Type()) &&
+              (reader.read<math::vec2>() == m_cellSize);
+
+    if (!matches)
+    {
+        RDGE_THROW("Graph snapshot does not match the graph");
+    }
+
+    // 2) Simulation state
+    reader.read(m_step);
+    reader.read(m_accumulator);
+    m_flags = (m_flags & ~STEPPED) | reader.read<uint16>();
+    m_flags |= FILTER_DIRTY; // fixture filters aren't part of the snapshot
+
+    m_awakeBodies.assign(reader.read<uint32>(), nullptr);
+    m_bodies.for_each([&](auto* body) {
+        reader.read(body->m_awakeIndex);
+        if (body->m_awakeIndex >= 0)
+        {
+            m_awakeBodies[static_cast<size_t>(body->m_awakeIndex)] = body;
+        }
+
+        reader.read(body->State());
+        reader.read(body->world_transform);
+        reader.read(body->linear);
+        reader.read(body->angular);
+        reader.read(body->m_sleepTime);
+        reader.read(body->m_previousCenter);
+        reader.read(body->m_previousAngle);
+        reader.read(body->m_flags);
+
+        body->fixtures.for_each([&](auto* f) {
+            reader.read(f->proxy->box);
+            reader.read(f->proxy->handle);
+            f->Syncronize();
+        });
+    });
+
+    m_joints.for_each([&](auto* joint) {
+        joint->RestoreState(reader);
+    });
+
+    m_staticBroadPhase->Restore(reader);
+    m_dynamicBroadPhase->Restore(reader);
+
+    m_dirtyProxies.resize(reader.read<uint32>());
+    reader.read(m_dirtyProxies.data(), m_dirtyProxies.size());
+
+    // 3) Contacts are recreated in their original order, which preserves the
+    //    order of the body edge lists and in turn the solver order
+    m_contacts.for_each([this](auto* contact) {
+        m_contacts.remove(*contact);
+        contact->GetFixtureA()->body->contact_edges.remove(contact->edge_a);
+        contact->GetFixtureB()->body->contact_edges.remove(contact->edge_b);
+        block_allocator.Delete<Contact>(contact);
+    });
+
+    // every contact is gone, so the states are packed in the restored order
+    m_contactStates.clear();
+    m_freeContactStates.clear();
+
+    m_awakeContacts.assign(reader.read<uint32>(), awake_contact());
+    auto contact_count = reader.read<uint32>();
+    const auto* records = reader.read_array<snapshot_contact>(contact_count);
+    for (uint32 i = 0; i < contact_count; i++)
+    {
+        const auto& record = records[i];
+        Fixture* a = GetProxy(record.key_a)->fixture;
+        Fixture* b = GetProxy(record.key_b)->fixture;
+
+        // fixtures were saved in their swapped order, so construction
+        // will not swap them again
+        int32 state = ReserveContactState();
+        Contact* contact = block_allocator.New<Contact>(a, b, &m_contactStates, state);
+        SDL_assert(contact->GetFixtureA() == a);
+
+        contact->State().flags = record.flags;
+        contact->State().manifold = record.manifold;
+        contact->m_awakeIndex = record.awake_index;
+        if (contact->m_awakeIndex >= 0)
+        {
+            m_awakeContacts[static_cast<size_t>(contact->m_awakeIndex)] = { contact, state, record.key_a, record.key_b };
+        }
+
+        contact->friction = record.friction;
+        contact->restitution = record.restitution;
+        contact->tangent_speed = record.tangent_speed;
+        contact->impulse = record.impulse;
+
+        m_contacts.push_back(*contact);
+        a->body->contact_edges.push_back(contact->edge_a);
+        b->body->contact_edges.push_back(contact->edge_b);
+    }
+
+    // 4) Sensor overlaps.  Events not yet reported belong to the discarded state.
+    m_sensorOverlaps.clear();
+    m_sensorLookup.clear();
+    m_sensorBegin.clear();
+    m_sensorEnd.clear();
+
+    auto sensor_count = reader.read<uint32>();
+    const auto* sensor_records = reader.read_array<snapshot_sensor>(sensor_count);
+    for (uint32 i = 0; i < sensor_count; i++)
+    {
+        const auto& record = sensor_records[i];
+        sensor_overlap overlap;
+        overlap.sensor = GetProxy(record.key_sensor)->fixture;
+        overlap.visitor = GetProxy(record.key_visitor)->fixture;
+        overlap.key_sensor = record.key_sensor;
+        overlap.key_visitor = record.key_visitor;
+        overlap.touching = record.touching;
+
+        m_sensorLookup[sensor_pair_key(record.key_sensor, record.key_visitor)] = i;
+        m_sensorOverlaps.push_back(overlap);
+    }
+
+    SDL_assert(std::find(m_awakeBodies.begin(), m_awakeBodies.end(), nullptr) == m_awakeBodies.end());
+    SDL_assert(std::none_of(m_awakeContacts.begin(), m_awakeContacts.end(),
+                            [](const auto& entry) { return entry.contact == nullptr; }));
+    SDL_assert(reader.at_end());
+}
+
+void
+CollisionGraph::CreateContact (fixture_proxy* a, fixture_proxy* b)
+{
+    RigidBody* body_a = a->fixture->body;
+    RigidBody* body_b = b->fixture->body;
+
+    if (!body_a->ShouldCollide(body_b))
+    {
+        return;
+    }
+
+    if (custom_filter && !custom_filter->ShouldCollide(a->fixture, b->fixture))
+    {
+        return;
+    }
+
+    if (a->fixture->IsSensor() || b->fixture->IsSensor())
+    {
+        CreateSensorOverlap(a, b);
+        return;
+    }
+
+    if (body_a->HasEdge(a->fixture, b->fixture))
+    {
+        return;
+    }
+
+    int32 state = ReserveContactState();
+    Contact* contact = block_allocator.New<Contact>(a->fixture, b->fixture, &m_contactStates, state);
+    m_contacts.push_back(*contact);
+    m_current.contacts_created++;
+
+    // fixtures may have swapped order during contact construction, so cached
+    // body variables cannot be trusted.
+    contact->GetFixtureA()->body->contact_edges.push_back(contact->edge_a);
+    contact->GetFixtureB()->body->contact_edges.push_back(contact->edge_b);
+
+    if (body_a->IsAwake() || body_b->IsAwake())
+    {
+        AddAwakeContact(contact);
+    }
+
+    body_a->WakeUp();
+    body_b->WakeUp();
+}
+
+void
+CollisionGraph::DestroyContact (Contact* contact)
+{
+    RigidBody* body_a = contact->GetFixtureA()->body;
+    RigidBody* body_b = contact->GetFixtureB()->body;
+
+    if (contact->IsTouching())
+    {
+        if (listener)
+        {
+            listener->OnContactEnd(contact);
+        }
+
+        body_a->WakeUp();
+        body_b->WakeUp();
+    }
+
+    if (contact->m_awakeIndex >= 0)
+    {
+        RemoveAwakeContact(contact);
+    }
+
+    m_contacts.remove(*contact);
+    body_a->contact_edges.remove(contact->edge_a);
+    body_b->contact_edges.remove(contact->edge_b);
+
+    m_freeContactStates.push_back(contact->m_state);
+    block_allocator.Delete<Contact>(contact);
+    m_current.contacts_destroyed++;
+}
+
+int32
+CollisionGraph::ReserveBodyState (void)
+{
+    return reserve_state(m_bodyStates, m_freeBodyStates);
+}
+
+int32
+CollisionGraph::ReserveContactState (void)
+{
+    return reserve_state(m_contactStates, m_freeContactStates);
+}
+
+void
+CollisionGraph::PurgeContacts (void)
+{
+    // Contacts between sleeping bodies are not in the awake set, so they're
+    // never visited.  Destroyed contacts are swap removed, so the index only
+    // advances when the contact survives.  Only the dense awake set and
+    // contact states are read, and fixtures are only inspected when a filter
+    // has changed.
+    bool refilter = (m_flags & FILTER_DIRTY);
+    m_flags &= ~FILTER_DIRTY;
+
+    m_contactUpdates.clear();
+    size_t i = 0;
+    while (i < m_awakeContacts.size())
+    {
+        // copied, as destroying a contact may wake bodies and grow the set
+        awake_contact entry = m_awakeContacts[i];
+        Contact* contact = entry.contact;
+        const auto& state = m_contactStates[static_cast<size_t>(entry.state)];
+        SDL_assert(state.fixture_a->body->IsAwake() || state.fixture_b->body->IsAwake());
+
+        if (refilter)
+        {
+            Fixture* a = state.fixture_a;
+            Fixture* b = state.fixture_b;
+            if (a->IsFilterDirty() || b->IsFilterDirty())
+            {
+                if (a->body->ShouldCollide(b->body) == false)
+                {
+                    DestroyContact(contact);
+                    continue;
+                }
+
+                if (custom_filter && custom_filter->ShouldCollide(a, b) == false)
+                {
+                    DestroyContact(contact);
+                    continue;
+                }
+
+                a->FlagFilterClean();
+                b->FlagFilterClean();
+            }
+        }
+
+        // purge non-intersecting contacts.  check is on the enlarged AABBs
+        const aabb& box_a = GetFatAABB(entry.key_a);
+        const aabb& box_b = GetFatAABB(entry.key_b);
+        if (!box_a.intersects_with(box_b))
+        {
+            DestroyContact(contact);
+            continue;
+        }
+
+        m_contactUpdates.push_back({ contact, state.manifold, (state.flags & Contact::TOUCHING) != 0 });
+        i++;
+    }
+
+    // fixtures with only sensor overlaps never reach the contact refilter
+    for (Fixture* fixture : m_sensorRefiltered)
+    {
+        fixture->FlagFilterClean();
+    }
+
+    m_sensorRefiltered.clear();
+
+    // Manifold generation only modifies the contact, so it can be split across
+    // workers.  Waking bodies and listener events are applied afterwards in
+    // contact order.
+    auto evaluate = [this](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++)
+        {
+            const auto& update = m_contactUpdates[i];
+            update.contact->Evaluate(update);
+        }
+    };
+
+    if (workers)
+    {
+        workers->ParallelFor(m_contactUpdates.size(), NARROW_PHASE_BATCH_SIZE, evaluate);
+    }
+    else
+    {
+        evaluate(0, m_contactUpdates.size(), 0);
+    }
+
+    for (const auto& update : m_contactUpdates)
+    {
+        update.contact->Commit(update, listener);
+    }
+}
+
+void
+CollisionGraph::CreateSensorOverlap (fixture_proxy* a, fixture_proxy* b)
+{
+    // the pair buffer is unique within a step, but pairs of proxies which
+    // moved are found again while the overlap exists
+    if (!a->fixture->IsSensor())
+    {
+        std::swap(a, b);
+    }
+
+    int32 key_a = GetProxyKey(a);
+    int32 key_b = GetProxyKey(b);
+    auto index = static_cast<uint32>(m_sensorOverlaps.size());
+    if (!m_sensorLookup.emplace(sensor_pair_key(key_a, key_b), index).second)
+    {
+        return;
+    }
+
+    sensor_overlap overlap;
+    overlap.sensor = a->fixture;
+    overlap.visitor = b->fixture;
+    overlap.key_sensor = key_a;
+    overlap.key_visitor = key_b;
+    m_sensorOverlaps.push_back(overlap);
+}
+
+void
+CollisionGraph::DestroySensorOverlap (size_t index, bool report)
+{
+    SDL_assert(index < m_sensorOverlaps.size());
+
+    auto& overlap = m_sensorOverlaps[index];
+    if (report && overlap.touching)
+    {
+        m_sensorEnd.push_back({ overlap.sensor, overlap.visitor });
+    }
+
+    m_sensorLookup.erase(sensor_pair_key(overlap.key_sensor, overlap.key_visitor));
+    if (index + 1 < m_sensorOverlaps.size())
+    {
+        overlap = m_sensorOverlaps.back();
+        m_sensorLookup[sensor_pair_key(overlap.key_sensor, overlap.key_visitor)] = static_cast<uint32>(index);
+    }
+
+    m_sensorOverlaps.pop_back();
+}
+
+void
+CollisionGraph::DestroySensorOverlaps (const Fixture* fixture, bool report)
+{
+    int32 key = GetProxyKey(fixture->proxy);
+    size_t i = 0;
+    while (i < m_sensorOverlaps.size())
+    {
+        const auto& overlap = m_sensorOverlaps[i];
+        if (overlap.key_sensor == key || overlap.key_visitor == key)
+        {
+            DestroySensorOverlap(i, report);
+            continue;
+        }
+
+        i++;
+    }
+
+    if (!report)
+    {
+        // the fixture is being destroyed, so pending events can't reference it
+        auto references = [=](const sensor_event& e) {
+            return (e.sensor == fixture || e.visitor == fixture);
+        };
+
+        m_sensorBegin.erase(std::remove_if(m_sensorBegin.begin(), m_sensorBegin.end(), references),
+                            m_sensorBegin.end());
+        m_sensorEnd.erase(std::remove_if(m_sensorEnd.begin(), m_sensorEnd.end(), references),
+                          m_sensorEnd.end());
+    }
+}
+
+void
+CollisionGraph::UpdateSensors (void)
+{
+    // Overlaps between sleeping bodies can't change, so they're skipped.  The
+    // shape test doesn't build a manifold, and all events of the step are
+    // reported together once the overlaps are updated.
+    bool refilter = (m_flags & FILTER_DIRTY);
+
+    size_t i = 0;
+    while (i < m_sensorOverlaps.size())
+    {
+        auto& overlap = m_sensorOverlaps[i];
+        Fixture* sensor = overlap.sensor;
+        Fixture* visitor = overlap.visitor;
+        if (!sensor->body->IsAwake() && !visitor->body->IsAwake())
+        {
+            i++;
+            continue;
+        }
+
+        if (refilter && (sensor->IsFilterDirty() || visitor->IsFilterDirty()))
+        {
+            if (!sensor->body->ShouldCollide(visitor->body) ||
+                (custom_filter && !custom_filter->ShouldCollide(sensor, visitor)))
+            {
+                DestroySensorOverlap(i, true);
+                continue;
+            }
+
+            // flags are cleared after the purge, which may refilter contacts
+            // of the same fixtures
+            m_sensorRefiltered.push_back(sensor);
+            m_sensorRefiltered.push_back(visitor);
+        }
+
+        if (!GetFatAABB(overlap.key_sensor).intersects_with(GetFatAABB(overlap.key_visitor)))
+        {
+            DestroySensorOverlap(i, true);
+            continue;
+        }
+
+        bool touching = sensor->shape.world->intersects_with(visitor->shape.world);
+        if (touching != overlap.touching)
+        {
+            overlap.touching = touching;
+            auto& events = (touching) ? m_sensorBegin : m_sensorEnd;
+            events.push_back({ sensor, visitor });
+        }
+
+        i++;
+    }
+
+    if (listener)
+    {
+        if (!m_sensorBegin.empty())
+        {
+            listener->OnSensorBegin(m_sensorBegin.data(), m_sensorBegin.size());
+        }
+
+        if (!m_sensorEnd.empty())
+        {
+            listener->OnSensorEnd(m_sensorEnd.data(), m_sensorEnd.size());
+        }
+    }
+
+    m_sensorBegin.clear();
+    m_sensorEnd.clear();
+}
+
+void
+CollisionGraph::AddAwakeBody (RigidBody* body)
+{
+    SDL_assert(body->m_awakeIndex < 0);
+
+    body->m_awakeIndex = static_cast<int32>(m_awakeBodies.size());
+    m_awakeBodies.push_back(body);
+
+    body->contact_edges.for_each([=](auto* edge) {
+        if (edge->contact->m_awakeIndex < 0)
+        {
+            AddAwakeContact(edge->contact);
+        }
+    });
+}
+
+void
+CollisionGraph::RemoveAwakeBody (RigidBody* body)
+{
+    SDL_assert(m_awakeBodies[static_cast<size_t>(body->m_awakeIndex)] == body);
+
+    RigidBody* last = m_awakeBodies.back();
+    last->m_awakeIndex = body->m_awakeIndex;
+    m_awakeBodies[static_cast<size_t>(body->m_awakeIndex)] = last;
+    m_awakeBodies.pop_back();
+    body->m_awakeIndex = -1;
+
+    body->contact_edges.for_each([=](auto* edge) {
+        if (edge->contact->m_awakeIndex >= 0 && !edge->other->IsAwake())
+        {
+            RemoveAwakeContact(edge->contact);
+        }
+    });
+}
+
+void
+CollisionGraph::AddAwakeContact (Contact* contact)
+{
+    SDL_assert(contact->m_awakeIndex < 0);
+
+    Fixture* a = contact->GetFixtureA();
+    Fixture* b = contact->GetFixtureB();
+    contact->m_awakeIndex = static_cast<int32>(m_awakeContacts.size());
+    m_awakeContacts.push_back({ contact, contact->m_state, GetProxyKey(a->proxy), GetProxyKey(b->proxy) });
+
+    // filters may have changed while the contact was asleep
+    if (a->IsFilterDirty() || b->IsFilterDirty())
+    {
+        m_flags |= FILTER_DIRTY;
+    }
+}
+
+void
+CollisionGraph::RemoveAwakeContact (Contact* contact)
+{
+    auto index = static_cast<size_t>(contact->m_awakeIndex);
+    SDL_assert(m_awakeContacts[index].contact == contact);
+
+    m_awakeContacts[index] = m_awakeContacts.back();
+    m_awakeContacts[index].contact->m_awakeIndex = contact->m_awakeIndex;
+    m_awakeContacts.pop_back();
+    contact->m_awakeIndex = -1;
+}
+
+int32
+CollisionGraph::RegisterProxy (fixture_proxy* proxy)
+{
+    int32 handle = 0;
+    if (proxy->fixture->body->IsStatic())
+    {
+        handle = m_staticBroadPhase->CreateDeferredProxy(proxy->box, proxy);
+        m_staticBroadPhase->SetFilter(handle, make_proxy_filter(proxy->fixture));
+        m_dirtyProxies.push_back(~handle);
+    }
+    else
+    {
+        handle = (m_flags & STEPPED) ? m_dynamicBroadPhase->CreateProxy(proxy->box, proxy)
+                                     : m_dynamicBroadPhase->CreateDeferredProxy(proxy->box, proxy);
+        m_dynamicBroadPhase->SetFilter(handle, make_proxy_filter(proxy->fixture));
+        m_dirtyProxies.push_back(handle);
+    }
+
+    return handle;
+}
+
+void
+CollisionGraph::UnregisterProxy (const fixture_proxy* proxy)
 {
     int32 handle = proxy->handle;
     if (handle == fixture_proxy::INVALID_HANDLE)
@@ -438,24 +1818,96 @@ CollisionGraph::UnregisterProxy (const fixture_proxy* proxy)
         return;
     }
 
-    m_tree.DestroyProxy(handle);
+    int32 key = GetProxyKey(proxy);
+    DestroySensorOverlaps(proxy->fixture, false);
+    if (proxy->fixture->body->IsStatic())
+    {
+        m_staticBroadPhase->DestroyProxy(handle);
+    }
+    else
+    {
+        m_dynamicBroadPhase->DestroyProxy(handle);
+    }
+
     m_dirtyProxies.erase(std::remove_if(m_dirtyProxies.begin(),
                                         m_dirtyProxies.end(),
-                                        [=](int32 h) { return h == handle; }),
+                                        [=](int32 k) { return k == key; }),
                                         m_dirtyProxies.end());
 }
 
 void
 CollisionGraph::MoveProxy (const fixture_proxy* proxy, const math::vec2& displacement)
 {
-    m_tree.MoveProxy(proxy->handle, proxy->box, displacement);
-    m_dirtyProxies.push_back(proxy->handle);
+    if (proxy->fixture->body->IsStatic())
+    {
+        m_staticBroadPhase->MoveProxy(proxy->handle, proxy->box, displacement);
+    }
+    else
+    {
+        m_dynamicBroadPhase->MoveProxy(proxy->handle, proxy->box, displacement);
+    }
+
+    m_dirtyProxies.push_back(GetProxyKey(proxy));
 }
 
 void
 CollisionGraph::TouchProxy (const fixture_proxy* proxy)
 {
-    m_dirtyProxies.push_back(proxy->handle);
+    m_dirtyProxies.push_back(GetProxyKey(proxy));
+}
+
+void
+CollisionGraph::RefilterProxy (const fixture_proxy* proxy)
+{
+    if (proxy->handle == fixture_proxy::INVALID_HANDLE)
+    {
+        return;
+    }
+
+    IBroadPhase* broad_phase = (proxy->fixture->body->IsStatic()) ? m_staticBroadPhase.get()
+                                                                  : m_dynamicBroadPhase.get();
+    broad_phase->SetFilter(proxy->handle, make_proxy_filter(proxy->fixture));
+    TouchProxy(proxy);
+}
+
+void
+CollisionGraph::RebuildPairs (Fixture* fixture)
+{
+    if (fixture->proxy->handle == fixture_proxy::INVALID_HANDLE)
+    {
+        return;
+    }
+
+    fixture->body->contact_edges.for_each([=](auto* edge) {
+        Contact* c = edge->contact;
+        if (fixture == c->GetFixtureA() || fixture == c->GetFixtureB())
+        {
+            DestroyContact(c);
+        }
+    });
+
+    DestroySensorOverlaps(fixture, true);
+    TouchProxy(fixture->proxy);
+}
+
+int32
+CollisionGraph::GetProxyKey (const fixture_proxy* proxy) const noexcept
+{
+    return (proxy->fixture->body->IsStatic()) ? ~proxy->handle : proxy->handle;
+}
+
+fixture_proxy*
+CollisionGraph::GetProxy (int32 key) const noexcept
+{
+    void* user_data = (key < 0) ? m_staticBroadPhase->GetUserData(~key)
+                                : m_dynamicBroadPhase->GetUserData(key);
+    return static_cast<fixture_proxy*>(user_data);
+}
+
+const aabb&
+CollisionGraph::GetFatAABB (int32 key) const noexcept
+{
+    return (key < 0) ? m_staticBroadPhase->GetFatAABB(~key) : m_dynamicBroadPhase->GetFatAABB(key);
 }
 
 } // namespace physics
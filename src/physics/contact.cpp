@@ -7,98 +7,110 @@
 
 #include <SDL_assert.h>
 
-#include <algorithm>
-
 namespace rdge {
 namespace physics {
 
-namespace {
-
-float mix_friction (float a, float b)
-{
-    return std::sqrtf(a * b);
-}
-
-constexpr float mix_restitution (float a, float b)
-{
-    return std::max(a, b);
-}
-
-} // anonymous namespace
-
-Contact::Contact (Fixture* a, Fixture* b)
-    : fixture_a(a)
-    , fixture_b(b)
-    , friction(mix_friction(a->friction, b->friction))
+Contact::Contact (Fixture* a, Fixture* b, std::vector<contact_state>* states, int32 state)
+    : friction(mix_friction(a->friction, b->friction))
     , restitution(mix_restitution(a->restitution, b->restitution))
+    , m_states(states)
+    , m_state(state)
 {
-    SDL_assert(fixture_a);
-    SDL_assert(fixture_b);
-    SDL_assert(fixture_a != fixture_b);
-
-    if (fixture_a->shape.world->type() == ShapeType::CIRCLE &&
-        fixture_b->shape.world->type() == ShapeType::POLYGON)
+    SDL_assert(a);
+    SDL_assert(b);
+    SDL_assert(a != b);
+
+    // edges are primary to all shapes, and polygons are primary to circles
+    ShapeType type_a = a->shape.world->type();
+    ShapeType type_b = b->shape.world->type();
+    if ((type_a == ShapeType::CIRCLE && type_b == ShapeType::POLYGON) ||
+        (type_a != ShapeType::EDGE && type_b == ShapeType::EDGE))
     {
-        std::swap(this->fixture_a, this->fixture_b);
+        std::swap(a, b);
     }
 
+    auto& data = State();
+    data.fixture_a = a;
+    data.fixture_b = b;
+
     this->edge_a.contact = this;
     this->edge_b.contact = this;
-    this->edge_a.other = fixture_b->body;
-    this->edge_b.other = fixture_a->body;
+    this->edge_a.other = b->body;
+    this->edge_b.other = a->body;
 
-    if (fixture_a->IsSensor() || fixture_b->IsSensor())
-    {
-        m_flags |= HAS_SENSOR;
-    }
+    // sensors are tracked by the graph sensor set
+    SDL_assert(!a->IsSensor() && !b->IsSensor());
 }
 
 void
-Contact::Update (GraphListener* listener)
+Contact::Evaluate (const contact_update& update)
 {
-    m_flags |= ENABLED;
+    SDL_assert(update.contact == this);
 
-    auto old_manifold = manifold;
-    bool was_touching = IsTouching();
-    bool is_touching = false;
+    auto& data = State();
+    auto& manifold = data.manifold;
+    data.flags |= ENABLED;
 
-    auto shape_a = fixture_a->shape.world;
-    auto shape_b = fixture_b->shape.world;
+    auto shape_a = data.fixture_a->shape.world;
+    auto shape_b = data.fixture_b->shape.world;
 
-    if (m_flags & HAS_SENSOR)
-    {
-        manifold.count = 0;
-        is_touching = shape_a->intersects_with(shape_b);
-    }
-    else
+    bool is_touching = shape_a->intersects_with(shape_b, manifold);
+    SDL_assert(is_touching == shape_a->intersects_with(shape_b));
+
+    SET_FLAG(is_touching, data.flags, TOUCHING);
+
+    // carry over impulses for warm starting.  points are matched by the
+    // features which generated them, and new points start from zero
+    auto old_impulse = impulse;
+    const auto& old_manifold = update.old_manifold;
+    SDL_assert(old_impulse.count <= old_manifold.count);
+
+    impulse.count = manifold.count;
+    for (size_t i = 0; i < manifold.count; i++)
     {
-        is_touching = shape_a->intersects_with(shape_b, manifold);
-        SDL_assert(is_touching == shape_a->intersects_with(shape_b));
+        impulse.normals[i] = 0.f;
+        impulse.tangents[i] = 0.f;
 
-        if (was_touching != is_touching)
+        uint32 key = manifold.features[i].key();
+        for (size_t j = 0; j < old_impulse.count; j++)
         {
-            fixture_a->body->WakeUp();
-            fixture_b->body->WakeUp();
+            if (old_manifold.features[j].key() == key)
+            {
+                impulse.normals[i] = old_impulse.normals[j];
+                impulse.tangents[i] = old_impulse.tangents[j];
+                break;
+            }
         }
     }
+}
+
+void
+Contact::Commit (const contact_update& update, GraphListener* listener)
+{
+    SDL_assert(update.contact == this);
 
-    SET_FLAG(is_touching, m_flags, TOUCHING);
+    bool is_touching = IsTouching();
+    if (update.was_touching != is_touching)
+    {
+        GetFixtureA()->body->WakeUp();
+        GetFixtureB()->body->WakeUp();
+    }
 
     if (listener)
     {
-        if (is_touching && !was_touching)
+        if (is_touching && !update.was_touching)
         {
             listener->OnContactStart(this);
         }
 
-        if (was_touching && !is_touching)
+        if (update.was_touching && !is_touching)
         {
             listener->OnContactEnd(this);
         }
 
-        if (is_touching && (m_flags & HAS_SENSOR) == 0)
+        if (is_touching)
         {
-            listener->OnPreSolve(this, old_manifold);
+            listener->OnPreSolve(this, update.old_manifold);
         }
     }
 }
@@ -3,6 +3,7 @@
 #include <rdge/physics/collision_graph.hpp>
 #include <rdge/physics/shapes/circle.hpp>
 #include <rdge/physics/shapes/polygon.hpp>
+#include <rdge/physics/shapes/edge.hpp>
 #include <rdge/util/memory/small_block_allocator.hpp>
 
 #include <SDL_assert.h>
@@ -40,6 +41,11 @@ Fixture::Fixture (const fixture_profile& profile, RigidBody* parent)
         shape.world = allocator.New<polygon>(*static_cast<const polygon*>(profile.shape));
         break;
 
+    case ShapeType::EDGE:
+        shape.local = allocator.New<edge>(*static_cast<const edge*>(profile.shape));
+        shape.world = allocator.New<edge>(*static_cast<const edge*>(profile.shape));
+        break;
+
     default:
         SDL_assert(false);
         break;
@@ -93,6 +99,11 @@ Fixture::~Fixture (void) noexcept
         allocator.Delete<polygon>(static_cast<polygon*>(shape.world));
         break;
 
+    case ShapeType::EDGE:
+        allocator.Delete<edge>(static_cast<edge*>(shape.local));
+        allocator.Delete<edge>(static_cast<edge*>(shape.world));
+        break;
+
     default:
         SDL_assert(false);
         break;
@@ -100,12 +111,46 @@ Fixture::~Fixture (void) noexcept
 }
 
 void
-Fixture::SetSensor (bool value) noexcept
+Fixture::FlagFilterDirty (void) noexcept
+{
+    m_flags |= FILTER_DIRTY;
+
+    // contacts are only filtered when the graph has been notified
+    body->graph->m_flags |= CollisionGraph::FILTER_DIRTY;
+}
+
+void
+Fixture::SetFilter (const collision_filter& f)
+{
+    filter = f;
+    Refilter();
+}
+
+void
+Fixture::Refilter (void)
+{
+    // existing contacts are flagged, and the proxy is touched to find pairs the
+    // previous filter rejected
+    FlagFilterDirty();
+    body->graph->RefilterProxy(proxy);
+}
+
+void
+Fixture::SetSensor (bool value)
 {
+    if (body->graph->IsLocked())
+    {
+        SDL_assert(false);
+        return;
+    }
+
     if (IsSensor() != value)
     {
         body->WakeUp();
         SET_FLAG(value, m_flags, SENSOR);
+
+        // sensors aren't paired with contacts, so existing pairs are replaced
+        body->graph->RebuildPairs(this);
     }
 }
 
@@ -122,6 +167,10 @@ Fixture::Syncronize (void)
         *static_cast<polygon*>(shape.world) = *static_cast<const polygon*>(shape.local);
         break;
 
+    case ShapeType::EDGE:
+        *static_cast<edge*>(shape.world) = *static_cast<const edge*>(shape.local);
+        break;
+
     default:
         SDL_assert(false);
         break;
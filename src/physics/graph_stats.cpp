@@ -0,0 +1,82 @@
+#include <rdge/physics/graph_stats.hpp>
+
+#include <algorithm>
+
+namespace rdge {
+namespace physics {
+
+namespace {
+
+template <typename T>
+stat_summary
+summarize (const GraphStats& stats, T step_stats::* field) noexcept
+{
+    stat_summary result;
+    if (stats.Empty())
+    {
+        return result;
+    }
+
+    double values[GraphStats::HISTORY_SIZE];
+    double sum = 0.0;
+    size_t count = stats.Size();
+    for (size_t i = 0; i < count; i++)
+    {
+        values[i] = static_cast<double>(stats[i].*field);
+        sum += values[i];
+    }
+
+    auto minmax = std::minmax_element(values, values + count);
+    result.min = *minmax.first;
+    result.max = *minmax.second;
+    result.avg = sum / static_cast<double>(count);
+
+    // nearest rank, i.e. the smallest value greater than or equal to 99% of
+    // the recorded values
+    size_t rank = ((count * 99) + 99) / 100;
+    std::nth_element(values, values + (rank - 1), values + count);
+    result.p99 = values[rank - 1];
+
+    return result;
+}
+
+} // anonymous namespace
+
+constexpr size_t GraphStats::HISTORY_SIZE;
+
+void
+GraphStats::Record (const step_stats& stats) noexcept
+{
+    if (m_count < HISTORY_SIZE)
+    {
+        m_history[(m_head + m_count) % HISTORY_SIZE] = stats;
+        m_count++;
+    }
+    else
+    {
+        m_history[m_head] = stats;
+        m_head = (m_head + 1) % HISTORY_SIZE;
+    }
+}
+
+void
+GraphStats::Clear (void) noexcept
+{
+    m_head = 0;
+    m_count = 0;
+}
+
+stat_summary
+GraphStats::Summarize (int64 step_stats::* field) const noexcept
+{
+    return summarize(*this, field);
+}
+
+stat_summary
+GraphStats::Summarize (uint32 step_stats::* field) const noexcept
+{
+    return summarize(*this, field);
+}
+
+} // namespace physics
+} // namespace rdge
@@ -2,11 +2,14 @@
 #include <rdge/physics/collision_graph.hpp>
 #include <rdge/physics/rigid_body.hpp>
 #include <rdge/physics/solver.hpp>
+#include <rdge/physics/snapshot.hpp>
 #include <rdge/physics/isometry.hpp>
 #include <rdge/math/intrinsics.hpp>
 #include <rdge/math/mat2.hpp>
 #include <rdge/util/logger.hpp>
 
+#include <algorithm>
+
 namespace rdge {
 namespace physics {
 
@@ -63,7 +66,7 @@ RevoluteJoint::JointAngle (void) const noexcept
 float
 RevoluteJoint::JointSpeed (void) const noexcept
 {
-    return body_b->angular.velocity - body_a->angular.velocity;
+    return body_b->GetAngularVelocity() - body_a->GetAngularVelocity();
 }
 
 void
@@ -454,6 +457,198 @@ RevoluteJoint::SolvePositionConstraints (solver_body_data& bdata_a, solver_body_
     return (linear_error <= LINEAR_SLOP) && (angular_error <= ANGULAR_SLOP);
 }
 
+void
+RevoluteJoint::InitializeSoftSolver (const time_step&  step,
+                                     solver_body_data& bdata_a,
+                                     solver_body_data& bdata_b)
+{
+    // point-to-point effective mass is rebuilt every substep from the current
+    // anchors, and warm starting is performed by WarmStartSoft
+    m_localCenterA = body_a->GetLocalCenter();
+    m_localCenterB = body_b->GetLocalCenter();
+
+    m_motorMass = (bdata_a.inv_mmoi + bdata_b.inv_mmoi);
+    if (m_motorMass > 0.f)
+    {
+        m_motorMass = 1.f / m_motorMass;
+    }
+
+    if ((m_flags & MOTOR_ENABLED) == 0)
+    {
+        m_motorImpulse = 0.f;
+    }
+
+    if ((m_flags & LIMIT_ENABLED) == 0)
+    {
+        m_impulse.z = 0.f;
+    }
+
+    // account for the variable time step
+    m_impulse *= step.ratio;
+    m_motorImpulse *= step.ratio;
+}
+
+void
+RevoluteJoint::WarmStartSoft (solver_body_data& bdata_a, solver_body_data& bdata_b)
+{
+    rotation rot_a(bdata_a.rotation + bdata_a.angle);
+    rotation rot_b(bdata_b.rotation + bdata_b.angle);
+    auto r_a = rot_a.rotate(m_anchor[0] - m_localCenterA);
+    auto r_b = rot_b.rotate(m_anchor[1] - m_localCenterB);
+
+    math::vec2 impulse = m_impulse.xy();
+    float constraint_impulse = m_motorImpulse + m_impulse.z;
+
+    bdata_a.linear_vel -= bdata_a.inv_mass * impulse;
+    bdata_a.angular_vel -= bdata_a.inv_mmoi *
+                           (math::perp_dot(r_a, impulse) + constraint_impulse);
+    bdata_b.linear_vel += bdata_b.inv_mass * impulse;
+    bdata_b.angular_vel += bdata_b.inv_mmoi *
+                           (math::perp_dot(r_b, impulse) + constraint_impulse);
+}
+
+bool
+RevoluteJoint::SolveSoftConstraints (const soft_step_data& soft,
+                                     bool                  use_bias,
+                                     solver_body_data&     bdata_a,
+                                     solver_body_data&     bdata_b)
+{
+    bool limits_enabled = (m_flags & LIMIT_ENABLED) != 0;
+    bool limits_equal = limits_enabled &&
+                        (math::abs(m_upperAngle - m_lowerAngle) < (2.f * ANGULAR_SLOP));
+
+    // Solve motor constraint
+    if (m_flags & MOTOR_ENABLED && !limits_equal)
+    {
+        float rv = bdata_b.angular_vel - bdata_a.angular_vel - m_motorSpeed;
+        float impulse = -m_motorMass * rv;
+
+        float old_impulse = m_motorImpulse;
+        float max_impulse = m_maxMotorTorque * soft.h;
+        m_motorImpulse = math::clamp(m_motorImpulse + impulse, -max_impulse, max_impulse);
+        impulse = m_motorImpulse - old_impulse;
+
+        bdata_a.angular_vel -= bdata_a.inv_mmoi * impulse;
+        bdata_b.angular_vel += bdata_b.inv_mmoi * impulse;
+    }
+
+    // Solve limit constraint
+    float angular_error = 0.f;
+    if (limits_enabled)
+    {
+        float angle = (bdata_b.rotation + bdata_b.angle) -
+                      (bdata_a.rotation + bdata_a.angle) -
+                      m_referenceAngle;
+
+        // Only the nearer limit is solved.  The accumulated impulse is positive
+        // at the lower limit and negative at the upper limit, so crossing to
+        // the other limit releases the impulse.
+        bool lower = (angle - m_lowerAngle) <= (m_upperAngle - angle);
+        float sign = (lower) ? 1.f : -1.f;
+        float c = (lower) ? (angle - m_lowerAngle) : (m_upperAngle - angle);
+        angular_error = std::max(-c, 0.f);
+
+        float bias = 0.f;
+        float mass_scale = 1.f;
+        float impulse_scale = 0.f;
+        if (c > 0.f)
+        {
+            // speculative, remove the approaching velocity beyond the gap
+            bias = c * soft.inv_h;
+        }
+        else if (use_bias)
+        {
+            bias = soft.joint.bias_rate * c;
+            mass_scale = soft.joint.mass_scale;
+            impulse_scale = soft.joint.impulse_scale;
+        }
+
+        float cdot = sign * (bdata_b.angular_vel - bdata_a.angular_vel);
+        float accumulated = sign * m_impulse.z;
+        float impulse = (-m_motorMass * mass_scale * (cdot + bias)) -
+                        (impulse_scale * accumulated);
+        float new_impulse = std::max(accumulated + impulse, 0.f);
+        impulse = sign * (new_impulse - accumulated);
+        m_impulse.z = sign * new_impulse;
+
+        bdata_a.angular_vel -= bdata_a.inv_mmoi * impulse;
+        bdata_b.angular_vel += bdata_b.inv_mmoi * impulse;
+    }
+
+    // Solve point-to-point constraint
+    rotation rot_a(bdata_a.rotation + bdata_a.angle);
+    rotation rot_b(bdata_b.rotation + bdata_b.angle);
+    auto r_a = rot_a.rotate(m_anchor[0] - m_localCenterA);
+    auto r_b = rot_b.rotate(m_anchor[1] - m_localCenterB);
+
+    math::vec2 vel_a = bdata_a.linear_vel + (r_a.perp() * bdata_a.angular_vel);
+    math::vec2 vel_b = bdata_b.linear_vel + (r_b.perp() * bdata_b.angular_vel);
+    math::vec2 cdot = vel_b - vel_a;
+
+    auto p = (bdata_b.world_center + bdata_b.pos + r_b) -
+             (bdata_a.world_center + bdata_a.pos + r_a);
+    float linear_error = p.length();
+
+    math::vec2 bias = { 0.f, 0.f };
+    float mass_scale = 1.f;
+    float impulse_scale = 0.f;
+    if (use_bias)
+    {
+        bias = p * soft.joint.bias_rate;
+        mass_scale = soft.joint.mass_scale;
+        impulse_scale = soft.joint.impulse_scale;
+    }
+
+    math::mat2 k;
+    k[0].x = (bdata_a.inv_mass + bdata_b.inv_mass) +
+             (bdata_a.inv_mmoi * math::square(r_a.y)) +
+             (bdata_b.inv_mmoi * math::square(r_b.y));
+    k[0].y = -(bdata_a.inv_mmoi * r_a.x * r_a.y) - (bdata_b.inv_mmoi * r_b.x * r_b.y);
+    k[1].x = k[0].y;
+    k[1].y = (bdata_a.inv_mass + bdata_b.inv_mass) +
+             (bdata_a.inv_mmoi * math::square(r_a.x)) +
+             (bdata_b.inv_mmoi * math::square(r_b.x));
+
+    math::vec2 impulse = (-mass_scale * k.solve(cdot + bias)) -
+                         (impulse_scale * m_impulse.xy());
+    m_impulse.x += impulse.x;
+    m_impulse.y += impulse.y;
+
+    bdata_a.linear_vel -= bdata_a.inv_mass * impulse;
+    bdata_a.angular_vel -= bdata_a.inv_mmoi * math::perp_dot(r_a, impulse);
+    bdata_b.linear_vel += bdata_b.inv_mass * impulse;
+    bdata_b.angular_vel += bdata_b.inv_mmoi * math::perp_dot(r_b, impulse);
+
+    return (linear_error <= LINEAR_SLOP) && (angular_error <= ANGULAR_SLOP);
+}
+
+void
+RevoluteJoint::SaveState (snapshot_writer& writer) const
+{
+    // effective masses and local centers are recomputed by InitializeSolver
+    writer.write(static_cast<uint16>(m_flags & ~ON_ISLAND));
+    writer.write(m_impulse);
+    writer.write(m_motorImpulse);
+    writer.write(m_maxMotorTorque);
+    writer.write(m_motorSpeed);
+    writer.write(m_limitState);
+    writer.write(m_lowerAngle);
+    writer.write(m_upperAngle);
+}
+
+void
+RevoluteJoint::RestoreState (snapshot_reader& reader)
+{
+    reader.read(m_flags);
+    reader.read(m_impulse);
+    reader.read(m_motorImpulse);
+    reader.read(m_maxMotorTorque);
+    reader.read(m_motorSpeed);
+    reader.read(m_limitState);
+    reader.read(m_lowerAngle);
+    reader.read(m_upperAngle);
+}
+
 std::ostream& operator<< (std::ostream& os, const RevoluteJoint& j)
 {
     os << "RevoluteJoint: {"
@@ -0,0 +1,196 @@
+#include <rdge/physics/pair_buffer.hpp>
+#include <rdge/util/compiler.hpp>
+#include <rdge/util/exception.hpp>
+#include <rdge/util/memory/alloc.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace rdge {
+namespace physics {
+
+namespace {
+
+// Hash slots are kept at most half full
+constexpr size_t LOAD_FACTOR_INVERSE = 2;
+
+uint64
+make_key (int32 a, int32 b) noexcept
+{
+    SDL_assert(a < b);
+    return (static_cast<uint64>(static_cast<uint32>(a)) << 32) | static_cast<uint32>(b);
+}
+
+// MurmurHash3 64-bit finalizer
+uint64
+hash_key (uint64 key) noexcept
+{
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDull;
+    key ^= key >> 33;
+    key *= 0xC4CEB9FE1A85EC53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+size_t
+next_power_of_two (size_t value) noexcept
+{
+    size_t result = 1;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+
+    return result;
+}
+
+} // anonymous namespace
+
+PairBuffer::PairBuffer (size_t capacity)
+    : m_capacity(next_power_of_two(std::max(capacity, static_cast<size_t>(16))))
+    , m_tableSize(m_capacity * LOAD_FACTOR_INVERSE)
+{
+    if (RDGE_UNLIKELY(!RDGE_TMALLOC(m_pairs, m_capacity, memory_bucket_physics)))
+    {
+        RDGE_THROW_ALLOC_FAILED();
+    }
+
+    if (RDGE_UNLIKELY(!RDGE_TMALLOC(m_pairSlots, m_capacity, memory_bucket_physics)))
+    {
+        RDGE_THROW_ALLOC_FAILED();
+    }
+
+    if (RDGE_UNLIKELY(!RDGE_TMALLOC(m_table, m_tableSize, memory_bucket_physics)))
+    {
+        RDGE_THROW_ALLOC_FAILED();
+    }
+
+    // all bits set is EMPTY_SLOT
+    memset(m_table, 0xFF, sizeof(int32) * m_tableSize);
+}
+
+PairBuffer::~PairBuffer (void) noexcept
+{
+    RDGE_FREE(m_pairs, memory_bucket_physics);
+    RDGE_FREE(m_pairSlots, memory_bucket_physics);
+    RDGE_FREE(m_table, memory_bucket_physics);
+}
+
+bool
+PairBuffer::Insert (int32 a, int32 b)
+{
+    SDL_assert(a != b);
+    if (b < a)
+    {
+        std::swap(a, b);
+    }
+
+    uint64 key = make_key(a, b);
+    size_t slot = FindSlot(key);
+    if (m_table[slot] != EMPTY_SLOT)
+    {
+        return false;
+    }
+
+    if (m_count == m_capacity)
+    {
+        Grow();
+        slot = FindSlot(key);
+    }
+
+    m_table[slot] = static_cast<int32>(m_count);
+    m_pairs[m_count] = { a, b };
+    m_pairSlots[m_count] = static_cast<uint32>(slot);
+    m_count++;
+
+    return true;
+}
+
+bool
+PairBuffer::Contains (int32 a, int32 b) const noexcept
+{
+    if (a == b)
+    {
+        return false;
+    }
+
+    if (b < a)
+    {
+        std::swap(a, b);
+    }
+
+    return (m_table[FindSlot(make_key(a, b))] != EMPTY_SLOT);
+}
+
+void
+PairBuffer::Clear (void) noexcept
+{
+    for (size_t i = 0; i < m_count; i++)
+    {
+        m_table[m_pairSlots[i]] = EMPTY_SLOT;
+    }
+
+    m_count = 0;
+}
+
+size_t
+PairBuffer::FindSlot (uint64 key) const noexcept
+{
+    // linear probing, where the table is never full so an empty slot will be found
+    size_t mask = m_tableSize - 1;
+    size_t slot = static_cast<size_t>(hash_key(key)) & mask;
+    while (true)
+    {
+        int32 index = m_table[slot];
+        if (index == EMPTY_SLOT)
+        {
+            return slot;
+        }
+
+        const auto& pair = m_pairs[index];
+        if (make_key(pair.handle_a, pair.handle_b) == key)
+        {
+            return slot;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+}
+
+void
+PairBuffer::Grow (void)
+{
+    m_capacity *= 2;
+    m_tableSize = m_capacity * LOAD_FACTOR_INVERSE;
+
+    if (RDGE_UNLIKELY(!RDGE_TREALLOC(m_pairs, m_capacity, memory_bucket_physics)))
+    {
+        RDGE_THROW_ALLOC_FAILED();
+    }
+
+    if (RDGE_UNLIKELY(!RDGE_TREALLOC(m_pairSlots, m_capacity, memory_bucket_physics)))
+    {
+        RDGE_THROW_ALLOC_FAILED();
+    }
+
+    // contents are rebuilt, so there's no need to copy the old table
+    RDGE_FREE(m_table, memory_bucket_physics);
+    if (RDGE_UNLIKELY(!RDGE_TMALLOC(m_table, m_tableSize, memory_bucket_physics)))
+    {
+        RDGE_THROW_ALLOC_FAILED();
+    }
+
+    memset(m_table, 0xFF, sizeof(int32) * m_tableSize);
+    for (size_t i = 0; i < m_count; i++)
+    {
+        const auto& pair = m_pairs[i];
+        size_t slot = FindSlot(make_key(pair.handle_a, pair.handle_b));
+        m_table[slot] = static_cast<int32>(i);
+        m_pairSlots[i] = static_cast<uint32>(slot);
+    }
+}
+
+} // namespace physics
+} // namespace rdge
@@ -0,0 +1,123 @@
+#include <rdge/physics/query_batch.hpp>
+
+#include <algorithm>
+
+namespace rdge {
+namespace physics {
+
+namespace {
+
+// Largest quantized coordinate of the Morton code
+constexpr float MORTON_MAX = 65535.f;
+
+// Spread the lower 16 bits so there is a zero between each
+uint32
+spread_bits (uint32 value) noexcept
+{
+    value &= 0x0000FFFF;
+    value = (value | (value << 8)) & 0x00FF00FF;
+    value = (value | (value << 4)) & 0x0F0F0F0F;
+    value = (value | (value << 2)) & 0x33333333;
+    value = (value | (value << 1)) & 0x55555555;
+    return value;
+}
+
+} // anonymous namespace
+
+void
+QueryBatch::Clear (void) noexcept
+{
+    m_boxes.clear();
+    m_offsets.resize(1);
+    m_handles.clear();
+}
+
+uint32
+QueryBatch::Add (const aabb& box)
+{
+    m_boxes.push_back(box);
+    m_offsets.resize(1);
+    return static_cast<uint32>(m_boxes.size() - 1);
+}
+
+void
+QueryBatch::Begin (size_t worker_count)
+{
+    m_order.clear();
+    if (!m_boxes.empty())
+    {
+        // quantize the centers within their bounds
+        math::vec2 lo = m_boxes[0].centroid();
+        math::vec2 hi = lo;
+        for (const auto& box : m_boxes)
+        {
+            math::vec2 c = box.centroid();
+            lo = { std::min(lo.x, c.x), std::min(lo.y, c.y) };
+            hi = { std::max(hi.x, c.x), std::max(hi.y, c.y) };
+        }
+
+        math::vec2 extent = hi - lo;
+        float scale_x = (extent.x > 0.f) ? (MORTON_MAX / extent.x) : 0.f;
+        float scale_y = (extent.y > 0.f) ? (MORTON_MAX / extent.y) : 0.f;
+        for (size_t i = 0; i < m_boxes.size(); i++)
+        {
+            math::vec2 c = m_boxes[i].centroid() - lo;
+            auto x = static_cast<uint32>(std::min(c.x * scale_x, MORTON_MAX));
+            auto y = static_cast<uint32>(std::min(c.y * scale_y, MORTON_MAX));
+            uint32 code = spread_bits(x) | (spread_bits(y) << 1);
+            m_order.push_back((static_cast<uint64>(code) << 32) | i);
+        }
+
+        std::sort(m_order.begin(), m_order.end());
+    }
+
+    if (m_scratch.size() < worker_count)
+    {
+        m_scratch.resize(worker_count);
+    }
+
+    for (auto& scratch : m_scratch)
+    {
+        scratch.hits.clear();
+    }
+}
+
+void
+QueryBatch::Finish (void)
+{
+    // counting sort back into query order.  Each query is traversed by a
+    // single worker, so the hits of a query retain their traversal order.
+    m_offsets.assign(m_boxes.size() + 1, 0);
+    for (const auto& scratch : m_scratch)
+    {
+        for (const auto& hit : scratch.hits)
+        {
+            m_offsets[hit.query + 1]++;
+        }
+    }
+
+    for (size_t i = 1; i < m_offsets.size(); i++)
+    {
+        m_offsets[i] += m_offsets[i - 1];
+    }
+
+    m_handles.resize(m_offsets.back());
+    for (const auto& scratch : m_scratch)
+    {
+        for (const auto& hit : scratch.hits)
+        {
+            // the offset is used as the write cursor, and is restored below
+            m_handles[m_offsets[hit.query]++] = hit.handle;
+        }
+    }
+
+    for (size_t i = m_offsets.size() - 1; i > 0; i--)
+    {
+        m_offsets[i] = m_offsets[i - 1];
+    }
+
+    m_offsets[0] = 0;
+}
+
+} // namespace physics
+} // namespace rdge
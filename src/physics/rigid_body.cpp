@@ -1,6 +1,7 @@
 #include <rdge/physics/rigid_body.hpp>
 #include <rdge/physics/collision_graph.hpp>
 #include <rdge/physics/aabb.hpp>
+#include <rdge/physics/shapes/edge.hpp>
 #include <rdge/util/memory/small_block_allocator.hpp>
 #include <rdge/util/logger.hpp>
 
@@ -14,11 +15,14 @@ RigidBody::RigidBody (const rigid_body_profile& prof, CollisionGraph* parent)
     , user_data(prof.user_data)
     , world_transform(prof.position, prof.angle)
     , gravity_scale(prof.gravity_scale)
+    , m_states(&parent->m_bodyStates)
+    , m_state(parent->ReserveBodyState())
     , m_type(prof.type)
 {
-    linear.velocity = prof.linear_velocity;
+    auto& state = State();
+    state.linear_velocity = prof.linear_velocity;
+    state.angular_velocity = prof.angular_velocity;
     linear.damping = prof.linear_damping;
-    angular.velocity = prof.angular_velocity;
     angular.damping = prof.angular_damping;
 
     if (prof.simulate)
@@ -41,10 +45,17 @@ RigidBody::RigidBody (const rigid_body_profile& prof, CollisionGraph* parent)
         m_flags |= PREVENT_SLEEP;
     }
 
-    sweep.pos_0 = world_transform.pos;
-    sweep.pos_n = world_transform.pos;
-    sweep.angle_0 = prof.angle;
-    sweep.angle_n = prof.angle;
+    if (prof.bullet)
+    {
+        m_flags |= BULLET;
+    }
+
+    state.sweep.pos_0 = world_transform.pos;
+    state.sweep.pos_n = world_transform.pos;
+    state.sweep.angle_0 = prof.angle;
+    state.sweep.angle_n = prof.angle;
+    m_previousCenter = state.sweep.pos_n;
+    m_previousAngle = state.sweep.angle_n;
 
     if (m_type == RigidBodyType::DYNAMIC)
     {
@@ -101,6 +112,49 @@ RigidBody::CreateFixture (ishape* shape, float density)
     return CreateFixture(p);
 }
 
+size_t
+RigidBody::CreateChain (const vec2* vertices, size_t count, bool loop, const fixture_profile& profile)
+{
+    SDL_assert(vertices != nullptr);
+    SDL_assert(count >= (loop ? 3u : 2u));
+
+    if (graph->IsLocked())
+    {
+        SDL_assert(false);
+        return 0;
+    }
+
+    auto vertex = [&](int64 i) {
+        int64 n = static_cast<int64>(count);
+        if (loop)
+        {
+            return vertices[static_cast<size_t>((i + n) % n)];
+        }
+        else if (i < 0)
+        {
+            return vertices[0] + (vertices[0] - vertices[1]);
+        }
+        else if (i >= n)
+        {
+            return vertices[count - 1] + (vertices[count - 1] - vertices[count - 2]);
+        }
+
+        return vertices[static_cast<size_t>(i)];
+    };
+
+    fixture_profile fprof = profile;
+    size_t segment_count = (loop) ? count : (count - 1);
+    for (size_t i = 0; i < segment_count; i++)
+    {
+        auto n = static_cast<int64>(i);
+        edge segment(vertex(n - 1), vertex(n), vertex(n + 1), vertex(n + 2));
+        fprof.shape = &segment;
+        CreateFixture(fprof);
+    }
+
+    return segment_count;
+}
+
 void
 RigidBody::DestroyFixture (Fixture* fixture)
 {
@@ -122,7 +176,7 @@ RigidBody::DestroyFixture (Fixture* fixture)
 
     contact_edges.for_each([=](auto* edge) {
         Contact* c = edge->contact;
-        if (fixture == c->fixture_a || fixture == c->fixture_b)
+        if (fixture == c->GetFixtureA() || fixture == c->GetFixtureB())
         {
             graph->DestroyContact(c);
         }
@@ -169,6 +223,45 @@ RigidBody::Disable (void)
     }
 }
 
+void
+RigidBody::WakeUp (void) noexcept
+{
+    if (!IsAwake())
+    {
+        m_flags |= AWAKE;
+        m_sleepTime = 0.f;
+
+        // static bodies are never awake, so only keep the flag
+        if (m_type != RigidBodyType::STATIC)
+        {
+            graph->AddAwakeBody(this);
+        }
+    }
+}
+
+void
+RigidBody::Sleep (void) noexcept
+{
+    if (IsAwake())
+    {
+        m_flags &= ~AWAKE;
+        m_sleepTime = 0.f;
+
+        auto& state = State();
+        linear.force = { 0.f, 0.f };
+        angular.torque = 0.f;
+        state.linear_velocity = { 0.f, 0.f };
+        state.angular_velocity = 0.f;
+
+        // the body won't be visited again until woken, so it must not be
+        // interpolated from an older state
+        m_previousCenter = state.sweep.pos_n;
+        m_previousAngle = state.sweep.angle_n;
+
+        graph->RemoveAwakeBody(this);
+    }
+}
+
 bool
 RigidBody::HasEdge (const Fixture* a, const Fixture* b) noexcept
 {
@@ -185,8 +278,8 @@ RigidBody::HasEdge (const Fixture* a, const Fixture* b) noexcept
         if (edge->other == b->body)
         {
             Contact* c = edge->contact;
-            if ((c->fixture_a == a && c->fixture_b == b) ||
-                (c->fixture_a == b && c->fixture_b == a))
+            if ((c->GetFixtureA() == a && c->GetFixtureB() == b) ||
+                (c->GetFixtureA() == b && c->GetFixtureB() == a))
             {
                 result = true;
                 return;
@@ -200,19 +293,35 @@ RigidBody::HasEdge (const Fixture* a, const Fixture* b) noexcept
 void
 RigidBody::SetPosition (math::vec2 pos)
 {
+    auto& sweep = State().sweep;
     world_transform.pos = pos;
     sweep.pos_n = world_transform.to_world(sweep.local_center);
     sweep.pos_0 = sweep.pos_n;
+    m_previousCenter = sweep.pos_n;
 
     SyncFixtures();
 }
 
+iso_transform
+RigidBody::GetInterpolatedTransform (float alpha) const noexcept
+{
+    SDL_assert(0.f <= alpha && alpha <= 1.f);
+
+    const auto& sweep = State().sweep;
+    iso_transform result(m_previousCenter + ((sweep.pos_n - m_previousCenter) * alpha),
+                         m_previousAngle + ((sweep.angle_n - m_previousAngle) * alpha));
+
+    result.pos -= result.rot.rotate(sweep.local_center);
+    return result;
+}
+
 void
 RigidBody::SyncFixtures (void)
 {
     // world transform has been updated.  the fixtures need to reset their
     // world shape and proxies (set to the swept shape over the time step)
 
+    const auto& sweep = State().sweep;
     iso_transform sweep_start;
     sweep_start.set_angle(sweep.angle_0);
     sweep_start.pos = sweep.pos_0 - sweep_start.rot.rotate(sweep.local_center);
@@ -232,6 +341,8 @@ RigidBody::SyncFixtures (void)
 void
 RigidBody::ComputeMass (void)
 {
+    auto& state = State();
+    auto& sweep = state.sweep;
     linear.mass = 0.f;
     linear.inv_mass = 0.f;
     angular.mmoi = 0.f;
@@ -243,6 +354,7 @@ RigidBody::ComputeMass (void)
         sweep.pos_0 = world_transform.pos;
         sweep.pos_n = world_transform.pos;
         sweep.angle_0 = sweep.angle_n;
+        m_previousCenter = sweep.pos_n;
         return;
     }
 
@@ -285,9 +397,10 @@ RigidBody::ComputeMass (void)
     sweep.local_center = local_center;
     sweep.pos_n = world_transform.to_world(sweep.local_center);
     sweep.pos_0 = sweep.pos_n;
+    m_previousCenter = sweep.pos_n;
 
     // Update velocity to the new center of mass
-    linear.velocity += (sweep.pos_n - old_center).perp() * angular.velocity;
+    state.linear_velocity += (sweep.pos_n - old_center).perp() * state.angular_velocity;
 }
 
 std::ostream& operator<< (std::ostream& os, RigidBodyType value)
@@ -317,24 +430,25 @@ std::ostream& operator<< (std::ostream& os, const RigidBody& b)
        << "\n    awake=" << std::boolalpha << b.IsAwake()
        << "\n    sleep_prevented=" << std::boolalpha << b.IsSleepPrevented()
        << "\n    fixed_rotation=" << std::boolalpha << b.IsFixedRotation()
+       << "\n    bullet=" << std::boolalpha << b.IsBullet()
        << "\n  collections:"
        << "\n    fixtures=" << b.fixtures.size()
        << "\n    contacts=" << b.contact_edges.size()
        << "\n    joints=" << b.joint_edges.size()
        << "\n  sweep:"
-       << "\n    local_center=" << b.sweep.local_center
-       << "\n    pos_0=" << b.sweep.pos_0
-       << "\n    pos_n=" << b.sweep.pos_n
-       << "\n    angle_0=" << b.sweep.angle_0
-       << "\n    angle_n=" << b.sweep.angle_n
+       << "\n    local_center=" << b.State().sweep.local_center
+       << "\n    pos_0=" << b.State().sweep.pos_0
+       << "\n    pos_n=" << b.State().sweep.pos_n
+       << "\n    angle_0=" << b.State().sweep.angle_0
+       << "\n    angle_n=" << b.State().sweep.angle_n
        << "\n  linear_motion:"
-       << "\n    velocity=" << b.linear.velocity
+       << "\n    velocity=" << b.GetLinearVelocity()
        << "\n    force=" << b.linear.force
        << "\n    damping=" << b.linear.damping
        << "\n    mass=" << b.linear.mass
        << "\n    inv_mass=" << b.linear.inv_mass
        << "\n  angular_motion:"
-       << "\n    velocity=" << b.angular.velocity
+       << "\n    velocity=" << b.GetAngularVelocity()
        << "\n    torque=" << b.angular.torque
        << "\n    damping=" << b.angular.damping
        << "\n    mmoi=" << b.angular.mmoi
@@ -1,6 +1,9 @@
 #include <rdge/physics/shapes/circle.hpp>
 #include <rdge/physics/shapes/polygon.hpp>
 
+#include <cmath>
+#include <limits>
+
 namespace rdge {
 namespace physics {
 
@@ -26,11 +29,43 @@ circle::intersects_with (const ishape* other, collision_manifold& mf) const
         return intersects_with(*static_cast<const circle*>(other), mf);
     }
 
-    // Polygon should be primary
+    // Polygon or edge should be primary
     SDL_assert(false);
     return false;
 }
 
+bool
+circle::ray_cast (const ray_cast_input& input, ray_cast_output& output) const
+{
+    // Solves |p1 + t * d - pos| = radius for the smallest t.  Based on
+    // Box2D b2CircleShape::RayCast()
+
+    vec2 s = input.p1 - pos;
+    float b = s.self_dot() - square(radius);
+
+    vec2 d = input.p2 - input.p1;
+    float c = dot(s, d);
+    float rr = d.self_dot();
+    float sigma = (c * c) - (rr * b);
+
+    // negative discriminant or zero length segment
+    if (sigma < 0.f || rr < std::numeric_limits<float>::epsilon())
+    {
+        return false;
+    }
+
+    float a = -(c + std::sqrt(sigma));
+    if (0.f <= a && a <= input.max_fraction * rr)
+    {
+        a /= rr;
+        output.fraction = a;
+        output.normal = (s + (d * a)).normalize();
+        return true;
+    }
+
+    return false;
+}
+
 bool
 circle::intersects_with (const circle& other, collision_manifold& mf) const noexcept
 {
@@ -46,6 +81,7 @@ circle::intersects_with (const circle& other, collision_manifold& mf) const noex
         mf.contacts[0] = (pos + other.pos) * 0.5f;
         mf.normal = (l != 0.f) ? d * (1.f / l) : vec2(0.f, 1.f);
         mf.plane = pos;
+        mf.features[0] = contact_feature();
 
         return true;
     }
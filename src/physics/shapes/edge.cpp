@@ -0,0 +1,137 @@
+#include <rdge/physics/shapes/edge.hpp>
+#include <rdge/physics/shapes/circle.hpp>
+#include <rdge/physics/shapes/polygon.hpp>
+
+#include <SDL_assert.h>
+
+#include <algorithm>
+
+namespace rdge {
+namespace physics {
+
+using namespace rdge::math;
+
+edge::edge (const vec2& p1, const vec2& p2)
+    : v0(p1)
+    , v1(p1)
+    , v2(p2)
+    , v3(p2)
+    , normal((p2 - p1).normalize().perp_ccw())
+    , one_sided(false)
+{
+    SDL_assert(p1 != p2);
+}
+
+edge::edge (const vec2& p0, const vec2& p1, const vec2& p2, const vec2& p3)
+    : v0(p0)
+    , v1(p1)
+    , v2(p2)
+    , v3(p3)
+    , normal((p2 - p1).normalize().perp_ccw())
+    , one_sided(true)
+{
+    SDL_assert(p1 != p2);
+}
+
+bool
+edge::intersects_with (const ishape* other) const
+{
+    collision_manifold mf;
+    return intersects_with(other, mf);
+}
+
+bool
+edge::intersects_with (const ishape* other, collision_manifold& mf) const
+{
+    mf.count = 0;
+    if (other->type() == ShapeType::POLYGON)
+    {
+        return intersects(*this, *static_cast<const polygon*>(other), mf);
+    }
+    else if (other->type() == ShapeType::CIRCLE)
+    {
+        return intersects(*this, *static_cast<const circle*>(other), mf);
+    }
+
+    // edges have no area to collide with
+    return false;
+}
+
+bool
+edge::ray_cast (const ray_cast_input& input, ray_cast_output& output) const
+{
+    // Intersects the ray with the line, and then tests the hit is within the
+    // segment.  Based on Box2D b2EdgeShape::RayCast()
+
+    vec2 d = input.p2 - input.p1;
+
+    // p = p1 + t * d
+    // dot(normal, p - v1) = 0
+    // dot(normal, p1 - v1) + t * dot(normal, d) = 0
+    float numerator = dot(normal, v1 - input.p1);
+    if (one_sided && numerator > 0.f)
+    {
+        // origin is behind the edge
+        return false;
+    }
+
+    float denominator = dot(normal, d);
+    if (denominator == 0.f)
+    {
+        return false;
+    }
+
+    float t = numerator / denominator;
+    if (t < 0.f || input.max_fraction < t)
+    {
+        return false;
+    }
+
+    vec2 e = v2 - v1;
+    float s = dot((input.p1 + d * t) - v1, e);
+    if (s < 0.f || e.self_dot() < s)
+    {
+        return false;
+    }
+
+    output.fraction = t;
+    output.normal = (numerator > 0.f) ? -normal : normal;
+    return true;
+}
+
+aabb
+edge::compute_aabb (void) const
+{
+    vec2 lo(std::min(v1.x, v2.x), std::min(v1.y, v2.y));
+    vec2 hi(std::max(v1.x, v2.x), std::max(v1.y, v2.y));
+    return aabb(lo - AABB_PADDING, hi + AABB_PADDING);
+}
+
+aabb
+edge::compute_aabb (const iso_transform& xf) const
+{
+    vec2 a = xf.to_world(v1);
+    vec2 b = xf.to_world(v2);
+    vec2 lo(std::min(a.x, b.x), std::min(a.y, b.y));
+    vec2 hi(std::max(a.x, b.x), std::max(a.y, b.y));
+    return aabb(lo - AABB_PADDING, hi + AABB_PADDING);
+}
+
+std::ostream& operator<< (std::ostream& os, const edge& e)
+{
+    os << "edge: ["
+       << "\n  v1=" << e.v1
+       << "\n  v2=" << e.v2
+       << "\n  normal=" << e.normal;
+
+    if (e.one_sided)
+    {
+        os << "\n  v0=" << e.v0
+           << "\n  v3=" << e.v3;
+    }
+
+    return os << "\n]\n";
+}
+
+} // namespace physics
+} // namespace rdge
@@ -1,6 +1,7 @@
 #include <rdge/physics/shapes/ishape.hpp>
 #include <rdge/physics/shapes/circle.hpp>
 #include <rdge/physics/shapes/polygon.hpp>
+#include <rdge/physics/shapes/edge.hpp>
 #include <rdge/util/strings.hpp>
 
 #include <cstring> // strrchr
@@ -35,6 +36,7 @@ to_string (physics::ShapeType value)
         CASE(physics::ShapeType::INVALID)
         CASE(physics::ShapeType::CIRCLE)
         CASE(physics::ShapeType::POLYGON)
+        CASE(physics::ShapeType::EDGE)
         default: break;
 #undef CASE
     }
@@ -50,6 +52,7 @@ try_parse (const std::string& test, physics::ShapeType& out)
     std::string s = rdge::to_lower(test);
     if      (s == "circle")  { out = physics::ShapeType::CIRCLE;  return true; }
     else if (s == "polygon") { out = physics::ShapeType::POLYGON; return true; }
+    else if (s == "edge")    { out = physics::ShapeType::EDGE;    return true; }
 
     return false;
 }
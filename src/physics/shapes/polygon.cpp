@@ -4,6 +4,8 @@
 
 #include <SDL_assert.h>
 
+#include <utility> // swap
+
 namespace rdge {
 namespace physics {
 
@@ -300,8 +302,71 @@ polygon::intersects_with (const ishape* other, collision_manifold& mf) const
     {
         return intersects_with(*static_cast<const polygon*>(other), mf);
     }
+    else if (other->type() == ShapeType::CIRCLE)
+    {
+        return intersects(*this, *static_cast<const circle*>(other), mf);
+    }
+
+    // Edge should be primary
+    SDL_assert(false);
+    return false;
+}
+
+bool
+polygon::ray_cast (const ray_cast_input& input, ray_cast_output& output) const
+{
+    // Clips the segment against each edge half-plane.  Based on
+    // Box2D b2PolygonShape::RayCast()
+
+    SDL_assert(count >= 3);
+
+    vec2 d = input.p2 - input.p1;
+    float lower = 0.f;
+    float upper = input.max_fraction;
+    int32 index = -1;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        // p = p1 + t * d
+        // dot(normal, p - v) = 0
+        // dot(normal, p1 - v) + t * dot(normal, d) = 0
+        float numerator = dot(normals[i], vertices[i] - input.p1);
+        float denominator = dot(normals[i], d);
+
+        if (denominator == 0.f)
+        {
+            // parallel to the edge and outside
+            if (numerator < 0.f)
+            {
+                return false;
+            }
+        }
+        else if (denominator < 0.f && numerator < lower * denominator)
+        {
+            // segment enters this half-plane
+            lower = numerator / denominator;
+            index = static_cast<int32>(i);
+        }
+        else if (denominator > 0.f && numerator < upper * denominator)
+        {
+            // segment exits this half-plane
+            upper = numerator / denominator;
+        }
+
+        if (upper < lower)
+        {
+            return false;
+        }
+    }
 
-    return intersects(*this, *static_cast<const circle*>(other), mf);
+    if (index >= 0)
+    {
+        output.fraction = lower;
+        output.normal = normals[static_cast<size_t>(index)];
+        return true;
+    }
+
+    return false;
 }
 
 bool
@@ -363,62 +428,40 @@ polygon::intersects_with (const polygon& other, collision_manifold& mf) const no
     }
 
     // build the clip vertices for the incident edge
-    math::vec2 inc_vertices[2];
-    inc_vertices[0] = inc_shape->vertices[inc_edge];
+    clip_vertex inc_vertices[2];
     size_t next_v = ((inc_edge + 1) < inc_shape->count) ? (inc_edge + 1) : 0;
-    inc_vertices[1] = inc_shape->vertices[next_v];
+    inc_vertices[0].point = inc_shape->vertices[inc_edge];
+    inc_vertices[0].feature = make_feature(ref_edge, contact_feature::FACE,
+                                           inc_edge, contact_feature::VERTEX);
+    inc_vertices[1].point = inc_shape->vertices[next_v];
+    inc_vertices[1].feature = make_feature(ref_edge, contact_feature::FACE,
+                                           next_v, contact_feature::VERTEX);
 
     // create two orthogonal planes from the reference edge attached to the end points
     math::vec2 ref_vertices[2];
+    size_t ref_next = ((ref_edge + 1) < ref_shape->count) ? ref_edge + 1 : 0;
     ref_vertices[0] = ref_shape->vertices[ref_edge];
-    next_v = ((ref_edge + 1) < ref_shape->count) ? ref_edge + 1 : 0;
-    ref_vertices[1] = ref_shape->vertices[next_v];
+    ref_vertices[1] = ref_shape->vertices[ref_next];
 
     auto tangent = (ref_vertices[1] - ref_vertices[0]).normalize();
     half_plane left = { -tangent, math::dot(-tangent, ref_vertices[0]) };
     half_plane right = { tangent, math::dot(tangent, ref_vertices[1]) };
 
     // clip incident vertices to reference planes
+    clip_vertex left_clipped[2];
+    if (clip_segment(left_clipped, inc_vertices, left,
+                     make_feature(ref_edge, contact_feature::VERTEX,
+                                  inc_edge, contact_feature::FACE)) < 2)
     {
-        int32 num_out = 0;
-        float d0 = distance(left, inc_vertices[0]);
-        float d1 = distance(left, inc_vertices[1]);
-
-        // points are behind the plane
-        if (d0 <= 0.f) { num_out++; }
-        if (d1 <= 0.f) { num_out++; }
-
-        // points are on different sides of the plane
-        if ((d0 * d1) < 0.f)
-        {
-            inc_vertices[num_out++] = inc_vertices[0] +
-                                      (d0 / (d0 - d1)) * (inc_vertices[1] - inc_vertices[0]);
-        }
-
-        if (num_out < 2)
-        {
-            return false;
-        }
+        return false;
     }
 
+    clip_vertex clipped[2];
+    if (clip_segment(clipped, left_clipped, right,
+                     make_feature(ref_next, contact_feature::VERTEX,
+                                  inc_edge, contact_feature::FACE)) < 2)
     {
-        int32 num_out = 0;
-        float d0 = distance(right, inc_vertices[0]);
-        float d1 = distance(right, inc_vertices[1]);
-
-        if (d0 <= 0.f) { num_out++; }
-        if (d1 <= 0.f) { num_out++; }
-
-        if ((d0 * d1) < 0.f)
-        {
-            inc_vertices[num_out++] = inc_vertices[0] +
-                                      (d0 / (d0 - d1)) * (inc_vertices[1] - inc_vertices[0]);
-        }
-
-        if (num_out < 2)
-        {
-            return false;
-        }
+        return false;
     }
 
     half_plane penetration_plane = {
@@ -429,12 +472,21 @@ polygon::intersects_with (const polygon& other, collision_manifold& mf) const no
     int32 num_points = 0;
     for (int32 i = 0; i < 2; i++)
     {
-        auto p = inc_vertices[i];
+        const auto& p = clipped[i].point;
         float d = distance(penetration_plane, p);
         if (d < 0.f)
         {
+            // features are stored relative to this and other
+            auto feature = clipped[i].feature;
+            if (mf.flip)
+            {
+                std::swap(feature.index_a, feature.index_b);
+                std::swap(feature.type_a, feature.type_b);
+            }
+
             mf.contacts[num_points] = p;
             mf.depths[num_points] = -d;
+            mf.features[num_points] = feature;
             num_points++;
         }
     }
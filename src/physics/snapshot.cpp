@@ -0,0 +1,14 @@
+#include <rdge/physics/snapshot.hpp>
+#include <rdge/util/exception.hpp>
+
+namespace rdge {
+namespace physics {
+
+void
+snapshot_reader::throw_out_of_range (void)
+{
+    RDGE_THROW("Snapshot read out of range");
+}
+
+} // namespace physics
+} // namespace rdge
@@ -4,8 +4,7 @@
 #include <rdge/physics/collision.hpp>
 #include <rdge/physics/collision_graph.hpp>
 #include <rdge/physics/joints/base_joint.hpp>
-
-#include <limits>
+#include <rdge/math/simd.hpp>
 
 //! \namespace rdge Rainbow Drop Game Engine
 namespace rdge {
@@ -16,11 +15,45 @@ namespace {
 // squared to avoid sqrt
 constexpr float MAX_TRANSLATION_SQAURED = math::square(Solver::MAX_TRANSLATION);
 constexpr float MAX_ROTATION_SQUARED = math::square(Solver::MAX_ROTATION);
-constexpr float LINEAR_SLEEP_TOLERANCE_SQUARED = math::square(Solver::LINEAR_SLEEP_TOLERANCE);
-constexpr float ANGULAR_SLEEP_TOLERANCE_SQUARED = math::square(Solver::ANGULAR_SLEEP_TOLERANCE);
+
+// Number of colors available to the wide contact solver (bits in the body mask)
+constexpr uint32 MAX_CONTACT_COLORS = 32;
+
+// Islands with fewer contacts are always solved individually
+constexpr size_t MIN_WIDE_CONTACTS = 16;
+
+// Largest condition number of a two point contact solved as a block
+constexpr float MAX_BLOCK_CONDITION = 1000.f;
+
+// Bodies which cannot be moved by the solver may be shared between lanes
+bool
+is_shareable (const solver_body_data& data)
+{
+    return (data.inv_mass == 0.f) && (data.inv_mmoi == 0.f);
+}
 
 } // anonymous namespace
 
+constexpr float Solver::CONTACT_HERTZ;
+
+softness::softness (float hertz, float damping_ratio, float h) noexcept
+{
+    if (hertz == 0.f)
+    {
+        return;
+    }
+
+    // Box2D soft step.  Implicit integration of a damped spring, where the
+    // coefficients are applied to a rigid constraint.
+    float omega = 2.f * math::PI * hertz;
+    float a1 = (2.f * damping_ratio) + (h * omega);
+    float a2 = h * omega * a1;
+    float a3 = 1.f / (1.f + a2);
+    bias_rate = omega / a1;
+    mass_scale = a2 * a3;
+    impulse_scale = a3;
+}
+
 Solver::Solver (const time_step* step)
     : m_step(step)
 { }
@@ -31,32 +64,33 @@ Solver::Initialize (size_t body_count, size_t contact_count, size_t joint_count)
     m_bodies.reserve(body_count);
     m_contacts.reserve(contact_count);
     m_joints.reserve(joint_count);
+
+    if (wide_contacts)
+    {
+        m_wideContacts.reserve(contact_count / 4);
+        m_remainingContacts.reserve(contact_count);
+        m_contactColors.reserve(contact_count);
+        m_bodyColors.reserve(body_count);
+    }
 }
 
 void
 Solver::Add (RigidBody* b)
 {
-    // Store positions for continuous collision
-    b->sweep.angle_0 = b->sweep.angle_n;
-    b->sweep.pos_0 = b->sweep.pos_n;
-
-    // Awake flag is set b/c for a body to be added to the island it
-    // was already awake or now in contact with an awake body
-    b->m_flags |= RigidBody::AWAKE;
-    b->solver_index = m_bodies.size();
-
+    const auto& state = b->State();
     auto& data = m_bodies.next();
     data.body = b;
-    data.world_center = b->sweep.pos_n;
-    data.rotation = b->sweep.angle_n;
+    data.world_center = state.sweep.pos_n;
+    data.rotation = state.sweep.angle_n;
     data.pos = { 0.f, 0.f };
     data.angle = 0.f;
-    data.linear_vel = b->linear.velocity;
-    data.angular_vel = b->angular.velocity;
+    data.linear_vel = state.linear_velocity;
+    data.angular_vel = state.angular_velocity;
     data.inv_mass = b->linear.inv_mass;
     data.inv_mmoi = b->angular.inv_mmoi;
 
-    if (b->GetType() == RigidBodyType::DYNAMIC)
+    // soft step integrates velocities every substep
+    if (!soft_step && b->GetType() == RigidBodyType::DYNAMIC)
     {
         // Perform initial velocity integration and apply damping
         auto linear_acc = (b->gravity_scale * gravity) +
@@ -81,17 +115,25 @@ Solver::Add (RigidBody* b)
 }
 
 void
-Solver::Add (Contact* c)
+Solver::Add (Contact* c, size_t index_a, size_t index_b)
 {
+    SDL_assert(index_a < m_bodies.size() && index_b < m_bodies.size());
+
     auto& data = m_contacts.next_clean();
     data.contact = c;
+    data.body_index[0] = index_a;
+    data.body_index[1] = index_b;
 }
 
 void
-Solver::Add (BaseJoint* j)
+Solver::Add (BaseJoint* j, size_t index_a, size_t index_b)
 {
+    SDL_assert(index_a < m_bodies.size() && index_b < m_bodies.size());
+
     auto& data = m_joints.next();
-    data = j;
+    data.joint = j;
+    data.body_index[0] = index_a;
+    data.body_index[1] = index_b;
 }
 
 void
@@ -105,35 +147,119 @@ Solver::Clear (void)
 void
 Solver::Solve (void)
 {
-    for (auto& data : m_contacts)
+    if (soft_step)
     {
-        // populate relevant body data
-        const auto body_a = data.contact->fixture_a->body;
-        const auto body_b = data.contact->fixture_b->body;
+        SolveSoft();
+        return;
+    }
+
+    PrepareContacts();
+
+    if (warm_starting)
+    {
+        WarmStart();
+    }
+
+    bool wide = wide_contacts && (m_contacts.size() >= MIN_WIDE_CONTACTS);
+    if (wide)
+    {
+        PrepareWideContacts();
+    }
+
+    for (auto& j : m_joints)
+    {
+        auto& bdata_a = m_bodies[j.body_index[0]];
+        auto& bdata_b = m_bodies[j.body_index[1]];
+        j.joint->InitializeSolver(*m_step, bdata_a, bdata_b);
+    }
 
-        data.body_index[0] = body_a->solver_index;
-        data.body_index[1] = body_b->solver_index;
+    for (size_t iter = 0; iter < velocity_iterations; iter++)
+    {
+        for (auto& j : m_joints)
+        {
+            auto& bdata_a = m_bodies[j.body_index[0]];
+            auto& bdata_b = m_bodies[j.body_index[1]];
+            j.joint->SolveVelocityConstraints(*m_step, bdata_a, bdata_b);
+        }
+
+        if (wide)
+        {
+            SolveWideVelocityConstraints();
+        }
+        else
+        {
+            SolveVelocityConstraints();
+        }
+    }
 
+    if (wide)
+    {
+        StoreWideImpulses();
+    }
+
+    IntegratePositions(m_step->dt);
+
+    m_positionsSolved = false;
+    m_velocityIterations = velocity_iterations;
+    m_positionIterations = 0;
+    for (size_t iter = 0; iter < position_iterations; iter++)
+    {
+        m_positionsSolved = CorrectPositions();
+        m_positionIterations++;
+
+        bool joints_solved = true;
+        for (auto& j : m_joints)
+        {
+            auto& bdata_a = m_bodies[j.body_index[0]];
+            auto& bdata_b = m_bodies[j.body_index[1]];
+            joints_solved = joints_solved && j.joint->SolvePositionConstraints(bdata_a, bdata_b);
+        }
+
+        if (m_positionsSolved && joints_solved)
+        {
+            break;
+        }
+    }
+
+    StoreBodies();
+}
+
+void
+Solver::PrepareContacts (void)
+{
+    for (auto& data : m_contacts)
+    {
+        // populate relevant body data
         auto& bdata_a = m_bodies[static_cast<uint32>(data.body_index[0])];
         auto& bdata_b = m_bodies[static_cast<uint32>(data.body_index[1])];
         data.combined_inv_mass = bdata_a.inv_mass + bdata_b.inv_mass;
 
         // build the velocity constraint points
-        const auto& mf = data.contact->manifold;
-        math::vec2 tangent = mf.normal.perp_ccw();
+        const auto& mf = data.contact->GetManifold();
+        const auto& impulse_cache = data.contact->impulse;
+        math::vec2 normal = mf.oriented_normal();
+        math::vec2 tangent = normal.perp_ccw();
         float restitution = data.contact->restitution;
 
         for (size_t i = 0; i < mf.count; i++)
         {
             auto& vcp = data.points[i];
 
+            // impulses from the previous step, scaled to support variable time steps
+            if (warm_starting && i < impulse_cache.count)
+            {
+                vcp.normal_impulse = m_step->ratio * impulse_cache.normals[i];
+                vcp.tangent_impulse = m_step->ratio * impulse_cache.tangents[i];
+            }
+
             // bodies position relative to the contact points
             vcp.rel_point[0] = mf.contacts[i] - bdata_a.world_center;
             vcp.rel_point[1] = mf.contacts[i] - bdata_b.world_center;
+            vcp.separation = math::dot(mf.contacts[i] - mf.plane, mf.normal);
 
             // two body effective mass relative to the normal
-            float radius_normal_a = math::perp_dot(vcp.rel_point[0], mf.normal);
-            float radius_normal_b = math::perp_dot(vcp.rel_point[1], mf.normal);
+            float radius_normal_a = math::perp_dot(vcp.rel_point[0], normal);
+            float radius_normal_b = math::perp_dot(vcp.rel_point[1], normal);
             float enm = data.combined_inv_mass +
                         (bdata_a.inv_mmoi * math::square(radius_normal_a)) +
                         (bdata_b.inv_mmoi * math::square(radius_normal_b));
@@ -152,7 +278,7 @@ Solver::Solve (void)
                                (vcp.rel_point[0].perp() * bdata_a.angular_vel);
             math::vec2 vel_b = bdata_b.linear_vel +
                                (vcp.rel_point[1].perp() * bdata_b.angular_vel);
-            float rnv = math::dot(mf.normal, vel_b - vel_a);
+            float rnv = math::dot(normal, vel_b - vel_a);
 
             vcp.velocity_bias = 0.f;
             if (rnv < -VELOCITY_THRESHOLD)
@@ -160,29 +286,51 @@ Solver::Solve (void)
                 vcp.velocity_bias = rnv * -restitution;
             }
         }
-    }
 
-    for (auto& j : m_joints)
-    {
-        auto& bdata_a = m_bodies[static_cast<uint32>(j->body_a->solver_index)];
-        auto& bdata_b = m_bodies[static_cast<uint32>(j->body_b->solver_index)];
-        j->InitializeSolver(*m_step, bdata_a, bdata_b);
-    }
-
-    for (size_t iter = 0; iter < velocity_iterations; iter++)
-    {
-        for (auto& j : m_joints)
+        // two point effective mass matrix, where the off diagonal couples the
+        // points through the body rotations
+        data.block_solve = false;
+        if (block_contacts && !soft_step && mf.count == 2)
         {
-            auto& bdata_a = m_bodies[static_cast<uint32>(j->body_a->solver_index)];
-            auto& bdata_b = m_bodies[static_cast<uint32>(j->body_b->solver_index)];
-            j->SolveVelocityConstraints(*m_step, bdata_a, bdata_b);
-        }
+            const auto& vcp1 = data.points[0];
+            const auto& vcp2 = data.points[1];
+            float rn1a = math::perp_dot(vcp1.rel_point[0], normal);
+            float rn1b = math::perp_dot(vcp1.rel_point[1], normal);
+            float rn2a = math::perp_dot(vcp2.rel_point[0], normal);
+            float rn2b = math::perp_dot(vcp2.rel_point[1], normal);
+
+            float k11 = data.combined_inv_mass +
+                        (bdata_a.inv_mmoi * rn1a * rn1a) +
+                        (bdata_b.inv_mmoi * rn1b * rn1b);
+            float k22 = data.combined_inv_mass +
+                        (bdata_a.inv_mmoi * rn2a * rn2a) +
+                        (bdata_b.inv_mmoi * rn2b * rn2b);
+            float k12 = data.combined_inv_mass +
+                        (bdata_a.inv_mmoi * rn1a * rn2a) +
+                        (bdata_b.inv_mmoi * rn1b * rn2b);
+
+            float det = (k11 * k22) - (k12 * k12);
+            if ((k11 * k11) < (MAX_BLOCK_CONDITION * det))
+            {
+                data.block_k[0] = { k11, k12 };
+                data.block_k[1] = { k12, k22 };
 
-        SolveVelocityConstraints();
+                float inv_det = 1.f / det;
+                data.block_mass[0] = { k22 * inv_det, -k12 * inv_det };
+                data.block_mass[1] = { -k12 * inv_det, k11 * inv_det };
+                data.block_solve = true;
+            }
+        }
     }
+}
 
+void
+Solver::IntegratePositions (float h)
+{
     for (auto& data : m_bodies)
     {
+        // limits are relative to the full step, so they are independent of
+        // the number of substeps
         auto t = data.linear_vel * m_step->dt;
         if (t.self_dot() > MAX_TRANSLATION_SQAURED)
         {
@@ -195,110 +343,409 @@ Solver::Solve (void)
             data.angular_vel *= MAX_ROTATION / math::abs(r);
         }
 
-        data.pos += data.linear_vel * m_step->dt;
-        data.angle += data.angular_vel * m_step->dt;
+        data.pos += data.linear_vel * h;
+        data.angle += data.angular_vel * h;
     }
+}
 
-    m_positionsSolved = false;
-    for (size_t iter = 0; iter < position_iterations; iter++)
+void
+Solver::StoreBodies (void)
+{
+    for (auto& data : m_bodies)
     {
-        m_positionsSolved = CorrectPositions();
-
-        bool joints_solved = true;
-        for (auto& j : m_joints)
+        // static bodies may be shared with islands being solved concurrently
+        auto body = data.body;
+        if (body->m_type == RigidBodyType::STATIC)
         {
-            auto& bdata_a = m_bodies[static_cast<uint32>(j->body_a->solver_index)];
-            auto& bdata_b = m_bodies[static_cast<uint32>(j->body_b->solver_index)];
-            joints_solved = joints_solved && j->SolvePositionConstraints(bdata_a, bdata_b);
+            continue;
         }
 
-        if (m_positionsSolved && joints_solved)
+        auto& state = body->State();
+        state.sweep.pos_n += data.pos;
+        state.sweep.angle_n += data.angle;
+        state.linear_velocity = data.linear_vel;
+        state.angular_velocity = data.angular_vel;
+
+        auto& xf = body->world_transform;
+        xf.set_angle(state.sweep.angle_n);
+        xf.pos = state.sweep.pos_n - xf.rot.rotate(state.sweep.local_center);
+    }
+}
+
+void
+Solver::WarmStart (void)
+{
+    for (auto& data : m_contacts)
+    {
+        auto& bdata_a = m_bodies[static_cast<uint32>(data.body_index[0])];
+        auto& bdata_b = m_bodies[static_cast<uint32>(data.body_index[1])];
+
+        const auto& mf = data.contact->GetManifold();
+        math::vec2 normal = mf.oriented_normal();
+        math::vec2 tangent = normal.perp_ccw();
+
+        for (size_t i = 0; i < mf.count; i++)
         {
-            break;
+            const auto& vcp = data.points[i];
+            math::vec2 impulse = (normal * vcp.normal_impulse) +
+                                 (tangent * vcp.tangent_impulse);
+
+            bdata_a.linear_vel -= bdata_a.inv_mass * impulse;
+            bdata_a.angular_vel -= bdata_a.inv_mmoi *
+                                   math::perp_dot(vcp.rel_point[0], impulse);
+
+            bdata_b.linear_vel += bdata_b.inv_mass * impulse;
+            bdata_b.angular_vel += bdata_b.inv_mmoi *
+                                   math::perp_dot(vcp.rel_point[1], impulse);
         }
     }
+}
 
-    for (auto& data : m_bodies)
+void
+Solver::SolveVelocityConstraints (void)
+{
+    for (auto& data : m_contacts)
     {
-        auto body = data.body;
-        body->sweep.pos_n += data.pos;
-        body->sweep.angle_n += data.angle;
-        body->linear.velocity = data.linear_vel;
-        body->angular.velocity = data.angular_vel;
+        SolveVelocityConstraint(data);
+    }
+}
 
-        auto& xf = body->world_transform;
-        xf.set_angle(body->sweep.angle_n);
-        xf.pos = body->sweep.pos_n - xf.rot.rotate(body->sweep.local_center);
+void
+Solver::SolveVelocityConstraint (solver_contact_data& data)
+{
+    auto& bdata_a = m_bodies[static_cast<uint32>(data.body_index[0])];
+    auto& bdata_b = m_bodies[static_cast<uint32>(data.body_index[1])];
 
-        // allow static bodies to be added to other islands
-        if (body->m_type == RigidBodyType::STATIC)
+    const auto& mf = data.contact->GetManifold();
+    math::vec2 normal = mf.oriented_normal();
+    math::vec2 tangent = normal.perp_ccw();
+    float tangent_speed = data.contact->tangent_speed;
+    float friction = data.contact->friction;
+
+    auto& impulse_cache = data.contact->impulse;
+    impulse_cache.count = mf.count;
+
+    for (size_t i = 0; i < mf.count; i++)
+    {
+        // Solve tangent constraints first b/c non-penetration is more
+        // important than friction
+
+        auto& vcp = data.points[i];
+
+        // relative velocity along direction of contact tangent
+        math::vec2 vel_a = bdata_a.linear_vel +
+                           (vcp.rel_point[0].perp() * bdata_a.angular_vel);
+        math::vec2 vel_b = bdata_b.linear_vel +
+                           (vcp.rel_point[1].perp() * bdata_b.angular_vel);
+        float rtv = math::dot(tangent, vel_b - vel_a) - tangent_speed;
+
+        // Compute tangent force
+        float lambda = vcp.tangent_mass * (-rtv);
+
+        // clamp the accumulated force
+        float max_friction = friction * vcp.normal_impulse;
+        float new_impulse = math::clamp(vcp.tangent_impulse + lambda,
+                                        -max_friction, max_friction);
+        lambda = new_impulse - vcp.tangent_impulse;
+        vcp.tangent_impulse = new_impulse;
+
+        // cache impulses (for OnPostSolve)
+        impulse_cache.tangents[i] = vcp.tangent_impulse;
+
+        // apply contact impulse
+        math::vec2 impulse = tangent * lambda;
+
+        bdata_a.linear_vel -= bdata_a.inv_mass * impulse;
+        bdata_a.angular_vel -= bdata_a.inv_mmoi *
+                               math::perp_dot(vcp.rel_point[0], impulse);
+
+        bdata_b.linear_vel += bdata_b.inv_mass * impulse;
+        bdata_b.angular_vel += bdata_b.inv_mmoi *
+                               math::perp_dot(vcp.rel_point[1], impulse);
+    }
+
+    if (data.block_solve)
+    {
+        SolveBlockConstraint(data);
+        return;
+    }
+
+    for (size_t i = 0; i < mf.count; i++)
+    {
+        // Solve normal constraints
+
+        auto& vcp = data.points[i];
+
+        // relative velocity along direction of contact normal
+        math::vec2 vel_a = bdata_a.linear_vel +
+                           (vcp.rel_point[0].perp() * bdata_a.angular_vel);
+        math::vec2 vel_b = bdata_b.linear_vel +
+                           (vcp.rel_point[1].perp() * bdata_b.angular_vel);
+        float rnv = math::dot(normal, vel_b - vel_a);
+
+        // Compute normal force
+        float lambda = -vcp.normal_mass * (rnv - vcp.velocity_bias);
+
+        // clamp the accumulated force
+        float new_impulse = std::max(vcp.normal_impulse + lambda, 0.f);
+        lambda = new_impulse - vcp.normal_impulse;
+        vcp.normal_impulse = new_impulse;
+
+        // cache impulses (for OnPostSolve)
+        impulse_cache.normals[i] = vcp.normal_impulse;
+
+        // apply contact impulse
+        math::vec2 impulse = normal * lambda;
+
+        bdata_a.linear_vel -= bdata_a.inv_mass * impulse;
+        bdata_a.angular_vel -= bdata_a.inv_mmoi *
+                               math::perp_dot(vcp.rel_point[0], impulse);
+
+        bdata_b.linear_vel += bdata_b.inv_mass * impulse;
+        bdata_b.angular_vel += bdata_b.inv_mmoi *
+                               math::perp_dot(vcp.rel_point[1], impulse);
+    }
+}
+
+void
+Solver::SolveBlockConstraint (solver_contact_data& data)
+{
+    // Box2D block solver.  The accumulated impulses (a) and the new impulses
+    // (x) are related by the velocity constraints
+    //     vn = K * (x - a) + vn_0
+    // which must satisfy the complementarity conditions
+    //     x >= 0, vn >= 0, x_i * vn_i = 0
+    // The four combinations of active points are tested in order, where the
+    // first combination satisfying the conditions is the solution.
+
+    auto& bdata_a = m_bodies[static_cast<uint32>(data.body_index[0])];
+    auto& bdata_b = m_bodies[static_cast<uint32>(data.body_index[1])];
+    auto& vcp1 = data.points[0];
+    auto& vcp2 = data.points[1];
+
+    const auto& mf = data.contact->GetManifold();
+    math::vec2 normal = mf.oriented_normal();
+
+    auto normal_velocity = [&](const solver_contact_data::velocity_constraint_point& vcp) {
+        math::vec2 vel_a = bdata_a.linear_vel +
+                           (vcp.rel_point[0].perp() * bdata_a.angular_vel);
+        math::vec2 vel_b = bdata_b.linear_vel +
+                           (vcp.rel_point[1].perp() * bdata_b.angular_vel);
+        return math::dot(normal, vel_b - vel_a);
+    };
+
+    math::vec2 a = { vcp1.normal_impulse, vcp2.normal_impulse };
+    SDL_assert(a.x >= 0.f && a.y >= 0.f);
+
+    // velocity constraint with the accumulated impulse removed
+    math::vec2 b = { normal_velocity(vcp1) - vcp1.velocity_bias,
+                     normal_velocity(vcp2) - vcp2.velocity_bias };
+    b -= data.block_k * a;
+
+    auto apply = [&](const math::vec2& x) {
+        math::vec2 d = x - a;
+        math::vec2 p1 = normal * d.x;
+        math::vec2 p2 = normal * d.y;
+
+        bdata_a.linear_vel -= bdata_a.inv_mass * (p1 + p2);
+        bdata_a.angular_vel -= bdata_a.inv_mmoi *
+                               (math::perp_dot(vcp1.rel_point[0], p1) +
+                                math::perp_dot(vcp2.rel_point[0], p2));
+
+        bdata_b.linear_vel += bdata_b.inv_mass * (p1 + p2);
+        bdata_b.angular_vel += bdata_b.inv_mmoi *
+                               (math::perp_dot(vcp1.rel_point[1], p1) +
+                                math::perp_dot(vcp2.rel_point[1], p2));
+
+        vcp1.normal_impulse = x.x;
+        vcp2.normal_impulse = x.y;
+    };
+
+    for (;;)
+    {
+        // 1) both points active (vn = 0)
+        math::vec2 x = -(data.block_mass * b);
+        if (x.x >= 0.f && x.y >= 0.f)
+        {
+            apply(x);
+            break;
+        }
+
+        // 2) first point active, second separating (x2 = 0, vn1 = 0)
+        x = { -vcp1.normal_mass * b.x, 0.f };
+        float vn2 = (data.block_k[0].y * x.x) + b.y;
+        if (x.x >= 0.f && vn2 >= 0.f)
         {
-            body->m_flags &= ~RigidBody::ON_ISLAND;
+            apply(x);
+            break;
         }
+
+        // 3) second point active, first separating (x1 = 0, vn2 = 0)
+        x = { 0.f, -vcp2.normal_mass * b.y };
+        float vn1 = (data.block_k[1].x * x.y) + b.x;
+        if (x.y >= 0.f && vn1 >= 0.f)
+        {
+            apply(x);
+            break;
+        }
+
+        // 4) both points separating (x = 0)
+        if (b.x >= 0.f && b.y >= 0.f)
+        {
+            apply({ 0.f, 0.f });
+            break;
+        }
+
+        // no solution, which only happens with round off, so the impulses
+        // are left unchanged
+        break;
     }
+
+    // cache impulses (for OnPostSolve)
+    data.contact->impulse.normals[0] = vcp1.normal_impulse;
+    data.contact->impulse.normals[1] = vcp2.normal_impulse;
 }
 
 void
-Solver::ProcessPostSolve (const CollisionGraph& graph)
+Solver::SolveSoft (void)
 {
-    if (graph.listener)
+    // Box2D v3 soft step.  Substeps are cheaper than iterations because the
+    // positions are integrated every substep, so the constraints are solved
+    // against the current positions rather than those at the start of the step.
+    SDL_assert(substeps > 0);
+
+    auto& soft = m_softStep;
+    soft.count = substeps;
+    soft.h = m_step->dt / static_cast<float>(substeps);
+    soft.inv_h = (soft.h > 0.f) ? (1.f / soft.h) : 0.f;
+
+    float contact_hertz = std::min(CONTACT_HERTZ, 0.25f * soft.inv_h);
+    soft.contact = softness(contact_hertz, CONTACT_DAMPING_RATIO, soft.h);
+    soft.joint = softness(2.f * contact_hertz, JOINT_DAMPING_RATIO, soft.h);
+
+    PrepareContacts();
+
+    // cached impulses are the total of the step, and are applied every substep
+    float inv_count = 1.f / static_cast<float>(soft.count);
+    for (auto& data : m_contacts)
     {
-        for (auto& data : m_contacts)
+        for (size_t i = 0; i < data.contact->GetManifold().count; i++)
         {
-            graph.listener->OnPostSolve(data.contact);
+            data.points[i].normal_impulse *= inv_count;
+            data.points[i].tangent_impulse *= inv_count;
         }
     }
 
-    if (!graph.IsSleepPrevented() && m_positionsSolved)
+    for (auto& j : m_joints)
+    {
+        auto& bdata_a = m_bodies[j.body_index[0]];
+        auto& bdata_b = m_bodies[j.body_index[1]];
+        j.joint->InitializeSoftSolver(*m_step, bdata_a, bdata_b);
+    }
+
+    float min_separation = 0.f;
+    bool joints_solved = true;
+    for (size_t sub = 0; sub < soft.count; sub++)
     {
-        float min_sleep_time = std::numeric_limits<float>::max();
-        for (auto& data : m_bodies)
+        IntegrateVelocities(soft.h);
+
+        // impulses accumulated by the previous substeps are always applied,
+        // where warm starting only controls the impulses of the last step
+        WarmStart();
+        for (auto& j : m_joints)
         {
-            auto body = data.body;
-            if (body->m_type == RigidBodyType::STATIC)
-            {
-                continue;
-            }
+            auto& bdata_a = m_bodies[j.body_index[0]];
+            auto& bdata_b = m_bodies[j.body_index[1]];
+            j.joint->WarmStartSoft(bdata_a, bdata_b);
+        }
 
-            if (body->IsSleepPrevented() ||
-                body->linear.velocity.self_dot() > LINEAR_SLEEP_TOLERANCE_SQUARED ||
-                math::square(body->angular.velocity) > ANGULAR_SLEEP_TOLERANCE_SQUARED)
-            {
-                body->m_sleepTime = 0.f;
-                min_sleep_time = 0.f;
-            }
-            else
-            {
-                body->m_sleepTime += m_step->dt;
-                min_sleep_time = std::min(min_sleep_time, body->m_sleepTime);
-            }
+        for (auto& j : m_joints)
+        {
+            auto& bdata_a = m_bodies[j.body_index[0]];
+            auto& bdata_b = m_bodies[j.body_index[1]];
+            j.joint->SolveSoftConstraints(soft, true, bdata_a, bdata_b);
         }
 
-        if (min_sleep_time >= SLEEP_THRESHOLD)
+        SolveSoftConstraints(true);
+        IntegratePositions(soft.h);
+
+        // relax to remove the velocity added by the bias
+        joints_solved = true;
+        for (auto& j : m_joints)
         {
-            for (auto& data : m_bodies)
-            {
-                data.body->Sleep();
-            }
+            auto& bdata_a = m_bodies[j.body_index[0]];
+            auto& bdata_b = m_bodies[j.body_index[1]];
+            joints_solved = j.joint->SolveSoftConstraints(soft, false, bdata_a, bdata_b) &&
+                            joints_solved;
+        }
+
+        min_separation = SolveSoftConstraints(false);
+    }
+
+    ApplyRestitution();
+
+    for (auto& data : m_contacts)
+    {
+        // cache impulses (for OnPostSolve)
+        auto& impulse_cache = data.contact->impulse;
+        impulse_cache.count = data.contact->GetManifold().count;
+        for (size_t i = 0; i < impulse_cache.count; i++)
+        {
+            impulse_cache.normals[i] = data.points[i].normal_impulse * static_cast<float>(soft.count);
+            impulse_cache.tangents[i] = data.points[i].tangent_impulse * static_cast<float>(soft.count);
         }
     }
+
+    m_positionsSolved = (min_separation >= LINEAR_SLOP * -3.f) && joints_solved;
+    m_velocityIterations = soft.count;
+    m_positionIterations = 0;
+
+    StoreBodies();
 }
 
 void
-Solver::SolveVelocityConstraints (void)
+Solver::IntegrateVelocities (float h)
 {
+    for (auto& data : m_bodies)
+    {
+        const auto body = data.body;
+        if (body->m_type != RigidBodyType::DYNAMIC)
+        {
+            continue;
+        }
+
+        auto linear_acc = (body->gravity_scale * gravity) +
+                          (body->linear.force * body->linear.inv_mass);
+        auto angular_acc = (body->angular.torque * body->angular.inv_mmoi);
+
+        data.linear_vel += linear_acc * h;
+        data.angular_vel += angular_acc * h;
+
+        // see Add for the damping approximation
+        data.linear_vel *= 1.f / (1.f + h * body->linear.damping);
+        data.angular_vel *= 1.f / (1.f + h * body->angular.damping);
+    }
+}
+
+float
+Solver::SolveSoftConstraints (bool use_bias)
+{
+    const auto& soft = m_softStep;
+    float min_separation = 0.f;
+
     for (auto& data : m_contacts)
     {
         auto& bdata_a = m_bodies[static_cast<uint32>(data.body_index[0])];
         auto& bdata_b = m_bodies[static_cast<uint32>(data.body_index[1])];
 
-        const auto& mf = data.contact->manifold;
-        math::vec2 tangent = mf.normal.perp_ccw();
+        const auto& mf = data.contact->GetManifold();
+        math::vec2 normal = mf.oriented_normal();
+        math::vec2 tangent = normal.perp_ccw();
         float tangent_speed = data.contact->tangent_speed;
         float friction = data.contact->friction;
 
-        auto& impulse_cache = data.contact->impulse;
-        impulse_cache.count = mf.count;
+        rotation rot_a(bdata_a.angle);
+        rotation rot_b(bdata_b.angle);
 
         for (size_t i = 0; i < mf.count; i++)
         {
@@ -307,27 +754,19 @@ Solver::SolveVelocityConstraints (void)
 
             auto& vcp = data.points[i];
 
-            // relative velocity along direction of contact tangent
             math::vec2 vel_a = bdata_a.linear_vel +
                                (vcp.rel_point[0].perp() * bdata_a.angular_vel);
             math::vec2 vel_b = bdata_b.linear_vel +
                                (vcp.rel_point[1].perp() * bdata_b.angular_vel);
             float rtv = math::dot(tangent, vel_b - vel_a) - tangent_speed;
 
-            // Compute tangent force
             float lambda = vcp.tangent_mass * (-rtv);
-
-            // clamp the accumulated force
             float max_friction = friction * vcp.normal_impulse;
             float new_impulse = math::clamp(vcp.tangent_impulse + lambda,
                                             -max_friction, max_friction);
             lambda = new_impulse - vcp.tangent_impulse;
             vcp.tangent_impulse = new_impulse;
 
-            // cache impulses (for OnPostSolve)
-            impulse_cache.tangents[i] = vcp.tangent_impulse;
-
-            // apply contact impulse
             math::vec2 impulse = tangent * lambda;
 
             bdata_a.linear_vel -= bdata_a.inv_mass * impulse;
@@ -345,26 +784,94 @@ Solver::SolveVelocityConstraints (void)
 
             auto& vcp = data.points[i];
 
-            // relative velocity along direction of contact normal
+            // separation linearized about the start of the step
+            math::vec2 d = (bdata_b.pos + rot_b.rotate(vcp.rel_point[1]) - vcp.rel_point[1]) -
+                           (bdata_a.pos + rot_a.rotate(vcp.rel_point[0]) - vcp.rel_point[0]);
+            float separation = vcp.separation + math::dot(d, normal);
+            min_separation = std::min(min_separation, separation);
+
+            float bias = 0.f;
+            float mass_scale = 1.f;
+            float impulse_scale = 0.f;
+            if (separation > 0.f)
+            {
+                // speculative, remove the approaching velocity beyond the gap
+                bias = separation * soft.inv_h;
+            }
+            else if (use_bias)
+            {
+                bias = std::max(soft.contact.bias_rate * std::min(separation + LINEAR_SLOP, 0.f),
+                                -MAX_PUSHOUT_VELOCITY);
+                mass_scale = soft.contact.mass_scale;
+                impulse_scale = soft.contact.impulse_scale;
+            }
+
             math::vec2 vel_a = bdata_a.linear_vel +
                                (vcp.rel_point[0].perp() * bdata_a.angular_vel);
             math::vec2 vel_b = bdata_b.linear_vel +
                                (vcp.rel_point[1].perp() * bdata_b.angular_vel);
-            float rnv = math::dot(mf.normal, vel_b - vel_a);
-
-            // Compute normal force
-            float lambda = -vcp.normal_mass * (rnv - vcp.velocity_bias);
+            float rnv = math::dot(normal, vel_b - vel_a);
 
-            // clamp the accumulated force
+            float lambda = (-vcp.normal_mass * mass_scale * (rnv + bias)) -
+                           (impulse_scale * vcp.normal_impulse);
             float new_impulse = std::max(vcp.normal_impulse + lambda, 0.f);
             lambda = new_impulse - vcp.normal_impulse;
             vcp.normal_impulse = new_impulse;
 
-            // cache impulses (for OnPostSolve)
-            impulse_cache.normals[i] = vcp.normal_impulse;
+            math::vec2 impulse = normal * lambda;
+
+            bdata_a.linear_vel -= bdata_a.inv_mass * impulse;
+            bdata_a.angular_vel -= bdata_a.inv_mmoi *
+                                   math::perp_dot(vcp.rel_point[0], impulse);
+
+            bdata_b.linear_vel += bdata_b.inv_mass * impulse;
+            bdata_b.angular_vel += bdata_b.inv_mmoi *
+                                   math::perp_dot(vcp.rel_point[1], impulse);
+        }
+    }
+
+    return min_separation;
+}
+
+void
+Solver::ApplyRestitution (void)
+{
+    // The soft constraints absorb the approaching velocity, so restitution is
+    // applied once after all substeps.  The bias is only set for points which
+    // were approaching faster than the velocity threshold.
+    for (auto& data : m_contacts)
+    {
+        if (data.contact->restitution == 0.f)
+        {
+            continue;
+        }
+
+        auto& bdata_a = m_bodies[static_cast<uint32>(data.body_index[0])];
+        auto& bdata_b = m_bodies[static_cast<uint32>(data.body_index[1])];
+
+        const auto& mf = data.contact->GetManifold();
+        math::vec2 normal = mf.oriented_normal();
+
+        for (size_t i = 0; i < mf.count; i++)
+        {
+            auto& vcp = data.points[i];
+            if (vcp.velocity_bias == 0.f || vcp.normal_impulse == 0.f)
+            {
+                continue;
+            }
+
+            math::vec2 vel_a = bdata_a.linear_vel +
+                               (vcp.rel_point[0].perp() * bdata_a.angular_vel);
+            math::vec2 vel_b = bdata_b.linear_vel +
+                               (vcp.rel_point[1].perp() * bdata_b.angular_vel);
+            float rnv = math::dot(normal, vel_b - vel_a);
+
+            float lambda = -vcp.normal_mass * (rnv - vcp.velocity_bias);
+            float new_impulse = std::max(vcp.normal_impulse + lambda, 0.f);
+            lambda = new_impulse - vcp.normal_impulse;
+            vcp.normal_impulse = new_impulse;
 
-            // apply contact impulse
-            math::vec2 impulse = mf.normal * lambda;
+            math::vec2 impulse = normal * lambda;
 
             bdata_a.linear_vel -= bdata_a.inv_mass * impulse;
             bdata_a.angular_vel -= bdata_a.inv_mmoi *
@@ -377,6 +884,280 @@ Solver::SolveVelocityConstraints (void)
     }
 }
 
+void
+Solver::PrepareWideContacts (void)
+{
+    // Greedy coloring in contact order.  Each body tracks the colors of the
+    // contacts it belongs to, and a contact takes the lowest color free on
+    // both bodies.  Bodies the solver cannot move never restrict the color.
+    m_wideContacts.clear();
+    m_remainingContacts.clear();
+    m_contactColors.clear();
+    m_bodyColors.clear();
+
+    for (size_t i = 0; i < m_bodies.size(); i++)
+    {
+        m_bodyColors.next() = 0;
+    }
+
+    size_t color_counts[MAX_CONTACT_COLORS + 1] = { };
+    for (const auto& data : m_contacts)
+    {
+        size_t index_a = data.body_index[0];
+        size_t index_b = data.body_index[1];
+        bool shared_a = is_shareable(m_bodies[index_a]);
+        bool shared_b = is_shareable(m_bodies[index_b]);
+
+        uint32 used = (shared_a ? 0 : m_bodyColors[index_a]) |
+                      (shared_b ? 0 : m_bodyColors[index_b]);
+
+        uint32 color = MAX_CONTACT_COLORS;
+        if (used != 0xFFFFFFFF)
+        {
+            color = static_cast<uint32>(math::lsb(static_cast<int64>(~used)) - 1);
+
+            uint32 bit = 1u << color;
+            if (!shared_a) { m_bodyColors[index_a] |= bit; }
+            if (!shared_b) { m_bodyColors[index_b] |= bit; }
+        }
+
+        m_contactColors.next() = color;
+        color_counts[color]++;
+    }
+
+    // Pack each color into bundles of four.  Contacts left over from a color,
+    // or which could not be colored, are solved individually.
+    for (uint32 color = 0; color < MAX_CONTACT_COLORS; color++)
+    {
+        size_t remaining = color_counts[color];
+        size_t bundled = remaining - (remaining % 4);
+        size_t lane = 0;
+        solver_contact_wide* wide = nullptr;
+
+        for (size_t i = 0; i < m_contacts.size() && remaining > 0; i++)
+        {
+            if (m_contactColors[i] != color)
+            {
+                continue;
+            }
+
+            remaining--;
+
+            if (bundled == 0)
+            {
+                m_remainingContacts.next() = i;
+                continue;
+            }
+
+            if (lane == 0)
+            {
+                wide = &m_wideContacts.next_clean();
+            }
+
+            const auto& data = m_contacts[i];
+            const auto& mf = data.contact->GetManifold();
+            const auto& bdata_a = m_bodies[data.body_index[0]];
+            const auto& bdata_b = m_bodies[data.body_index[1]];
+            math::vec2 normal = mf.oriented_normal();
+
+            wide->contact_index[lane] = i;
+            wide->body_index[0][lane] = data.body_index[0];
+            wide->body_index[1][lane] = data.body_index[1];
+            wide->normal_x[lane] = normal.x;
+            wide->normal_y[lane] = normal.y;
+            wide->friction[lane] = data.contact->friction;
+            wide->tangent_speed[lane] = data.contact->tangent_speed;
+            wide->inv_mass_a[lane] = bdata_a.inv_mass;
+            wide->inv_mmoi_a[lane] = bdata_a.inv_mmoi;
+            wide->inv_mass_b[lane] = bdata_b.inv_mass;
+            wide->inv_mmoi_b[lane] = bdata_b.inv_mmoi;
+
+            for (size_t p = 0; p < mf.count; p++)
+            {
+                const auto& vcp = data.points[p];
+                auto& wcp = wide->points[p];
+                wcp.rel_ax[lane] = vcp.rel_point[0].x;
+                wcp.rel_ay[lane] = vcp.rel_point[0].y;
+                wcp.rel_bx[lane] = vcp.rel_point[1].x;
+                wcp.rel_by[lane] = vcp.rel_point[1].y;
+                wcp.normal_impulse[lane] = vcp.normal_impulse;
+                wcp.tangent_impulse[lane] = vcp.tangent_impulse;
+                wcp.normal_mass[lane] = vcp.normal_mass;
+                wcp.tangent_mass[lane] = vcp.tangent_mass;
+                wcp.velocity_bias[lane] = vcp.velocity_bias;
+            }
+
+            bundled--;
+            lane = (lane + 1) % 4;
+        }
+    }
+
+    for (size_t i = 0; i < m_contacts.size(); i++)
+    {
+        if (m_contactColors[i] == MAX_CONTACT_COLORS)
+        {
+            m_remainingContacts.next() = i;
+        }
+    }
+}
+
+void
+Solver::SolveWideVelocityConstraints (void)
+{
+    using namespace rdge::math;
+
+    const float4 zero = splat4(0.f);
+    for (auto& wide : m_wideContacts)
+    {
+        // gather body velocities
+        float va_x[4], va_y[4], wa[4];
+        float vb_x[4], vb_y[4], wb[4];
+        for (size_t lane = 0; lane < 4; lane++)
+        {
+            const auto& bdata_a = m_bodies[wide.body_index[0][lane]];
+            const auto& bdata_b = m_bodies[wide.body_index[1][lane]];
+            va_x[lane] = bdata_a.linear_vel.x;
+            va_y[lane] = bdata_a.linear_vel.y;
+            wa[lane] = bdata_a.angular_vel;
+            vb_x[lane] = bdata_b.linear_vel.x;
+            vb_y[lane] = bdata_b.linear_vel.y;
+            wb[lane] = bdata_b.angular_vel;
+        }
+
+        float4 lin_ax = load4(va_x);
+        float4 lin_ay = load4(va_y);
+        float4 ang_a = load4(wa);
+        float4 lin_bx = load4(vb_x);
+        float4 lin_by = load4(vb_y);
+        float4 ang_b = load4(wb);
+
+        const float4 normal_x = load4(wide.normal_x);
+        const float4 normal_y = load4(wide.normal_y);
+        const float4 inv_mass_a = load4(wide.inv_mass_a);
+        const float4 inv_mmoi_a = load4(wide.inv_mmoi_a);
+        const float4 inv_mass_b = load4(wide.inv_mass_b);
+        const float4 inv_mmoi_b = load4(wide.inv_mmoi_b);
+
+        // applies the impulse (px, py) at the contact point to both bodies
+        auto apply = [&](const auto& wcp, const float4& px, const float4& py) {
+            const float4 rax = load4(wcp.rel_ax);
+            const float4 ray = load4(wcp.rel_ay);
+            const float4 rbx = load4(wcp.rel_bx);
+            const float4 rby = load4(wcp.rel_by);
+
+            lin_ax = lin_ax - (inv_mass_a * px);
+            lin_ay = lin_ay - (inv_mass_a * py);
+            ang_a = ang_a - (inv_mmoi_a * ((rax * py) - (ray * px)));
+
+            lin_bx = lin_bx + (inv_mass_b * px);
+            lin_by = lin_by + (inv_mass_b * py);
+            ang_b = ang_b + (inv_mmoi_b * ((rbx * py) - (rby * px)));
+        };
+
+        // relative velocity at the contact point projected on the axis
+        auto relative_velocity = [&](const auto& wcp, const float4& ax, const float4& ay) {
+            const float4 rax = load4(wcp.rel_ax);
+            const float4 ray = load4(wcp.rel_ay);
+            const float4 rbx = load4(wcp.rel_bx);
+            const float4 rby = load4(wcp.rel_by);
+
+            float4 dvx = (lin_bx - (rby * ang_b)) - (lin_ax - (ray * ang_a));
+            float4 dvy = (lin_by + (rbx * ang_b)) - (lin_ay + (rax * ang_a));
+            return (ax * dvx) + (ay * dvy);
+        };
+
+        // Solve tangent constraints first b/c non-penetration is more
+        // important than friction
+        const float4 tangent_x = normal_y;
+        const float4 tangent_y = zero - normal_x;
+        const float4 friction = load4(wide.friction);
+        const float4 tangent_speed = load4(wide.tangent_speed);
+        for (auto& wcp : wide.points)
+        {
+            float4 rtv = relative_velocity(wcp, tangent_x, tangent_y) - tangent_speed;
+            float4 lambda = load4(wcp.tangent_mass) * (zero - rtv);
+
+            // clamp the accumulated force
+            float4 max_friction = friction * load4(wcp.normal_impulse);
+            float4 old_impulse = load4(wcp.tangent_impulse);
+            float4 new_impulse = max4(min4(old_impulse + lambda, max_friction),
+                                      zero - max_friction);
+            lambda = new_impulse - old_impulse;
+            store4(wcp.tangent_impulse, new_impulse);
+
+            apply(wcp, tangent_x * lambda, tangent_y * lambda);
+        }
+
+        for (auto& wcp : wide.points)
+        {
+            float4 rnv = relative_velocity(wcp, normal_x, normal_y);
+            float4 lambda = (zero - load4(wcp.normal_mass)) * (rnv - load4(wcp.velocity_bias));
+
+            // clamp the accumulated force
+            float4 old_impulse = load4(wcp.normal_impulse);
+            float4 new_impulse = max4(old_impulse + lambda, zero);
+            lambda = new_impulse - old_impulse;
+            store4(wcp.normal_impulse, new_impulse);
+
+            apply(wcp, normal_x * lambda, normal_y * lambda);
+        }
+
+        // scatter body velocities
+        store4(va_x, lin_ax);
+        store4(va_y, lin_ay);
+        store4(wa, ang_a);
+        store4(vb_x, lin_bx);
+        store4(vb_y, lin_by);
+        store4(wb, ang_b);
+        for (size_t lane = 0; lane < 4; lane++)
+        {
+            auto& bdata_a = m_bodies[wide.body_index[0][lane]];
+            auto& bdata_b = m_bodies[wide.body_index[1][lane]];
+            if (!is_shareable(bdata_a))
+            {
+                bdata_a.linear_vel = { va_x[lane], va_y[lane] };
+                bdata_a.angular_vel = wa[lane];
+            }
+
+            if (!is_shareable(bdata_b))
+            {
+                bdata_b.linear_vel = { vb_x[lane], vb_y[lane] };
+                bdata_b.angular_vel = wb[lane];
+            }
+        }
+    }
+
+    for (size_t index : m_remainingContacts)
+    {
+        SolveVelocityConstraint(m_contacts[index]);
+    }
+}
+
+void
+Solver::StoreWideImpulses (void)
+{
+    for (auto& wide : m_wideContacts)
+    {
+        for (size_t lane = 0; lane < 4; lane++)
+        {
+            auto& data = m_contacts[wide.contact_index[lane]];
+            auto& impulse_cache = data.contact->impulse;
+            impulse_cache.count = data.contact->GetManifold().count;
+
+            for (size_t p = 0; p < impulse_cache.count; p++)
+            {
+                auto& vcp = data.points[p];
+                vcp.normal_impulse = wide.points[p].normal_impulse[lane];
+                vcp.tangent_impulse = wide.points[p].tangent_impulse[lane];
+
+                // cache impulses (for OnPostSolve)
+                impulse_cache.normals[p] = vcp.normal_impulse;
+                impulse_cache.tangents[p] = vcp.tangent_impulse;
+            }
+        }
+    }
+}
+
 bool
 Solver::CorrectPositions (void)
 {
@@ -400,13 +1181,17 @@ Solver::CorrectPositions (void)
         auto& bdata_a = m_bodies[static_cast<uint32>(data.body_index[0])];
         auto& bdata_b = m_bodies[static_cast<uint32>(data.body_index[1])];
 
-        const auto& mf = data.contact->manifold;
+        const auto& mf = data.contact->GetManifold();
+
+        // Manifold data is in world space at the start of the step.  Apply the
+        // accumulated deltas, rotating about the center of mass.
+        iso_transform xf_a(bdata_a.pos, bdata_a.angle);
+        iso_transform xf_b(bdata_b.pos, bdata_b.angle);
+        xf_a.pos += bdata_a.world_center - xf_a.rot.rotate(bdata_a.world_center);
+        xf_b.pos += bdata_b.world_center - xf_b.rot.rotate(bdata_b.world_center);
 
         for (size_t i = 0; i < mf.count; i++)
         {
-            iso_transform xf_a(bdata_a.pos, bdata_a.angle);
-            iso_transform xf_b(bdata_b.pos, bdata_b.angle);
-
             math::vec2 normal;
             math::vec2 point;
             float separation;
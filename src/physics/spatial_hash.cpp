@@ -0,0 +1,364 @@
+#include <rdge/physics/spatial_hash.hpp>
+#include <rdge/physics/snapshot.hpp>
+#include <rdge/util/exception.hpp>
+
+#ifdef RDGE_DEBUG
+#include <rdge/debug/renderer.hpp>
+#include <rdge/graphics/color.hpp>
+#endif
+
+namespace rdge {
+namespace physics {
+
+namespace {
+
+// Cell coordinates are clamped so far away (or invalid) boxes can't overflow
+constexpr float MAX_CELL_COORD = 1073741824.f; // 2^30
+
+int32
+ToCell (float value)
+{
+    return static_cast<int32>(std::min(std::max(value, -MAX_CELL_COORD), MAX_CELL_COORD));
+}
+
+uint32
+BucketShift (size_t bucket_count)
+{
+    uint32 shift = 32;
+    for (size_t n = bucket_count; n > 1; n >>= 1)
+    {
+        shift--;
+    }
+
+    return shift;
+}
+
+} // anonymous namespace
+
+constexpr int32 SpatialHashGrid::NULL_ENTRY;
+constexpr int64 SpatialHashGrid::MAX_PROXY_CELLS;
+constexpr size_t SpatialHashGrid::INITIAL_BUCKET_COUNT;
+
+SpatialHashGrid::SpatialHashGrid (const math::vec2& cell_size, float margin)
+    : m_cellSize(cell_size)
+    , m_margin(margin)
+{
+    if (cell_size.x <= 0.f || cell_size.y <= 0.f)
+    {
+        RDGE_THROW("Grid cell size must be greater than zero");
+    }
+
+    m_invCellSize = { 1.f / cell_size.x, 1.f / cell_size.y };
+    m_buckets.assign(INITIAL_BUCKET_COUNT, NULL_ENTRY);
+    m_bucketShift = BucketShift(INITIAL_BUCKET_COUNT);
+}
+
+void
+SpatialHashGrid::ClearProxies (void) noexcept
+{
+    m_proxies.clear();
+    std::fill(m_buckets.begin(), m_buckets.end(), NULL_ENTRY);
+    m_entries.clear();
+    m_freeEntry = NULL_ENTRY;
+    m_entryCount = 0;
+    m_oversized.clear();
+}
+
+int32
+SpatialHashGrid::CreateProxy (const aabb& box, void* user_data)
+{
+    auto handle = static_cast<int32>(m_proxies.reserve());
+    auto& proxy = m_proxies[handle];
+    proxy.fat_box = box;
+    proxy.fat_box.fatten(m_margin);
+    proxy.user_data = user_data;
+    proxy.filter = proxy_filter();
+
+    InsertCells(handle);
+    return handle;
+}
+
+void
+SpatialHashGrid::DestroyProxy (int32 handle)
+{
+    RemoveCells(handle);
+    m_proxies.release(handle);
+}
+
+bool
+SpatialHashGrid::MoveProxy (int32 handle, const aabb& box, const math::vec2& displacement)
+{
+    auto& proxy = m_proxies[handle];
+    if (proxy.fat_box.contains(box))
+    {
+        return false;
+    }
+
+    proxy.fat_box = box;
+    proxy.fat_box.fatten(m_margin);
+    math::vec2 expansion = displacement * DISP_MULTIPLIER;
+
+    if (expansion.x < 0.f)
+    {
+        proxy.fat_box.lo.x += expansion.x;
+    }
+    else
+    {
+        proxy.fat_box.hi.x += expansion.x;
+    }
+
+    if (expansion.y < 0.f)
+    {
+        proxy.fat_box.lo.y += expansion.y;
+    }
+    else
+    {
+        proxy.fat_box.hi.y += expansion.y;
+    }
+
+    // most moves stay within the same cells, which only requires the box update
+    grid_range cells = ComputeRange(proxy.fat_box, false);
+    if (proxy.oversized < 0 && cells == proxy.cells)
+    {
+        return true;
+    }
+
+    RemoveCells(handle);
+    InsertCells(handle);
+    return true;
+}
+
+grid_range
+SpatialHashGrid::ComputeRange (const aabb& box, bool edge_inclusive) const noexcept
+{
+    float lo_x = std::floor(box.lo.x * m_invCellSize.x);
+    float lo_y = std::floor(box.lo.y * m_invCellSize.y);
+    float hi_x = std::floor(box.hi.x * m_invCellSize.x);
+    float hi_y = std::floor(box.hi.y * m_invCellSize.y);
+
+    // intersection tests are edge exclusive, so a box ending exactly on a cell
+    // boundary does not need the next cell
+    if (!edge_inclusive)
+    {
+        hi_x = std::max(lo_x, std::ceil(box.hi.x * m_invCellSize.x) - 1.f);
+        hi_y = std::max(lo_y, std::ceil(box.hi.y * m_invCellSize.y) - 1.f);
+    }
+
+    grid_range result;
+    result.lo[0] = ToCell(lo_x);
+    result.lo[1] = ToCell(lo_y);
+    result.hi[0] = std::max(result.lo[0], ToCell(hi_x));
+    result.hi[1] = std::max(result.lo[1], ToCell(hi_y));
+    return result;
+}
+
+void
+SpatialHashGrid::InsertCells (int32 handle)
+{
+    auto& proxy = m_proxies[handle];
+    proxy.cells = ComputeRange(proxy.fat_box, false);
+
+    if (proxy.cells.count() > MAX_PROXY_CELLS)
+    {
+        proxy.oversized = static_cast<int32>(m_oversized.size());
+        m_oversized.push_back(handle);
+        return;
+    }
+
+    proxy.oversized = -1;
+
+    // keep the load factor at or below one
+    size_t required = m_entryCount + static_cast<size_t>(proxy.cells.count());
+    if (required > m_buckets.size())
+    {
+        size_t bucket_count = m_buckets.size();
+        while (bucket_count < required)
+        {
+            bucket_count *= 2;
+        }
+
+        Rehash(bucket_count);
+    }
+
+    for (int32 y = proxy.cells.lo[1]; y <= proxy.cells.hi[1]; y++)
+    {
+        for (int32 x = proxy.cells.lo[0]; x <= proxy.cells.hi[0]; x++)
+        {
+            int32 e = m_freeEntry;
+            if (e != NULL_ENTRY)
+            {
+                m_freeEntry = m_entries[static_cast<size_t>(e)].next;
+            }
+            else
+            {
+                e = static_cast<int32>(m_entries.size());
+                m_entries.emplace_back();
+            }
+
+            size_t bucket = Bucket(x, y);
+            auto& entry = m_entries[static_cast<size_t>(e)];
+            entry.x = x;
+            entry.y = y;
+            entry.proxy = handle;
+            entry.next = m_buckets[bucket];
+            m_buckets[bucket] = e;
+        }
+    }
+
+    m_entryCount += static_cast<size_t>(proxy.cells.count());
+}
+
+void
+SpatialHashGrid::RemoveCells (int32 handle)
+{
+    auto& proxy = m_proxies[handle];
+    if (proxy.oversized >= 0)
+    {
+        // swap with the last to keep the list packed
+        int32 last = m_oversized.back();
+        m_oversized[static_cast<size_t>(proxy.oversized)] = last;
+        m_proxies[last].oversized = proxy.oversized;
+        m_oversized.pop_back();
+        proxy.oversized = -1;
+        return;
+    }
+
+    for (int32 y = proxy.cells.lo[1]; y <= proxy.cells.hi[1]; y++)
+    {
+        for (int32 x = proxy.cells.lo[0]; x <= proxy.cells.hi[0]; x++)
+        {
+            int32* link = &m_buckets[Bucket(x, y)];
+            while (*link != NULL_ENTRY)
+            {
+                auto& entry = m_entries[static_cast<size_t>(*link)];
+                if (entry.proxy == handle && entry.x == x && entry.y == y)
+                {
+                    int32 e = *link;
+                    *link = entry.next;
+                    entry.next = m_freeEntry;
+                    m_freeEntry = e;
+                    break;
+                }
+
+                link = &entry.next;
+            }
+        }
+    }
+
+    m_entryCount -= static_cast<size_t>(proxy.cells.count());
+}
+
+void
+SpatialHashGrid::Rehash (size_t bucket_count)
+{
+    std::vector<int32> buckets(bucket_count, NULL_ENTRY);
+    m_bucketShift = BucketShift(bucket_count);
+
+    for (int32 head : m_buckets)
+    {
+        for (int32 e = head; e != NULL_ENTRY;)
+        {
+            auto& entry = m_entries[static_cast<size_t>(e)];
+            int32 next = entry.next;
+
+            size_t bucket = Bucket(entry.x, entry.y);
+            entry.next = buckets[bucket];
+            buckets[bucket] = e;
+
+            e = next;
+        }
+    }
+
+    m_buckets.swap(buckets);
+}
+
+void
+SpatialHashGrid::QueryProxies (const aabb& box, query_fn fn, void* context) const
+{
+    QueryCells(box, [=](int32 handle) {
+        return fn(context, handle);
+    });
+}
+
+void
+SpatialHashGrid::SweepProxies (const ray_cast_input& input,
+                               const math::vec2& extension,
+                               sweep_fn fn,
+                               void* context) const
+{
+    SweepCells(input, extension, [=](const ray_cast_input& sub_input, int32 handle) {
+        return fn(context, sub_input, handle);
+    });
+}
+
+void
+SpatialHashGrid::Save (snapshot_writer& writer) const
+{
+    writer.write(static_cast<uint64>(m_proxies.size()));
+    writer.write(static_cast<uint64>(m_proxies.capacity()));
+    writer.write(m_proxies.data(), m_proxies.capacity());
+    writer.write(m_proxies.handles(), m_proxies.capacity());
+
+    writer.write(static_cast<uint64>(m_buckets.size()));
+    writer.write(m_buckets.data(), m_buckets.size());
+    writer.write(static_cast<uint64>(m_entries.size()));
+    writer.write(m_entries.data(), m_entries.size());
+    writer.write(m_freeEntry);
+    writer.write(static_cast<uint64>(m_entryCount));
+
+    writer.write(static_cast<uint64>(m_oversized.size()));
+    writer.write(m_oversized.data(), m_oversized.size());
+}
+
+void
+SpatialHashGrid::Restore (snapshot_reader& reader)
+{
+    auto count = static_cast<size_t>(reader.read<uint64>());
+    auto capacity = static_cast<size_t>(reader.read<uint64>());
+    const auto* proxies = reader.read_array<grid_proxy>(capacity);
+    const auto* handles = reader.read_array<freelist<grid_proxy>::handle_type>(capacity);
+    m_proxies.assign(proxies, handles, count, capacity);
+
+    m_buckets.resize(static_cast<size_t>(reader.read<uint64>()));
+    reader.read(m_buckets.data(), m_buckets.size());
+    m_bucketShift = BucketShift(m_buckets.size());
+    m_entries.resize(static_cast<size_t>(reader.read<uint64>()));
+    reader.read(m_entries.data(), m_entries.size());
+    reader.read(m_freeEntry);
+    m_entryCount = static_cast<size_t>(reader.read<uint64>());
+
+    m_oversized.resize(static_cast<size_t>(reader.read<uint64>()));
+    reader.read(m_oversized.data(), m_oversized.size());
+}
+
+void
+SpatialHashGrid::DebugDraw (float pixel_ratio)
+{
+#ifdef RDGE_DEBUG
+    for (size_t i = 0; i < m_proxies.size(); i++)
+    {
+        const auto& proxy = m_proxies.data()[m_proxies.handles()[i]];
+        debug::DrawWireFrame(proxy.fat_box, color::WHITE, pixel_ratio);
+    }
+#else
+    Unused(pixel_ratio);
+#endif
+}
+
+std::ostream& operator<< (std::ostream& os, BroadPhaseType value)
+{
+    switch (value)
+    {
+    case BroadPhaseType::BVH:
+        return os << "BVH";
+    case BroadPhaseType::SPATIAL_HASH:
+        return os << "SPATIAL_HASH";
+    default:
+        break;
+    }
+
+    return os << "UNKNOWN";
+}
+
+} // namespace physics
+} // namespace rdge
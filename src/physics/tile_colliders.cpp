@@ -0,0 +1,156 @@
+#include <rdge/physics/tile_colliders.hpp>
+
+#include <SDL_assert.h>
+
+namespace rdge {
+namespace physics {
+
+namespace {
+
+// Boundary directions in CCW order, so a left turn is (dir + 1) % 4
+enum Direction : uint8
+{
+    POSITIVE_X = 0,
+    POSITIVE_Y,
+    NEGATIVE_X,
+    NEGATIVE_Y,
+    DIRECTION_COUNT
+};
+
+constexpr int32 STEP_X[DIRECTION_COUNT] = { 1, 0, -1, 0 };
+constexpr int32 STEP_Y[DIRECTION_COUNT] = { 0, 1, 0, -1 };
+
+// Turns tried at each corner.  Preferring left keeps tiles which only touch at
+// a corner in separate loops (unless they're connected elsewhere, in which case
+// the loop passes through the shared corner twice).
+constexpr uint8 TURNS[3] = { 1, 0, 3 };
+
+} // anonymous namespace
+
+std::vector<TileChain>
+merge_tile_colliders (const tile_collider_grid& grid)
+{
+    SDL_assert(grid.solid != nullptr || grid.cols == 0 || grid.rows == 0);
+
+    std::vector<TileChain> result;
+    if (grid.cols == 0 || grid.rows == 0)
+    {
+        return result;
+    }
+
+    int32 cols = static_cast<int32>(grid.cols);
+    int32 rows = static_cast<int32>(grid.rows);
+    auto is_solid = [&](int32 x, int32 y) {
+        return (0 <= x && x < cols && 0 <= y && y < rows) &&
+               grid.solid[(y * cols) + x] != 0;
+    };
+
+    // Outgoing boundary directions of each tile corner.  Every solid/empty tile
+    // pair contributes a unit length boundary with the solid tile on the left.
+    int32 pitch = cols + 1;
+    std::vector<uint8> corners(static_cast<size_t>(pitch * (rows + 1)), 0);
+    auto corner = [&](int32 x, int32 y) -> uint8& {
+        return corners[static_cast<size_t>((y * pitch) + x)];
+    };
+
+    size_t boundary_count = 0;
+    for (int32 y = 0; y < rows; y++)
+    {
+        for (int32 x = 0; x < cols; x++)
+        {
+            if (!is_solid(x, y))
+            {
+                continue;
+            }
+
+            if (!is_solid(x, y - 1)) { corner(x, y) |= (1 << POSITIVE_X); boundary_count++; }
+            if (!is_solid(x + 1, y)) { corner(x + 1, y) |= (1 << POSITIVE_Y); boundary_count++; }
+            if (!is_solid(x, y + 1)) { corner(x + 1, y + 1) |= (1 << NEGATIVE_X); boundary_count++; }
+            if (!is_solid(x - 1, y)) { corner(x, y + 1) |= (1 << NEGATIVE_Y); boundary_count++; }
+        }
+    }
+
+    std::vector<uint8> path;
+    for (int32 start_y = 0; start_y <= rows && boundary_count > 0; start_y++)
+    {
+        for (int32 start_x = 0; start_x <= cols && boundary_count > 0; start_x++)
+        {
+            while (corner(start_x, start_y) != 0)
+            {
+                uint8 start_dir = 0;
+                while ((corner(start_x, start_y) & (1 << start_dir)) == 0)
+                {
+                    start_dir++;
+                }
+
+                // walk the loop, recording the direction leaving each corner
+                path.clear();
+                int32 x = start_x;
+                int32 y = start_y;
+                uint8 dir = start_dir;
+                while (true)
+                {
+                    corner(x, y) &= ~(1 << dir);
+                    boundary_count--;
+                    path.push_back(dir);
+                    x += STEP_X[dir];
+                    y += STEP_Y[dir];
+
+                    // the start boundary is still available when returning, so
+                    // the loop closes where the walk would repeat it
+                    uint8 available = corner(x, y);
+                    if (x == start_x && y == start_y)
+                    {
+                        available |= (1 << start_dir);
+                    }
+
+                    uint8 next = DIRECTION_COUNT;
+                    for (uint8 turn : TURNS)
+                    {
+                        uint8 candidate = (dir + turn) % DIRECTION_COUNT;
+                        if (available & (1 << candidate))
+                        {
+                            next = candidate;
+                            break;
+                        }
+                    }
+
+                    SDL_assert(next != DIRECTION_COUNT);
+                    if (x == start_x && y == start_y && next == start_dir)
+                    {
+                        break;
+                    }
+
+                    dir = next;
+                }
+
+                // emit corners where the direction changes
+                TileChain chain;
+                x = start_x;
+                y = start_y;
+                uint8 prev = path.back();
+                for (uint8 d : path)
+                {
+                    if (d != prev)
+                    {
+                        chain.emplace_back(grid.origin.x + (grid.cell_size.x * static_cast<float>(x)),
+                                           grid.origin.y + (grid.cell_size.y * static_cast<float>(y)));
+                    }
+
+                    x += STEP_X[d];
+                    y += STEP_Y[d];
+                    prev = d;
+                }
+
+                SDL_assert(chain.size() >= 4);
+                result.push_back(std::move(chain));
+            }
+        }
+    }
+
+    SDL_assert(boundary_count == 0);
+    return result;
+}
+
+} // namespace physics
+} // namespace rdge
@@ -0,0 +1,125 @@
+#include <rdge/util/worker_pool.hpp>
+
+namespace rdge {
+
+WorkerPool::WorkerPool (size_t thread_count)
+{
+    try
+    {
+        m_threads.reserve(thread_count);
+        for (size_t i = 0; i < thread_count; i++)
+        {
+            // calling thread is worker zero
+            m_threads.emplace_back(&WorkerPool::WorkerMain, this, i + 1);
+        }
+    }
+    catch (...)
+    {
+        // threads already started must be joined before they're destroyed
+        Shutdown();
+        throw;
+    }
+}
+
+WorkerPool::~WorkerPool (void) noexcept
+{
+    Shutdown();
+}
+
+size_t
+WorkerPool::DefaultThreadCount (void) noexcept
+{
+    unsigned int hardware = std::thread::hardware_concurrency();
+    return (hardware > 1) ? (hardware - 1) : 0;
+}
+
+void
+WorkerPool::Execute (job_fn fn, void* context)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_job = fn;
+        m_context = context;
+        m_active = m_threads.size();
+        m_generation++;
+    }
+
+    m_start.notify_all();
+
+    // the context is owned by the caller, so the workers must be finished
+    // before an exception on the calling thread unwinds it
+    try
+    {
+        fn(context, 0);
+    }
+    catch (...)
+    {
+        Wait();
+        throw;
+    }
+
+    Wait();
+}
+
+void
+WorkerPool::Wait (void)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finish.wait(lock, [this] { return (m_active == 0); });
+    m_job = nullptr;
+    m_context = nullptr;
+}
+
+void
+WorkerPool::Shutdown (void) noexcept
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_shutdown = true;
+    }
+
+    m_start.notify_all();
+    for (auto& t : m_threads)
+    {
+        t.join();
+    }
+}
+
+void
+WorkerPool::WorkerMain (size_t worker)
+{
+    uint64 generation = 0;
+    while (true)
+    {
+        job_fn fn = nullptr;
+        void* context = nullptr;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&] { return m_shutdown || (m_generation != generation); });
+            if (m_shutdown)
+            {
+                return;
+            }
+
+            generation = m_generation;
+            fn = m_job;
+            context = m_context;
+        }
+
+        fn(context, worker);
+
+        bool done = false;
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            done = (--m_active == 0);
+        }
+
+        if (done)
+        {
+            m_finish.notify_one();
+        }
+    }
+}
+
+} // namespace rdge
@@ -0,0 +1,315 @@
+#include <gtest/gtest.h>
+
+#include <rdge/math/vec2.hpp>
+#include <rdge/physics/aabb.hpp>
+#include <rdge/physics/bvh.hpp>
+#include <rdge/util/worker_pool.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace rdge;
+using namespace rdge::math;
+using namespace rdge::physics;
+
+struct test_proxy
+{
+    int32 id;
+};
+
+aabb
+random_box (std::mt19937& rng, float extent)
+{
+    std::uniform_real_distribution<float> pos(-extent, extent);
+    std::uniform_real_distribution<float> size(0.1f, 2.f);
+
+    vec2 lo(pos(rng), pos(rng));
+    return aabb(lo, size(rng), size(rng));
+}
+
+std::vector<int32>
+query_ids (const BVHTree& tree, const aabb& box)
+{
+    std::vector<int32> result;
+    for (auto* p : tree.Query<test_proxy>(box))
+    {
+        result.push_back(p->id);
+    }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+TEST(BVHTreeTest, VerifyWideLayoutQueries)
+{
+    std::mt19937 rng(1234);
+    std::vector<test_proxy> proxies(500);
+    std::vector<int32> handles;
+
+    BVHTree tree;
+    for (size_t i = 0; i < proxies.size(); i++)
+    {
+        proxies[i].id = static_cast<int32>(i);
+        handles.push_back(tree.CreateProxy(random_box(rng, 50.f), &proxies[i]));
+    }
+
+    // a) Wide layout is not used until it's been built
+    tree.EnableWideLayout(true);
+    EXPECT_FALSE(tree.UsesWideLayout());
+    tree.UpdateWideLayout();
+    EXPECT_TRUE(tree.UsesWideLayout());
+
+    // b) Box queries are equivalent to the binary tree
+    std::vector<std::vector<int32>> wide_results;
+    std::vector<aabb> queries;
+    for (size_t i = 0; i < 100; i++)
+    {
+        queries.push_back(random_box(rng, 50.f).fatten(3.f));
+        wide_results.push_back(query_ids(tree, queries.back()));
+    }
+
+    auto wide_pairs = tree.Query<test_proxy>(handles);
+
+    tree.EnableWideLayout(false);
+    for (size_t i = 0; i < queries.size(); i++)
+    {
+        EXPECT_EQ(wide_results[i], query_ids(tree, queries[i]));
+    }
+
+    // c) Pair queries are equivalent to the binary tree
+    auto pairs = tree.Query<test_proxy>(handles);
+    ASSERT_EQ(wide_pairs.size(), pairs.size());
+    for (size_t i = 0; i < pairs.size(); i++)
+    {
+        EXPECT_EQ(wide_pairs[i], pairs[i]);
+    }
+
+    // d) Modifying the tree invalidates the layout
+    tree.EnableWideLayout(true);
+    tree.UpdateWideLayout();
+    tree.DestroyProxy(handles.back());
+    EXPECT_FALSE(tree.UsesWideLayout());
+    tree.UpdateWideLayout();
+    EXPECT_TRUE(tree.UsesWideLayout());
+}
+
+TEST(BVHTreeTest, VerifyWideLayoutSingleLeaf)
+{
+    test_proxy proxy = { 7 };
+
+    BVHTree tree;
+    tree.CreateProxy(aabb({ 0.f, 0.f }, { 1.f, 1.f }), &proxy);
+    tree.EnableWideLayout(true);
+    tree.UpdateWideLayout();
+
+    auto result = tree.Query<test_proxy>(aabb({ 0.5f, 0.5f }, { 2.f, 2.f }));
+    ASSERT_EQ(result.size(), 1u);
+    EXPECT_EQ(result[0]->id, 7);
+
+    result = tree.Query<test_proxy>(aabb({ 5.f, 5.f }, { 6.f, 6.f }));
+    EXPECT_TRUE(result.empty());
+}
+
+TEST(BVHTreeTest, VerifyBuild)
+{
+    std::mt19937 rng(5678);
+    std::vector<test_proxy> proxies(1000);
+    std::vector<aabb> boxes;
+    std::vector<int32> handles;
+
+    BVHTree incremental;
+    BVHTree built;
+    for (size_t i = 0; i < proxies.size(); i++)
+    {
+        proxies[i].id = static_cast<int32>(i);
+        boxes.push_back(random_box(rng, 100.f));
+        incremental.CreateProxy(boxes.back(), &proxies[i]);
+        handles.push_back(built.CreateDeferredProxy(boxes.back(), &proxies[i]));
+    }
+
+    // a) deferred proxies are not visible until built
+    EXPECT_TRUE(built.HasDeferredProxies());
+    EXPECT_TRUE(query_ids(built, aabb({ -100.f, -100.f }, { 100.f, 100.f })).empty());
+
+    built.Build();
+    EXPECT_FALSE(built.HasDeferredProxies());
+
+    // b) handles are stable
+    for (size_t i = 0; i < handles.size(); i++)
+    {
+        EXPECT_EQ(static_cast<test_proxy*>(built.GetUserData(handles[i]))->id, proxies[i].id);
+    }
+
+    // c) queries are equivalent to the incrementally built tree
+    for (size_t i = 0; i < 100; i++)
+    {
+        aabb query = random_box(rng, 100.f).fatten(5.f);
+        EXPECT_EQ(query_ids(built, query), query_ids(incremental, query));
+    }
+
+    // d) built tree is at least as good as incremental insertion
+    EXPECT_LE(built.AreaRatio(), incremental.AreaRatio());
+
+    // e) tree can be modified and rebuilt after a build
+    built.DestroyProxy(handles[0]);
+    built.MoveProxy(handles[1], aabb({ 500.f, 500.f }, { 501.f, 501.f }), { 0.f, 0.f });
+    int32 extra = built.CreateDeferredProxy(aabb({ 600.f, 600.f }, { 601.f, 601.f }), &proxies[0]);
+    built.Build();
+
+    auto result = query_ids(built, aabb({ 450.f, 450.f }, { 650.f, 650.f }));
+    ASSERT_EQ(result.size(), 2u);
+    EXPECT_EQ(result[0], 0);
+    EXPECT_EQ(result[1], 1);
+    EXPECT_EQ(built.GetUserData(extra), &proxies[0]);
+}
+
+TEST(BVHTreeTest, VerifyBuildDegenerate)
+{
+    // identical boxes have no centroid extent, forcing median splits
+    std::vector<test_proxy> proxies(100);
+    BVHTree tree;
+    for (size_t i = 0; i < proxies.size(); i++)
+    {
+        proxies[i].id = static_cast<int32>(i);
+        tree.CreateDeferredProxy(aabb({ 0.f, 0.f }, { 1.f, 1.f }), &proxies[i]);
+    }
+
+    tree.Build();
+    EXPECT_EQ(query_ids(tree, aabb({ 0.5f, 0.5f }, { 2.f, 2.f })).size(), proxies.size());
+    EXPECT_LE(tree.Height(), 8);
+}
+
+TEST(BVHTreeTest, VerifyRayCast)
+{
+    std::mt19937 rng(4321);
+    std::vector<test_proxy> proxies(200);
+    std::vector<aabb> boxes;
+
+    BVHTree tree;
+    for (size_t i = 0; i < proxies.size(); i++)
+    {
+        proxies[i].id = static_cast<int32>(i);
+        boxes.push_back(random_box(rng, 50.f));
+        tree.CreateProxy(boxes.back(), &proxies[i]);
+    }
+
+    // a) every proxy touching the segment is reported
+    ray_cast_input input = { { -60.f, -40.f }, { 60.f, 45.f } };
+    std::vector<int32> hits;
+    tree.RayCast(input, [&](const ray_cast_input& sub_input, int32 handle) {
+        hits.push_back(static_cast<test_proxy*>(tree.GetUserData(handle))->id);
+        return sub_input.max_fraction;
+    });
+
+    std::sort(hits.begin(), hits.end());
+    std::vector<int32> expected;
+    for (size_t i = 0; i < proxies.size(); i++)
+    {
+        // brute force slab test, where the fat box always contains the original
+        const aabb& box = boxes[i];
+        vec2 d = input.p2 - input.p1;
+        float t0 = 0.f;
+        float t1 = 1.f;
+        for (size_t axis = 0; axis < 2; axis++)
+        {
+            float p = (axis == 0) ? input.p1.x : input.p1.y;
+            float v = (axis == 0) ? d.x : d.y;
+            float lo = (axis == 0) ? box.lo.x : box.lo.y;
+            float hi = (axis == 0) ? box.hi.x : box.hi.y;
+            float a = (lo - p) / v;
+            float b = (hi - p) / v;
+            t0 = std::max(t0, std::min(a, b));
+            t1 = std::min(t1, std::max(a, b));
+        }
+
+        if (t0 <= t1)
+        {
+            expected.push_back(static_cast<int32>(i));
+        }
+    }
+
+    EXPECT_FALSE(expected.empty());
+    for (int32 id : expected)
+    {
+        EXPECT_TRUE(std::binary_search(hits.begin(), hits.end(), id));
+    }
+
+    // b) returning zero terminates the cast
+    size_t count = 0;
+    tree.RayCast(input, [&](const ray_cast_input&, int32) {
+        count++;
+        return 0.f;
+    });
+
+    EXPECT_EQ(count, 1u);
+}
+
+TEST(BVHTreeTest, VerifyQueryBatch)
+{
+    std::mt19937 rng(4321);
+    std::vector<test_proxy> proxies(800);
+
+    BVHTree tree;
+    for (size_t i = 0; i < proxies.size(); i++)
+    {
+        proxies[i].id = static_cast<int32>(i);
+        tree.CreateProxy(random_box(rng, 60.f), &proxies[i]);
+    }
+
+    // more queries than a single chunk, including some which miss everything
+    QueryBatch batch;
+    for (size_t i = 0; i < 300; i++)
+    {
+        EXPECT_EQ(batch.Add(random_box(rng, 80.f)), i);
+    }
+
+    auto verify = [&](const QueryBatch& result) {
+        ASSERT_EQ(result.Offsets().size(), result.Size() + 1);
+        EXPECT_EQ(result.Offsets().back(), result.Handles().size());
+        for (uint32 q = 0; q < result.Size(); q++)
+        {
+            std::vector<int32> ids;
+            for (auto it = result.begin(q); it != result.end(q); ++it)
+            {
+                ids.push_back(static_cast<test_proxy*>(tree.GetUserData(*it))->id);
+            }
+
+            std::sort(ids.begin(), ids.end());
+            EXPECT_EQ(ids, query_ids(tree, result.Boxes()[q]));
+        }
+    };
+
+    // a) each query matches the individual query
+    tree.Query(batch);
+    verify(batch);
+    EXPECT_FALSE(batch.Handles().empty());
+
+    // b) results are ordered the same when split across workers
+    std::vector<int32> serial = batch.Handles();
+    WorkerPool workers(3);
+    tree.Query(batch, &workers);
+    verify(batch);
+    EXPECT_EQ(batch.Handles(), serial);
+
+    // c) wide layout
+    tree.EnableWideLayout(true);
+    tree.UpdateWideLayout();
+    ASSERT_TRUE(tree.UsesWideLayout());
+    tree.Query(batch, &workers);
+    verify(batch);
+
+    // d) empty batch and empty tree
+    batch.Clear();
+    tree.Query(batch);
+    EXPECT_TRUE(batch.Handles().empty());
+
+    BVHTree empty;
+    batch.Add(aabb({ 0.f, 0.f }, { 1.f, 1.f }));
+    empty.Query(batch);
+    EXPECT_EQ(batch.Count(0), 0u);
+}
+
+} // anonymous namespace
@@ -2,7 +2,9 @@
 
 #include <rdge/math/vec2.hpp>
 #include <rdge/math/intrinsics.hpp>
+#include <rdge/physics/collision.hpp>
 #include <rdge/physics/shapes/circle.hpp>
+#include <rdge/physics/shapes/polygon.hpp>
 #include <rdge/physics/aabb.hpp>
 
 #include <exception>
@@ -35,3 +37,62 @@ TEST(CircleTest, ComputeMass)
     EXPECT_FLOAT_EQ(circle_mass.mass, 24.5078f);
     EXPECT_FLOAT_EQ(circle_mass.mmoi, 520.532f);
 }
+
+TEST(CircleTest, RayCast)
+{
+    circle c({ 5.f, 0.f }, 1.f);
+    ray_cast_output output;
+
+    // a) hit the near side
+    ray_cast_input input = { { 0.f, 0.f }, { 10.f, 0.f } };
+    EXPECT_TRUE(c.ray_cast(input, output));
+    EXPECT_FLOAT_EQ(output.fraction, 0.4f);
+    EXPECT_FLOAT_EQ(output.normal.x, -1.f);
+    EXPECT_FLOAT_EQ(output.normal.y, 0.f);
+
+    // b) max fraction stops short of the circle
+    input.max_fraction = 0.3f;
+    EXPECT_FALSE(c.ray_cast(input, output));
+
+    // c) miss
+    input = { { 0.f, 2.f }, { 10.f, 2.f } };
+    EXPECT_FALSE(c.ray_cast(input, output));
+
+    // d) origin inside the circle
+    input = { { 5.f, 0.f }, { 10.f, 0.f } };
+    EXPECT_FALSE(c.ray_cast(input, output));
+}
+
+TEST(CircleTest, ShapeCast)
+{
+    circle a({ 0.f, 0.f }, 1.f);
+    circle b({ 5.f, 0.f }, 1.f);
+    ray_cast_output output;
+
+    // a) circle hits circle
+    EXPECT_TRUE(shape_cast(&a, { 10.f, 0.f }, &b, 1.f, output));
+    EXPECT_FLOAT_EQ(output.fraction, 0.3f);
+    EXPECT_FLOAT_EQ(output.normal.x, -1.f);
+
+    // b) moving away
+    EXPECT_FALSE(shape_cast(&a, { -10.f, 0.f }, &b, 1.f, output));
+
+    // c) initial overlap
+    circle c({ 1.5f, 0.f }, 1.f);
+    EXPECT_TRUE(shape_cast(&a, { -10.f, 0.f }, &c, 1.f, output));
+    EXPECT_FLOAT_EQ(output.fraction, 0.f);
+
+    // d) circle hits box face
+    polygon box(1.f, 1.f, { 5.f, 0.f });
+    EXPECT_TRUE(shape_cast(&a, { 10.f, 0.f }, &box, 1.f, output));
+    EXPECT_FLOAT_EQ(output.fraction, 0.3f);
+    EXPECT_FLOAT_EQ(output.normal.x, -1.f);
+    EXPECT_FLOAT_EQ(output.normal.y, 0.f);
+
+    // e) circle hits box corner
+    a = circle({ 0.f, 1.5f }, 1.f);
+    EXPECT_TRUE(shape_cast(&a, { 10.f, 0.f }, &box, 1.f, output));
+    EXPECT_NEAR(output.fraction, 0.3133975f, 1e-5f);
+    EXPECT_NEAR(output.normal.x, -0.8660254f, 1e-5f);
+    EXPECT_NEAR(output.normal.y, 0.5f, 1e-5f);
+}
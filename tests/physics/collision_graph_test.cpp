@@ -0,0 +1,970 @@
+#include <gtest/gtest.h>
+
+#include <rdge/math/vec2.hpp>
+#include <rdge/physics/collision_graph.hpp>
+#include <rdge/physics/joints/revolute_joint.hpp>
+#include <rdge/physics/shapes/circle.hpp>
+#include <rdge/physics/shapes/polygon.hpp>
+#include <rdge/util/exception.hpp>
+#include <rdge/util/worker_pool.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using namespace rdge;
+using namespace rdge::math;
+using namespace rdge::physics;
+
+RigidBody*
+create_box (CollisionGraph& graph, RigidBodyType type, const vec2& pos, float he)
+{
+    rigid_body_profile profile;
+    profile.type = type;
+    profile.position = pos;
+
+    polygon box(he, he);
+    RigidBody* body = graph.CreateBody(profile);
+    body->CreateFixture(&box, (type == RigidBodyType::DYNAMIC) ? 1.f : 0.f);
+    return body;
+}
+
+TEST(CollisionGraphTest, VerifyBroadPhasePairs)
+{
+    CollisionGraph graph({ 0.f, -10.f });
+
+    // overlapping static bodies never create a contact
+    RigidBody* ground = create_box(graph, RigidBodyType::STATIC, { 0.f, 0.f }, 1.f);
+    RigidBody* wall = create_box(graph, RigidBodyType::STATIC, { 1.5f, 0.f }, 1.f);
+    RigidBody* box = create_box(graph, RigidBodyType::DYNAMIC, { 0.f, 1.9f }, 1.f);
+    RigidBody* other = create_box(graph, RigidBodyType::DYNAMIC, { 0.f, 3.8f }, 1.f);
+
+    graph.Step(1.f / 60.f);
+
+    EXPECT_EQ(ground->contact_edges.size(), 1u);
+    EXPECT_EQ(wall->contact_edges.size(), 1u);
+    EXPECT_EQ(box->contact_edges.size(), 3u);
+    EXPECT_EQ(other->contact_edges.size(), 1u);
+
+    // static bodies created after the first step are added to the broad phase
+    RigidBody* ledge = create_box(graph, RigidBodyType::STATIC, { 1.5f, 4.5f }, 1.f);
+    graph.Step(1.f / 60.f);
+
+    EXPECT_EQ(ledge->contact_edges.size(), 1u);
+    EXPECT_EQ(other->contact_edges.size(), 2u);
+}
+
+TEST(CollisionGraphTest, VerifyRayCast)
+{
+    CollisionGraph graph({ 0.f, 0.f });
+    create_box(graph, RigidBodyType::STATIC, { 0.f, 0.f }, 1.f);
+    RigidBody* box = create_box(graph, RigidBodyType::DYNAMIC, { 0.f, 5.f }, 1.f);
+    graph.Step(1.f / 60.f);
+
+    // a) closest hit is found across both trees
+    cast_hit hit;
+    EXPECT_TRUE(graph.RayCastClosest({ 0.f, 10.f }, { 0.f, -10.f }, hit));
+    EXPECT_EQ(hit.fixture->body, box);
+    EXPECT_FLOAT_EQ(hit.point.y, 6.f);
+    EXPECT_FLOAT_EQ(hit.normal.y, 1.f);
+
+    EXPECT_TRUE(graph.RayCastClosest({ 0.f, -10.f }, { 0.f, 10.f }, hit));
+    EXPECT_NE(hit.fixture->body, box);
+    EXPECT_FLOAT_EQ(hit.point.y, -1.f);
+
+    EXPECT_FALSE(graph.RayCastClosest({ 5.f, -10.f }, { 5.f, 10.f }, hit));
+
+    // b) shape cast stops on the top of the dynamic box
+    circle c({ 0.f, 10.f }, 0.5f);
+    EXPECT_TRUE(graph.ShapeCastClosest(&c, { 0.f, -20.f }, hit));
+    EXPECT_EQ(hit.fixture->body, box);
+    EXPECT_FLOAT_EQ(hit.point.y, 6.5f);
+}
+
+TEST(CollisionGraphTest, VerifyQueryAABB)
+{
+    CollisionGraph graph({ 0.f, 0.f });
+    RigidBody* ground = create_box(graph, RigidBodyType::STATIC, { 0.f, 0.f }, 1.f);
+    RigidBody* box = create_box(graph, RigidBodyType::DYNAMIC, { 0.f, 5.f }, 1.f);
+    graph.Step(1.f / 60.f);
+
+    std::vector<RigidBody*> found;
+    auto collect = [&](Fixture* fixture) {
+        found.push_back(fixture->body);
+        return true;
+    };
+
+    // a) fixtures are found in both broad phases
+    graph.QueryAABB(aabb({ -0.5f, -0.5f }, { 0.5f, 5.5f }), collect);
+    ASSERT_EQ(found.size(), 2u);
+    EXPECT_NE(std::find(found.begin(), found.end(), ground), found.end());
+    EXPECT_NE(std::find(found.begin(), found.end(), box), found.end());
+
+    found.clear();
+    graph.QueryAABB(aabb({ 0.f, 4.5f }, { 0.5f, 5.5f }), collect);
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_EQ(found[0], box);
+
+    found.clear();
+    graph.QueryAABB(aabb({ 5.f, 5.f }, { 6.f, 6.f }), collect);
+    EXPECT_TRUE(found.empty());
+
+    // b) returning false terminates the query across both broad phases
+    size_t visited = 0;
+    graph.QueryAABB(aabb({ -0.5f, -0.5f }, { 0.5f, 5.5f }), [&](Fixture*) {
+        visited++;
+        return false;
+    });
+
+    EXPECT_EQ(visited, 1u);
+}
+
+TEST(CollisionGraphTest, VerifyWarmStarting)
+{
+    CollisionGraph graph({ 0.f, -10.f });
+    create_box(graph, RigidBodyType::STATIC, { 0.f, 0.f }, 1.f);
+
+    std::vector<RigidBody*> stack;
+    for (int32 i = 0; i < 5; i++)
+    {
+        float y = static_cast<float>(i) + 1.5f;
+        stack.push_back(create_box(graph, RigidBodyType::DYNAMIC, { 0.f, y }, 0.5f));
+    }
+
+    for (int32 i = 0; i < 60; i++)
+    {
+        graph.Step(1.f / 60.f);
+    }
+
+    // a) accumulated impulses persist and support the weight of the stack
+    Contact* ground_contact = nullptr;
+    stack.front()->contact_edges.for_each([&](auto* edge) {
+        if (edge->other->IsStatic())
+        {
+            ground_contact = edge->contact;
+        }
+    });
+
+    ASSERT_NE(ground_contact, nullptr);
+    ASSERT_EQ(ground_contact->impulse.count, 2u);
+    float total = ground_contact->impulse.normals[0] + ground_contact->impulse.normals[1];
+    EXPECT_NEAR(total, 5.f * 10.f / 60.f, 0.05f);
+
+    // b) stack comes to rest and falls asleep
+    for (int32 i = 0; i < 240; i++)
+    {
+        graph.Step(1.f / 60.f);
+    }
+
+    for (size_t i = 0; i < stack.size(); i++)
+    {
+        EXPECT_FALSE(stack[i]->IsAwake());
+        EXPECT_NEAR(stack[i]->GetWorldCenter().x, 0.f, 0.01f);
+        EXPECT_NEAR(stack[i]->GetWorldCenter().y, static_cast<float>(i) + 1.5f, 0.05f);
+    }
+}
+
+TEST(CollisionGraphTest, VerifyAwakeSets)
+{
+    CollisionGraph graph({ 0.f, -10.f });
+    create_box(graph, RigidBodyType::STATIC, { 0.f, -20.f }, 20.f);
+
+    std::vector<RigidBody*> stack;
+    for (int32 i = 0; i < 3; i++)
+    {
+        float y = (static_cast<float>(i) * 1.05f) + 0.55f;
+        stack.push_back(create_box(graph, RigidBodyType::DYNAMIC, { -5.f, y }, 0.5f));
+    }
+
+    RigidBody* single = create_box(graph, RigidBodyType::DYNAMIC, { 5.f, 0.55f }, 0.5f);
+
+    // a) static bodies are never in the awake set
+    EXPECT_EQ(graph.AwakeBodyCount(), 4u);
+
+    graph.Step(1.f / 60.f);
+    EXPECT_EQ(graph.ContactCount(), 4u);
+    EXPECT_EQ(graph.AwakeContactCount(), 4u);
+
+    // b) sleeping islands leave the awake sets
+    for (int32 i = 0; i < 300; i++)
+    {
+        graph.Step(1.f / 60.f);
+    }
+
+    EXPECT_FALSE(single->IsAwake());
+    EXPECT_EQ(graph.AwakeBodyCount(), 0u);
+    EXPECT_EQ(graph.AwakeContactCount(), 0u);
+    EXPECT_EQ(graph.ContactCount(), 4u);
+    EXPECT_EQ(graph.stats.Last().bodies_awake, 0u);
+
+    // c) waking a body only brings back its own contacts
+    single->WakeUp();
+    EXPECT_EQ(graph.AwakeBodyCount(), 1u);
+    EXPECT_EQ(graph.AwakeContactCount(), 1u);
+
+    graph.Step(1.f / 60.f);
+    EXPECT_EQ(graph.stats.Last().bodies_awake, 1u);
+    for (auto* body : stack)
+    {
+        EXPECT_FALSE(body->IsAwake());
+    }
+
+    // d) contact with a sleeping island wakes the whole island
+    RigidBody* dropped = create_box(graph, RigidBodyType::DYNAMIC, { -5.f, 4.f }, 0.5f);
+    for (int32 i = 0; i < 30; i++)
+    {
+        graph.Step(1.f / 60.f);
+    }
+
+    for (auto* body : stack)
+    {
+        EXPECT_TRUE(body->IsAwake());
+    }
+
+    EXPECT_TRUE(dropped->IsAwake());
+    EXPECT_EQ(graph.ContactCount(), 5u);
+
+    // e) destroying bodies removes them from the awake sets
+    graph.DestroyBody(dropped);
+    graph.DestroyBody(single);
+    EXPECT_EQ(graph.AwakeBodyCount(), 3u);
+    EXPECT_EQ(graph.AwakeContactCount(), 3u);
+    EXPECT_EQ(graph.ContactCount(), 3u);
+
+    for (int32 i = 0; i < 300; i++)
+    {
+        graph.Step(1.f / 60.f);
+    }
+
+    EXPECT_EQ(graph.AwakeBodyCount(), 0u);
+    EXPECT_EQ(graph.AwakeContactCount(), 0u);
+}
+
+TEST(CollisionGraphTest, VerifyFilterChanges)
+{
+    CollisionGraph graph({ 0.f, -10.f });
+    ContactFilter filter;
+    graph.custom_filter = &filter;
+
+    create_box(graph, RigidBodyType::STATIC, { 0.f, -20.f }, 20.f);
+    RigidBody* awake = create_box(graph, RigidBodyType::DYNAMIC, { -5.f, 0.55f }, 0.5f);
+    RigidBody* asleep = create_box(graph, RigidBodyType::DYNAMIC, { 5.f, 0.55f }, 0.5f);
+
+    for (int32 i = 0; i < 300; i++)
+    {
+        graph.Step(1.f / 60.f);
+    }
+
+    awake->WakeUp();
+    ASSERT_TRUE(awake->IsAwake());
+    ASSERT_FALSE(asleep->IsAwake());
+    EXPECT_EQ(graph.ContactCount(), 2u);
+
+    // a) contacts of awake fixtures are filtered on the next step
+    collision_filter none;
+    none.mask = 0;
+    awake->fixtures.front().SetFilter(none);
+    graph.Step(1.f / 60.f);
+    EXPECT_EQ(graph.ContactCount(), 1u);
+
+    // b) sleeping contacts are filtered once the body wakes
+    asleep->fixtures.front().SetFilter(none);
+    graph.Step(1.f / 60.f);
+    EXPECT_EQ(graph.ContactCount(), 1u);
+
+    asleep->WakeUp();
+    graph.Step(1.f / 60.f);
+    EXPECT_EQ(graph.ContactCount(), 0u);
+
+    for (int32 i = 0; i < 30; i++)
+    {
+        graph.Step(1.f / 60.f);
+    }
+
+    EXPECT_LT(awake->GetWorldCenter().y, 0.f);
+    EXPECT_LT(asleep->GetWorldCenter().y, 0.f);
+}
+
+TEST(CollisionGraphTest, VerifyStateReuse)
+{
+    CollisionGraph graph({ 0.f, 0.f });
+
+    // a) released body states are reused without disturbing other bodies
+    std::vector<RigidBody*> bodies;
+    for (int32 i = 0; i < 4; i++)
+    {
+        bodies.push_back(create_box(graph, RigidBodyType::DYNAMIC, { static_cast<float>(i) * 3.f, 0.f }, 0.5f));
+        bodies.back()->SetLinearVelocity({ 0.f, static_cast<float>(i + 1) });
+    }
+
+    graph.Step(1.f / 60.f);
+    graph.DestroyBody(bodies[1]);
+    RigidBody* added = create_box(graph, RigidBodyType::DYNAMIC, { 20.f, 0.f }, 0.5f);
+    added->SetLinearVelocity({ -1.f, 0.f });
+    graph.Step(1.f / 60.f);
+
+    EXPECT_FLOAT_EQ(bodies[0]->GetLinearVelocity().y, 1.f);
+    EXPECT_FLOAT_EQ(bodies[2]->GetLinearVelocity().y, 3.f);
+    EXPECT_FLOAT_EQ(bodies[3]->GetLinearVelocity().y, 4.f);
+    EXPECT_FLOAT_EQ(added->GetLinearVelocity().x, -1.f);
+    EXPECT_NEAR(bodies[2]->GetWorldCenter().y, 3.f * 2.f / 60.f, 0.0001f);
+    EXPECT_NEAR(added->GetWorldCenter().x, 20.f - (1.f / 60.f), 0.0001f);
+
+    // b) a released contact state is reused by the next contact
+    RigidBody* base = create_box(graph, RigidBodyType::DYNAMIC, { 50.f, 0.f }, 0.5f);
+    RigidBody* first = create_box(graph, RigidBodyType::DYNAMIC, { 50.f, 0.9f }, 0.5f);
+    graph.Step(1.f / 60.f);
+    ASSERT_EQ(graph.ContactCount(), 1u);
+
+    graph.DestroyBody(first);
+    EXPECT_EQ(graph.ContactCount(), 0u);
+
+    RigidBody* second = create_box(graph, RigidBodyType::DYNAMIC, { 50.9f, 0.f }, 0.5f);
+    graph.Step(1.f / 60.f);
+    ASSERT_EQ(graph.ContactCount(), 1u);
+
+    const Contact* contact = base->contact_edges.front().contact;
+    EXPECT_TRUE(contact->IsTouching());
+    EXPECT_EQ(contact->GetManifold().count, 2u);
+    EXPECT_NE(contact->GetFixtureA(), contact->GetFixtureB());
+    for (const Fixture* fixture : { contact->GetFixtureA(), contact->GetFixtureB() })
+    {
+        EXPECT_TRUE(fixture->body == base || fixture->body == second);
+    }
+}
+
+TEST(CollisionGraphTest, VerifyBroadPhaseFilter)
+{
+    for (auto type : { BroadPhaseType::BVH, BroadPhaseType::SPATIAL_HASH })
+    {
+        CollisionGraph graph({ 0.f, 0.f });
+        graph.SetBroadPhase(type, type);
+
+        // overlapping bodies which can never collide
+        create_box(graph, RigidBodyType::STATIC, { 0.f, 0.f }, 1.f);
+        create_box(graph, RigidBodyType::KINEMATIC, { 0.5f, 0.f }, 1.f);
+        RigidBody* a = create_box(graph, RigidBodyType::DYNAMIC, { 5.f, 0.f }, 1.f);
+        create_box(graph, RigidBodyType::DYNAMIC, { 5.5f, 0.f }, 1.f);
+
+        collision_filter none;
+        none.mask = 0;
+        a->fixtures.front().SetFilter(none);
+
+        // a) filtered pairs never reach the pair buffer
+        graph.Step(1.f / 60.f);
+        EXPECT_EQ(graph.stats.Last().pairs_tested, 0u);
+        EXPECT_EQ(graph.ContactCount(), 0u);
+
+        // b) changing the filter finds the pair without moving the proxy
+        a->fixtures.front().SetFilter(collision_filter());
+        graph.Step(1.f / 60.f);
+        EXPECT_EQ(graph.stats.Last().pairs_tested, 1u);
+        EXPECT_EQ(graph.ContactCount(), 1u);
+
+        // c) custom filters see every pair unless they opt in to the rule
+        struct accept_all : public ContactFilter
+        {
+            bool ShouldCollide (Fixture*, Fixture*) const noexcept override { return true; }
+        } custom;
+
+        graph.custom_filter = &custom;
+        a->fixtures.front().SetFilter(none);
+        graph.Step(1.f / 60.f);
+        EXPECT_EQ(graph.stats.Last().pairs_tested, 1u);
+        EXPECT_EQ(graph.ContactCount(), 1u);
+
+        struct default_rule : public ContactFilter
+        {
+            bool UsesDefaultRule (void) const noexcept override { return true; }
+        } opt_in;
+
+        graph.custom_filter = &opt_in;
+        a->fixtures.front().Refilter();
+        graph.Step(1.f / 60.f);
+        EXPECT_EQ(graph.stats.Last().pairs_tested, 0u);
+        EXPECT_EQ(graph.ContactCount(), 0u);
+    }
+}
+
+TEST(CollisionGraphTest, VerifySensorOverlaps)
+{
+    struct sensor_listener : public GraphListener
+    {
+        void OnSensorBegin (const sensor_event* events, size_t count) override
+        {
+            begin.insert(begin.end(), events, events + count);
+        }
+
+        void OnSensorEnd (const sensor_event* events, size_t count) override
+        {
+            end.insert(end.end(), events, events + count);
+        }
+
+        std::vector<sensor_event> begin;
+        std::vector<sensor_event> end;
+    } listener;
+
+    CollisionGraph graph({ 0.f, 0.f });
+    graph.listener = &listener;
+
+    polygon trigger_shape(1.f, 1.f);
+    fixture_profile trigger_profile;
+    trigger_profile.shape = &trigger_shape;
+    trigger_profile.is_sensor = true;
+
+    RigidBody* trigger = graph.CreateBody(rigid_body_profile());
+    Fixture* sensor = trigger->CreateFixture(trigger_profile);
+
+    // a) bodies passing through the sensor report a single begin and end
+    rigid_body_profile profile;
+    profile.type = RigidBodyType::DYNAMIC;
+    profile.position = { 5.f, 0.f };
+    profile.linear_velocity = { -30.f, 0.f };
+
+    polygon box(0.5f, 0.5f);
+    RigidBody* body = graph.CreateBody(profile);
+    Fixture* visitor = body->CreateFixture(&box, 1.f);
+
+    for (int32 i = 0; i < 40; i++)
+    {
+        graph.Step(1.f / 60.f);
+        EXPECT_EQ(graph.ContactCount(), 0u);
+    }
+
+    ASSERT_EQ(listener.begin.size(), 1u);
+    ASSERT_EQ(listener.end.size(), 1u);
+    EXPECT_EQ(listener.begin[0].sensor, sensor);
+    EXPECT_EQ(listener.begin[0].visitor, visitor);
+    EXPECT_EQ(listener.end[0].sensor, sensor);
+    EXPECT_EQ(listener.end[0].visitor, visitor);
+    EXPECT_FLOAT_EQ(body->GetLinearVelocity().x, -30.f);
+    EXPECT_EQ(graph.SensorOverlapCount(), 0u);
+
+    // b) the pair moves between the overlaps and the contacts with the flag
+    graph.DestroyBody(body);
+    profile.position = { 0.5f, 0.f };
+    profile.linear_velocity = { 0.f, 0.f };
+    body = graph.CreateBody(profile);
+    visitor = body->CreateFixture(&box, 1.f);
+    listener.begin.clear();
+    listener.end.clear();
+
+    graph.Step(1.f / 60.f);
+    EXPECT_EQ(listener.begin.size(), 1u);
+    EXPECT_EQ(graph.SensorOverlapCount(), 1u);
+    EXPECT_EQ(graph.ContactCount(), 0u);
+
+    sensor->SetSensor(false);
+    graph.Step(1.f / 60.f);
+    EXPECT_EQ(listener.end.size(), 1u);
+    EXPECT_EQ(graph.SensorOverlapCount(), 0u);
+    EXPECT_EQ(graph.ContactCount(), 1u);
+
+    sensor->SetSensor(true);
+    graph.Step(1.f / 60.f);
+    EXPECT_EQ(listener.begin.size(), 2u);
+    EXPECT_EQ(graph.SensorOverlapCount(), 1u);
+    EXPECT_EQ(graph.ContactCount(), 0u);
+
+    // c) refiltered fixtures with only sensor overlaps are flagged clean
+    visitor->SetFilter(collision_filter());
+    graph.Step(1.f / 60.f);
+    EXPECT_EQ(graph.SensorOverlapCount(), 1u);
+    EXPECT_FALSE(sensor->IsFilterDirty());
+    EXPECT_FALSE(visitor->IsFilterDirty());
+
+    // d) destroyed fixtures remove their overlaps without an event
+    graph.DestroyBody(body);
+    graph.Step(1.f / 60.f);
+    EXPECT_EQ(listener.end.size(), 1u);
+    EXPECT_EQ(graph.SensorOverlapCount(), 0u);
+}
+
+TEST(CollisionGraphTest, VerifyWideSolver)
+{
+    // pyramid large enough for the contacts to be bundled
+    CollisionGraph graph({ 0.f, -10.f });
+    graph.EnableWideSolver();
+    create_box(graph, RigidBodyType::STATIC, { 0.f, 0.f }, 20.f);
+
+    std::vector<RigidBody*> bodies;
+    std::vector<vec2> expected;
+    for (int32 row = 0; row < 8; row++)
+    {
+        for (int32 i = 0; i < (8 - row); i++)
+        {
+            float x = (static_cast<float>(row) * 0.55f) + (static_cast<float>(i) * 1.1f) - 4.f;
+            float y = 20.51f + static_cast<float>(row) * 1.01f;
+            bodies.push_back(create_box(graph, RigidBodyType::DYNAMIC, { x, y }, 0.5f));
+            expected.push_back({ x, 20.5f + static_cast<float>(row) });
+        }
+    }
+
+    for (int32 i = 0; i < 300; i++)
+    {
+        graph.Step(1.f / 60.f);
+    }
+
+    float total = 0.f;
+    for (size_t i = 0; i < bodies.size(); i++)
+    {
+        EXPECT_FALSE(bodies[i]->IsAwake());
+        EXPECT_NEAR(bodies[i]->GetWorldCenter().x, expected[i].x, 0.05f);
+        EXPECT_NEAR(bodies[i]->GetWorldCenter().y, expected[i].y, 0.1f);
+
+        bodies[i]->contact_edges.for_each([&](auto* edge) {
+            if (edge->other->IsStatic())
+            {
+                const auto& impulse = edge->contact->impulse;
+                for (size_t p = 0; p < impulse.count; p++)
+                {
+                    total += impulse.normals[p];
+                }
+            }
+        });
+    }
+
+    // ground supports the weight of the pyramid
+    EXPECT_NEAR(total, static_cast<float>(bodies.size()) * 10.f / 60.f, 0.1f);
+}
+
+TEST(CollisionGraphTest, VerifyBlockSolver)
+{
+    // towers are the worst case for sequential impulses, where solving one
+    // point of each contact at a time slowly tips the tower over
+    auto build = [](CollisionGraph& graph) {
+        create_box(graph, RigidBodyType::STATIC, { 0.f, 0.f }, 20.f);
+
+        std::vector<RigidBody*> bodies;
+        for (int32 i = 0; i < 10; i++)
+        {
+            float y = 20.5f + static_cast<float>(i);
+            bodies.push_back(create_box(graph, RigidBodyType::DYNAMIC, { 0.f, y }, 0.5f));
+        }
+
+        for (int32 i = 0; i < 300; i++)
+        {
+            graph.Step(1.f / 60.f);
+        }
+
+        return bodies;
+    };
+
+    CollisionGraph block_graph({ 0.f, -10.f });
+    auto bodies = build(block_graph);
+    for (size_t i = 0; i < bodies.size(); i++)
+    {
+        EXPECT_FALSE(bodies[i]->IsAwake());
+        EXPECT_NEAR(bodies[i]->GetWorldCenter().x, 0.f, 0.001f);
+        EXPECT_NEAR(bodies[i]->GetAngle(), 0.f, 0.001f);
+    }
+
+    // both points of the ground contact carry an equal share of the weight
+    bodies.front()->contact_edges.for_each([&](auto* edge) {
+        if (edge->other->IsStatic())
+        {
+            const auto& impulse = edge->contact->impulse;
+            ASSERT_EQ(impulse.count, 2u);
+            EXPECT_NEAR(impulse.normals[0], impulse.normals[1], 0.001f);
+            EXPECT_NEAR(impulse.normals[0] + impulse.normals[1], 10.f * 10.f / 60.f, 0.01f);
+        }
+    });
+
+    CollisionGraph sequential_graph({ 0.f, -10.f });
+    sequential_graph.DisableBlockSolver();
+    auto sequential = build(sequential_graph);
+    EXPECT_GT(std::abs(sequential.back()->GetWorldCenter().x),
+              std::abs(bodies.back()->GetWorldCenter().x));
+}
+
+TEST(CollisionGraphTest, VerifySoftStep)
+{
+    // swinging chain, where the iterative solver stretches the joints
+    auto build_chain = [](CollisionGraph& graph) {
+        RigidBody* prev = create_box(graph, RigidBodyType::STATIC, { 0.f, 20.f }, 0.1f);
+
+        std::vector<RevoluteJoint*> joints;
+        for (int32 i = 0; i < 20; i++)
+        {
+            rigid_body_profile profile;
+            profile.type = RigidBodyType::DYNAMIC;
+            profile.position = { static_cast<float>(i) + 0.5f, 20.f };
+
+            polygon link(0.5f, 0.1f);
+            RigidBody* body = graph.CreateBody(profile);
+            body->CreateFixture(&link, 1.f);
+
+            joints.push_back(graph.CreateRevoluteJoint(prev, body, { static_cast<float>(i), 20.f }));
+            prev = body;
+        }
+
+        for (int32 i = 0; i < 600; i++)
+        {
+            graph.Step(1.f / 60.f);
+        }
+
+        float max_error = 0.f;
+        for (auto* joint : joints)
+        {
+            max_error = std::max(max_error, (joint->AnchorA() - joint->AnchorB()).length());
+        }
+
+        return max_error;
+    };
+
+    CollisionGraph soft_graph({ 0.f, -10.f });
+    soft_graph.EnableSoftStep();
+    float soft_error = build_chain(soft_graph);
+    EXPECT_LT(soft_error, 0.01f);
+
+    CollisionGraph iterative_graph({ 0.f, -10.f });
+    EXPECT_GT(build_chain(iterative_graph), soft_error);
+
+    // reported impulses are the total of all substeps
+    CollisionGraph graph({ 0.f, -10.f });
+    graph.EnableSoftStep();
+    graph.SetSubsteps(8);
+    create_box(graph, RigidBodyType::STATIC, { 0.f, 0.f }, 20.f);
+
+    std::vector<RigidBody*> bodies;
+    for (int32 i = 0; i < 5; i++)
+    {
+        float y = 20.5f + static_cast<float>(i);
+        bodies.push_back(create_box(graph, RigidBodyType::DYNAMIC, { 0.f, y }, 0.5f));
+    }
+
+    for (int32 i = 0; i < 300; i++)
+    {
+        graph.Step(1.f / 60.f);
+    }
+
+    for (size_t i = 0; i < bodies.size(); i++)
+    {
+        EXPECT_FALSE(bodies[i]->IsAwake());
+        EXPECT_NEAR(bodies[i]->GetWorldCenter().x, 0.f, 0.01f);
+        EXPECT_NEAR(bodies[i]->GetWorldCenter().y, 20.5f + static_cast<float>(i), 0.05f);
+    }
+
+    float total = 0.f;
+    bodies.front()->contact_edges.for_each([&](auto* edge) {
+        if (edge->other->IsStatic())
+        {
+            const auto& impulse = edge->contact->impulse;
+            for (size_t p = 0; p < impulse.count; p++)
+            {
+                total += impulse.normals[p];
+            }
+        }
+    });
+
+    EXPECT_NEAR(total, 5.f * 10.f / 60.f, 0.01f);
+}
+
+TEST(CollisionGraphTest, VerifyBullets)
+{
+    // projectiles travel further than the wall thickness every step
+    CollisionGraph graph({ 0.f, 0.f });
+
+    rigid_body_profile profile;
+    RigidBody* wall = graph.CreateBody(profile);
+    polygon wall_shape(0.05f, 4.f);
+    wall->CreateFixture(&wall_shape, 0.f);
+
+    circle round(0.1f);
+    polygon square(0.1f, 0.1f);
+    auto create_projectile = [&](ishape* shape, float y, bool bullet) {
+        rigid_body_profile p;
+        p.type = RigidBodyType::DYNAMIC;
+        p.position = { -1.f, y };
+        p.linear_velocity = { 100.f, 0.f };
+        p.bullet = bullet;
+
+        RigidBody* body = graph.CreateBody(p);
+        body->CreateFixture(shape, 1.f);
+        return body;
+    };
+
+    RigidBody* circle_body = create_projectile(&round, -3.f, false);
+    RigidBody* box_body = create_projectile(&square, -1.f, false);
+    RigidBody* circle_bullet = create_projectile(&round, 1.f, true);
+    RigidBody* box_bullet = create_projectile(&square, 3.f, true);
+    EXPECT_TRUE(circle_bullet->IsBullet());
+    EXPECT_FALSE(circle_body->IsBullet());
+
+    for (int32 i = 0; i < 60; i++)
+    {
+        graph.Step(1.f / 60.f);
+    }
+
+    // without continuous collision the projectiles pass through the wall
+    EXPECT_GT(circle_body->GetWorldCenter().x, 0.f);
+    EXPECT_GT(box_body->GetWorldCenter().x, 0.f);
+
+    // bullets stop at the wall, and are pushed back by the regular solver
+    EXPECT_LT(circle_bullet->GetWorldCenter().x, -0.1f);
+    EXPECT_LT(box_bullet->GetWorldCenter().x, -0.1f);
+    EXPECT_NEAR(circle_bullet->GetWorldCenter().y, 1.f, 0.01f);
+    EXPECT_NEAR(box_bullet->GetWorldCenter().y, 3.f, 0.01f);
+}
+
+TEST(CollisionGraphTest, VerifyFixedStep)
+{
+    constexpr float step = 1.f / 60.f;
+    CollisionGraph graph({ 0.f, -10.f });
+    CollisionGraph reference({ 0.f, -10.f });
+    graph.SetFixedStep(step);
+    RigidBody* body = create_box(graph, RigidBodyType::DYNAMIC, { 0.f, 10.f }, 0.5f);
+    RigidBody* expected = create_box(reference, RigidBodyType::DYNAMIC, { 0.f, 10.f }, 0.5f);
+    EXPECT_EQ(graph.GetFixedStep(), step);
+
+    // time is accumulated until a whole step is available
+    EXPECT_EQ(graph.Update(0.01f), 0u);
+    EXPECT_NEAR(graph.GetInterpolationAlpha(), 0.6f, 1e-4f);
+    EXPECT_EQ(body->GetWorldCenter(), vec2(0.f, 10.f));
+
+    EXPECT_EQ(graph.Update(0.01f), 1u);
+    reference.Step(step);
+    EXPECT_NEAR(graph.GetInterpolationAlpha(), 0.2f, 1e-4f);
+    EXPECT_EQ(body->GetWorldCenter(), expected->GetWorldCenter());
+
+    // interpolated between the state before and after the last step
+    float alpha = graph.GetInterpolationAlpha();
+    iso_transform xf = body->GetInterpolatedTransform(alpha);
+    float y = 10.f + ((body->GetWorldCenter().y - 10.f) * alpha);
+    EXPECT_NEAR(xf.pos.x, 0.f, 1e-5f);
+    EXPECT_NEAR(xf.pos.y, y, 1e-5f);
+    EXPECT_EQ(body->GetInterpolatedTransform(1.f).pos, body->GetPosition());
+
+    // steps are limited per update, and the remaining whole steps discarded
+    EXPECT_EQ(graph.Update(1.f), graph.max_fixed_steps);
+    for (size_t i = 0; i < graph.max_fixed_steps; i++)
+    {
+        reference.Step(step);
+    }
+
+    EXPECT_EQ(body->GetWorldCenter(), expected->GetWorldCenter());
+    EXPECT_GE(graph.GetInterpolationAlpha(), 0.f);
+    EXPECT_LT(graph.GetInterpolationAlpha(), 1.f);
+}
+
+struct recording_listener : public GraphListener
+{
+    void OnContactStart (Contact* c) override { events.push_back({ 0, c->GetFixtureA() }); }
+    void OnContactEnd (Contact* c) override { events.push_back({ 1, c->GetFixtureA() }); }
+    void OnPreSolve (Contact* c, const collision_manifold&) override { events.push_back({ 2, c->GetFixtureA() }); }
+
+    std::vector<std::pair<int32, Fixture*>> events;
+};
+
+TEST(CollisionGraphTest, VerifyParallelIslands)
+{
+    // Several separate stacks on a shared ground form independent islands,
+    // which must produce the same results whether solved serially or not
+    auto build = [](CollisionGraph& graph) {
+        std::vector<RigidBody*> bodies;
+        create_box(graph, RigidBodyType::STATIC, { 0.f, -1.f }, 50.f);
+        for (int32 i = 0; i < 8; i++)
+        {
+            for (int32 j = 0; j < 4; j++)
+            {
+                float x = static_cast<float>(i) * 5.f - 20.f;
+                float y = static_cast<float>(j) * 1.1f + 49.6f;
+                bodies.push_back(create_box(graph, RigidBodyType::DYNAMIC, { x, y }, 0.5f));
+            }
+        }
+
+        return bodies;
+    };
+
+    // listeners must outlive the graphs
+    recording_listener serial_events;
+    recording_listener parallel_events;
+
+    CollisionGraph serial({ 0.f, -10.f });
+    CollisionGraph parallel({ 0.f, -10.f });
+    auto serial_bodies = build(serial);
+    auto parallel_bodies = build(parallel);
+
+    serial.listener = &serial_events;
+    parallel.listener = &parallel_events;
+
+    WorkerPool pool(3);
+    parallel.workers = &pool;
+    for (int32 i = 0; i < 120; i++)
+    {
+        serial.Step(1.f / 60.f);
+        parallel.Step(1.f / 60.f);
+    }
+
+    // listener events are sent in the same order
+    ASSERT_EQ(serial_events.events.size(), parallel_events.events.size());
+    EXPECT_FALSE(serial_events.events.empty());
+    for (size_t i = 0; i < serial_events.events.size(); i++)
+    {
+        const auto& s = serial_events.events[i];
+        const auto& p = parallel_events.events[i];
+        EXPECT_EQ(s.first, p.first);
+        EXPECT_EQ(s.second->body->GetWorldCenter(), p.second->body->GetWorldCenter());
+    }
+
+    for (size_t i = 0; i < serial_bodies.size(); i++)
+    {
+        EXPECT_EQ(serial_bodies[i]->GetWorldCenter(), parallel_bodies[i]->GetWorldCenter());
+        EXPECT_EQ(serial_bodies[i]->IsAwake(), parallel_bodies[i]->IsAwake());
+    }
+}
+
+TEST(CollisionGraphTest, VerifySnapshot)
+{
+    CollisionGraph graph({ 0.f, -10.f });
+    std::vector<RigidBody*> bodies;
+    create_box(graph, RigidBodyType::STATIC, { 0.f, -1.f }, 20.f);
+    for (int32 i = 0; i < 6; i++)
+    {
+        float x = static_cast<float>(i % 2) * 0.2f;
+        float y = static_cast<float>(i) * 1.1f + 19.6f;
+        bodies.push_back(create_box(graph, RigidBodyType::DYNAMIC, { x, y }, 0.5f));
+    }
+
+    RigidBody* anchor = create_box(graph, RigidBodyType::STATIC, { 10.f, 10.f }, 0.25f);
+    RigidBody* pendulum = create_box(graph, RigidBodyType::DYNAMIC, { 12.f, 10.f }, 0.25f);
+    graph.CreateRevoluteJoint(anchor, pendulum, { 10.f, 10.f });
+    bodies.push_back(pendulum);
+
+    auto capture = [&]() {
+        std::vector<std::pair<vec2, float>> result;
+        for (auto* b : bodies)
+        {
+            result.emplace_back(b->GetWorldCenter(), b->GetAngle());
+        }
+
+        return result;
+    };
+
+    // the boxes have landed, but continue to make and break contacts
+    for (int32 i = 0; i < 120; i++)
+    {
+        graph.Step(1.f / 60.f);
+    }
+
+    graph_snapshot snapshot;
+    graph.Snapshot(snapshot);
+    EXPECT_FALSE(snapshot.empty());
+    auto before = capture();
+
+    for (int32 i = 0; i < 60; i++)
+    {
+        graph.Step(1.f / 60.f);
+    }
+
+    auto first_run = capture();
+    EXPECT_NE(before, first_run);
+
+    // a) state returns to the snapshot
+    graph.Restore(snapshot);
+    EXPECT_EQ(capture(), before);
+
+    // b) stepping from the restored state replays the same simulation
+    for (int32 i = 0; i < 60; i++)
+    {
+        graph.Step(1.f / 60.f);
+    }
+
+    EXPECT_EQ(capture(), first_run);
+
+    // c) snapshots are rejected once the graph has changed
+    RigidBody* extra = create_box(graph, RigidBodyType::DYNAMIC, { -10.f, 10.f }, 0.5f);
+    EXPECT_THROW(graph.Restore(snapshot), rdge::Exception);
+    graph.DestroyBody(extra);
+    graph.Restore(snapshot);
+    EXPECT_EQ(capture(), before);
+
+    graph_snapshot truncated = snapshot;
+    truncated.data.resize(truncated.size() / 2);
+    EXPECT_THROW(graph.Restore(truncated), rdge::Exception);
+    EXPECT_EQ(capture(), before);
+}
+
+TEST(CollisionGraphTest, VerifySpatialHashBroadPhase)
+{
+    // boxes and balls dropped onto a tile ground
+    auto build = [](CollisionGraph& graph) {
+        rigid_body_profile profile;
+        RigidBody* ground = graph.CreateBody(profile);
+        for (int32 j = 0; j < 2; j++)
+        {
+            for (int32 i = -20; i < 20; i++)
+            {
+                polygon tile(0.5f, 0.5f, { static_cast<float>(i) + 0.5f, -0.5f - static_cast<float>(j) });
+                ground->CreateFixture(&tile, 0.f);
+            }
+        }
+
+        std::vector<RigidBody*> bodies;
+        circle ball(0.4f);
+        for (int32 i = 0; i < 12; i++)
+        {
+            float x = static_cast<float>(i) * 2.7f - 15.f;
+            if (i % 2 == 0)
+            {
+                bodies.push_back(create_box(graph, RigidBodyType::DYNAMIC, { x, 2.f }, 0.5f));
+            }
+            else
+            {
+                rigid_body_profile bprof;
+                bprof.type = RigidBodyType::DYNAMIC;
+                bprof.position = { x, 3.f };
+                bodies.push_back(graph.CreateBody(bprof));
+                bodies.back()->CreateFixture(&ball, 1.f);
+            }
+        }
+
+        return bodies;
+    };
+
+    CollisionGraph tree_graph({ 0.f, -10.f });
+    CollisionGraph grid_graph({ 0.f, -10.f });
+    grid_graph.SetBroadPhase(BroadPhaseType::SPATIAL_HASH, BroadPhaseType::SPATIAL_HASH, { 1.f, 1.f });
+
+    auto tree_bodies = build(tree_graph);
+    auto grid_bodies = build(grid_graph);
+    for (int32 i = 0; i < 120; i++)
+    {
+        tree_graph.Step(1.f / 60.f);
+        grid_graph.Step(1.f / 60.f);
+    }
+
+    // a) both broad phases find the same contacts (contact order differs, so
+    //    the results are not bitwise identical)
+    EXPECT_EQ(tree_graph.ContactCount(), grid_graph.ContactCount());
+    for (size_t i = 0; i < tree_bodies.size(); i++)
+    {
+        EXPECT_EQ(tree_bodies[i]->contact_edges.size(), grid_bodies[i]->contact_edges.size());
+        EXPECT_NEAR(tree_bodies[i]->GetWorldCenter().x, grid_bodies[i]->GetWorldCenter().x, 0.01f);
+        EXPECT_NEAR(tree_bodies[i]->GetWorldCenter().y, grid_bodies[i]->GetWorldCenter().y, 0.01f);
+    }
+
+    // b) ray casts report the same closest fixture
+    auto closest = [](const CollisionGraph& graph) {
+        float result = 1.f;
+        graph.RayCast({ -18.f, 5.f }, { 18.f, -5.f }, [&](Fixture*, const vec2&, const vec2&, float fraction) {
+            result = fraction;
+            return fraction;
+        });
+
+        return result;
+    };
+
+    EXPECT_LT(closest(grid_graph), 1.f);
+    EXPECT_NEAR(closest(tree_graph), closest(grid_graph), 0.0001f);
+
+    // c) the broad phase can only be changed while the graph is empty
+    EXPECT_THROW(grid_graph.SetBroadPhase(BroadPhaseType::BVH, BroadPhaseType::BVH), rdge::Exception);
+    grid_graph.ClearGraph();
+    grid_graph.SetBroadPhase(BroadPhaseType::BVH, BroadPhaseType::BVH);
+}
+
+} // anonymous namespace
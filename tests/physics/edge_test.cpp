@@ -0,0 +1,316 @@
+#include <gtest/gtest.h>
+
+#include <rdge/math/vec2.hpp>
+#include <rdge/physics/collision.hpp>
+#include <rdge/physics/collision_graph.hpp>
+#include <rdge/physics/tile_colliders.hpp>
+#include <rdge/physics/shapes/circle.hpp>
+#include <rdge/physics/shapes/edge.hpp>
+#include <rdge/physics/shapes/polygon.hpp>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace rdge;
+using namespace rdge::math;
+using namespace rdge::physics;
+
+// Twice the signed area (positive for CCW)
+float
+signed_area (const TileChain& chain)
+{
+    float result = 0.f;
+    for (size_t i = 0; i < chain.size(); i++)
+    {
+        result += perp_dot(chain[i], chain[(i + 1) % chain.size()]);
+    }
+
+    return result * 0.5f;
+}
+
+TEST(EdgeTest, HandlesConstruction)
+{
+    edge two_sided({ -1.f, 0.f }, { 1.f, 0.f });
+    EXPECT_EQ(two_sided.type(), ShapeType::EDGE);
+    EXPECT_FALSE(two_sided.one_sided);
+    EXPECT_FLOAT_EQ(two_sided.normal.x, 0.f);
+    EXPECT_FLOAT_EQ(two_sided.normal.y, -1.f);
+    EXPECT_EQ(two_sided.get_centroid(), vec2(0.f, 0.f));
+
+    // normal is to the right of v1 -> v2
+    edge one_sided({ 2.f, 0.f }, { 1.f, 0.f }, { -1.f, 0.f }, { -2.f, 0.f });
+    EXPECT_TRUE(one_sided.one_sided);
+    EXPECT_FLOAT_EQ(one_sided.normal.x, 0.f);
+    EXPECT_FLOAT_EQ(one_sided.normal.y, 1.f);
+
+    auto mass = one_sided.compute_mass(1.f);
+    EXPECT_FLOAT_EQ(mass.mass, 0.f);
+    EXPECT_FLOAT_EQ(mass.mmoi, 0.f);
+
+    aabb box = one_sided.compute_aabb();
+    EXPECT_FLOAT_EQ(box.lo.x, -1.f - edge::AABB_PADDING);
+    EXPECT_FLOAT_EQ(box.hi.x, 1.f + edge::AABB_PADDING);
+    EXPECT_FLOAT_EQ(box.lo.y, -edge::AABB_PADDING);
+    EXPECT_FLOAT_EQ(box.hi.y, edge::AABB_PADDING);
+
+    EXPECT_FALSE(one_sided.contains({ 0.f, 0.f }));
+    EXPECT_EQ(rdge::to_string(ShapeType::EDGE), "EDGE");
+}
+
+TEST(EdgeTest, VerifyRayCast)
+{
+    edge two_sided({ -1.f, 0.f }, { 1.f, 0.f });
+    edge one_sided({ 2.f, 0.f }, { 1.f, 0.f }, { -1.f, 0.f }, { -2.f, 0.f });
+
+    // a) two sided edges are hit from both sides
+    ray_cast_output output;
+    EXPECT_TRUE(two_sided.ray_cast({ { 0.f, 2.f }, { 0.f, -2.f }, 1.f }, output));
+    EXPECT_FLOAT_EQ(output.fraction, 0.5f);
+    EXPECT_FLOAT_EQ(output.normal.y, 1.f);
+
+    EXPECT_TRUE(two_sided.ray_cast({ { 0.5f, -1.f }, { 0.5f, 3.f }, 1.f }, output));
+    EXPECT_FLOAT_EQ(output.fraction, 0.25f);
+    EXPECT_FLOAT_EQ(output.normal.y, -1.f);
+
+    // b) misses past the end points and short of the edge
+    EXPECT_FALSE(two_sided.ray_cast({ { 1.5f, 2.f }, { 1.5f, -2.f }, 1.f }, output));
+    EXPECT_FALSE(two_sided.ray_cast({ { 0.f, 2.f }, { 0.f, -2.f }, 0.4f }, output));
+    EXPECT_FALSE(two_sided.ray_cast({ { -2.f, 1.f }, { 2.f, 1.f }, 1.f }, output));
+
+    // c) one sided edges are only hit from the side of the normal
+    EXPECT_TRUE(one_sided.ray_cast({ { 0.f, 2.f }, { 0.f, -2.f }, 1.f }, output));
+    EXPECT_FLOAT_EQ(output.normal.y, 1.f);
+    EXPECT_FALSE(one_sided.ray_cast({ { 0.f, -2.f }, { 0.f, 2.f }, 1.f }, output));
+}
+
+TEST(EdgeTest, VerifyPolygonManifold)
+{
+    edge ground({ 2.f, 0.f }, { -2.f, 0.f });
+
+    // a) box resting on the edge uses the edge as the reference
+    polygon box(0.5f, 0.5f, { 0.f, 0.49f });
+    collision_manifold mf;
+    EXPECT_TRUE(intersects(ground, box, mf));
+    ASSERT_EQ(mf.count, 2u);
+    EXPECT_FALSE(mf.flip);
+    EXPECT_FLOAT_EQ(mf.oriented_normal().y, 1.f);
+    EXPECT_NEAR(mf.depths[0], 0.01f, 1e-5f);
+    EXPECT_NEAR(mf.depths[1], 0.01f, 1e-5f);
+    EXPECT_NE(mf.features[0].key(), mf.features[1].key());
+    EXPECT_TRUE(ground.intersects_with(&box));
+
+    // b) separated shapes
+    polygon above(0.5f, 0.5f, { 0.f, 0.51f });
+    EXPECT_FALSE(intersects(ground, above, mf));
+    EXPECT_EQ(mf.count, 0u);
+
+    polygon beside(0.5f, 0.5f, { 2.51f, 0.f });
+    EXPECT_FALSE(intersects(ground, beside, mf));
+
+    // c) two sided edges push a box below back down
+    polygon below(0.5f, 0.5f, { 0.f, -0.49f });
+    EXPECT_TRUE(intersects(ground, below, mf));
+    EXPECT_FLOAT_EQ(mf.oriented_normal().y, -1.f);
+
+    // d) one sided edges ignore shapes behind the edge
+    edge chain({ 4.f, 0.f }, { 2.f, 0.f }, { -2.f, 0.f }, { -4.f, 0.f });
+    EXPECT_TRUE(intersects(chain, box, mf));
+    EXPECT_FLOAT_EQ(mf.oriented_normal().y, 1.f);
+    EXPECT_FALSE(intersects(chain, below, mf));
+    EXPECT_FALSE(chain.intersects_with(&below));
+
+    // e) tilted box corner on the edge uses the polygon as the reference
+    polygon corner(0.5f, 0.5f, { 0.f, 0.69f }, PI * 0.25f);
+    EXPECT_TRUE(intersects(ground, corner, mf));
+    EXPECT_GE(mf.count, 1u);
+    EXPECT_NEAR(mf.oriented_normal().y, 1.f, 0.0001f);
+}
+
+TEST(EdgeTest, VerifyGhostCollisions)
+{
+    // Ground chain (wound right to left so the normals point up) with a seam at
+    // the origin.  A box just past the seam overlaps the end of the left
+    // segment, where the least penetration is along the x-axis.
+    edge right({ 4.f, 0.f }, { 2.f, 0.f }, { 0.f, 0.f }, { -2.f, 0.f });
+    edge left({ 2.f, 0.f }, { 0.f, 0.f }, { -2.f, 0.f }, { -4.f, 0.f });
+    polygon box(0.5f, 0.5f, { 0.495f, 0.49f });
+
+    // a) a two sided segment reports the sideways normal
+    collision_manifold mf;
+    edge two_sided({ 0.f, 0.f }, { -2.f, 0.f });
+    EXPECT_TRUE(intersects(two_sided, box, mf));
+    EXPECT_NEAR(math::abs(mf.oriented_normal().x), 1.f, 0.0001f);
+
+    // b) the ghost vertices reject it, and the other segment supports the box
+    EXPECT_FALSE(intersects(left, box, mf));
+    EXPECT_TRUE(intersects(right, box, mf));
+    EXPECT_FLOAT_EQ(mf.oriented_normal().y, 1.f);
+
+    // c) circles are owned by the segment the center projects onto
+    circle ball({ 0.1f, 0.45f }, 0.5f);
+    EXPECT_FALSE(intersects(left, ball, mf));
+    EXPECT_TRUE(intersects(right, ball, mf));
+    EXPECT_FLOAT_EQ(mf.oriented_normal().y, 1.f);
+    EXPECT_NEAR(mf.depths[0], 0.05f, 1e-5f);
+
+    // d) a concave corner snaps to the segment normal
+    edge floor({ 2.f, 2.f }, { 2.f, 0.f }, { -2.f, 0.f }, { -4.f, 0.f });
+    polygon wedged(0.5f, 0.5f, { 1.495f, 0.49f });
+    EXPECT_TRUE(intersects(floor, wedged, mf));
+    EXPECT_FLOAT_EQ(mf.oriented_normal().y, 1.f);
+}
+
+TEST(EdgeTest, VerifyMergeTileColliders)
+{
+    auto merge = [](const std::vector<uint8>& solid, uint32 cols, uint32 rows) {
+        tile_collider_grid grid;
+        grid.solid = solid.data();
+        grid.cols = cols;
+        grid.rows = rows;
+        grid.cell_size = { 2.f, 1.f };
+        grid.origin = { -1.f, 10.f };
+        return merge_tile_colliders(grid);
+    };
+
+    // a) a row of tiles is a single rectangle
+    auto chains = merge({ 1, 1, 1, 1 }, 4, 1);
+    ASSERT_EQ(chains.size(), 1u);
+    ASSERT_EQ(chains[0].size(), 4u);
+    EXPECT_FLOAT_EQ(signed_area(chains[0]), 8.f);
+    for (const auto& v : chains[0])
+    {
+        EXPECT_TRUE(v.x == -1.f || v.x == 7.f);
+        EXPECT_TRUE(v.y == 10.f || v.y == 11.f);
+    }
+
+    // b) L shape (row zero is the bottom)
+    chains = merge({ 1, 1, 1,
+                     1, 0, 0 }, 3, 2);
+    ASSERT_EQ(chains.size(), 1u);
+    EXPECT_EQ(chains[0].size(), 6u);
+    EXPECT_FLOAT_EQ(signed_area(chains[0]), 8.f);
+
+    // c) hole is wound CW
+    chains = merge({ 1, 1, 1,
+                     1, 0, 1,
+                     1, 1, 1 }, 3, 3);
+    ASSERT_EQ(chains.size(), 2u);
+    EXPECT_EQ(chains[0].size(), 4u);
+    EXPECT_EQ(chains[1].size(), 4u);
+    EXPECT_FLOAT_EQ(signed_area(chains[0]) + signed_area(chains[1]), 16.f);
+    EXPECT_FLOAT_EQ(std::min(signed_area(chains[0]), signed_area(chains[1])), -2.f);
+
+    // d) tiles touching at a corner are separate
+    chains = merge({ 1, 0,
+                     0, 1 }, 2, 2);
+    ASSERT_EQ(chains.size(), 2u);
+    EXPECT_EQ(chains[0].size(), 4u);
+    EXPECT_EQ(chains[1].size(), 4u);
+
+    chains = merge({ 0, 0, 0 }, 3, 1);
+    EXPECT_TRUE(chains.empty());
+
+    // e) random grids cover the solid area, and never contain degenerate
+    //    segments or collinear vertices
+    std::mt19937 rng(7);
+    for (int32 n = 0; n < 20; n++)
+    {
+        std::vector<uint8> solid(24 * 16);
+        float expected = 0.f;
+        for (auto& s : solid)
+        {
+            s = (rng() % 3 != 0) ? 1 : 0;
+            expected += (s) ? 2.f : 0.f;
+        }
+
+        float area = 0.f;
+        for (const auto& chain : merge(solid, 24, 16))
+        {
+            ASSERT_GE(chain.size(), 4u);
+            area += signed_area(chain);
+
+            for (size_t i = 0; i < chain.size(); i++)
+            {
+                const auto& a = chain[i];
+                const auto& b = chain[(i + 1) % chain.size()];
+                const auto& c = chain[(i + 2) % chain.size()];
+                EXPECT_NE(a, b);
+                EXPECT_NE(perp_dot(b - a, c - b), 0.f);
+            }
+        }
+
+        EXPECT_FLOAT_EQ(area, expected);
+    }
+}
+
+TEST(EdgeTest, VerifyChainSimulation)
+{
+    // ground of 40x4 tiles with a step on the right
+    constexpr uint32 COLS = 40;
+    constexpr uint32 ROWS = 4;
+    std::vector<uint8> solid(COLS * ROWS, 1);
+    for (uint32 x = 0; x < 30; x++)
+    {
+        solid[(3 * COLS) + x] = 0;
+    }
+
+    tile_collider_grid grid;
+    grid.solid = solid.data();
+    grid.cols = COLS;
+    grid.rows = ROWS;
+    grid.origin = { -20.f, -3.f };
+    auto chains = merge_tile_colliders(grid);
+    ASSERT_EQ(chains.size(), 1u);
+    ASSERT_EQ(chains[0].size(), 6u);
+
+    CollisionGraph graph({ 0.f, -10.f });
+    RigidBody* ground = graph.CreateBody(rigid_body_profile());
+
+    fixture_profile fprof;
+    fprof.friction = 0.f;
+    EXPECT_EQ(ground->CreateChain(chains[0].data(), chains[0].size(), true, fprof), 6u);
+
+    // a) box sliding along the floor keeps its speed across the seams of the
+    //    tiles, and stops against the step
+    rigid_body_profile bprof;
+    bprof.type = RigidBodyType::DYNAMIC;
+    bprof.position = { -15.f, 0.5f };
+    bprof.linear_velocity = { 4.f, 0.f };
+    bprof.prevent_rotation = true;
+    RigidBody* box = graph.CreateBody(bprof);
+
+    polygon shape(0.5f, 0.5f);
+    fixture_profile box_prof;
+    box_prof.shape = &shape;
+    box_prof.density = 1.f;
+    box_prof.friction = 0.f;
+    box->CreateFixture(box_prof);
+
+    for (int32 i = 0; i < 120; i++)
+    {
+        graph.Step(1.f / 60.f);
+        EXPECT_NEAR(box->GetLinearVelocity().x, 4.f, 0.001f);
+        EXPECT_LE(graph.ContactCount(), 1u);
+    }
+
+    for (int32 i = 0; i < 360; i++)
+    {
+        graph.Step(1.f / 60.f);
+    }
+
+    EXPECT_NEAR(box->GetWorldCenter().x, 9.5f, 0.02f);
+    EXPECT_NEAR(box->GetWorldCenter().y, 0.5f, 0.02f);
+
+    // b) ray casts hit the outside of the chain, but not from inside the tiles
+    cast_hit hit;
+    EXPECT_TRUE(graph.RayCastClosest({ -10.f, 5.f }, { -10.f, -5.f }, hit));
+    EXPECT_EQ(hit.fixture->body, ground);
+    EXPECT_FLOAT_EQ(hit.point.y, 0.f);
+    EXPECT_FLOAT_EQ(hit.normal.y, 1.f);
+
+    EXPECT_FALSE(graph.RayCastClosest({ -10.f, -1.f }, { -10.f, -0.5f }, hit));
+}
+
+} // anonymous namespace
@@ -4,6 +4,7 @@
 #include <rdge/math/vec2.hpp>
 #include <rdge/math/intrinsics.hpp>
 #include <rdge/physics/shapes/circle.hpp>
+#include <rdge/physics/shapes/edge.hpp>
 #include <rdge/physics/shapes/polygon.hpp>
 
 #include <exception>
@@ -44,4 +45,106 @@ TEST(GJKTest, VerifyIntersection)
     EXPECT_TRUE(test3.intersects());
 }
 
+TEST(GJKTest, VerifyDistance)
+{
+    iso_transform identity({ 0.f, 0.f }, 0.f);
+    polygon box(0.5f, 0.5f);
+    circle ball({ 0.f, 0.f }, 0.5f);
+    edge segment({ -1.f, 0.f }, { 1.f, 0.f });
+
+    // a) separated boxes report the gap between the closest faces
+    distance_output output;
+    distance(&box, iso_transform({ 0.f, 0.f }, 0.f), &box, iso_transform({ 3.f, 0.5f }, 0.f), output);
+    EXPECT_NEAR(output.distance, 2.f, 1e-5f);
+    EXPECT_NEAR(output.normal.x, 1.f, 1e-5f);
+    EXPECT_NEAR(output.point_a.x, 0.5f, 1e-5f);
+    EXPECT_NEAR(output.point_b.x, 2.5f, 1e-5f);
+    EXPECT_NEAR(dot(output.point_b - output.point_a, output.normal), output.distance, 1e-5f);
+
+    // b) rotated box corner to a circle, which includes the radius
+    distance(&box, iso_transform({ 0.f, 0.f }, PI * 0.25f), &ball, iso_transform({ 0.f, 3.f }, 0.f), output);
+    EXPECT_NEAR(output.distance, 2.5f - std::sqrt(0.5f), 1e-5f);
+    EXPECT_NEAR(output.normal.y, 1.f, 1e-5f);
+    EXPECT_NEAR(output.point_a.y, std::sqrt(0.5f), 1e-5f);
+    EXPECT_NEAR(output.point_b.y, 2.5f, 1e-5f);
+
+    // c) edge to circle beyond the end point
+    distance(&segment, identity, &ball, iso_transform({ 4.f, 0.f }, 0.f), output);
+    EXPECT_NEAR(output.distance, 2.5f, 1e-5f);
+    EXPECT_NEAR(output.point_a.x, 1.f, 1e-5f);
+}
+
+TEST(GJKTest, VerifyPenetration)
+{
+    iso_transform identity({ 0.f, 0.f }, 0.f);
+    polygon box(0.5f, 0.5f);
+    circle ball({ 0.f, 0.f }, 0.5f);
+    edge segment({ -1.f, 0.f }, { 1.f, 0.f });
+
+    // a) overlapping boxes report the minimum translation along the y-axis
+    distance_output output;
+    distance(&box, identity, &box, iso_transform({ 0.2f, 0.7f }, 0.f), output);
+    EXPECT_NEAR(output.distance, -0.3f, 1e-4f);
+    EXPECT_NEAR(output.normal.x, 0.f, 1e-4f);
+    EXPECT_NEAR(output.normal.y, 1.f, 1e-4f);
+    EXPECT_NEAR(output.point_a.y, 0.5f, 1e-4f);
+    EXPECT_NEAR(output.point_b.y, 0.2f, 1e-4f);
+
+    // b) box contained by a larger box
+    polygon large(2.f, 2.f);
+    distance(&large, identity, &box, iso_transform({ -1.f, 0.2f }, 0.f), output);
+    EXPECT_NEAR(output.distance, -1.5f, 1e-4f);
+    EXPECT_NEAR(output.normal.x, -1.f, 1e-4f);
+
+    // c) circle overlapping an edge
+    distance(&segment, identity, &ball, iso_transform({ 0.3f, -0.2f }, 0.f), output);
+    EXPECT_NEAR(output.distance, -0.3f, 1e-4f);
+    EXPECT_NEAR(output.normal.y, -1.f, 1e-4f);
+
+    // d) circle cores overlapping by less than the radii
+    distance(&ball, identity, &ball, iso_transform({ 0.6f, 0.f }, 0.f), output);
+    EXPECT_NEAR(output.distance, -0.4f, 1e-5f);
+    EXPECT_NEAR(output.normal.x, 1.f, 1e-5f);
+
+    // e) concentric circles still report a unit normal and the full depth
+    distance(&ball, identity, &ball, identity, output);
+    EXPECT_NEAR(output.distance, -1.f, 1e-5f);
+    EXPECT_NEAR(output.normal.length(), 1.f, 1e-5f);
+}
+
+TEST(GJKTest, VerifyDistanceCache)
+{
+    iso_transform identity({ 0.f, 0.f }, 0.f);
+    polygon::PolygonData data;
+    for (size_t i = 0; i < polygon::MAX_VERTICES; i++)
+    {
+        float theta = (PI * 2.f * static_cast<float>(i)) / static_cast<float>(polygon::MAX_VERTICES);
+        data[i] = { std::cos(theta), std::sin(theta) };
+    }
+
+    polygon octagon(data, polygon::MAX_VERTICES);
+
+    // a) warm start from the previous query converges immediately when the
+    //    shapes have barely moved
+    simplex_cache cache;
+    distance_output cold;
+    distance(&octagon, identity, &octagon, iso_transform({ 3.f, 0.3f }, 0.1f), cache, cold);
+    EXPECT_GT(cold.iterations, 1u);
+    EXPECT_GT(cache.count, 0u);
+
+    distance_output warm;
+    distance(&octagon, identity, &octagon, iso_transform({ 3.f, 0.31f }, 0.1f), cache, warm);
+    EXPECT_LE(warm.iterations, 1u);
+
+    distance_output expected;
+    distance(&octagon, identity, &octagon, iso_transform({ 3.f, 0.31f }, 0.1f), expected);
+    EXPECT_NEAR(warm.distance, expected.distance, 1e-5f);
+    EXPECT_GT(expected.iterations, warm.iterations);
+
+    // b) cache from a different pair of shapes is discarded
+    circle ball({ 0.f, 0.f }, 0.5f);
+    distance(&ball, identity, &ball, iso_transform({ 2.f, 0.f }, 0.f), cache, warm);
+    EXPECT_NEAR(warm.distance, 1.f, 1e-5f);
+}
+
 } // namespace rdge
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <rdge/physics/graph_stats.hpp>
+#include <rdge/physics/collision_graph.hpp>
+#include <rdge/physics/shapes/polygon.hpp>
+
+namespace {
+
+using namespace rdge;
+using namespace rdge::physics;
+
+TEST(GraphStatsTest, VerifyHistory)
+{
+    GraphStats stats;
+    EXPECT_TRUE(stats.Empty());
+    EXPECT_EQ(stats.Summarize(&step_stats::total).max, 0.0);
+
+    // a) steps are ordered from oldest to newest
+    for (int64 i = 1; i <= 100; i++)
+    {
+        step_stats s;
+        s.total = i;
+        s.islands = static_cast<uint32>(i % 2);
+        stats.Record(s);
+    }
+
+    ASSERT_EQ(stats.Size(), 100u);
+    EXPECT_EQ(stats[0].total, 1);
+    EXPECT_EQ(stats.Last().total, 100);
+
+    auto total = stats.Summarize(&step_stats::total);
+    EXPECT_EQ(total.min, 1.0);
+    EXPECT_EQ(total.max, 100.0);
+    EXPECT_DOUBLE_EQ(total.avg, 50.5);
+    EXPECT_EQ(total.p99, 99.0);
+
+    auto islands = stats.Summarize(&step_stats::islands);
+    EXPECT_EQ(islands.min, 0.0);
+    EXPECT_EQ(islands.max, 1.0);
+    EXPECT_DOUBLE_EQ(islands.avg, 0.5);
+
+    // b) oldest steps are overwritten once full
+    for (int64 i = 101; i <= 200; i++)
+    {
+        step_stats s;
+        s.total = i;
+        stats.Record(s);
+    }
+
+    ASSERT_EQ(stats.Size(), GraphStats::HISTORY_SIZE);
+    EXPECT_EQ(stats[0].total, static_cast<int64>(200 - GraphStats::HISTORY_SIZE + 1));
+    EXPECT_EQ(stats.Last().total, 200);
+    EXPECT_EQ(stats.Summarize(&step_stats::total).min,
+              static_cast<double>(200 - GraphStats::HISTORY_SIZE + 1));
+
+    stats.Clear();
+    EXPECT_TRUE(stats.Empty());
+}
+
+TEST(GraphStatsTest, VerifyStepCounts)
+{
+    CollisionGraph graph({ 0.f, -10.f });
+
+    rigid_body_profile profile;
+    polygon ground_shape(10.f, 0.5f);
+    graph.CreateBody(profile)->CreateFixture(&ground_shape, 0.f);
+
+    profile.type = RigidBodyType::DYNAMIC;
+    polygon box(0.5f, 0.5f);
+    for (int32 i = 0; i < 3; i++)
+    {
+        profile.position = { static_cast<float>(i) * 3.f - 3.f, 1.01f };
+        graph.CreateBody(profile)->CreateFixture(&box, 1.f);
+    }
+
+    graph.Step(1.f / 60.f);
+    ASSERT_EQ(graph.stats.Size(), 1u);
+
+    // each box is paired with the ground and forms its own island
+    const auto& first = graph.stats.Last();
+    EXPECT_EQ(first.proxies_moved, 4u);
+    EXPECT_EQ(first.pairs_tested, 3u);
+    EXPECT_EQ(first.contacts_created, 3u);
+    EXPECT_EQ(first.contacts_destroyed, 0u);
+    EXPECT_EQ(first.islands, 3u);
+    EXPECT_EQ(first.bodies_awake, 3u);
+    EXPECT_EQ(first.velocity_iterations, 3u * 4u);
+    EXPECT_GE(first.position_iterations, 3u);
+    EXPECT_GE(first.total, first.solve);
+
+    graph.Step(1.f / 60.f);
+    ASSERT_EQ(graph.stats.Size(), 2u);
+    EXPECT_EQ(graph.stats.Last().contacts_created, 0u);
+
+    graph.ClearGraph();
+    EXPECT_TRUE(graph.stats.Empty());
+}
+
+} // anonymous namespace
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <rdge/physics/pair_buffer.hpp>
+
+#include <random>
+#include <set>
+#include <utility>
+
+namespace {
+
+using namespace rdge;
+using namespace rdge::physics;
+
+TEST(PairBufferTest, VerifyInsertion)
+{
+    PairBuffer buffer;
+    EXPECT_TRUE(buffer.Empty());
+
+    // a) handles are ordered and duplicates rejected
+    EXPECT_TRUE(buffer.Insert(5, 2));
+    EXPECT_FALSE(buffer.Insert(2, 5));
+    EXPECT_FALSE(buffer.Insert(5, 2));
+    EXPECT_TRUE(buffer.Insert(2, 6));
+    EXPECT_TRUE(buffer.Contains(5, 2));
+    EXPECT_TRUE(buffer.Contains(2, 5));
+    EXPECT_FALSE(buffer.Contains(5, 6));
+
+    ASSERT_EQ(buffer.Size(), 2u);
+    EXPECT_EQ(buffer[0].handle_a, 2);
+    EXPECT_EQ(buffer[0].handle_b, 5);
+    EXPECT_EQ(buffer[1].handle_a, 2);
+    EXPECT_EQ(buffer[1].handle_b, 6);
+
+    // b) clearing removes all pairs
+    buffer.Clear();
+    EXPECT_TRUE(buffer.Empty());
+    EXPECT_FALSE(buffer.Contains(2, 5));
+    EXPECT_TRUE(buffer.Insert(2, 5));
+}
+
+TEST(PairBufferTest, VerifyGrowth)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int32> dist(0, 200);
+
+    PairBuffer buffer(16);
+    std::set<std::pair<int32, int32>> expected;
+
+    for (size_t pass = 0; pass < 3; pass++)
+    {
+        buffer.Clear();
+        expected.clear();
+
+        for (size_t i = 0; i < 5000; i++)
+        {
+            int32 a = dist(rng);
+            int32 b = dist(rng);
+            if (a == b)
+            {
+                continue;
+            }
+
+            bool inserted = expected.emplace(std::min(a, b), std::max(a, b)).second;
+            EXPECT_EQ(buffer.Insert(a, b), inserted);
+        }
+
+        ASSERT_EQ(buffer.Size(), expected.size());
+        for (const auto& p : buffer)
+        {
+            EXPECT_LT(p.handle_a, p.handle_b);
+            EXPECT_EQ(expected.count(std::make_pair(p.handle_a, p.handle_b)), 1u);
+        }
+    }
+}
+
+} // anonymous namespace
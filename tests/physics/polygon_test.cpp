@@ -2,6 +2,8 @@
 
 #include <rdge/math/vec2.hpp>
 #include <rdge/math/intrinsics.hpp>
+#include <rdge/physics/collision.hpp>
+#include <rdge/physics/shapes/circle.hpp>
 #include <rdge/physics/shapes/polygon.hpp>
 #include <rdge/physics/aabb.hpp>
 
@@ -161,4 +163,115 @@ TEST(PolygonTest, VerifyManifoldPolygonPolygon)
     //]
 }
 
+TEST(PolygonTest, VerifyManifoldFeatures)
+{
+    // b rests on top of a, hanging off the right side
+    polygon a(0.5f, 0.5f);
+    polygon b(0.5f, 0.5f, { 0.6f, 0.95f }, 0.f);
+
+    collision_manifold mf;
+    EXPECT_TRUE(a.intersects_with(b, mf));
+    EXPECT_FALSE(mf.flip);
+    ASSERT_EQ(mf.count, 2u);
+
+    // a) unclipped vertex of b against the top face of a
+    EXPECT_FLOAT_EQ(mf.contacts[0].x, 0.1f);
+    EXPECT_NEAR(mf.depths[0], 0.05f, 1e-5f);
+    EXPECT_EQ(mf.features[0].index_a, 2u);
+    EXPECT_EQ(mf.features[0].type_a, contact_feature::FACE);
+    EXPECT_EQ(mf.features[0].index_b, 0u);
+    EXPECT_EQ(mf.features[0].type_b, contact_feature::VERTEX);
+
+    // b) bottom face of b clipped by the corner of a
+    EXPECT_FLOAT_EQ(mf.contacts[1].x, 0.5f);
+    EXPECT_NEAR(mf.depths[1], 0.05f, 1e-5f);
+    EXPECT_EQ(mf.features[1].index_a, 2u);
+    EXPECT_EQ(mf.features[1].type_a, contact_feature::VERTEX);
+    EXPECT_EQ(mf.features[1].index_b, 0u);
+    EXPECT_EQ(mf.features[1].type_b, contact_feature::FACE);
+
+    // c) features are stable as the shapes move
+    polygon moved(0.5f, 0.5f, { 0.55f, 0.96f }, 0.01f);
+    collision_manifold mf2;
+    EXPECT_TRUE(a.intersects_with(moved, mf2));
+    ASSERT_EQ(mf2.count, 2u);
+    EXPECT_EQ(mf2.features[0].key(), mf.features[0].key());
+    EXPECT_EQ(mf2.features[1].key(), mf.features[1].key());
+
+    // d) features are relative to the shapes, not the reference
+    polygon diamond(0.5f, 0.5f, { 0.f, 1.1771f }, math::PI * 0.25f);
+    polygon ground(2.f, 0.49f);
+    EXPECT_TRUE(diamond.intersects_with(ground, mf));
+    EXPECT_TRUE(mf.flip);
+    ASSERT_EQ(mf.count, 1u);
+    EXPECT_NEAR(mf.depths[0], 0.02f, 1e-4f);
+    EXPECT_EQ(mf.features[0].index_a, 0u);
+    EXPECT_EQ(mf.features[0].type_a, contact_feature::VERTEX);
+    EXPECT_EQ(mf.features[0].index_b, 2u);
+    EXPECT_EQ(mf.features[0].type_b, contact_feature::FACE);
+}
+
+TEST(PolygonTest, RayCast)
+{
+    polygon box(1.f, 1.f, { 5.f, 0.f });
+    ray_cast_output output;
+
+    // a) hit the near face
+    ray_cast_input input = { { 0.f, 0.f }, { 10.f, 0.f } };
+    EXPECT_TRUE(box.ray_cast(input, output));
+    EXPECT_FLOAT_EQ(output.fraction, 0.4f);
+    EXPECT_FLOAT_EQ(output.normal.x, -1.f);
+    EXPECT_FLOAT_EQ(output.normal.y, 0.f);
+
+    // b) hit the top face at an angle
+    input = { { 5.f, 5.f }, { 6.f, -5.f } };
+    EXPECT_TRUE(box.ray_cast(input, output));
+    EXPECT_FLOAT_EQ(output.fraction, 0.4f);
+    EXPECT_FLOAT_EQ(output.normal.y, 1.f);
+
+    // c) max fraction stops short of the box
+    input = { { 0.f, 0.f }, { 10.f, 0.f }, 0.3f };
+    EXPECT_FALSE(box.ray_cast(input, output));
+
+    // d) miss
+    input = { { 0.f, 2.f }, { 10.f, 2.f } };
+    EXPECT_FALSE(box.ray_cast(input, output));
+
+    // e) origin inside the box
+    input = { { 5.f, 0.f }, { 10.f, 0.f } };
+    EXPECT_FALSE(box.ray_cast(input, output));
+}
+
+TEST(PolygonTest, ShapeCast)
+{
+    polygon a(1.f, 1.f, { 0.f, 0.f });
+    polygon b(1.f, 1.f, { 5.f, 0.5f });
+    ray_cast_output output;
+
+    // a) box hits box
+    EXPECT_TRUE(shape_cast(&a, { 10.f, 0.f }, &b, 1.f, output));
+    EXPECT_FLOAT_EQ(output.fraction, 0.3f);
+    EXPECT_FLOAT_EQ(output.normal.x, -1.f);
+    EXPECT_FLOAT_EQ(output.normal.y, 0.f);
+
+    // b) clipped by max fraction
+    EXPECT_FALSE(shape_cast(&a, { 10.f, 0.f }, &b, 0.25f, output));
+
+    // c) passes above
+    polygon above(1.f, 1.f, { 5.f, 2.5f });
+    EXPECT_FALSE(shape_cast(&a, { 10.f, 0.f }, &above, 1.f, output));
+
+    // d) initial overlap
+    polygon c(1.f, 1.f, { 1.5f, 0.f });
+    EXPECT_TRUE(shape_cast(&a, { 10.f, 0.f }, &c, 1.f, output));
+    EXPECT_FLOAT_EQ(output.fraction, 0.f);
+
+    // e) box hits circle
+    circle d({ 0.f, -5.f }, 1.f);
+    EXPECT_TRUE(shape_cast(&a, { 0.f, -10.f }, &d, 1.f, output));
+    EXPECT_FLOAT_EQ(output.fraction, 0.3f);
+    EXPECT_FLOAT_EQ(output.normal.x, 0.f);
+    EXPECT_FLOAT_EQ(output.normal.y, 1.f);
+}
+
 } // anonymous namespace
@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+
+#include <rdge/math/vec2.hpp>
+#include <rdge/physics/aabb.hpp>
+#include <rdge/physics/bvh.hpp>
+#include <rdge/physics/spatial_hash.hpp>
+#include <rdge/physics/snapshot.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace rdge;
+using namespace rdge::math;
+using namespace rdge::physics;
+
+struct test_proxy
+{
+    int32 id;
+};
+
+aabb
+random_box (std::mt19937& rng, float extent)
+{
+    std::uniform_real_distribution<float> pos(-extent, extent);
+    std::uniform_real_distribution<float> size(0.1f, 2.f);
+
+    vec2 lo(pos(rng), pos(rng));
+    return aabb(lo, size(rng), size(rng));
+}
+
+std::vector<int32>
+query_ids (const IBroadPhase& broad_phase, const aabb& box)
+{
+    std::vector<int32> result;
+    broad_phase.Query(box, [&](int32 handle) {
+        result.push_back(static_cast<test_proxy*>(broad_phase.GetUserData(handle))->id);
+        return true;
+    });
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// Fraction where the segment enters the box, or a negative value on a miss
+float
+slab_fraction (const ray_cast_input& input, const aabb& box)
+{
+    vec2 d = input.p2 - input.p1;
+    float t0 = 0.f;
+    float t1 = input.max_fraction;
+    for (uint8 axis = 0; axis < 2; axis++)
+    {
+        if (d[axis] == 0.f)
+        {
+            if (input.p1[axis] < box.lo[axis] || input.p1[axis] > box.hi[axis])
+            {
+                return -1.f;
+            }
+
+            continue;
+        }
+
+        float a = (box.lo[axis] - input.p1[axis]) / d[axis];
+        float b = (box.hi[axis] - input.p1[axis]) / d[axis];
+        t0 = std::max(t0, std::min(a, b));
+        t1 = std::min(t1, std::max(a, b));
+    }
+
+    return (t0 <= t1) ? t0 : -1.f;
+}
+
+TEST(SpatialHashGridTest, VerifyQueries)
+{
+    std::mt19937 rng(1234);
+    std::vector<test_proxy> proxies(500);
+    std::vector<int32> grid_handles;
+    std::vector<int32> tree_handles;
+
+    SpatialHashGrid grid(vec2(1.f, 1.f));
+    BVHTree tree;
+    for (size_t i = 0; i < proxies.size(); i++)
+    {
+        // a few proxies are larger than the cell limit
+        aabb box = random_box(rng, 50.f);
+        if (i % 50 == 0)
+        {
+            box.fatten(8.f);
+        }
+
+        proxies[i].id = static_cast<int32>(i);
+        grid_handles.push_back(grid.CreateProxy(box, &proxies[i]));
+        tree_handles.push_back(tree.CreateProxy(box, &proxies[i]));
+    }
+
+    EXPECT_EQ(grid.ProxyCount(), proxies.size());
+    EXPECT_EQ(grid.OversizedCount(), 10u);
+
+    // a) Queries find the same proxies as the tree, including queries larger
+    //    than the occupied area
+    auto verify = [&](void) {
+        for (size_t i = 0; i < 100; i++)
+        {
+            aabb query = random_box(rng, 50.f).fatten((i % 10 == 0) ? 200.f : 3.f);
+            EXPECT_EQ(query_ids(grid, query), query_ids(tree, query));
+        }
+    };
+
+    verify();
+
+    // b) Moved proxies are found at the new position
+    std::uniform_real_distribution<float> disp(-2.f, 2.f);
+    for (size_t i = 0; i < proxies.size(); i++)
+    {
+        aabb box = grid.GetFatAABB(grid_handles[i]);
+        vec2 d(disp(rng), disp(rng));
+        box.lo += d;
+        box.hi += d;
+
+        grid.MoveProxy(grid_handles[i], box, d);
+        tree.MoveProxy(tree_handles[i], box, d);
+        EXPECT_EQ(grid.GetFatAABB(grid_handles[i]), tree.GetFatAABB(tree_handles[i]));
+    }
+
+    verify();
+
+    // c) Destroyed proxies are no longer reported
+    for (size_t i = 0; i < proxies.size(); i += 3)
+    {
+        grid.DestroyProxy(grid_handles[i]);
+        tree.DestroyProxy(tree_handles[i]);
+    }
+
+    verify();
+
+    // d) Termination stops the query
+    size_t count = 0;
+    grid.Query(aabb({ -100.f, -100.f }, { 100.f, 100.f }), [&](int32) {
+        count++;
+        return false;
+    });
+
+    EXPECT_EQ(count, 1u);
+}
+
+TEST(SpatialHashGridTest, VerifyRayCast)
+{
+    std::mt19937 rng(4321);
+    std::vector<test_proxy> proxies(300);
+    std::vector<int32> handles;
+
+    SpatialHashGrid grid(vec2(2.f, 2.f));
+    for (size_t i = 0; i < proxies.size(); i++)
+    {
+        proxies[i].id = static_cast<int32>(i);
+        handles.push_back(grid.CreateProxy(random_box(rng, 30.f), &proxies[i]));
+    }
+
+    // a) Every fat box touching the segment is reported exactly once
+    ray_cast_input inputs[] = { { { -40.f, -30.f }, { 40.f, 35.f }, 1.f },
+                                { { 35.f, 10.f }, { -35.f, -12.f }, 1.f },
+                                { { 5.f, 40.f }, { 2.f, -40.f }, 1.f },
+                                { { -40.f, 0.5f }, { 40.f, 0.5f }, 1.f } };
+    for (const auto& input : inputs)
+    {
+        std::vector<int32> hits;
+        grid.RayCast(input, [&](const ray_cast_input& sub_input, int32 handle) {
+            hits.push_back(static_cast<test_proxy*>(grid.GetUserData(handle))->id);
+            return sub_input.max_fraction;
+        });
+
+        std::vector<int32> expected;
+        float closest = std::numeric_limits<float>::max();
+        for (size_t i = 0; i < proxies.size(); i++)
+        {
+            float t = slab_fraction(input, grid.GetFatAABB(handles[i]));
+            if (t >= 0.f)
+            {
+                expected.push_back(static_cast<int32>(i));
+                closest = std::min(closest, t);
+            }
+        }
+
+        std::sort(hits.begin(), hits.end());
+        EXPECT_FALSE(expected.empty());
+        EXPECT_TRUE(std::adjacent_find(hits.begin(), hits.end()) == hits.end());
+        for (int32 id : expected)
+        {
+            EXPECT_TRUE(std::binary_search(hits.begin(), hits.end(), id));
+        }
+
+        // b) Clipping to the hit fraction finds the closest fat box
+        float result = std::numeric_limits<float>::max();
+        grid.RayCast(input, [&](const ray_cast_input& sub_input, int32 handle) {
+            float t = slab_fraction(sub_input, grid.GetFatAABB(handle));
+            if (t < 0.f)
+            {
+                return -1.f;
+            }
+
+            result = std::min(result, t);
+            return std::max(t, 0.0001f);
+        });
+
+        EXPECT_FLOAT_EQ(result, closest);
+    }
+
+    // c) Returning zero terminates the cast
+    size_t count = 0;
+    grid.RayCast(inputs[0], [&](const ray_cast_input&, int32) {
+        count++;
+        return 0.f;
+    });
+
+    EXPECT_EQ(count, 1u);
+}
+
+TEST(SpatialHashGridTest, VerifySnapshot)
+{
+    std::mt19937 rng(99);
+    std::vector<test_proxy> proxies(100);
+    std::vector<int32> handles;
+
+    SpatialHashGrid grid(vec2(1.f, 1.f));
+    for (size_t i = 0; i < proxies.size(); i++)
+    {
+        proxies[i].id = static_cast<int32>(i);
+        handles.push_back(grid.CreateProxy(random_box(rng, 20.f), &proxies[i]));
+    }
+
+    graph_snapshot snapshot;
+    snapshot_writer writer(snapshot);
+    grid.Save(writer);
+
+    aabb query({ -5.f, -5.f }, { 5.f, 5.f });
+    auto expected = query_ids(grid, query);
+
+    // restoring undoes proxies moved and created after the save
+    for (int32 handle : handles)
+    {
+        grid.MoveProxy(handle, aabb({ 30.f, 30.f }, 1.f, 1.f), { 0.f, 0.f });
+    }
+
+    test_proxy extra = { 1000 };
+    grid.CreateProxy(aabb({ 0.f, 0.f }, 1.f, 1.f), &extra);
+    EXPECT_NE(query_ids(grid, query), expected);
+
+    snapshot_reader reader(snapshot);
+    grid.Restore(reader);
+    EXPECT_TRUE(reader.at_end());
+    EXPECT_EQ(query_ids(grid, query), expected);
+    EXPECT_EQ(grid.ProxyCount(), proxies.size());
+}
+
+} // anonymous namespace
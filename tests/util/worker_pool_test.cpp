@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <rdge/core.hpp>
+#include <rdge/util/worker_pool.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace rdge;
+
+TEST(WorkerPoolTest, ValidateParallelFor)
+{
+    // a) every item is processed exactly once
+    WorkerPool pool(3);
+    EXPECT_EQ(pool.WorkerCount(), 4u);
+
+    std::vector<int32> items(1000, 0);
+    std::vector<std::atomic<size_t>> calls(pool.WorkerCount());
+    for (auto& c : calls)
+    {
+        c.store(0);
+    }
+
+    pool.ParallelFor(items.size(), 7, [&](size_t begin, size_t end, size_t worker) {
+        ASSERT_LT(worker, pool.WorkerCount());
+        ASSERT_LE(end - begin, 7u);
+
+        calls[worker]++;
+        for (size_t i = begin; i < end; i++)
+        {
+            items[i]++;
+        }
+    });
+
+    for (auto i : items)
+    {
+        EXPECT_EQ(i, 1);
+    }
+
+    size_t total = 0;
+    for (auto& c : calls)
+    {
+        total += c.load();
+    }
+
+    EXPECT_EQ(total, (1000u + 6u) / 7u);
+
+    // b) pool is reusable
+    std::atomic<size_t> sum(0);
+    for (size_t run = 0; run < 50; run++)
+    {
+        pool.ParallelFor(100, 1, [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; i++)
+            {
+                sum += i;
+            }
+        });
+    }
+
+    EXPECT_EQ(sum.load(), 50u * 4950u);
+
+    // c) exceptions on the calling thread wait for the workers, which are
+    //    held until the calling thread has thrown
+    std::atomic<bool> thrown(false);
+    std::atomic<size_t> processed(0);
+    EXPECT_THROW(pool.ParallelFor(100, 1, [&](size_t begin, size_t end, size_t worker) {
+        if (worker == 0)
+        {
+            thrown = true;
+            throw std::runtime_error("worker zero");
+        }
+
+        while (!thrown)
+        {
+            std::this_thread::yield();
+        }
+
+        processed += end - begin;
+    }), std::runtime_error);
+
+    EXPECT_EQ(processed.load(), 99u);
+
+    sum = 0;
+    pool.ParallelFor(100, 1, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++)
+        {
+            sum += i;
+        }
+    });
+
+    EXPECT_EQ(sum.load(), 4950u);
+}
+
+TEST(WorkerPoolTest, ValidateInline)
+{
+    // a) no threads runs on the calling thread
+    WorkerPool pool(0);
+    EXPECT_EQ(pool.WorkerCount(), 1u);
+
+    size_t count = 0;
+    pool.ParallelFor(10, 1, [&](size_t begin, size_t end, size_t worker) {
+        EXPECT_EQ(worker, 0u);
+        count += end - begin;
+    });
+
+    EXPECT_EQ(count, 10u);
+
+    // b) empty range is a no-op
+    pool.ParallelFor(0, 1, [&](size_t, size_t, size_t) { count++; });
+    EXPECT_EQ(count, 10u);
+}
+
+} // anonymous namespace
@@ -0,0 +1,271 @@
+#include "scenarios.hpp"
+
+#include <rdge/core.hpp>
+#include <rdge/physics/collision_graph.hpp>
+#include <rdge/util/json.hpp>
+#include <rdge/util/worker_pool.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Physics benchmark
+//
+// Runs deterministic physics scenarios without a window and writes the per
+// phase timings and counts as json.  Intended to be run before and after a
+// change to the physics module to detect regressions.
+//
+// Timings are in microseconds.  Counts are per step.
+
+using json = nlohmann::json;
+using namespace rdge;
+using namespace rdge::physics;
+
+namespace {
+
+struct benchmark_options
+{
+    uint32 steps = 600;
+    uint32 seed = 1;
+    size_t workers = 0;
+    bool wide = false;
+    float grid = 0.f; //!< Spatial hash cell size, or zero for the BVH
+    std::string scenario;
+    std::string output;
+};
+
+void
+PrintUsage (void)
+{
+    std::cout << "\nRuns headless physics scenarios and reports timings as json\n\n"
+              << "Usage:\n"
+              << "physics_benchmark [flags]\n\n"
+              << "Flags:\n"
+              << "  --steps N       Steps per scenario (default 600)\n"
+              << "  --seed N        Seed for the scenario layouts (default 1)\n"
+              << "  --scenario S    Only run the named scenario\n"
+              << "  --workers N     Solve islands with a pool of N workers\n"
+              << "  --wide          Use the four-wide static broad phase and solver\n"
+              << "  --grid SIZE     Use spatial hash grid broad phases with the cell size\n"
+              << "  --output FILE   Write to a file instead of stdout\n"
+              << "  --list          List the scenario names\n\n";
+}
+
+const std::pair<const char*, int64 step_stats::*> PHASES[] = {
+    { "create_contacts", &step_stats::create_contacts },
+    { "purge_contacts",  &step_stats::purge_contacts },
+    { "solve",           &step_stats::solve },
+    { "synchronize",     &step_stats::synchronize },
+    { "solve_toi",       &step_stats::solve_toi },
+    { "total",           &step_stats::total }
+};
+
+const std::pair<const char*, uint32 step_stats::*> COUNTS[] = {
+    { "proxies_moved",       &step_stats::proxies_moved },
+    { "pairs_tested",        &step_stats::pairs_tested },
+    { "contacts_created",    &step_stats::contacts_created },
+    { "contacts_destroyed",  &step_stats::contacts_destroyed },
+    { "islands",             &step_stats::islands },
+    { "bodies_awake",        &step_stats::bodies_awake },
+    { "velocity_iterations", &step_stats::velocity_iterations },
+    { "position_iterations", &step_stats::position_iterations }
+};
+
+// Summary of a metric over every step of a run (not limited to the history
+// retained by the graph)
+template <typename T>
+json
+Summarize (const std::vector<step_stats>& history, T step_stats::* field)
+{
+    std::vector<double> values;
+    values.reserve(history.size());
+    for (const auto& s : history)
+    {
+        values.push_back(static_cast<double>(s.*field));
+    }
+
+    std::sort(values.begin(), values.end());
+
+    double sum = 0.0;
+    for (double v : values)
+    {
+        sum += v;
+    }
+
+    size_t rank = ((values.size() * 99) + 99) / 100;
+    return { { "min", values.front() },
+             { "avg", sum / static_cast<double>(values.size()) },
+             { "max", values.back() },
+             { "p99", values[rank - 1] },
+             { "sum", sum } };
+}
+
+json
+RunScenario (IScenario& scenario, const benchmark_options& options, WorkerPool* pool)
+{
+    std::mt19937 rng(options.seed);
+    CollisionGraph graph({ 0.f, -10.f });
+    graph.workers = pool;
+    if (options.grid > 0.f)
+    {
+        graph.SetBroadPhase(BroadPhaseType::SPATIAL_HASH,
+                            BroadPhaseType::SPATIAL_HASH,
+                            { options.grid, options.grid });
+    }
+
+    if (options.wide)
+    {
+        graph.EnableWideBroadPhase();
+        graph.EnableWideSolver();
+    }
+
+    scenario.Build(graph, rng);
+
+    std::vector<step_stats> history;
+    history.reserve(options.steps);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32 i = 0; i < options.steps; i++)
+    {
+        scenario.PreStep(graph, rng, i);
+        graph.Step(1.f / 60.f);
+        history.push_back(graph.stats.Last());
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    json phases = json::object();
+    for (const auto& phase : PHASES)
+    {
+        phases[phase.first] = Summarize(history, phase.second);
+    }
+
+    json counts = json::object();
+    for (const auto& count : COUNTS)
+    {
+        counts[count.first] = Summarize(history, count.second);
+    }
+
+    return { { "name", scenario.Name() },
+             { "bodies", graph.BodyCount() },
+             { "contacts", graph.ContactCount() },
+             { "joints", graph.JointCount() },
+             { "wall_ms", std::chrono::duration<double, std::milli>(elapsed).count() },
+             { "phases", phases },
+             { "counts", counts } };
+}
+
+} // anonymous namespace
+
+int
+main (int argc, char** argv)
+{
+    benchmark_options options;
+    auto scenarios = CreateScenarios();
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool has_value = (i + 1) < argc;
+
+        if (arg == "--steps" && has_value)
+        {
+            options.steps = static_cast<uint32>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--seed" && has_value)
+        {
+            options.seed = static_cast<uint32>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--scenario" && has_value)
+        {
+            options.scenario = argv[++i];
+        }
+        else if (arg == "--workers" && has_value)
+        {
+            options.workers = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--grid" && has_value)
+        {
+            options.grid = std::strtof(argv[++i], nullptr);
+        }
+        else if (arg == "--output" && has_value)
+        {
+            options.output = argv[++i];
+        }
+        else if (arg == "--wide")
+        {
+            options.wide = true;
+        }
+        else if (arg == "--list")
+        {
+            for (const auto& scenario : scenarios)
+            {
+                std::cout << scenario->Name() << "\n";
+            }
+
+            return EXIT_SUCCESS;
+        }
+        else
+        {
+            PrintUsage();
+            return (arg == "--help") ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if (options.steps == 0)
+    {
+        std::cerr << "Step count must be greater than zero\n";
+        return EXIT_FAILURE;
+    }
+
+    std::unique_ptr<WorkerPool> pool;
+    if (options.workers > 0)
+    {
+        pool.reset(new WorkerPool(options.workers));
+    }
+
+    json results = json::array();
+    for (const auto& scenario : scenarios)
+    {
+        if (options.scenario.empty() || options.scenario == scenario->Name())
+        {
+            results.push_back(RunScenario(*scenario, options, pool.get()));
+        }
+    }
+
+    if (results.empty())
+    {
+        std::cerr << "Unknown scenario \"" << options.scenario << "\"\n";
+        return EXIT_FAILURE;
+    }
+
+    json report = { { "steps", options.steps },
+                    { "seed", options.seed },
+                    { "workers", options.workers },
+                    { "wide", options.wide },
+                    { "grid", options.grid },
+                    { "scenarios", results } };
+
+    if (options.output.empty())
+    {
+        std::cout << report.dump(4) << std::endl;
+    }
+    else
+    {
+        std::ofstream ofs(options.output, std::ofstream::out | std::ofstream::trunc);
+        if (!ofs)
+        {
+            std::cerr << "Unable to open \"" << options.output << "\"\n";
+            return EXIT_FAILURE;
+        }
+
+        ofs << report.dump(4) << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
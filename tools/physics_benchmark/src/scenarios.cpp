@@ -0,0 +1,282 @@
+#include "scenarios.hpp"
+
+#include <rdge/math/intrinsics.hpp>
+#include <rdge/physics/tile_colliders.hpp>
+#include <rdge/physics/joints/revolute_joint.hpp>
+#include <rdge/physics/shapes/circle.hpp>
+#include <rdge/physics/shapes/polygon.hpp>
+
+using namespace rdge;
+using namespace rdge::math;
+using namespace rdge::physics;
+
+namespace {
+
+// Offset applied to initial positions so each seed breaks symmetry differently
+vec2
+Jitter (std::mt19937& rng, float amount)
+{
+    std::uniform_real_distribution<float> dist(-amount, amount);
+    float x = dist(rng);
+    float y = dist(rng);
+    return { x, y };
+}
+
+RigidBody*
+CreateGround (CollisionGraph& graph, float he_x)
+{
+    rigid_body_profile bprof;
+    bprof.position.y = -0.5f;
+    RigidBody* ground = graph.CreateBody(bprof);
+
+    polygon shape(he_x, 0.5f);
+    ground->CreateFixture(&shape, 0.f);
+    return ground;
+}
+
+// Boxes are spaced vertically so no two shapes start exactly touching
+void
+CreatePyramid (CollisionGraph& graph, std::mt19937& rng, int32 base_count, vec2 x)
+{
+    polygon shape(0.5f, 0.5f);
+    vec2 delta_x(0.5625f, 1.25f);
+    vec2 delta_y(1.125f, 0.f);
+
+    for (int32 i = 0; i < base_count; i++)
+    {
+        vec2 y = x;
+        for (int32 j = i; j < base_count; j++)
+        {
+            rigid_body_profile bprof;
+            bprof.type = RigidBodyType::DYNAMIC;
+            bprof.position = y + Jitter(rng, 0.01f);
+
+            graph.CreateBody(bprof)->CreateFixture(&shape, 5.f);
+            y += delta_y;
+        }
+
+        x += delta_x;
+    }
+}
+
+//! \class PyramidScenario
+//! \brief Tall stack resting on the ground
+class PyramidScenario : public IScenario
+{
+public:
+    const char* Name (void) const noexcept override { return "pyramid"; }
+
+    void Build (CollisionGraph& graph, std::mt19937& rng) override
+    {
+        CreateGround(graph, 40.f);
+        CreatePyramid(graph, rng, 20, { -10.5f, 0.75f });
+    }
+};
+
+//! \class TumblerScenario
+//! \brief Rotating box that is continuously filled with small boxes
+//! \details Mirrors the tumbler scene of the physics sandbox.
+class TumblerScenario : public IScenario
+{
+public:
+    static constexpr int32 MAX_COUNT = 800;
+    static constexpr uint32 SPAWN_INTERVAL = 6;
+
+    const char* Name (void) const noexcept override { return "tumbler"; }
+
+    void Build (CollisionGraph& graph, std::mt19937& rng) override
+    {
+        Unused(rng);
+
+        rigid_body_profile bprof;
+        bprof.type = RigidBodyType::DYNAMIC;
+        bprof.angular_velocity = 0.05f * PI;
+        bprof.gravity_scale = 0.f;
+        m_tumbler = graph.CreateBody(bprof);
+
+        polygon side_a(0.5f, 10.f, { 10.f, 0.f }, 0.f);
+        m_tumbler->CreateFixture(&side_a, 5.f);
+        polygon side_b(0.5f, 10.f, { -10.f, 0.f }, 0.f);
+        m_tumbler->CreateFixture(&side_b, 5.f);
+        polygon side_c(10.f, 0.5f, { 0.f, 10.f }, 0.f);
+        m_tumbler->CreateFixture(&side_c, 5.f);
+        polygon side_d(10.f, 0.5f, { 0.f, -10.f }, 0.f);
+        m_tumbler->CreateFixture(&side_d, 5.f);
+
+        m_count = 0;
+    }
+
+    void PreStep (CollisionGraph& graph, std::mt19937& rng, uint32 step) override
+    {
+        m_tumbler->SetAngularVelocity(0.05f * PI);
+        m_tumbler->SetLinearVelocity({ 0.f, 0.f });
+
+        if (m_count < MAX_COUNT && (step % SPAWN_INTERVAL) == 0)
+        {
+            rigid_body_profile bprof;
+            bprof.type = RigidBodyType::DYNAMIC;
+            bprof.position = Jitter(rng, 5.f);
+
+            polygon box(0.125f, 0.125f);
+            graph.CreateBody(bprof)->CreateFixture(&box, 1.f);
+            m_count++;
+        }
+    }
+
+private:
+    RigidBody* m_tumbler = nullptr;
+    int32 m_count = 0;
+};
+
+//! \class TilesScenario
+//! \brief Stack resting on a ground made of many tile fixtures
+//! \details Mirrors the larger configuration of the tiles scene of the physics
+//!          sandbox.
+class TilesScenario : public IScenario
+{
+public:
+    const char* Name (void) const noexcept override { return "tiles"; }
+
+    void Build (CollisionGraph& graph, std::mt19937& rng) override
+    {
+        constexpr int32 N = 200;
+        constexpr int32 M = 10;
+        constexpr float a = 0.5f;
+
+        rigid_body_profile bprof;
+        bprof.position.y = -a;
+        RigidBody* ground = graph.CreateBody(bprof);
+
+        vec2 position;
+        for (int32 j = 0; j < M; j++)
+        {
+            position.x = -N * a;
+            for (int32 i = 0; i < N; i++)
+            {
+                polygon p(a, a, position);
+                ground->CreateFixture(&p, 0.f);
+                position.x += 2.f * a;
+            }
+
+            position.y -= 2.f * a;
+        }
+
+        CreatePyramid(graph, rng, 20, { -7.f, 0.75f });
+    }
+};
+
+//! \class TileChainScenario
+//! \brief Same ground as \ref TilesScenario, merged into a single chain
+class TileChainScenario : public IScenario
+{
+public:
+    const char* Name (void) const noexcept override { return "tile_chains"; }
+
+    void Build (CollisionGraph& graph, std::mt19937& rng) override
+    {
+        constexpr int32 N = 200;
+        constexpr int32 M = 10;
+        constexpr float a = 0.5f;
+
+        rigid_body_profile bprof;
+        bprof.position.y = -a;
+        RigidBody* ground = graph.CreateBody(bprof);
+
+        std::vector<uint8> solid(N * M, 1);
+        tile_collider_grid grid;
+        grid.solid = solid.data();
+        grid.cols = N;
+        grid.rows = M;
+        grid.cell_size = { 2.f * a, 2.f * a };
+        grid.origin = { (-N * a) - a, (-2.f * a * M) + a };
+
+        for (const auto& loop : merge_tile_colliders(grid))
+        {
+            ground->CreateChain(loop.data(), loop.size(), true);
+        }
+
+        CreatePyramid(graph, rng, 20, { -7.f, 0.75f });
+    }
+};
+
+//! \class SleepingScenario
+//! \brief Row of separated bodies which come to rest and fall asleep
+class SleepingScenario : public IScenario
+{
+public:
+    static constexpr int32 COUNT = 1000;
+
+    const char* Name (void) const noexcept override { return "sleeping"; }
+
+    void Build (CollisionGraph& graph, std::mt19937& rng) override
+    {
+        CreateGround(graph, static_cast<float>(COUNT) + 10.f);
+
+        polygon box(0.5f, 0.5f);
+        circle ball(0.5f);
+        for (int32 i = 0; i < COUNT; i++)
+        {
+            rigid_body_profile bprof;
+            bprof.type = RigidBodyType::DYNAMIC;
+            bprof.position.x = (static_cast<float>(i - (COUNT / 2)) * 2.f) + Jitter(rng, 0.25f).x;
+            bprof.position.y = 0.55f;
+
+            ishape* shape = (i % 2 == 0) ? static_cast<ishape*>(&box) : &ball;
+            graph.CreateBody(bprof)->CreateFixture(shape, 1.f);
+        }
+    }
+};
+
+//! \class ChainScenario
+//! \brief Revolute joint chains swinging from a ceiling
+class ChainScenario : public IScenario
+{
+public:
+    const char* Name (void) const noexcept override { return "chains"; }
+
+    void Build (CollisionGraph& graph, std::mt19937& rng) override
+    {
+        constexpr int32 CHAIN_COUNT = 10;
+        constexpr int32 LINK_COUNT = 30;
+
+        RigidBody* ground = CreateGround(graph, 200.f);
+        polygon link(0.5f, 0.125f);
+
+        for (int32 i = 0; i < CHAIN_COUNT; i++)
+        {
+            // chains start horizontal, and are spaced so neighbours swing
+            // into one another
+            float x = (static_cast<float>(i) * 20.f) - 100.f;
+            float y = 40.f + Jitter(rng, 0.25f).y;
+
+            RigidBody* prev = ground;
+            for (int32 j = 0; j < LINK_COUNT; j++)
+            {
+                rigid_body_profile bprof;
+                bprof.type = RigidBodyType::DYNAMIC;
+                bprof.position = { x + 0.5f + static_cast<float>(j), y };
+
+                RigidBody* body = graph.CreateBody(bprof);
+                body->CreateFixture(&link, 20.f);
+                graph.CreateRevoluteJoint(prev, body, { x + static_cast<float>(j), y });
+                prev = body;
+            }
+        }
+    }
+};
+
+} // anonymous namespace
+
+std::vector<std::unique_ptr<IScenario>>
+CreateScenarios (void)
+{
+    std::vector<std::unique_ptr<IScenario>> result;
+    result.emplace_back(new PyramidScenario);
+    result.emplace_back(new TumblerScenario);
+    result.emplace_back(new TilesScenario);
+    result.emplace_back(new TileChainScenario);
+    result.emplace_back(new SleepingScenario);
+    result.emplace_back(new ChainScenario);
+
+    return result;
+}
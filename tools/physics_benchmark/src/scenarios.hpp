@@ -0,0 +1,32 @@
+#pragma once
+
+#include <rdge/core.hpp>
+#include <rdge/physics/collision_graph.hpp>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+//! \class IScenario
+//! \brief Deterministic physics workload
+//! \details Scenarios only depend on the provided random engine, so a seed
+//!          always produces the same simulation.
+class IScenario
+{
+public:
+    virtual ~IScenario (void) noexcept = default;
+
+    virtual const char* Name (void) const noexcept = 0;
+
+    //! \brief Populate an empty graph
+    virtual void Build (rdge::physics::CollisionGraph& graph, std::mt19937& rng) = 0;
+
+    //! \brief Called prior to every step (e.g. to spawn bodies)
+    virtual void PreStep (rdge::physics::CollisionGraph& graph, std::mt19937& rng, rdge::uint32 step)
+    {
+        rdge::Unused(graph, rng, step);
+    }
+};
+
+//! \returns All available scenarios
+std::vector<std::unique_ptr<IScenario>> CreateScenarios (void);